@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -27,6 +27,10 @@ CONFIG += c++11
 
 QMAKE_CXXFLAGS += -m64
 
+#exprtk.hpp (used in scripting.cpp) generates more sections than the default object file format allows
+win32-g++: QMAKE_CXXFLAGS += -Wa,-mbig-obj
+win32-msvc*: QMAKE_CXXFLAGS += /bigobj
+
 SOURCES += main.cpp\
         mainwindow.cpp \
     domain/project.cpp \
@@ -75,7 +79,7 @@ SOURCES += main.cpp\
     gslib/gslibparams/widgets/widgetgslibparrepeat.cpp \
     gslib/gslibparams/widgets/widgetgslibparcolor.cpp \
     gslib/igslibparameterfinder.cpp \
-    gslib/workerthread.cpp \
+    gslib/gslibjobrunner.cpp \
     domain/plot.cpp \
     domain/experimentalvariogram.cpp \
     domain/variogrammodel.cpp \
@@ -172,7 +176,34 @@ SOURCES += main.cpp\
     dialogs/sgsimdialog.cpp \
     widgets/distributionfieldselector.cpp \
     viewer3d/view3dverticalexaggerationwidget.cpp \
-    widgets/focuswatcher.cpp
+    widgets/focuswatcher.cpp \
+    plotting/maprenderer.cpp \
+    dialogs/mapviewdialog.cpp \
+    geostats/univariatestatistics.cpp \
+    plotting/distributionplot.cpp \
+    dialogs/distributionplotdialog.cpp \
+    geostats/ensemblestatistics.cpp \
+    domain/auxiliary/geoeasheadercache.cpp \
+    dialogs/calculatordialog.cpp \
+    geostats/faciesmapbuilder.cpp \
+    geostats/normalscoretransform.cpp \
+    geostats/celldeclustering.cpp \
+    geostats/griddedvariogramcalculator.cpp \
+    geostats/averagevariogram.cpp \
+    geostats/covariancemodel.cpp \
+    geostats/indicatorkriging.cpp \
+    geostats/neighborhoodsearch.cpp \
+    geostats/cokriging.cpp \
+    geostats/gridpointsampler.cpp \
+    geostats/indicatorpostprocessing.cpp \
+    geostats/annealingsmoother.cpp \
+    geostats/distributionsmoother.cpp \
+    geostats/bidistributionsmoother.cpp \
+    geostats/variogramfitter.cpp \
+    geostats/variogrammodelcurves.cpp \
+    plotting/variogramplot.cpp \
+    dialogs/variogramplotdialog.cpp \
+    domain/normalscoretable.cpp
 
 HEADERS  += mainwindow.h \
     domain/project.h \
@@ -226,7 +257,7 @@ HEADERS  += mainwindow.h \
     gslib/gslibparams/widgets/widgetgslibparrepeat.h \
     gslib/gslibparams/widgets/widgetgslibparcolor.h \
     gslib/igslibparameterfinder.h \
-    gslib/workerthread.h \
+    gslib/gslibjobrunner.h \
     domain/plot.h \
     domain/experimentalvariogram.h \
     domain/variogrammodel.h \
@@ -324,7 +355,34 @@ HEADERS  += mainwindow.h \
     dialogs/sgsimdialog.h \
     widgets/distributionfieldselector.h \
     viewer3d/view3dverticalexaggerationwidget.h \
-    widgets/focuswatcher.h
+    widgets/focuswatcher.h \
+    plotting/maprenderer.h \
+    dialogs/mapviewdialog.h \
+    geostats/univariatestatistics.h \
+    plotting/distributionplot.h \
+    dialogs/distributionplotdialog.h \
+    geostats/ensemblestatistics.h \
+    domain/auxiliary/geoeasheadercache.h \
+    dialogs/calculatordialog.h \
+    geostats/faciesmapbuilder.h \
+    geostats/normalscoretransform.h \
+    geostats/celldeclustering.h \
+    geostats/griddedvariogramcalculator.h \
+    geostats/averagevariogram.h \
+    geostats/covariancemodel.h \
+    geostats/indicatorkriging.h \
+    geostats/neighborhoodsearch.h \
+    geostats/cokriging.h \
+    geostats/gridpointsampler.h \
+    geostats/indicatorpostprocessing.h \
+    geostats/annealingsmoother.h \
+    geostats/distributionsmoother.h \
+    geostats/bidistributionsmoother.h \
+    geostats/variogramfitter.h \
+    geostats/variogrammodelcurves.h \
+    plotting/variogramplot.h \
+    dialogs/variogramplotdialog.h \
+    domain/normalscoretable.h
 
 FORMS    += mainwindow.ui \
     gslib/gslibparams/widgets/widgetgslibpardouble.ui \
@@ -388,7 +446,11 @@ FORMS    += mainwindow.ui \
     imagejockey/equalizer/equalizerslider.ui \
     dialogs/sgsimdialog.ui \
     widgets/distributionfieldselector.ui \
-    viewer3d/view3dverticalexaggerationwidget.ui
+    viewer3d/view3dverticalexaggerationwidget.ui \
+    dialogs/mapviewdialog.ui \
+    dialogs/distributionplotdialog.ui \
+    dialogs/calculatordialog.ui \
+    dialogs/variogramplotdialog.ui
 
 #==================== The Boost include path.==================
 _BOOST_INCLUDE = $$(BOOST_INCLUDE)
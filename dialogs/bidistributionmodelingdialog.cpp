@@ -1,7 +1,6 @@
 #include "bidistributionmodelingdialog.h"
 #include "ui_bidistributionmodelingdialog.h"
 #include "displayplotdialog.h"
-#include "distributioncolumnrolesdialog.h"
 #include "util.h"
 #include "domain/attribute.h"
 #include "domain/file.h"
@@ -14,9 +13,11 @@
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslibparametersdialog.h"
 #include "gslib/gslib.h"
+#include "geostats/bidistributionsmoother.h"
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QLineEdit>
+#include <QThread>
 #include <cmath>
 
 BidistributionModelingDialog::BidistributionModelingDialog(Attribute *atX, Attribute *atY, QWidget *parent) :
@@ -27,7 +28,8 @@ BidistributionModelingDialog::BidistributionModelingDialog(Attribute *atX, Attri
     m_cmbXDist( new UnivariateDistributionSelector() ),
     m_cmbYDist( new UnivariateDistributionSelector() ),
     m_gpf_scatsmth( nullptr ),
-    m_gpf_bivplt( nullptr )
+    m_gpf_bivplt( nullptr ),
+    m_smoother( nullptr )
 {
     ui->setupUi(this);
 
@@ -62,6 +64,8 @@ BidistributionModelingDialog::~BidistributionModelingDialog()
     delete ui;
     if( m_gpf_scatsmth )
         delete m_gpf_scatsmth;
+    if( m_smoother )
+        delete m_smoother;
     Application::instance()->logInfo("BidistributionModelingDialog destroyed.");
 }
 
@@ -179,23 +183,91 @@ void BidistributionModelingDialog::onParameters()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
-        m_gpf_scatsmth->save( par_file_path );
+        if( runSmoothing( Xdistr, Ydistr ) )
+            onPlot();
+    }
+}
 
-        //to be notified when scatsmth completes.
-        connect( GSLib::instance(), SIGNAL(programFinished()), this, SLOT(onScatsmthCompletion()) );
+bool BidistributionModelingDialog::runSmoothing(UnivariateDistribution *Xdistr, UnivariateDistribution *Ydistr)
+{
+    //assumes that both variables are from the same data file
+    DataFile* data_file = (DataFile*)m_atX->getContainingFile();
+
+    BidistributionSmoother* smoother = new BidistributionSmoother();
+
+    GSLibParMultiValuedFixed *par1 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(1);
+    smoother->setData( data_file,
+                       par1->getParameter<GSLibParUInt*>(0)->_value,
+                       par1->getParameter<GSLibParUInt*>(1)->_value,
+                       par1->getParameter<GSLibParUInt*>(2)->_value );
+
+    smoother->setMarginals( Xdistr, Ydistr );
+
+    GSLibParMultiValuedFixed *par6 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(6);
+    smoother->setLogScaling( par6->getParameter<GSLibParOption*>(0)->_selected_value == 1,
+                             par6->getParameter<GSLibParOption*>(1)->_selected_value == 1 );
+
+    GSLibParMultiValuedFixed *par11 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(11);
+    smoother->setMaxPerturbations( par11->getParameter<GSLibParDouble*>(0)->_value );
+    smoother->setReportingInterval( par11->getParameter<GSLibParDouble*>(1)->_value );
+    smoother->setMinObjective( par11->getParameter<GSLibParDouble*>(2)->_value );
+    smoother->setSeed( par11->getParameter<GSLibParUInt*>(3)->_value );
+
+    //the four switches/weights are those of the marginals, correlation, smoothness and quantiles
+    GSLibParMultiValuedFixed *par12 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(12);
+    smoother->setComponents( par12->getParameter<GSLibParOption*>(0)->_selected_value == 1,
+                             par12->getParameter<GSLibParOption*>(1)->_selected_value == 1,
+                             par12->getParameter<GSLibParOption*>(2)->_selected_value == 1,
+                             par12->getParameter<GSLibParOption*>(3)->_selected_value == 1 );
+    GSLibParMultiValuedFixed *par13 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(13);
+    smoother->setComponentWeights( par13->getParameter<GSLibParDouble*>(0)->_value,
+                                   par13->getParameter<GSLibParDouble*>(1)->_value,
+                                   par13->getParameter<GSLibParDouble*>(2)->_value,
+                                   par13->getParameter<GSLibParDouble*>(3)->_value );
+
+    smoother->setSmoothingWindow( m_gpf_scatsmth->getParameter<GSLibParDouble*>(14)->_value );
+    smoother->setTargetCorrelation( m_gpf_scatsmth->getParameter<GSLibParDouble*>(15)->_value );
+
+    GSLibParMultiValuedFixed *par16 = m_gpf_scatsmth->getParameter<GSLibParMultiValuedFixed*>(16);
+    smoother->setNumberOfQuantiles( par16->getParameter<GSLibParUInt*>(0)->_value,
+                                    par16->getParameter<GSLibParUInt*>(1)->_value );
+
+    uint nVertexes = m_gpf_scatsmth->getParameter<GSLibParUInt*>(17)->_value;
+    GSLibParRepeat *par18 = m_gpf_scatsmth->getParameter<GSLibParRepeat*>(18);
+    for( uint i = 0; i < nVertexes; ++i ){
+        GSLibParMultiValuedFixed *par18_i = par18->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        smoother->addEnvelopeVertex( par18_i->getParameter<GSLibParDouble*>(0)->_value,
+                                     par18_i->getParameter<GSLibParDouble*>(1)->_value );
+    }
 
-        //run scatsmth program
-        Application::instance()->logInfo("Starting scatsmth program...");
-        GSLib::instance()->runProgramAsync( "scatsmth", par_file_path );
+    //the replicas are annealed in parallel, so there is one per core
+    smoother->setNumberOfReplicas( QThread::idealThreadCount() );
+
+    if( ! smoother->run() ){
+        delete smoother;
+        QMessageBox::critical( this, "Error", "Bidistribution modeling failed.  Check the messages panel for details." );
+        return false;
     }
+    if( m_smoother )
+        delete m_smoother;
+    m_smoother = smoother;
+
+    //save the bivariate model and its marginals to the files given in the parameters
+    QString title = "Bidistr. model for " + m_atX->getName() + " X " + m_atY->getName();
+    m_smoother->saveInGEOEASFormat( m_gpf_scatsmth->getParameter<GSLibParFile*>(10)->_path, title );
+    m_smoother->saveXMarginalInGEOEASFormat( m_gpf_scatsmth->getParameter<GSLibParFile*>(8)->_path,
+                                             "Marginal of " + m_atX->getName() + " from the bidistr. model" );
+    m_smoother->saveYMarginalInGEOEASFormat( m_gpf_scatsmth->getParameter<GSLibParFile*>(9)->_path,
+                                             "Marginal of " + m_atY->getName() + " from the bidistr. model" );
+    return true;
 }
 
-void BidistributionModelingDialog::onScatsmthCompletion()
+void BidistributionModelingDialog::onPlot()
 {
-    //frees all signal connections to the GSLib singleton.
-    GSLib::instance()->disconnect();
+    if( ! m_smoother ){
+        QMessageBox::critical(this, "Error", QString("You must model the bidistribution at least once."));
+        return;
+    }
 
     if( ! m_gpf_bivplt ){
         m_gpf_bivplt = new GSLibParameterFile("bivplt");
@@ -252,7 +324,7 @@ void BidistributionModelingDialog::onScatsmthCompletion()
         m_gpf_bivplt->getParameter<GSLibParString*>(14)->_value = title;
     }
 
-    //set the bidistribution file (may change between several scatsmth runs
+    //set the bidistribution file (may change between several runs)
     m_gpf_bivplt->getParameter<GSLibParFile*>(8)->_path = m_gpf_scatsmth->getParameter<GSLibParFile*>(10)->_path;
 
     //Generate the parameter file
@@ -272,18 +344,10 @@ void BidistributionModelingDialog::onScatsmthCompletion()
     dpd->show();
 }
 
-void BidistributionModelingDialog::onPlot()
-{
-    if( m_gpf_scatsmth )
-        onScatsmthCompletion();
-    else
-        QMessageBox::critical(this, "Error", QString("You must run scatsmth at least once."));
-}
-
 void BidistributionModelingDialog::onSave()
 {
-    if( !m_gpf_scatsmth ){
-        QMessageBox::critical( this, "Error", QString("You must run scatsmth at least once."));
+    if( ! m_smoother ){
+        QMessageBox::critical( this, "Error", QString("You must model the bidistribution at least once."));
         return;
     }
 
@@ -301,39 +365,35 @@ void BidistributionModelingDialog::onSave()
 
     if (ok && !new_dist_model_name.isEmpty()){
 
-        QString tmpPathOfDistr = m_gpf_bivplt->getParameter<GSLibParFile*>(8)->_path;
-
-        //asks the user to set the roles for each of the distribution file columns.
-        DistributionColumnRolesDialog dcrd( tmpPathOfDistr, this );
-        dcrd.adjustSize();
-        int result = dcrd.exec(); //show modally
-        if( result == QDialog::Accepted )
-            Application::instance()->getProject()->importBivariateDistribution( tmpPathOfDistr,
-                                                                                new_dist_model_name.append(".bidst"),
-                                                                                dcrd.getRoles() );
-        else
-            Application::instance()->getProject()->importBivariateDistribution( tmpPathOfDistr,
-                                                                                new_dist_model_name.append(".bidst"),
-                                                                                QMap<uint, Roles::DistributionColumnRole>() ); //empty list
+        QString tmpPathOfDistr = m_gpf_scatsmth->getParameter<GSLibParFile*>(10)->_path;
+
+        //the columns of the bidistribution file are known: X, Y and probability
+        QMap<uint, Roles::DistributionColumnRole> roles;
+        roles.insert( 1, Roles::DistributionColumnRole::VALUE );
+        roles.insert( 2, Roles::DistributionColumnRole::VALUE );
+        roles.insert( 3, Roles::DistributionColumnRole::PVALUE );
+        Application::instance()->getProject()->importBivariateDistribution( tmpPathOfDistr,
+                                                                            new_dist_model_name.append(".bidst"),
+                                                                            roles );
     }
 }
 
 void BidistributionModelingDialog::onSaveXDistr()
 {
-    if( !m_gpf_scatsmth ){
-        QMessageBox::critical( this, "Error", QString("You must run scatsmth at least once."));
+    if( ! m_smoother ){
+        QMessageBox::critical( this, "Error", QString("You must model the bidistribution at least once."));
         return;
     }
 
-    Util::importUnivariateDistribution( m_atX, m_gpf_scatsmth->getParameter<GSLibParFile*>(8)->_path, this );
+    Util::importUnivariateDistribution( m_atX, m_gpf_scatsmth->getParameter<GSLibParFile*>(8)->_path, this, false );
 }
 
 void BidistributionModelingDialog::onSaveYDistr()
 {
-    if( !m_gpf_scatsmth ){
-        QMessageBox::critical( this, "Error", QString("You must run scatsmth at least once."));
+    if( ! m_smoother ){
+        QMessageBox::critical( this, "Error", QString("You must model the bidistribution at least once."));
         return;
     }
 
-    Util::importUnivariateDistribution( m_atY, m_gpf_scatsmth->getParameter<GSLibParFile*>(9)->_path, this );
+    Util::importUnivariateDistribution( m_atY, m_gpf_scatsmth->getParameter<GSLibParFile*>(9)->_path, this, false );
 }
@@ -5,7 +5,9 @@
 
 class Attribute;
 class UnivariateDistributionSelector;
+class UnivariateDistribution;
 class GSLibParameterFile;
+class BidistributionSmoother;
 
 namespace Ui {
 class BidistributionModelingDialog;
@@ -27,10 +29,14 @@ private:
     UnivariateDistributionSelector* m_cmbYDist;
     GSLibParameterFile* m_gpf_scatsmth;
     GSLibParameterFile* m_gpf_bivplt;
+    BidistributionSmoother* m_smoother;
+
+    /** Runs the bidistribution modeling in-process with the scatsmth parameters and saves the bivariate model
+     *  and the marginals in the files given in the parameters.  Returns false on failure. */
+    bool runSmoothing( UnivariateDistribution* Xdistr, UnivariateDistribution* Ydistr );
 
 private slots:
     void onParameters();
-    void onScatsmthCompletion();
     void onPlot();
     void onSave();
     void onSaveXDistr();
@@ -0,0 +1,77 @@
+#include "calculatordialog.h"
+#include "ui_calculatordialog.h"
+
+#include "domain/application.h"
+#include "domain/datafile.h"
+#include "scripting.h"
+
+#include <QMessageBox>
+
+CalculatorDialog::CalculatorDialog(DataFile *dataFile, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::CalculatorDialog),
+    m_dataFile( dataFile )
+{
+    ui->setupUi(this);
+
+    //deletes dialog from memory upon user closing it
+    this->setAttribute(Qt::WA_DeleteOnClose);
+
+    setWindowTitle( "Calculator" );
+
+    ui->lblFile->setText( "<html><head/><body><p><span style=\" font-weight:600; color:#0000ff;\">" +
+                          m_dataFile->getName() + "</span></p></body></html>" );
+
+    //list the variables by the names used in expressions
+    QStringList fieldNames = m_dataFile->getFieldNames();
+    for( const QString& fieldName : fieldNames ){
+        QListWidgetItem* item = new QListWidgetItem( Scripting::getVariableName( fieldName ) );
+        if( item->text() != fieldName.trimmed() )
+            item->setToolTip( fieldName.trimmed() );
+        ui->lstVariables->addItem( item );
+    }
+
+    ui->txtNewVariableName->setText( "Calculated" );
+
+    connect( ui->lstVariables, SIGNAL(itemDoubleClicked(QListWidgetItem*)),
+             this, SLOT(onVariableDoubleClicked(QListWidgetItem*)) );
+    connect( ui->btnCompute, SIGNAL(clicked()), this, SLOT(onCompute()) );
+}
+
+CalculatorDialog::~CalculatorDialog()
+{
+    delete ui;
+}
+
+void CalculatorDialog::onVariableDoubleClicked(QListWidgetItem *item)
+{
+    ui->txtExpression->insertPlainText( item->text() );
+    ui->txtExpression->setFocus();
+}
+
+void CalculatorDialog::onCompute()
+{
+    QString expression = ui->txtExpression->toPlainText().trimmed();
+    QString newVariableName = ui->txtNewVariableName->text().trimmed();
+    if( expression.isEmpty() || newVariableName.isEmpty() ){
+        QMessageBox::critical( this, "Error", "Please, enter an expression and a name for the new variable.");
+        return;
+    }
+
+    Scripting scripting( m_dataFile );
+    if( ! scripting.compile( expression ) ){
+        QMessageBox::critical( this, "Error in expression", scripting.getLastError() );
+        return;
+    }
+    if( scripting.getUsedVariables().isEmpty() )
+        Application::instance()->logWarn( "CalculatorDialog::onCompute(): the expression does not use any variable of " +
+                                          m_dataFile->getName() + ".  All values will be the same." );
+
+    NewGEOEASColumn column;
+    column.values = scripting.run();
+    column.name = newVariableName;
+    m_dataFile->addGEOEASColumns( { column } );
+
+    Application::instance()->logInfo( "Variable " + newVariableName + " = " + expression + " added to " +
+                                      m_dataFile->getName() + "." );
+}
@@ -0,0 +1,35 @@
+#ifndef CALCULATORDIALOG_H
+#define CALCULATORDIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class CalculatorDialog;
+}
+
+class DataFile;
+class QListWidgetItem;
+
+/**
+ * The CalculatorDialog lets the user derive a new variable in a data file from an expression over
+ * its variables (e.g. "log10(Cu)*density").  The expression is evaluated by Scripting and the result
+ * is appended to the data file as a new column.
+ */
+class CalculatorDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CalculatorDialog( DataFile* dataFile, QWidget *parent = 0 );
+    ~CalculatorDialog();
+
+private:
+    Ui::CalculatorDialog *ui;
+    DataFile* m_dataFile;
+
+private slots:
+    void onVariableDoubleClicked( QListWidgetItem* item );
+    void onCompute();
+};
+
+#endif // CALCULATORDIALOG_H
@@ -12,13 +12,14 @@
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslibparametersdialog.h"
-#include "gslib/gslib.h"
+#include "geostats/cokriging.h"
 #include "util.h"
 
 #include <QFile>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QLineEdit>
+#include <cmath>
 #include <limits>
 #include <tuple>
 
@@ -31,7 +32,7 @@ CokrigingDialog::CokrigingDialog(QWidget *parent) :
 
     ui->setupUi(this);
 
-    this->setWindowTitle("Cokriging (with cokb3d)");
+    this->setWindowTitle("Cokriging");
 
     //deletes dialog from memory upon user closing it
     this->setAttribute(Qt::WA_DeleteOnClose);
@@ -420,17 +421,113 @@ void CokrigingDialog::onParameters()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
-        m_gpf_cokb3d->save( par_file_path );
+        //the estimation is done in-process
+        if( runCokriging( psInputData, cgColocSec ) )
+            preview();
+    }
+}
+
+bool CokrigingDialog::runCokriging(PointSet *psInputData, CartesianGrid *cgColocSec)
+{
+    //the variogram models must form a LMC
+    Application::instance()->logWarningOff();
+    bool isLMC = true;
+    uint nvars = m_gpf_cokb3d->getParameter<GSLibParUInt*>(1)->_value;
+    for( uint i = 1; i < nvars; ++i )
+        for( uint j = i + 1; j <= nvars; ++j )
+            isLMC = Util::isLMC( getVariogramModel( i, i ), getVariogramModel( j, j ), getVariogramModel( i, j ) ) && isLMC;
+    Application::instance()->logWarningOn();
+    if( ! isLMC ){
+        QMessageBox::critical( this, "Error", "The variograms do not form a LMC.  Please, check the message panel for error messages with the details.");
+        return false;
+    }
+
+    //primary and secondary variables
+    GSLibParMultiValuedVariable *par2 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedVariable*>(2);
+    std::vector<uint> variables;
+    for( uint i = 0; i < nvars; ++i )
+        variables.push_back( par2->getParameter<GSLibParUInt*>(3 + i)->_value );
+    Cokriging ck( psInputData, variables );
+
+    //trimming limits
+    GSLibParMultiValuedFixed *par3 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(3);
+    ck.setTrimmingLimits( par3->getParameter<GSLibParDouble*>(0)->_value,
+                          par3->getParameter<GSLibParDouble*>(1)->_value );
+
+    //the collocated secondary must be in a grid with the same geometry of the estimation grid
+    if( m_gpf_cokb3d->getParameter<GSLibParOption*>(4)->_selected_value == 1 && cgColocSec ){
+        uint column = m_gpf_cokb3d->getParameter<GSLibParUInt*>(6)->_value - 1;
+        cgColocSec->loadData();
+        bool hasNDV = cgColocSec->hasNoDataValue();
+        double NDV = cgColocSec->getNoDataValueAsDouble();
+        std::vector<double> values( cgColocSec->getDataLineCount() );
+        for( uint i = 0; i < values.size(); ++i ){
+            values[i] = cgColocSec->data( i, column );
+            if( hasNDV && Util::almostEqual2sComplement( NDV, values[i], 1 ) )
+                values[i] = std::nan("");
+        }
+        ck.setCollocatedSecondary( values );
+    }
 
-        //to be notified when cokb3d completes.
-        connect( GSLib::instance(), SIGNAL(programFinished()), this, SLOT(onCokb3dCompletes()) );
+    //estimation grid and block discretization
+    GSLibParGrid* par10 = m_gpf_cokb3d->getParameter<GSLibParGrid*>(10);
+    ck.setGridGeometry( par10->_specs_x->getParameter<GSLibParUInt*>(0)->_value,
+                        par10->_specs_y->getParameter<GSLibParUInt*>(0)->_value,
+                        par10->_specs_z->getParameter<GSLibParUInt*>(0)->_value,
+                        par10->_specs_x->getParameter<GSLibParDouble*>(1)->_value,
+                        par10->_specs_y->getParameter<GSLibParDouble*>(1)->_value,
+                        par10->_specs_z->getParameter<GSLibParDouble*>(1)->_value,
+                        par10->_specs_x->getParameter<GSLibParDouble*>(2)->_value,
+                        par10->_specs_y->getParameter<GSLibParDouble*>(2)->_value,
+                        par10->_specs_z->getParameter<GSLibParDouble*>(2)->_value );
+    GSLibParMultiValuedFixed *par11 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(11);
+    ck.setBlockDiscretization( par11->getParameter<GSLibParUInt*>(0)->_value,
+                               par11->getParameter<GSLibParUInt*>(1)->_value,
+                               par11->getParameter<GSLibParUInt*>(2)->_value );
+
+    //search parameters
+    GSLibParMultiValuedFixed *par12 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(12);
+    ck.setNumberOfData( par12->getParameter<GSLibParUInt*>(0)->_value,
+                        par12->getParameter<GSLibParUInt*>(1)->_value,
+                        par12->getParameter<GSLibParUInt*>(2)->_value );
+    GSLibParMultiValuedFixed *par13 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(13);
+    GSLibParMultiValuedFixed *par14 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(14);
+    GSLibParMultiValuedFixed *par15 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedFixed*>(15);
+    ck.setSearchEllipsoids( par13->getParameter<GSLibParDouble*>(0)->_value,
+                            par13->getParameter<GSLibParDouble*>(1)->_value,
+                            par13->getParameter<GSLibParDouble*>(2)->_value,
+                            par14->getParameter<GSLibParDouble*>(0)->_value,
+                            par14->getParameter<GSLibParDouble*>(1)->_value,
+                            par14->getParameter<GSLibParDouble*>(2)->_value,
+                            par15->getParameter<GSLibParDouble*>(0)->_value,
+                            par15->getParameter<GSLibParDouble*>(1)->_value,
+                            par15->getParameter<GSLibParDouble*>(2)->_value );
+
+    //kriging type and means
+    ck.setType( (CokrigingType)m_gpf_cokb3d->getParameter<GSLibParOption*>(16)->_selected_value );
+    GSLibParMultiValuedVariable *par17 = m_gpf_cokb3d->getParameter<GSLibParMultiValuedVariable*>(17);
+    std::vector<double> means;
+    for( uint i = 0; i < nvars; ++i )
+        means.push_back( par17->getParameter<GSLibParDouble*>(i)->_value );
+    ck.setMeans( means );
+
+    //auto and cross variograms
+    GSLibParRepeat *par18 = m_gpf_cokb3d->getParameter<GSLibParRepeat*>(18);
+    for( uint i = 0; i < (uint)m_variograms.count(); ++i ){
+        GSLibParMultiValuedFixed *par18_ii = par18->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        uint head = par18_ii->getParameter<GSLibParUInt*>(0)->_value;
+        uint tail = par18_ii->getParameter<GSLibParUInt*>(1)->_value;
+        ck.setCovarianceModel( head - 1, tail - 1, CovarianceModel( par18->getParameter<GSLibParVModel*>(i, 1) ) );
+    }
 
-        //run cokb3d program asynchronously
-        Application::instance()->logInfo("Starting cokb3d program...");
-        GSLib::instance()->runProgramAsync( "cokb3d", par_file_path );
+    //run and save the results where cokb3d would
+    Application::instance()->logInfo("Starting cokriging...");
+    if( ! ck.run() ){
+        QMessageBox::critical( this, "Error", "Cokriging failed.  Please, check the Output Message panel.");
+        return false;
     }
+    ck.saveInGEOEASFormat( m_gpf_cokb3d->getParameter<GSLibParFile*>(9)->_path );
+    return true;
 }
 
 void CokrigingDialog::onLMCcheck()
@@ -452,14 +549,6 @@ void CokrigingDialog::onLMCcheck()
     Application::instance()->logWarningOn();
 }
 
-void CokrigingDialog::onCokb3dCompletes()
-{
-    //frees all signal connections to the GSLib singleton.
-    GSLib::instance()->disconnect();
-
-    preview();
-}
-
 void CokrigingDialog::onSave()
 {
     save( true );
@@ -478,10 +567,10 @@ void CokrigingDialog::preview()
     //get the tmp file path created by cokb3d with the estimates and kriging variances
     QString grid_file_path = m_gpf_cokb3d->getParameter<GSLibParFile*>(9)->_path;
 
-    //cokb3d may fail to estimate, most of times due to non-LMC variography
+    //the estimation may fail, most of times due to non-LMC variography
     QFile file( grid_file_path );
     if( ! file.exists() ){
-        Application::instance()->logError( "File with estimates not found. Check cokb3d messages." );
+        Application::instance()->logError( "File with estimates not found. Check previous messages." );
         return;
     }
 
@@ -16,6 +16,7 @@ class VariogramModelSelector;
 class GSLibParameterFile;
 class VariogramModel;
 class CartesianGrid;
+class PointSet;
 
 class CokrigingDialog : public QDialog
 {
@@ -46,7 +47,6 @@ private slots:
     void onUpdateVarMatrixLabels();
     void onParameters();
     void onLMCcheck();
-    void onCokb3dCompletes();
     void onSave();
     void onSaveKrigingVariances();
 
@@ -60,6 +60,9 @@ private:
     VariogramModel *getVariogramModel( uint head, uint tail );
     void preview();
     void save( bool estimates );
+    /** Runs cokriging in-process with the current cokb3d parameters and saves the estimates and kriging
+     *  variances to the cokb3d output file.  Returns false if the estimation failed. */
+    bool runCokriging( PointSet* psInputData, CartesianGrid* cgColocSec );
 };
 
 #endif // COKRIGINGDIALOG_H
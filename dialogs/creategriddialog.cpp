@@ -8,14 +8,16 @@
 #include "domain/attribute.h"
 #include "gslib/gslibparams/widgets/widgetgslibpargrid.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
-#include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "util.h"
 #include <QInputDialog>
 #include <math.h>
+#include <cmath>
 #include <QMessageBox>
 #include <QDir>
 #include "domain/variogrammodel.h"
-#include "gslib/gslib.h"
+#include "geostats/averagevariogram.h"
+#include "plotting/distributionplot.h"
+#include <QVBoxLayout>
 
 CreateGridDialog::CreateGridDialog(PointSet *pointSet, QWidget *parent) :
     QDialog(parent),
@@ -96,56 +98,63 @@ void CreateGridDialog::runGammaBar()
         return;
     }
 
-    GSLibParameterFile gpar("gammabar");
-    //set variogram model parameters
-    gpar.setVariogramModel( vm );
-    //set grid cell sizes
-    GSLibParMultiValuedFixed *par0 = gpar.getParameter<GSLibParMultiValuedFixed*>(0);
-    par0->getParameter<GSLibParDouble*>(0)->_value = m_par->_specs_x->getParameter<GSLibParDouble*>(2)->_value;
-    par0->getParameter<GSLibParDouble*>(1)->_value = m_par->_specs_y->getParameter<GSLibParDouble*>(2)->_value;
-    par0->getParameter<GSLibParDouble*>(2)->_value = m_par->_specs_z->getParameter<GSLibParDouble*>(2)->_value;
-    //leave block discretization as one
-    GSLibParMultiValuedFixed *par1 = gpar.getParameter<GSLibParMultiValuedFixed*>(1);
-    par1->getParameter<GSLibParUInt*>(0)->_value = ui->txtBlkDiscrX->text().toInt();
-    par1->getParameter<GSLibParUInt*>(1)->_value = ui->txtBlkDiscrY->text().toInt();
-    par1->getParameter<GSLibParUInt*>(2)->_value = ui->txtBlkDiscrZ->text().toInt();
-
-    //Generate the parameter file
-    //NOTE: due to a buggy input file setting in gammabar, the parameter file must be generated
-    //      in the same directory of the executable and the path is simply the file name, without a path.
-    QString par_file_path = Application::instance()->generateUniqueFilePathInGSLibDir("par");
-    gpar.save( par_file_path );
-
-    //to extract the filename from the path
-    QFileInfo par_fileinfo( par_file_path );
-    par_file_path = par_fileinfo.fileName();
-
-    //run gammabar program
-    //NOTE: do not pass the complete path to gammabar.
-    Application::instance()->logInfo("Starting gammabar program...");
-    GSLib::instance()->runProgram( "gammabar", par_file_path, true );
-
-    //get gammabar output text
-    QString gammabar_out = GSLib::instance()->getLastOutput();
-
-    //parse the gammabar text for the average variogram value
-    QRegularExpression re("average\\s*variogram\\s*=\\s*([^\\s]+)", QRegularExpression::MultilineOption | QRegularExpression::CaseInsensitiveOption );
-    double gamma_value = 0.0;
-    QRegularExpressionMatch match = re.match( gammabar_out );
-    if( match.hasMatch() ){
-        gamma_value = match.captured(1).toDouble();
-    }
+    //compute the average variogram within a grid cell (formerly done by running gammabar)
+    AverageVariogram gammaBar( vm );
+    gammaBar.setBlockDiscretization( ui->txtBlkDiscrX->text().toInt(),
+                                     ui->txtBlkDiscrY->text().toInt(),
+                                     ui->txtBlkDiscrZ->text().toInt() );
+    double gamma_value = gammaBar.compute( m_par->_specs_x->getParameter<GSLibParDouble*>(2)->_value,
+                                           m_par->_specs_y->getParameter<GSLibParDouble*>(2)->_value,
+                                           m_par->_specs_z->getParameter<GSLibParDouble*>(2)->_value );
 
     //compute variance loss due to current grid resolution against the selected variogram model.
-    double variance_loss = gamma_value / vm->getSill() * 100;
+    double variance_loss = gammaBar.getVarianceLoss( gamma_value );
 
     //display result
     ui->lblVarianceLoss->setText("<html><head/><body><p><span style=\" font-weight:600; color:#0000ff;\">Variance Loss = " +
                                  QString::number( variance_loss, 'f', 1) + "%</span></p></body></html>");
+}
+
+void CreateGridDialog::onVarianceLossSweep()
+{
+    //update the variance loss of the current cell size
+    runGammaBar();
+    VariogramModel* vm = m_vModelList->getSelectedVModel();
+    if( !vm )
+        return;
+
+    //the cell sizes evaluated are from a quarter to four times the current ones (keeping the cell proportions)
+    const int nSizes = 41;
+    std::vector<double> factors;
+    for( int i = 0; i < nSizes; ++i )
+        factors.push_back( std::pow( 4.0, -1.0 + 2.0 * i / ( nSizes - 1 ) ) );
+
+    double dx = m_par->_specs_x->getParameter<GSLibParDouble*>(2)->_value;
+    double dy = m_par->_specs_y->getParameter<GSLibParDouble*>(2)->_value;
+    double dz = m_par->_specs_z->getParameter<GSLibParDouble*>(2)->_value;
+    AverageVariogram gammaBar( vm );
+    gammaBar.setBlockDiscretization( ui->txtBlkDiscrX->text().toInt(),
+                                     ui->txtBlkDiscrY->text().toInt(),
+                                     ui->txtBlkDiscrZ->text().toInt() );
+    std::vector<double> gammaValues = gammaBar.computeSweep( dx, dy, dz, factors );
+
+    std::vector<double> cellSizes;
+    std::vector<double> losses;
+    for( int i = 0; i < nSizes; ++i ){
+        cellSizes.push_back( dx * factors[i] );
+        losses.push_back( gammaBar.getVarianceLoss( gammaValues[i] ) );
+    }
 
-    //delete the parameter file generated in the GSLib directory.
-    QFile file( par_fileinfo.absoluteFilePath() );
-    file.remove();
+    //show the curve in a separate window so the user can keep adjusting the grid
+    QDialog* window = new QDialog( this );
+    window->setAttribute( Qt::WA_DeleteOnClose );
+    window->setWindowTitle( "Variance loss x cell size (" + vm->getName() + ")" );
+    window->setLayout( new QVBoxLayout() );
+    DistributionPlot* plot = new DistributionPlot();
+    plot->showVarianceLossCurve( cellSizes, losses, dx );
+    window->layout()->addWidget( plot );
+    window->resize( 600, 450 );
+    window->show();
 }
 
 void CreateGridDialog::createGridAndClose()
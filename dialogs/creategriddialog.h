@@ -29,6 +29,7 @@ private:
 
 private slots:
     void runGammaBar();
+    void onVarianceLossSweep();
     void createGridAndClose();
     void calcN();
     void preview();
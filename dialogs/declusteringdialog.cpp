@@ -8,18 +8,26 @@
 #include "domain/project.h"
 #include "gslib/gslib.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
+#include "geostats/celldeclustering.h"
+#include "geostats/univariatestatistics.h"
+#include "plotting/distributionplot.h"
 #include <cmath>
 #include <QMessageBox>
 #include "filecontentsdialog.h"
 #include "displayplotdialog.h"
 #include <QInputDialog>
+#include <QVBoxLayout>
+#include <QPlainTextEdit>
+#include <QFile>
+#include <QTextStream>
 #include "util.h"
 
 DeclusteringDialog::DeclusteringDialog(Attribute *attribute, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DeclusteringDialog),
     m_attribute( attribute ),
-    m_gpf_declus( nullptr )
+    m_gpf_declus( nullptr ),
+    m_declus( nullptr )
 {
     ui->setupUi(this);
     ui->lblTitle->setText("variable: <font color=\"red\"><b>" + m_attribute->getName() + "</b></color>" );
@@ -42,6 +50,7 @@ DeclusteringDialog::~DeclusteringDialog()
     delete ui;
     if( m_gpf_declus )
         delete m_gpf_declus;
+    delete m_declus;
     Application::instance()->logInfo("Declustering dialog destroyed.");
 }
 
@@ -112,183 +121,171 @@ void DeclusteringDialog::onDeclus()
     GSLibParametersDialog gslibpardiag ( m_gpf_declus );
     int result = gslibpardiag.exec();
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-        m_gpf_declus->save( par_file_path );
-        //run declus program
-        Application::instance()->logInfo("Starting declus program...");
-        GSLib::instance()->runProgram( "declus", par_file_path );
+        //compute the declustering in-process with the parameters entered by the user
+        CellDeclustering* declus = new CellDeclustering( m_attribute );
+        GSLibParMultiValuedFixed* par2 = m_gpf_declus->getParameter<GSLibParMultiValuedFixed*>(2);
+        declus->setTrimmingLimits( par2->getParameter<GSLibParDouble*>(0)->_value,
+                                   par2->getParameter<GSLibParDouble*>(1)->_value );
+        GSLibParMultiValuedFixed* par5 = m_gpf_declus->getParameter<GSLibParMultiValuedFixed*>(5);
+        declus->setCellAnisotropy( par5->getParameter<GSLibParDouble*>(0)->_value,
+                                   par5->getParameter<GSLibParDouble*>(1)->_value );
+        declus->setLookForMaximum( m_gpf_declus->getParameter<GSLibParOption*>(6)->_selected_value == 1 );
+        GSLibParMultiValuedFixed* par7 = m_gpf_declus->getParameter<GSLibParMultiValuedFixed*>(7);
+        declus->setCellSizes( par7->getParameter<GSLibParUInt*>(0)->_value,
+                              par7->getParameter<GSLibParDouble*>(1)->_value,
+                              par7->getParameter<GSLibParDouble*>(2)->_value );
+        declus->setNumberOfOriginOffsets( m_gpf_declus->getParameter<GSLibParUInt*>(8)->_value );
+        if( ! declus->run() ){
+            delete declus;
+            QMessageBox::critical( this, "Error", "There are no valid data to decluster.");
+            return;
+        }
+        delete m_declus;
+        m_declus = declus;
+        onViewSummary();
     } else {
         delete m_gpf_declus;
         m_gpf_declus = nullptr;
     }
 }
 
+void DeclusteringDialog::showWindow(QWidget *content, const QString title)
+{
+    QDialog* window = new QDialog( this );
+    window->setAttribute( Qt::WA_DeleteOnClose );
+    window->setWindowTitle( title );
+    window->setLayout( new QVBoxLayout() );
+    window->layout()->addWidget( content );
+    window->resize( 600, 450 );
+    window->show();
+}
+
 void DeclusteringDialog::onViewSummary()
 {
-    if( ! m_gpf_declus ){
+    if( ! m_declus ){
         QMessageBox::critical( this, "Error", "You must first compute the declustering at least once.");
         return;
     }
-    FileContentsDialog fcd( this, m_gpf_declus->getParameter<GSLibParFile*>(3)->_path, "Declustering summary");
-    fcd.exec();
+    //the declustered mean versus cell size curve along with the summary text
+    QWidget* content = new QWidget();
+    content->setLayout( new QVBoxLayout() );
+    DistributionPlot* plot = new DistributionPlot();
+    plot->showDeclusteringCurve( m_declus->getCellSizes(), m_declus->getDeclusteredMeans(),
+                                 m_declus->getOptimalCellSize(), m_declus->getNaiveMean(), m_attribute->getName() );
+    content->layout()->addWidget( plot );
+    QPlainTextEdit* txtSummary = new QPlainTextEdit( m_declus->getSummary() );
+    txtSummary->setReadOnly( true );
+    content->layout()->addWidget( txtSummary );
+    showWindow( content, "Declustering summary" );
 }
 
 void DeclusteringDialog::onHistogram()
 {
-    if( ! m_gpf_declus ){
+    if( ! m_declus ){
         QMessageBox::critical( this, "Error", "You must first compute the declustering at least once.");
         return;
     }
 
-    PointSet* original_data_file = (PointSet*)m_attribute->getContainingFile();
-
-
-    //parse and get input data file
-    //the resulting file of declus is a point set
-    PointSet* input_data_file = new PointSet( m_gpf_declus->getParameter<GSLibParFile*>(4)->_path );
-    input_data_file->setInfo( original_data_file->getXindex(),
-                              original_data_file->getYindex(),
-                              original_data_file->getZindex(),
-                              "-999");
-
-    //load file data.
-    input_data_file->loadData();
-
-    //get the variable index
-    uint var_index = input_data_file->getFieldGEOEASIndex( m_attribute->getName() );
+    PointSet* data_file = (PointSet*)m_attribute->getContainingFile();
 
-    //declus always puts the new computed weights as the last column
-    uint declus_weight_index = input_data_file->getLastFieldGEOEASIndex();
+    //get the values (lines without weight are skipped along with their NaN weights)
+    data_file->loadData();
+    uint var_index = data_file->getFieldGEOEASIndex( m_attribute->getName() );
+    long nLines = data_file->getDataLineCount();
+    std::vector<double> values( nLines );
+    for( long iLine = 0; iLine < nLines; ++iLine )
+        values[iLine] = data_file->data( iLine, var_index-1 );
 
     //make plot/window title
-    QString title = input_data_file->getName();
+    QString title = data_file->getName();
     title.append("/");
     title.append(m_attribute->getName());
     title.append(" declustered histogram");
 
-    //Construct an object composition based on the parameter file template for the hisplt program.
-    GSLibParameterFile gpf( "histplt" );
-
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf.setDefaultValues();
-
-    //get the maximum and minimun of selected variable, excluding no-data value
-    double data_min = input_data_file->min( var_index-1 );
-    double data_max = input_data_file->max( var_index-1 );
-
-    //----------------set the minimum required histplt paramaters-----------------------
-    //input parameters (input file, variable and trimming limits)
-    GSLibParInputData* par0;
-    par0 = gpf.getParameter<GSLibParInputData*>(0);
-    par0->_file_with_data._path = input_data_file->getPath();
-    par0->_var_wgt_pairs.first()->_var_index = var_index;
-    par0->_var_wgt_pairs.first()->_wgt_index = declus_weight_index;
-    par0->_trimming_limits._min = data_min - fabs( data_min/100.0 );
-    par0->_trimming_limits._max = data_max + fabs( data_max/100.0 );
-
-    //postscript file
-    gpf.getParameter<GSLibParFile*>(1)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //plot title
-    gpf.getParameter<GSLibParString*>(9)->_value = title;
+    UnivariateStatistics stats( values, m_declus->getWeights(), m_attribute->getName() );
+    stats.compute();
 
-    //reference value for the box plot
-    gpf.getParameter<GSLibParDouble*>(11)->_value = input_data_file->mean( var_index-1 );
-    //----------------------------------------------------------------------------------
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run histplt program
-    Application::instance()->logInfo("Starting histplt program...");
-    GSLib::instance()->runProgram( "histplt", par_file_path );
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(1)->_path, title, gpf, this);
-    dpd->show(); //show() makes dialog modalless
-
-    //discard the locally constructed PointSet object
-    delete input_data_file;
+    DistributionPlot* plot = new DistributionPlot();
+    double min, max;
+    Util::assureNonZeroWindow( min, max, stats.getMin(), stats.getMax() );
+    plot->showHistogram( stats, 30, min, max, m_attribute->getName() );
+    showWindow( plot, title );
 }
 
 void DeclusteringDialog::onSave()
 {
-    if( ! m_gpf_declus ){
+    if( ! m_declus ){
         QMessageBox::critical( this, "Error", "You must first compute the declustering at least once.");
         return;
     }
 
-    //get the original Point Set file before declustering
+    //get the original Point Set file
     PointSet* original_data_file = (PointSet*)m_attribute->getContainingFile();
 
-    //get the Point Set resulted from declustering
-    PointSet* input_data_file = new PointSet( m_gpf_declus->getParameter<GSLibParFile*>(4)->_path );
-    input_data_file->setInfo( original_data_file->getXindex(),
-                              original_data_file->getYindex(),
-                              original_data_file->getZindex(),
-                              "-999");
-
-    //declus writes the declustering weights variable as the last one in the Point Set
-    ProjectComponent* pc = input_data_file->getChildByIndex( input_data_file->getChildCount()-1 );
-
-    //get the name generated by declus
-    QString last_attr_name = pc->getName();
-
-    //presents a dialog so the user can change the default name given by declus.
+    //presents a dialog so the user can change the default name.
     bool ok;
     QString proposed_name(m_attribute->getName());
     proposed_name = proposed_name.append("_wgt");
-    QString new_var_name = QInputDialog::getText(this, "Rename declustering weight variable",
+    QString new_var_name = QInputDialog::getText(this, "Name the declustering weight variable",
                                              "New variable name:", QLineEdit::Normal,
                                              proposed_name, &ok);
     if (ok && !new_var_name.isEmpty()){
-        //renames the new variable names in the physical file.
-        Util::renameGEOEASvariable( input_data_file->getPath(), last_attr_name, new_var_name );
         //get the variable index in the GEO-EAS file
         uint indexGEOEASvariable = original_data_file->getFieldGEOEASIndex( m_attribute->getName() );
-        //get the weight index in the GEO-EAS file
-        uint indexGEOEASweight = input_data_file->getFieldGEOEASIndex( new_var_name );
-        //sets the variable-weight relationship
+        //the weight will be the last variable in the GEO-EAS file
+        uint indexGEOEASweight = original_data_file->getFieldNames().size() + 1;
+        //sets the variable-weight relationship before the column is added, so the new
+        //variable appears as a weight of the original one when the project tree is rebuilt
         original_data_file->addVariableWeightRelationship( indexGEOEASvariable, indexGEOEASweight );
-        //replaces the PointSet's physical file with the generated one.
-        original_data_file->replacePhysicalFile( input_data_file->getPath() );
+        //append the weights to the point set
+        NewGEOEASColumn column;
+        column.values = m_declus->getWeights();
+        column.name = new_var_name;
+        original_data_file->addGEOEASColumns( { column } );
     }
 }
 
 void DeclusteringDialog::onLocmap()
 {
 
-    if( ! m_gpf_declus ){
+    if( ! m_declus ){
         QMessageBox::critical( this, "Error", "You must first compute the declustering at least once.");
         return;
     }
 
     //get input data file
-    //assumes the file is a Point Set, since declus works on point sets
+    //assumes the file is a Point Set, since declustering works on point sets
     PointSet* original_data_file = (PointSet*)m_attribute->getContainingFile();
-
-    //parse and get input data file
-    //the resulting file of declus is a point set
-    PointSet* input_data_file = new PointSet( m_gpf_declus->getParameter<GSLibParFile*>(4)->_path );
-    input_data_file->setInfo( original_data_file->getXindex(),
-                              original_data_file->getYindex(),
-                              original_data_file->getZindex(),
-                              "-999");
+    original_data_file->loadData();
+
+    //locmap needs a file: write the coordinates and the weights to a temporary point set
+    QString tmp_path = Application::instance()->getProject()->generateUniqueTmpFilePath("dat");
+    {
+        QFile file( tmp_path );
+        file.open( QFile::WriteOnly | QFile::Text );
+        QTextStream out( &file );
+        out << "Declustering weights of " << m_attribute->getName() << '\n';
+        out << "3\nX\nY\nweight\n";
+        const std::vector<double>& weights = m_declus->getWeights();
+        for( size_t iLine = 0; iLine < weights.size(); ++iLine ){
+            if( std::isnan( weights[iLine] ) )
+                continue;
+            out << QString::number( original_data_file->data( iLine, original_data_file->getXindex()-1 ), 'g', 12 ) << '\t'
+                << QString::number( original_data_file->data( iLine, original_data_file->getYindex()-1 ), 'g', 12 ) << '\t'
+                << QString::number( weights[iLine], 'g', 8 ) << '\n';
+        }
+    }
+    PointSet* input_data_file = new PointSet( tmp_path );
+    input_data_file->setInfo( 1, 2, 0, "-999" );
 
     //loads data in file, because it's necessary.
     input_data_file->loadData();
 
-    //get the variable index in parent data file
-    //declus always puts the new computed weights as the last column
-    ProjectComponent* pc = input_data_file->getChildByIndex( input_data_file->getChildCount()-1 );
-    QString last_attr_name = pc->getName();
-    uint var_index = input_data_file->getFieldGEOEASIndex( last_attr_name );
+    //the weights are the third variable
+    uint var_index = 3;
 
     //make plot/window title
-    QString title = input_data_file->getName();
+    QString title = original_data_file->getName();
     title.append("/");
     title.append(m_attribute->getName());
     title.append(" declust. weights map");
@@ -353,4 +350,7 @@ void DeclusteringDialog::onLocmap()
     //display the plot output
     DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(3)->_path, title, gpf, this);
     dpd->show(); //show() makes dialog modalless
+
+    //discard the locally constructed PointSet object
+    delete input_data_file;
 }
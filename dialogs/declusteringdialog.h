@@ -9,7 +9,12 @@ class DeclusteringDialog;
 
 class Attribute;
 class GSLibParameterFile;
+class CellDeclustering;
 
+/**
+ * The DeclusteringDialog computes cell declustering weights for a point set variable.  The parameters are entered
+ * in the form of the GSLib program declus, but the computation is done in-process by CellDeclustering.
+ */
 class DeclusteringDialog : public QDialog
 {
     Q_OBJECT
@@ -22,6 +27,10 @@ private:
     Ui::DeclusteringDialog *ui;
     Attribute* m_attribute;
     GSLibParameterFile* m_gpf_declus;
+    CellDeclustering* m_declus;
+
+    /** Shows a non-modal window with the given widget. */
+    void showWindow( QWidget* content, const QString title );
 
 private slots:
     void onDeclus();
@@ -4,24 +4,28 @@
 #include "domain/attribute.h"
 #include "domain/project.h"
 #include "domain/file.h"
+#include "domain/datafile.h"
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "domain/application.h"
 #include "gslib/gslibparametersdialog.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
-#include "gslib/gslib.h"
-#include "displayplotdialog.h"
-#include "distributioncolumnrolesdialog.h"
+#include "geostats/distributionsmoother.h"
+#include "geostats/univariatestatistics.h"
+#include "plotting/distributionplot.h"
 #include "util.h"
 
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QLineEdit>
+#include <QVBoxLayout>
+#include <QThread>
 
 DistributionModelingDialog::DistributionModelingDialog(Attribute *at, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::DistributionModelingDialog),
     m_gpf_histsmth( nullptr ),
-    m_attribute( at )
+    m_attribute( at ),
+    m_smoother( nullptr )
 {
     ui->setupUi(this);
 
@@ -43,6 +47,8 @@ DistributionModelingDialog::~DistributionModelingDialog()
 {
     if( m_gpf_histsmth )
         delete m_gpf_histsmth;
+    if( m_smoother )
+        delete m_smoother;
     delete ui;
     Application::instance()->logInfo( "DistributionModelingDialog destroyed." );
 }
@@ -81,47 +87,112 @@ void DistributionModelingDialog::onParameters()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
-        m_gpf_histsmth->save( par_file_path );
-
-        //to be notified when histsmth completes.
-        connect( GSLib::instance(), SIGNAL(programFinished()), this, SLOT(onHistsmthCompletion()) );
-
-        //run histsmth program
-        Application::instance()->logInfo("Starting histsmth program...");
-        GSLib::instance()->runProgramAsync( "histsmth", par_file_path );
+        if( runSmoothing() )
+            onPlot();
     }
 }
 
-void DistributionModelingDialog::onHistsmthCompletion()
+bool DistributionModelingDialog::runSmoothing()
 {
-    //frees all signal connections to the GSLib singleton.
-    GSLib::instance()->disconnect();
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(m_gpf_histsmth->getParameter<GSLibParFile*>(2)->_path,
-                                                   m_gpf_histsmth->getParameter<GSLibParString*>(1)->_value,
-                                                   *m_gpf_histsmth,
-                                                   this);
-    //show dialog non-modally
-    dpd->show();
+    DataFile* dataFile = (DataFile*)m_attribute->getContainingFile();
+    GSLibParInputData* par0 = m_gpf_histsmth->getParameter<GSLibParInputData*>(0);
+
+    DistributionSmoother* smoother = new DistributionSmoother();
+    smoother->setData( dataFile,
+                       par0->_var_wgt_pairs[0]->_var_index,
+                       par0->_var_wgt_pairs[0]->_wgt_index,
+                       par0->getLowerTrimmingLimit(),
+                       par0->getUpperTrimmingLimit() );
+
+    GSLibParMultiValuedFixed *par5 = m_gpf_histsmth->getParameter<GSLibParMultiValuedFixed*>(5);
+    smoother->setValues( par5->getParameter<GSLibParUInt*>(0)->_value,
+                         par5->getParameter<GSLibParDouble*>(1)->_value,
+                         par5->getParameter<GSLibParDouble*>(2)->_value,
+                         m_gpf_histsmth->getParameter<GSLibParOption*>(6)->_selected_value == 1 );
+
+    GSLibParMultiValuedFixed *par7 = m_gpf_histsmth->getParameter<GSLibParMultiValuedFixed*>(7);
+    smoother->setMaxPerturbations( par7->getParameter<GSLibParDouble*>(0)->_value );
+    smoother->setReportingInterval( par7->getParameter<GSLibParDouble*>(1)->_value );
+    smoother->setMinObjective( par7->getParameter<GSLibParDouble*>(2)->_value );
+    smoother->setSeed( par7->getParameter<GSLibParUInt*>(3)->_value );
+
+    GSLibParMultiValuedFixed *par8 = m_gpf_histsmth->getParameter<GSLibParMultiValuedFixed*>(8);
+    smoother->setComponents( par8->getParameter<GSLibParOption*>(0)->_selected_value == 1,
+                             par8->getParameter<GSLibParOption*>(1)->_selected_value == 1,
+                             par8->getParameter<GSLibParOption*>(2)->_selected_value == 1,
+                             par8->getParameter<GSLibParOption*>(3)->_selected_value == 1 );
+    GSLibParMultiValuedFixed *par9 = m_gpf_histsmth->getParameter<GSLibParMultiValuedFixed*>(9);
+    smoother->setComponentWeights( par9->getParameter<GSLibParDouble*>(0)->_value,
+                                   par9->getParameter<GSLibParDouble*>(1)->_value,
+                                   par9->getParameter<GSLibParDouble*>(2)->_value,
+                                   par9->getParameter<GSLibParDouble*>(3)->_value );
+
+    smoother->setSmoothingWindow( m_gpf_histsmth->getParameter<GSLibParDouble*>(10)->_value );
+
+    GSLibParMultiValuedFixed *par11 = m_gpf_histsmth->getParameter<GSLibParMultiValuedFixed*>(11);
+    smoother->setTargetMeanAndVariance( par11->getParameter<GSLibParDouble*>(0)->_value,
+                                        par11->getParameter<GSLibParDouble*>(1)->_value );
+
+    smoother->setNumberOfDataQuantiles( m_gpf_histsmth->getParameter<GSLibParUInt*>(12)->_value );
+    uint nUserQuantiles = m_gpf_histsmth->getParameter<GSLibParUInt*>(13)->_value;
+    GSLibParRepeat *par14 = m_gpf_histsmth->getParameter<GSLibParRepeat*>(14);
+    for( uint i = 0; i < nUserQuantiles; ++i ){
+        GSLibParMultiValuedFixed *par14_i = par14->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        smoother->addUserQuantile( par14_i->getParameter<GSLibParDouble*>(0)->_value,
+                                   par14_i->getParameter<GSLibParDouble*>(1)->_value );
+    }
+
+    //the replicas are annealed in parallel, so there is one per core
+    smoother->setNumberOfReplicas( QThread::idealThreadCount() );
+
+    if( ! smoother->run() ){
+        delete smoother;
+        QMessageBox::critical( this, "Error", "Distribution modeling failed.  Check the messages panel for details." );
+        return false;
+    }
+    if( m_smoother )
+        delete m_smoother;
+    m_smoother = smoother;
+
+    //save the distribution model to the file given in the parameters
+    m_smoother->saveInGEOEASFormat( m_gpf_histsmth->getParameter<GSLibParFile*>(4)->_path,
+                                    m_gpf_histsmth->getParameter<GSLibParString*>(1)->_value );
+    return true;
 }
 
 void DistributionModelingDialog::onPlot()
 {
-    if( m_gpf_histsmth )
-        onHistsmthCompletion();
-    else
-        QMessageBox::critical(this, "Error", QString("You must run histsmth at least once."));
+    if( ! m_smoother ){
+        QMessageBox::critical(this, "Error", QString("You must model the distribution at least once."));
+        return;
+    }
+
+    //the data histogram against the distribution model
+    GSLibParInputData* par0 = m_gpf_histsmth->getParameter<GSLibParInputData*>(0);
+    DataFile* dataFile = (DataFile*)m_attribute->getContainingFile();
+    uint weightIndex = par0->_var_wgt_pairs[0]->_wgt_index;
+    UnivariateStatistics stats( m_attribute, weightIndex > 0 ? dataFile->getAttributeFromGEOEASIndex( weightIndex ) : nullptr );
+    stats.setTrimmingLimits( par0->getLowerTrimmingLimit(), par0->getUpperTrimmingLimit() );
+    stats.compute();
+
+    QDialog* dialog = new QDialog( this );
+    dialog->setAttribute( Qt::WA_DeleteOnClose );
+    dialog->setWindowTitle( m_gpf_histsmth->getParameter<GSLibParString*>(1)->_value );
+    dialog->setLayout( new QVBoxLayout() );
+    DistributionPlot* plot = new DistributionPlot();
+    dialog->layout()->addWidget( plot );
+    plot->showDistributionModel( stats, m_smoother->getValues(), m_smoother->getProbabilities(),
+                                 m_gpf_histsmth->getParameter<GSLibParUInt*>(3)->_value, m_attribute->getName() );
+    dialog->resize( 600, 450 );
+    dialog->show();
 }
 
 void DistributionModelingDialog::onSave()
 {
-    if( !m_gpf_histsmth ){
-        QMessageBox::critical( this, "Error", QString("You must run histsmth at least once."));
+    if( ! m_smoother ){
+        QMessageBox::critical( this, "Error", QString("You must model the distribution at least once."));
         return;
     }
 
-    Util::importUnivariateDistribution( m_attribute, m_gpf_histsmth->getParameter<GSLibParFile*>(4)->_path, this );
+    Util::importUnivariateDistribution( m_attribute, m_gpf_histsmth->getParameter<GSLibParFile*>(4)->_path, this, false );
 }
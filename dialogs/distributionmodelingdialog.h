@@ -5,6 +5,7 @@
 
 class Attribute;
 class GSLibParameterFile;
+class DistributionSmoother;
 
 namespace Ui {
 class DistributionModelingDialog;
@@ -22,10 +23,14 @@ private:
     Ui::DistributionModelingDialog *ui;
     GSLibParameterFile* m_gpf_histsmth;
     Attribute * m_attribute;
+    DistributionSmoother* m_smoother;
+
+    /** Runs the distribution modeling in-process with the histsmth parameters and saves the result in
+     *  the file given in the parameters.  Returns false on failure. */
+    bool runSmoothing();
 
 private slots:
     void onParameters();
-    void onHistsmthCompletion();
     void onPlot();
     void onSave();
 };
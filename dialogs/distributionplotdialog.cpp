@@ -0,0 +1,268 @@
+#include "distributionplotdialog.h"
+#include "ui_distributionplotdialog.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/cartesiangrid.h"
+#include "domain/file.h"
+#include "domain/weight.h"
+#include "geostats/univariatestatistics.h"
+#include "geostats/ensemblestatistics.h"
+#include "plotting/distributionplot.h"
+#include "util.h"
+
+#include <QFileDialog>
+#include <QElapsedTimer>
+#include <algorithm>
+
+DistributionPlotDialog::DistributionPlotDialog(Attribute *at, DistributionPlotType type, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DistributionPlotDialog),
+    m_at( at ),
+    m_at2( nullptr ),
+    m_type( type ),
+    m_plot( nullptr ),
+    m_stats( nullptr ),
+    m_stats2( nullptr ),
+    m_ensemble( nullptr ),
+    m_realization( 0 )
+{
+    init();
+}
+
+DistributionPlotDialog::DistributionPlotDialog(Attribute *atX, Attribute *atY, DistributionPlotType type, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DistributionPlotDialog),
+    m_at( atX ),
+    m_at2( atY ),
+    m_type( type ),
+    m_plot( nullptr ),
+    m_stats( nullptr ),
+    m_stats2( nullptr ),
+    m_ensemble( nullptr ),
+    m_realization( 0 )
+{
+    init();
+}
+
+DistributionPlotDialog::DistributionPlotDialog(Attribute *at, uint realization, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::DistributionPlotDialog),
+    m_at( at ),
+    m_at2( nullptr ),
+    m_type( DistributionPlotType::HISTOGRAM ),
+    m_plot( nullptr ),
+    m_stats( nullptr ),
+    m_stats2( nullptr ),
+    m_ensemble( nullptr ),
+    m_realization( realization )
+{
+    init();
+}
+
+DistributionPlotDialog::~DistributionPlotDialog()
+{
+    delete m_stats;
+    delete m_stats2;
+    delete m_ensemble;
+    delete ui;
+}
+
+void DistributionPlotDialog::init()
+{
+    ui->setupUi(this);
+
+    //deletes dialog from memory upon user closing it
+    this->setAttribute(Qt::WA_DeleteOnClose);
+
+    //make window title
+    QString title = m_at->getContainingFile()->getName() + "/" + m_at->getName();
+    switch( m_type ){
+        case DistributionPlotType::HISTOGRAM: title += " histogram"; break;
+        case DistributionPlotType::PROBABILITY: title += " probability plot"; break;
+        case DistributionPlotType::QQ:
+            title = "Q-Q/P-P plot " + title + " X " + m_at2->getContainingFile()->getName() + "/" + m_at2->getName();
+            break;
+        case DistributionPlotType::REALIZATIONS: title += ": realizations"; break;
+    }
+    if( m_realization > 0 )
+        title += " (realization " + QString::number( m_realization ) + ")";
+    setWindowTitle( title );
+
+    //add the plot widget (not originally present in .UI file)
+    m_plot = new DistributionPlot();
+    ui->frmPlot->layout()->addWidget( m_plot );
+
+    //show only the controls pertinent to the plot type
+    bool isQQ = m_type == DistributionPlotType::QQ;
+    bool isRealizations = m_type == DistributionPlotType::REALIZATIONS;
+    ui->lblBins->setVisible( m_type == DistributionPlotType::HISTOGRAM );
+    ui->spinBins->setVisible( m_type == DistributionPlotType::HISTOGRAM );
+    ui->chkLogScale->setVisible( m_type == DistributionPlotType::PROBABILITY );
+    ui->cmbQQPP->setVisible( isQQ );
+    ui->lblWeight->setVisible( ! isRealizations ); //realizations are in grids, which do not have weights
+    ui->cmbWeight->setVisible( ! isRealizations );
+    ui->lblWeight2->setVisible( isQQ || ( isRealizations && m_at2 ) );
+    ui->cmbWeight2->setVisible( isQQ || ( isRealizations && m_at2 ) );
+    if( isQQ )
+        ui->lblWeight->setText( "Weight (X):" );
+    if( isRealizations )
+        ui->lblWeight2->setText( "Weight (reference):" );
+    ui->btnGSLibPlot->setVisible( m_realization == 0 );
+
+    fillWeightsComboBox( ui->cmbWeight, m_at );
+    if( m_at2 )
+        fillWeightsComboBox( ui->cmbWeight2, m_at2 );
+
+    connect( ui->cmbWeight, SIGNAL(currentIndexChanged(int)), this, SLOT(onRecompute()) );
+    connect( ui->cmbWeight2, SIGNAL(currentIndexChanged(int)), this, SLOT(onRecompute()) );
+    connect( ui->spinBins, SIGNAL(valueChanged(int)), this, SLOT(onReplot()) );
+    connect( ui->chkLogScale, SIGNAL(toggled(bool)), this, SLOT(onReplot()) );
+    connect( ui->cmbQQPP, SIGNAL(currentIndexChanged(int)), this, SLOT(onReplot()) );
+    connect( ui->btnSaveImage, SIGNAL(clicked()), this, SLOT(onSaveImage()) );
+    connect( ui->btnGSLibPlot, SIGNAL(clicked()), this, SLOT(onGSLibPlot()) );
+
+    if( Util::getDisplayResolutionClass() == DisplayResolution::HIGH_DPI ){
+        ui->btnSaveImage->setIcon( QIcon(":icons32/snapshot32") );
+        ui->btnGSLibPlot->setIcon( QIcon(":icons32/plot32") );
+    }
+
+    onRecompute();
+}
+
+void DistributionPlotDialog::fillWeightsComboBox(QComboBox *cmb, Attribute *at)
+{
+    cmb->addItem( "none", -1 );
+    //declustering weights are represented as children of the variable they refer to
+    for( int i = 0; i < at->getChildCount(); ++i ){
+        Weight* weight = dynamic_cast<Weight*>( at->getChildByIndex( i ) );
+        if( weight )
+            cmb->addItem( weight->getIcon(), weight->getName(), i );
+    }
+}
+
+Attribute *DistributionPlotDialog::getSelectedWeight(QComboBox *cmb, Attribute *at)
+{
+    int childIndex = cmb->currentData().toInt();
+    if( childIndex < 0 )
+        return nullptr;
+    return (Attribute*)at->getChildByIndex( childIndex );
+}
+
+void DistributionPlotDialog::onRecompute()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QString summary;
+
+    if( m_type == DistributionPlotType::REALIZATIONS ){
+        //the realizations are read only once (changing the weight of the reference does not affect them)
+        if( ! m_ensemble ){
+            m_ensemble = new EnsembleStatistics( m_at );
+            //only the distributions of the realizations are needed, not the per-cell statistics
+            m_ensemble->setComputeCellStatistics( false );
+            m_ensemble->run();
+        }
+        const std::vector<RealizationSummary>& summaries = m_ensemble->getRealizationSummaries();
+        double meanOfMeans = 0.0;
+        double meanOfVariances = 0.0;
+        for( const RealizationSummary& realization : summaries ){
+            meanOfMeans += realization.mean / summaries.size();
+            meanOfVariances += realization.variance / summaries.size();
+        }
+        summary = "Realizations: " + QString::number( summaries.size() ) + "\n" +
+                  "Average mean: " + QString::number( meanOfMeans ) + "\n" +
+                  "Average variance: " + QString::number( meanOfVariances ) + "\n";
+        for( size_t iReal = 0; iReal < summaries.size(); ++iReal )
+            summary += "\n#" + QString::number( iReal + 1 ) + ": mean=" + QString::number( summaries[iReal].mean ) +
+                       " var.=" + QString::number( summaries[iReal].variance );
+    } else {
+        delete m_stats;
+        m_stats = new UnivariateStatistics( m_at, getSelectedWeight( ui->cmbWeight, m_at ) );
+        //the data page of the grid is set to the realization only while its statistics are computed
+        CartesianGrid* cg = (CartesianGrid*)m_at->getContainingFile();
+        if( m_realization > 0 )
+            cg->setDataPageToRealization( m_realization - 1 );
+        m_stats->compute();
+        if( m_realization > 0 )
+            cg->setDataPageToAll();
+        summary = m_stats->getSummary();
+    }
+
+    if( m_at2 ){
+        delete m_stats2;
+        m_stats2 = new UnivariateStatistics( m_at2, getSelectedWeight( ui->cmbWeight2, m_at2 ) );
+        m_stats2->compute();
+        if( m_type == DistributionPlotType::QQ )
+            summary = "X: " + m_at->getName() + "\n" + summary + "\n\nY: " + m_at2->getName() + "\n" + m_stats2->getSummary();
+        else
+            summary = "Reference: " + m_at2->getName() + "\n" + m_stats2->getSummary() + "\n\n" + summary;
+    }
+
+    ui->txtSummary->setPlainText( summary );
+
+    Application::instance()->logInfo( "DistributionPlotDialog::onRecompute(): statistics computed in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+
+    onReplot();
+}
+
+void DistributionPlotDialog::onReplot()
+{
+    switch( m_type ){
+    case DistributionPlotType::HISTOGRAM:
+        {
+            double min, max;
+            Util::assureNonZeroWindow( min, max, m_stats->getMin(), m_stats->getMax() );
+            m_plot->showHistogram( *m_stats, ui->spinBins->value(), min, max, m_at->getName() );
+        }
+        break;
+    case DistributionPlotType::PROBABILITY:
+        m_plot->showProbabilityPlot( *m_stats, ui->chkLogScale->isChecked(), m_at->getName() );
+        break;
+    case DistributionPlotType::QQ:
+        {
+            std::vector<double> x, y;
+            if( ui->cmbQQPP->currentIndex() == 0 ){
+                //the number of quantiles is that of the smallest data set, up to 1000
+                long nQuantiles = std::min( 1000L, std::min( m_stats->getCount(), m_stats2->getCount() ) );
+                UnivariateStatistics::makeQQ( *m_stats, *m_stats2, nQuantiles, x, y );
+                m_plot->showQQPlot( x, y, m_at->getName(), m_at2->getName() );
+            } else {
+                UnivariateStatistics::makePP( *m_stats, *m_stats2, 200, x, y );
+                m_plot->showQQPlot( x, y, "Cumulative probability (" + m_at->getName() + ")",
+                                          "Cumulative probability (" + m_at2->getName() + ")" );
+            }
+        }
+        break;
+    case DistributionPlotType::REALIZATIONS:
+        {
+            std::vector< std::vector<double> > quantiles;
+            for( const RealizationSummary& realization : m_ensemble->getRealizationSummaries() )
+                quantiles.push_back( realization.quantiles );
+            m_plot->showCDFs( quantiles, EnsembleStatistics::getCDFProbabilities(), m_stats2, m_at->getName() );
+        }
+        break;
+    }
+}
+
+void DistributionPlotDialog::onSaveImage()
+{
+    QString path = QFileDialog::getSaveFileName( this, "Save plot image", Util::getLastBrowsedDirectory(),
+                                                 "PNG image (*.png)" );
+    if( path.isEmpty() )
+        return;
+    Util::saveLastBrowsedDirectoryOfFile( path );
+    m_plot->grab().save( path, "PNG" );
+}
+
+void DistributionPlotDialog::onGSLibPlot()
+{
+    switch( m_type ){
+        case DistributionPlotType::HISTOGRAM: Util::viewHistogramWithHistplt( m_at, this ); break;
+        case DistributionPlotType::PROBABILITY: Util::viewProbabilityPlotWithProbplt( m_at, this ); break;
+        case DistributionPlotType::QQ: Util::viewQQPlotWithQpplt( m_at, m_at2, this ); break;
+        case DistributionPlotType::REALIZATIONS: Util::viewRealizationsHistogramsWithHistpltsim( m_at, m_at2, this ); break;
+    }
+}
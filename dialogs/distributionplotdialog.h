@@ -0,0 +1,83 @@
+#ifndef DISTRIBUTIONPLOTDIALOG_H
+#define DISTRIBUTIONPLOTDIALOG_H
+
+#include <QDialog>
+
+namespace Ui {
+class DistributionPlotDialog;
+}
+
+class Attribute;
+class QComboBox;
+class DistributionPlot;
+class UnivariateStatistics;
+class EnsembleStatistics;
+
+/*! The types of plots of univariate distributions. */
+enum class DistributionPlotType : unsigned {
+    HISTOGRAM = 0, /*!< Histogram with cumulative frequency curve. */
+    PROBABILITY,   /*!< Probability plot (Gaussian probability scale). */
+    QQ,            /*!< Q-Q or P-P plot of two distributions. */
+    REALIZATIONS   /*!< Cumulative distributions of the realizations of a simulated variable. */
+};
+
+/**
+ * The DistributionPlotDialog displays histograms, probability plots, Q-Q/P-P plots and distributions of realizations
+ * computed in-process by UnivariateStatistics and EnsembleStatistics and rendered with Qwt, so it works without GSLib
+ * or Ghostscript.  Since the statistics are computed only once, changing the number of classes or the scale does not
+ * re-read the data.
+ * The user can still open the GSLib plot (histplt, probplt, qpplt or histpltsim) from this dialog.
+ */
+class DistributionPlotDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /** Constructor for the histogram or the probability plot of a variable. */
+    explicit DistributionPlotDialog( Attribute* at, DistributionPlotType type, QWidget *parent = 0 );
+
+    /** Constructor for the Q-Q/P-P plot of two variables or for the distributions of the realizations
+     * of a simulated variable in a grid (atX) against an optional reference distribution (atY, may be null).
+     */
+    explicit DistributionPlotDialog( Attribute* atX, Attribute* atY,
+                                     DistributionPlotType type = DistributionPlotType::QQ,
+                                     QWidget *parent = 0 );
+
+    /** Constructor for the histogram of one realization (1 == first) of a simulated variable in a grid.  The
+     * GSLib plot is not offered in this case, since histplt would read all the realizations in the file.
+     */
+    explicit DistributionPlotDialog( Attribute* at, uint realization, QWidget *parent = 0 );
+
+    ~DistributionPlotDialog();
+
+private:
+    Ui::DistributionPlotDialog *ui;
+    Attribute* m_at;
+    Attribute* m_at2;
+    DistributionPlotType m_type;
+    DistributionPlot* m_plot;
+    UnivariateStatistics* m_stats;
+    UnivariateStatistics* m_stats2;
+    EnsembleStatistics* m_ensemble;
+    /** The realization whose statistics are computed (1 == first) or zero for all data. */
+    uint m_realization;
+
+    /** Initializes the widgets common to both constructors. */
+    void init();
+
+    /** Fills the combo box with "none" plus the declustering weights of the given variable. */
+    void fillWeightsComboBox( QComboBox* cmb, Attribute* at );
+
+    /** Returns the weight selected in the combo box or nullptr if none was selected. */
+    Attribute* getSelectedWeight( QComboBox* cmb, Attribute* at );
+
+private slots:
+    /** (Re)computes the statistics with the selected weights and replots. */
+    void onRecompute();
+    /** Redraws the plot with the current settings (e.g. number of classes) without recomputing the statistics. */
+    void onReplot();
+    void onSaveImage();
+    void onGSLibPlot();
+};
+
+#endif // DISTRIBUTIONPLOTDIALOG_H
@@ -19,10 +19,14 @@
 #include "gslib/gslibparametersdialog.h"
 #include "gslib/gslib.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
+#include "geostats/faciesmapbuilder.h"
+#include "geostats/indicatorkriging.h"
+#include "geostats/covariancemodel.h"
 #include "util.h"
 
 #include <QInputDialog>
 #include <QMessageBox>
+#include <cmath>
 
 IndicatorKrigingDialog::IndicatorKrigingDialog(IKVariableType varType, QWidget *parent) :
     QDialog(parent),
@@ -366,6 +370,13 @@ void IndicatorKrigingDialog::onConfigureAndRun()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
+        //without soft indicators, the estimation is done in-process
+        if( ! psSoftData ){
+            if( runIndicatorKriging( pointSet, varIndex ) )
+                preview();
+            return;
+        }
+
         //Generate the parameter file
         QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
         m_gpf_ik3d->save( par_file_path );
@@ -379,6 +390,82 @@ void IndicatorKrigingDialog::onConfigureAndRun()
     }
 }
 
+bool IndicatorKrigingDialog::runIndicatorKriging(PointSet *pointSet, uint varIndex)
+{
+    uint ndist = m_gpf_ik3d->getParameter<GSLibParUInt*>(4)->_value;
+
+    IndicatorKriging ik( pointSet, varIndex );
+    ik.setCategorical( m_gpf_ik3d->getParameter<GSLibParOption*>(0)->_selected_value == 0 );
+
+    //thresholds/categories and global c.d.f./p.d.f.
+    GSLibParMultiValuedVariable *par5 = m_gpf_ik3d->getParameter<GSLibParMultiValuedVariable*>(5);
+    GSLibParMultiValuedVariable *par6 = m_gpf_ik3d->getParameter<GSLibParMultiValuedVariable*>(6);
+    std::vector<double> thresholds, globalProbabilities;
+    for( uint i = 0; i < ndist; ++i ){
+        thresholds.push_back( par5->getParameter<GSLibParDouble*>(i)->_value );
+        globalProbabilities.push_back( par6->getParameter<GSLibParDouble*>(i)->_value );
+    }
+    ik.setThresholds( thresholds, globalProbabilities );
+
+    //the indicator variogram models
+    GSLibParRepeat *par22 = m_gpf_ik3d->getParameter<GSLibParRepeat*>(22);
+    std::vector<CovarianceModel> models;
+    for( uint i = 0; i < ndist; ++i )
+        models.push_back( CovarianceModel( par22->getParameter<GSLibParVModel*>(i, 0) ) );
+    //median IK: the model of the threshold closest to the median is used for all thresholds
+    GSLibParMultiValuedFixed *par20 = m_gpf_ik3d->getParameter<GSLibParMultiValuedFixed*>(20);
+    if( par20->getParameter<GSLibParOption*>(0)->_selected_value == 1 && ndist > 0 ){
+        double median = par20->getParameter<GSLibParDouble*>(1)->_value;
+        uint iMedian = 0;
+        for( uint i = 1; i < ndist; ++i )
+            if( std::abs( thresholds[i] - median ) < std::abs( thresholds[iMedian] - median ) )
+                iMedian = i;
+        models.assign( ndist, models[iMedian] );
+    }
+    ik.setCovarianceModels( models );
+
+    //trimming limits
+    GSLibParMultiValuedFixed *par11 = m_gpf_ik3d->getParameter<GSLibParMultiValuedFixed*>(11);
+    ik.setTrimmingLimits( par11->getParameter<GSLibParDouble*>(0)->_value,
+                          par11->getParameter<GSLibParDouble*>(1)->_value );
+
+    //estimation grid
+    GSLibParGrid* par15 = m_gpf_ik3d->getParameter<GSLibParGrid*>(15);
+    ik.setGridGeometry( par15->_specs_x->getParameter<GSLibParUInt*>(0)->_value,
+                        par15->_specs_y->getParameter<GSLibParUInt*>(0)->_value,
+                        par15->_specs_z->getParameter<GSLibParUInt*>(0)->_value,
+                        par15->_specs_x->getParameter<GSLibParDouble*>(1)->_value,
+                        par15->_specs_y->getParameter<GSLibParDouble*>(1)->_value,
+                        par15->_specs_z->getParameter<GSLibParDouble*>(1)->_value,
+                        par15->_specs_x->getParameter<GSLibParDouble*>(2)->_value,
+                        par15->_specs_y->getParameter<GSLibParDouble*>(2)->_value,
+                        par15->_specs_z->getParameter<GSLibParDouble*>(2)->_value );
+
+    //search parameters
+    GSLibParMultiValuedFixed *par16 = m_gpf_ik3d->getParameter<GSLibParMultiValuedFixed*>(16);
+    ik.setNumberOfData( par16->getParameter<GSLibParUInt*>(0)->_value,
+                        par16->getParameter<GSLibParUInt*>(1)->_value );
+    GSLibParMultiValuedFixed *par17 = m_gpf_ik3d->getParameter<GSLibParMultiValuedFixed*>(17);
+    GSLibParMultiValuedFixed *par18 = m_gpf_ik3d->getParameter<GSLibParMultiValuedFixed*>(18);
+    ik.setSearchEllipsoid( par17->getParameter<GSLibParDouble*>(0)->_value,
+                           par17->getParameter<GSLibParDouble*>(1)->_value,
+                           par17->getParameter<GSLibParDouble*>(2)->_value,
+                           par18->getParameter<GSLibParDouble*>(0)->_value,
+                           par18->getParameter<GSLibParDouble*>(1)->_value,
+                           par18->getParameter<GSLibParDouble*>(2)->_value );
+    ik.setMaxDataPerOctant( m_gpf_ik3d->getParameter<GSLibParUInt*>(19)->_value );
+    ik.setOrdinaryKriging( m_gpf_ik3d->getParameter<GSLibParOption*>(21)->_selected_value == 1 );
+
+    //run and save the estimates where ik3d would
+    Application::instance()->logInfo("Starting indicator kriging...");
+    if( ! ik.run() ){
+        QMessageBox::critical( this, "Error", "Indicator kriging failed.  Please, check the Output Message panel.");
+        return false;
+    }
+    ik.saveInGEOEASFormat( m_gpf_ik3d->getParameter<GSLibParFile*>(14)->_path );
+    return true;
+}
+
 void IndicatorKrigingDialog::onIk3dCompletes()
 {
     //frees all signal connections to the GSLib singleton.
@@ -442,6 +529,9 @@ void IndicatorKrigingDialog::onSave()
             //get the category definition used to create the p.d.f. (if defined)
             CategoryDefinition *cd = pdf->getCategoryDefinition();
 
+            //the probability fields are added at once (the estimation grid is rewritten only once)
+            std::vector<NewGEOEASColumn> columns( pdf->getPairCount() );
+
             //for each code/probability pair
             for(int i = 0; i < pdf->getPairCount(); ++i){
                 //make a meaningful name
@@ -452,10 +542,12 @@ void IndicatorKrigingDialog::onSave()
                     proposed_name.append( "Category_" ).append( pdf->get1stValue( i ) );
 
                 //the estimates normally follow the order of the categories in the resulting grid
-                Attribute* values = m_cg_estimation->getAttributeFromGEOEASIndex( i + 1 );
-                //add the estimates or variances to the selected estimation grid
-                estimation_grid->addGEOEASColumn( values, proposed_name );
+                columns[i].attribute = m_cg_estimation->getAttributeFromGEOEASIndex( i + 1 );
+                columns[i].name = proposed_name;
             }
+
+            //add the estimates to the selected estimation grid
+            estimation_grid->addGEOEASColumns( columns );
         }
     }
 
@@ -473,17 +565,22 @@ void IndicatorKrigingDialog::onSave()
             //get the selected c.d.f. file
             ThresholdCDF *cdf = (ThresholdCDF *)m_dfSelector->getSelectedFile();
 
+            //the probability fields are added at once (the estimation grid is rewritten only once)
+            std::vector<NewGEOEASColumn> columns( cdf->getPairCount() );
+
             //for each code/probability pair
             for(int i = 0; i < cdf->getPairCount(); ++i){
                 //make a meaningful name
                 QString proposed_name( prefix );
                 proposed_name.append( QString::number(cdf->get1stValue( i )) );
 
-                //the estimates normally follow the order of the categories in the resulting grid
-                Attribute* values = m_cg_estimation->getAttributeFromGEOEASIndex( i + 1 );
-                //add the estimates or variances to the selected estimation grid
-                estimation_grid->addGEOEASColumn( values, proposed_name );
+                //the estimates normally follow the order of the thresholds in the resulting grid
+                columns[i].attribute = m_cg_estimation->getAttributeFromGEOEASIndex( i + 1 );
+                columns[i].name = proposed_name;
             }
+
+            //add the estimates to the selected estimation grid
+            estimation_grid->addGEOEASColumns( columns );
         }
     }
 }
@@ -505,80 +602,62 @@ void IndicatorKrigingDialog::onCreateFaciesMap()
     //get the selected p.d.f. file
     CategoryPDF *pdf = (CategoryPDF *)m_dfSelector->getSelectedFile();
 
-    //define a temp path for the facies map
-    QString faciesMapPath = Application::instance()->getProject()->generateUniqueTmpFilePath("dat");
-
-    //open the file for output
-    QFile outputFile( faciesMapPath );
-    outputFile.open( QFile::WriteOnly | QFile::Text );
-    QTextStream out(&outputFile);
-
-    //write cartesian grid header
-    out << "Indicator Kriging facies map" << "\n";
-    out << "1" << "\n";
-    out << "Category" << "\n";
-
-    //read the grid with the probability fields
-    uint nLines = m_cg_estimation->getDataLineCount();
-    uint nColumns = m_cg_estimation->getDataColumnCount();
-    for( uint iLine = 0; iLine < nLines; ++iLine ){
-        double maxLikelihood = -0.0001;
-        int columnWithMaxLikelihood = -1;
-        //find the column with the greatest value
-        for( uint iColumn = 0; iColumn < nColumns; ++iColumn ){
-            double prob = m_cg_estimation->data( iLine, iColumn );
-            if( prob > maxLikelihood ){
-                maxLikelihood = prob;
-                columnWithMaxLikelihood = iColumn;
-            }
-        }
-        //write the facies code
-        if( columnWithMaxLikelihood >= 0 )
-            out << pdf->get1stValue( columnWithMaxLikelihood ) << "\n";
-        else
-            out << "-1" << "\n";
-    }
-
-    //closes the output file
-    outputFile.close();
-
-    //create a CartesianGrid object from the recently created file
-    CartesianGrid* cgFacies = new CartesianGrid( faciesMapPath );
-
-    //set the grid paramaters with the same values of the estimation grid.
-    cgFacies->setInfoFromOtherCG( m_cg_estimation );
-
-    //the NDV for the facies grid is -1
-    cgFacies->setNoDataValue( "-1" );
-
-    //get the single variable
-    Attribute* cat_var = (Attribute*)cgFacies->getChildByIndex( 0 );
-
     //get the category definition (if nullptr, the map will be displayed as a continuous variable)
     CategoryDefinition *cd = pdf->getCategoryDefinition();
 
-    //open the plot dialog
-    if( Util::viewGrid( cat_var, this, true, cd ) ){
-        //make a meaningful name
-        QString proposed_name;
-        if( cd )
-            proposed_name = cd->getName();
-        else
-            proposed_name = "Facies";
+    //make a meaningful name
+    QString proposed_name;
+    if( cd )
+        proposed_name = cd->getName();
+    else
+        proposed_name = "Facies";
 
-        //presents a dialog so the user can change the suggested name.
-        bool ok;
-        proposed_name = QInputDialog::getText(this, "Define variable name",
-                                                 "Name for the categorical variable:", QLineEdit::Normal,
-                                                 proposed_name, &ok);
-        //if the user didn't cancel the input dialog
-        if( ok ){
-            //get the single variable
-            Attribute* values = cgFacies->getAttributeFromGEOEASIndex( 1 );
-            //add the categorical variable the selected estimation grid
-            estimation_grid->addGEOEASColumn( values, proposed_name, true, cd );
-        }
+    //presents a dialog so the user can change the suggested name.
+    bool ok;
+    proposed_name = QInputDialog::getText(this, "Define variable name",
+                                             "Name for the categorical variable:", QLineEdit::Normal,
+                                             proposed_name, &ok);
+    //if the user canceled the input dialog
+    if( ! ok )
+        return;
+
+    //ask for the options
+    bool correctOrderRelations = QMessageBox::question( this, "Facies map", "Correct order relations (reset the probabilities "
+                                                        "to [0,1] and restandardize them to sum up to 1) before classifying?",
+                                                        QMessageBox::Yes | QMessageBox::No ) == QMessageBox::Yes;
+    bool saveUncertainty = QMessageBox::question( this, "Facies map", "Also save the probability of the most likely category "
+                                                  "and the normalized entropy as measures of uncertainty?",
+                                                  QMessageBox::Yes | QMessageBox::No ) == QMessageBox::Yes;
+
+    //the category codes in the order of the probability columns
+    std::vector<int> categoryCodes;
+    for( int i = 0; i < pdf->getPairCount(); ++i )
+        categoryCodes.push_back( pdf->get1stValue( i ) );
+
+    //classify the cells with the probabilities in memory
+    FaciesMapBuilder builder( m_cg_estimation, categoryCodes );
+    builder.setCorrectOrderRelations( correctOrderRelations );
+    builder.run();
+
+    //add the categorical variable (and the uncertainty measures, if requested) to the selected estimation grid
+    std::vector<NewGEOEASColumn> columns( saveUncertainty ? 3 : 1 );
+    columns[0].values = builder.getCategories();
+    columns[0].name = proposed_name;
+    columns[0].categorical = true;
+    columns[0].categoryDefinition = cd;
+    if( saveUncertainty ){
+        columns[1].values = builder.getMaxProbabilities();
+        columns[1].name = proposed_name + "_max_prob";
+        columns[2].values = builder.getEntropies();
+        columns[2].name = proposed_name + "_entropy";
     }
+    uint firstNewIndex = estimation_grid->getFieldNames().size() + 1;
+    estimation_grid->addGEOEASColumns( columns );
+
+    //display the facies map
+    Attribute* cat_var = estimation_grid->getAttributeFromGEOEASIndex( firstNewIndex );
+    if( cat_var )
+        Util::viewGrid( cat_var, this, false, cd );
 }
 
 void IndicatorKrigingDialog::onSaveForPostik()
@@ -16,6 +16,7 @@ class VariogramModelSelector;
 class FileSelectorWidget;
 class GSLibParameterFile;
 class CartesianGrid;
+class PointSet;
 
 /*! The variable type result in different indicator kriging beahvior. */
 enum class IKVariableType : uint {
@@ -46,6 +47,9 @@ private:
     IKVariableType m_varType;
     CartesianGrid* m_cg_estimation;
     void preview();
+    /** Runs indicator kriging in-process with the current ik3d parameters (soft indicators are not supported)
+     *  and saves the estimates to the ik3d output file.  Returns false if the estimation failed. */
+    bool runIndicatorKriging( PointSet* pointSet, uint varIndex );
 
 private slots:
     void onUpdateVariogramSelectors();
@@ -0,0 +1,180 @@
+#include "mapviewdialog.h"
+#include "ui_mapviewdialog.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/cartesiangrid.h"
+#include "domain/pointset.h"
+#include "domain/project.h"
+#include "plotting/maprenderer.h"
+#include "widgets/qlabelwithcrosshairs.h"
+#include "util.h"
+
+#include <QFileDialog>
+#include <QPixmap>
+#include <QElapsedTimer>
+
+MapViewDialog::MapViewDialog(Attribute *at, CategoryDefinition *cd, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::MapViewDialog),
+    m_cd( cd ),
+    m_isGrid( false ),
+    m_nI( 0 ), m_nJ( 0 ),
+    m_hasNDV( false ),
+    m_NDV( 0.0 ),
+    m_min( 0.0 ),
+    m_max( 0.0 )
+{
+    ui->setupUi(this);
+
+    //deletes dialog from memory upon user closing it
+    this->setAttribute(Qt::WA_DeleteOnClose);
+
+    //make window title
+    setWindowTitle( at->getContainingFile()->getName() + "/" + at->getName() + " map" );
+
+    //add the image label (not originally present in .UI file)
+    m_lblImage = new QLabelWithCrossHairs();
+    ui->scrollAreaWidgetContents->layout()->addWidget( m_lblImage );
+
+    //get the data file and loads data in file, because it's necessary.
+    DataFile* dataFile = (DataFile*)at->getContainingFile();
+    dataFile->loadData();
+
+    //get the variable index in parent data file
+    uint column = dataFile->getFieldGEOEASIndex( at->getName() ) - 1;
+
+    //get the max and min of the selected variable
+    Util::assureNonZeroWindow( m_min, m_max, dataFile->min( column ), dataFile->max( column ) );
+
+    //get the no-data value configuration once (DataFile::isNDV() is slow).
+    m_hasNDV = dataFile->hasNoDataValue();
+    m_NDV = dataFile->getNoDataValueAsDouble();
+
+    //copy the values and the geometry, since the data file may be deleted while this dialog is open
+    m_isGrid = dataFile->getFileType() == "CARTESIANGRID";
+    uint nSlices = 1;
+    if( m_isGrid ){
+        CartesianGrid* cg = (CartesianGrid*)dataFile;
+        m_nI = cg->getNX();
+        m_nJ = cg->getNY();
+        nSlices = cg->getNZ();
+        m_values.reserve( (long)m_nI * m_nJ * nSlices );
+        for( uint k = 0; k < nSlices; ++k )
+            for( uint j = 0; j < m_nJ; ++j )
+                for( uint i = 0; i < m_nI; ++i )
+                    m_values.push_back( cg->dataIJK( column, i, j, k ) );
+    } else {
+        PointSet* ps = (PointSet*)dataFile;
+        uint xColumn = ps->getXindex() - 1;
+        uint yColumn = ps->getYindex() - 1;
+        long nPoints = ps->getDataLineCount();
+        m_values.reserve( nPoints );
+        m_x.reserve( nPoints );
+        m_y.reserve( nPoints );
+        for( long line = 0; line < nPoints; ++line ){
+            m_values.push_back( ps->data( line, column ) );
+            m_x.push_back( ps->data( line, xColumn ) );
+            m_y.push_back( ps->data( line, yColumn ) );
+        }
+    }
+
+    //the GSLib plot needs the attribute, so it is only offered for files in the project, which are
+    //looked up again when the plot is requested
+    if( Application::instance()->getProject()->fileIsChild( dataFile ) )
+        m_objectLocator = at->getObjectLocator();
+    ui->btnGSLibPlot->setVisible( ! m_objectLocator.isEmpty() );
+
+    //the slice selector is only meaningful for 3D grids
+    ui->spinSlice->setMaximum( nSlices - 1 );
+    ui->lblSlice->setVisible( nSlices > 1 );
+    ui->spinSlice->setVisible( nSlices > 1 );
+
+    //set a default zoom (cell size in pixels) that fits about 600 pixels
+    if( m_isGrid ){
+        uint largestDimension = std::max( m_nI, m_nJ );
+        ui->spinZoom->setValue( std::max( 1u, 600 / std::max( 1u, largestDimension ) ) );
+        ui->lblZoom->setText("Cell size (pixels):");
+    } else {
+        ui->spinZoom->setValue( 3 );
+        ui->lblZoom->setText("Point size (pixels):");
+    }
+
+    //render the color scale
+    QImage scale = MapRenderer::renderColorScale( 150, 300, m_min, m_max, m_cd );
+    ui->lblColorScale->setPixmap( QPixmap::fromImage( scale ) );
+
+    connect( ui->spinSlice, SIGNAL(valueChanged(int)), this, SLOT(onRender()) );
+    connect( ui->spinZoom, SIGNAL(valueChanged(int)), this, SLOT(onRender()) );
+    connect( ui->btnSaveImage, SIGNAL(clicked()), this, SLOT(onSaveImage()) );
+    connect( ui->btnGSLibPlot, SIGNAL(clicked()), this, SLOT(onGSLibPlot()) );
+    connect( ui->btnCrossHairs, SIGNAL(clicked()), this, SLOT(onShowHideCrossHairs()) );
+
+    if( Util::getDisplayResolutionClass() == DisplayResolution::HIGH_DPI ){
+        ui->btnSaveImage->setIcon( QIcon(":icons32/snapshot32") );
+        ui->btnCrossHairs->setIcon( QIcon(":icons32/crosshairs32") );
+        ui->btnGSLibPlot->setIcon( QIcon(":icons32/plot32") );
+    }
+
+    onRender();
+
+    adjustSize();
+}
+
+MapViewDialog::~MapViewDialog()
+{
+    delete ui;
+}
+
+void MapViewDialog::onRender()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image;
+    if( m_isGrid )
+        image = MapRenderer::renderGrid( m_values, m_nI, m_nJ, ui->spinSlice->value(), ui->spinZoom->value(),
+                                         m_hasNDV, m_NDV, m_min, m_max, m_cd );
+    else
+        image = MapRenderer::renderPointSet( m_x, m_y, m_values, 600, 600, ui->spinZoom->value(),
+                                             m_hasNDV, m_NDV, m_min, m_max, m_cd );
+
+    //display the image
+    QPixmap pixmap = QPixmap::fromImage( image );
+    m_lblImage->setPixmap( pixmap );
+    m_lblImage->setFixedSize( pixmap.size() );
+    m_lblImage->show();
+
+    Application::instance()->logInfo( "MapViewDialog::onRender(): map rendered in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+}
+
+void MapViewDialog::onSaveImage()
+{
+    QString path = QFileDialog::getSaveFileName( this, "Save map image", Util::getLastBrowsedDirectory(),
+                                                 "PNG image (*.png)" );
+    if( path.isEmpty() )
+        return;
+    Util::saveLastBrowsedDirectoryOfFile( path );
+    m_lblImage->pixmap()->save( path, "PNG" );
+}
+
+void MapViewDialog::onGSLibPlot()
+{
+    //the attribute may have been removed from the project since the map was built
+    Attribute* at = (Attribute*)Application::instance()->getProject()->findObject( m_objectLocator );
+    if( ! at ){
+        Application::instance()->logError( "MapViewDialog::onGSLibPlot(): the variable " + m_objectLocator +
+                                           " is no longer in the project." );
+        return;
+    }
+    if( m_isGrid )
+        Util::viewGridWithPixelplt( at, this, false, m_cd );
+    else
+        Util::viewPointSetWithLocmap( at, this, false );
+}
+
+void MapViewDialog::onShowHideCrossHairs()
+{
+    m_lblImage->toggleCrossHairs();
+}
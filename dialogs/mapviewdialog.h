@@ -0,0 +1,58 @@
+#ifndef MAPVIEWDIALOG_H
+#define MAPVIEWDIALOG_H
+
+#include <QDialog>
+#include <vector>
+
+namespace Ui {
+class MapViewDialog;
+}
+
+class Attribute;
+class CategoryDefinition;
+class QLabelWithCrossHairs;
+
+/**
+ * The MapViewDialog displays a map of an Attribute of a Cartesian grid or of a point set rendered in-process by
+ * MapRenderer, so it works without GSLib or Ghostscript.  The user can still open the GSLib plot (pixelplt or locmap)
+ * from this dialog if a plot with the GSLib programs' settings is desired.
+ * The values and the geometry are copied when the dialog is built, so an open map does not depend on the
+ * data file, which may be deleted by its owner (e.g. the preview grids of the kriging and simulation dialogs).
+ */
+class MapViewDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param cd If set, the attribute is rendered as a categorical variable.
+     */
+    explicit MapViewDialog(Attribute* at, CategoryDefinition* cd = nullptr, QWidget *parent = 0);
+    ~MapViewDialog();
+
+private:
+    Ui::MapViewDialog *ui;
+    CategoryDefinition* m_cd;
+    /** The locator of the attribute in the project, used to find it for the GSLib plot (empty if the file
+     *  is not in the project). */
+    QString m_objectLocator;
+    bool m_isGrid;
+    uint m_nI, m_nJ;
+    /** The values (in GEO-EAS grid order for grids) and the coordinates of the point set samples. */
+    std::vector<double> m_values;
+    std::vector<double> m_x, m_y;
+    bool m_hasNDV;
+    double m_NDV;
+    double m_min;
+    double m_max;
+    QLabelWithCrossHairs* m_lblImage;
+
+private slots:
+    /** Renders the map with the current settings (slice, zoom). */
+    void onRender();
+    void onSaveImage();
+    void onGSLibPlot();
+    void onShowHideCrossHairs();
+};
+
+#endif // MAPVIEWDIALOG_H
@@ -11,6 +11,7 @@
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparametersdialog.h"
 #include "gslib/gslib.h"
+#include "geostats/griddedvariogramcalculator.h"
 #include "dialogs/displayplotdialog.h"
 
 MultiVariogramDialog::MultiVariogramDialog(const std::vector<Attribute *> attributes,
@@ -104,76 +105,44 @@ void MultiVariogramDialog::onGam()
 
     //if the user didn't cancel the dialog...
     if( result == QDialog::Accepted ){
-        std::vector<QString> expVarFilePaths;
+        //one output file with experimental variogram values per attribute (in the order of validAttributes)
+        std::vector<QString> expVarFilePaths( validAttributes.size() );
+
+        //the attributes of the same grid are computed together in a single pass over the grid
+        std::vector<bool> done( validAttributes.size(), false );
+        for( size_t i = 0; i < validAttributes.size(); ++i ){
+            if( done[i] )
+                continue;
+            //can assume the file is a Cartesian grid.
+            CartesianGrid* cg = (CartesianGrid*)validAttributes[i]->getContainingFile();
+
+            //the trimming limits and the grid geometry are those of each file (no trimming is done)
+            GriddedVariogramCalculator calculator( cg );
+            calculator.setParametersFromGam( m_gpf_gam, false );
+
+            //add the attributes of this grid
+            std::vector<size_t> attributesInGrid;
+            for( size_t j = i; j < validAttributes.size(); ++j ){
+                if( validAttributes[j]->getContainingFile() != cg )
+                    continue;
+                Application::instance()->logInfo("Processing attribute " + validAttributes[j]->getName() +
+                                                 " of file " + cg->getName() + "...");
+                calculator.addVariable( validAttributes[j], m_gpf_gam->getParameter<GSLibParUInt*>(4)->_value );
+                attributesInGrid.push_back( j );
+                done[j] = true;
+            }
 
-        //set attributes that must vary for each variable...
-        //TODO: these can be done in parallel
-        it = validAttributes.begin();
-        for(; it != validAttributes.end(); ++it){
-            //get the Attribute
-            Attribute *at = *it;
+            calculator.run();
 
-            //can assume the file is a Cartesian grid.
-            CartesianGrid* cg = (CartesianGrid*)at->getContainingFile();
-            Application::instance()->logInfo("Processing attribute " + at->getName() + " of file " + cg->getName() + "...");
-
-            //loads data in file.
-            cg->loadData();
-
-            //get the variable index(es) in parent data file
-            uint var_index = cg->getFieldGEOEASIndex( at->getName() );
-
-            //get the max and min of the variable
-            double data_min = cg->min( var_index-1 );
-            double data_max = cg->max( var_index-1 );
-
-            //input file
-            m_gpf_gam->getParameter<GSLibParFile*>(0)->_path = cg->getPath();
-
-            //variable to compute variogram for
-            GSLibParMultiValuedFixed *par1 = m_gpf_gam->getParameter<GSLibParMultiValuedFixed*>(1);
-            par1->getParameter<GSLibParUInt*>(0)->_value = 1; //number of variables
-            GSLibParMultiValuedVariable *par1_1 = par1->getParameter<GSLibParMultiValuedVariable*>(1);
-            par1_1->getParameter<GSLibParUInt*>(0)->_value = var_index;
-
-            //trimming limits
-            GSLibParMultiValuedFixed *par2 = m_gpf_gam->getParameter<GSLibParMultiValuedFixed*>(2);
-            par2->getParameter<GSLibParDouble*>(0)->_value = data_min;
-            par2->getParameter<GSLibParDouble*>(1)->_value = data_max;
-
-            //grid definition parameters (assuming the grids have the same cell size so the
-            //variograms plotted together make sense)
-            GSLibParGrid* par5 = m_gpf_gam->getParameter<GSLibParGrid*>(5);
-            par5->_specs_x->getParameter<GSLibParUInt*>(0)->_value = cg->getNX(); //nx
-            par5->_specs_x->getParameter<GSLibParDouble*>(1)->_value = cg->getX0(); //min x
-            par5->_specs_x->getParameter<GSLibParDouble*>(2)->_value = cg->getDX(); //cell size x
-            par5->_specs_y->getParameter<GSLibParUInt*>(0)->_value = cg->getNY(); //ny
-            par5->_specs_y->getParameter<GSLibParDouble*>(1)->_value = cg->getY0(); //min y
-            par5->_specs_y->getParameter<GSLibParDouble*>(2)->_value = cg->getDY(); //cell size y
-            par5->_specs_z->getParameter<GSLibParUInt*>(0)->_value = cg->getNZ(); //nz
-            par5->_specs_z->getParameter<GSLibParDouble*>(1)->_value = cg->getZ0(); //min z
-            par5->_specs_z->getParameter<GSLibParDouble*>(2)->_value = cg->getDZ(); //cell size z
-
-            //realization number (assumes only one realization per file)
-            // Letting the user change it (one may do some weird cross-simulation analysis...)
-            //m_gpf_gam->getParameter<GSLibParUInt*>(4)->_value = 1;
-
-            //set an output file with experimental variogram values
-            m_gpf_gam->getParameter<GSLibParFile*>(3)->_path =
-                    Application::instance()->getProject()->generateUniqueTmpFilePath("out");
-            expVarFilePaths.push_back( m_gpf_gam->getParameter<GSLibParFile*>(3)->_path );
-
-            //Generate the parameter file
-            QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-            m_gpf_gam->save( par_file_path );
-
-            //...run gam program
-            Application::instance()->logInfo("Starting gam program for variable " +
-                                             at->getName() + " in file " + cg->getName() + "...");
-            GSLib::instance()->runProgram( "gam", par_file_path );
+            //save the results in gam format for vargplt
+            for( size_t iVar = 0; iVar < attributesInGrid.size(); ++iVar ){
+                QString path = Application::instance()->getProject()->generateUniqueTmpFilePath("out");
+                if( ! calculator.saveInGamFormat( iVar, path ) )
+                    return;
+                expVarFilePaths[ attributesInGrid[iVar] ] = path;
+            }
         }
 
-
         onVargplt( expVarFilePaths );
     }
 }
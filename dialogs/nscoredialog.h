@@ -2,15 +2,20 @@
 #define NSCOREDIALOG_H
 
 #include <QDialog>
+#include <vector>
 
 namespace Ui {
 class NScoreDialog;
 }
 
 class Attribute;
-class GSLibParameterFile;
-class DataFile;
+class NormalScoreTransform;
 
+/**
+ * The NScoreDialog performs the normal score transform of a variable, optionally declustered, in-process with
+ * NormalScoreTransform (no longer running the GSLib program nscore).  The user can review the histogram of the
+ * normal scores before saving them to the data file along with the transform table.
+ */
 class NScoreDialog : public QDialog
 {
     Q_OBJECT
@@ -22,17 +27,18 @@ public:
 private:
     Ui::NScoreDialog *ui;
     Attribute* m_attribute;
-    GSLibParameterFile* m_gpf_nscore;
+    NormalScoreTransform* m_transform;
+    /** The normal scores of the last run (NaN where the variable has no-data values). */
+    std::vector<double> m_scores;
+
+    /** Returns the declustering weight selected by the user or nullptr if none was selected. */
+    Attribute* getSelectedWeight();
 
 private slots:
+    /** Computes the normal scores. */
     void onParams();
     void onHistogram();
     void onSave();
-
-private:
-    void doHistogramPointSet();
-    void doHistogramGrid();
-    void doHistogramCommon(DataFile* input_data_file);
 };
 
 #endif // NSCOREDIALOG_H
@@ -14,14 +14,15 @@
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslibparametersdialog.h"
-#include "gslib/gslib.h"
+#include "geostats/indicatorpostprocessing.h"
 #include "util.h"
 
 PostikDialog::PostikDialog(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::PostikDialog),
     m_gpf_postik( nullptr ),
-    m_cg_postprocess( nullptr )
+    m_cg_postprocess( nullptr ),
+    m_postProcessing( nullptr )
 {
     ui->setupUi(this);
 
@@ -65,6 +66,7 @@ PostikDialog::PostikDialog(QWidget *parent) :
 PostikDialog::~PostikDialog()
 {
     delete ui;
+    delete m_postProcessing;
     Application::instance()->logInfo("PostikDialog destroyed.");
 }
 
@@ -158,80 +160,113 @@ void PostikDialog::onConfigureAndRun()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
-        m_gpf_postik->save( par_file_path );
-
-        //to be notified when postik completes.
-        connect( GSLib::instance(), SIGNAL(programFinished()), this, SLOT(onPostikCompletes()) );
-
-        //run postik program asynchronously
-        Application::instance()->logInfo("Starting postik program...");
-        GSLib::instance()->runProgramAsync( "postik", par_file_path );
+        //the post-processing is performed in-process
+        if( runPostProcessing( cg_ik3d, cg_dataForDist ) )
+            preview();
     }
 
 }
 
-void PostikDialog::onPostikCompletes()
+bool PostikDialog::runPostProcessing(CartesianGrid *cg_ik3d, DataFile *dataForDist)
 {
-    //frees all signal connections to the GSLib singleton.
-    GSLib::instance()->disconnect();
+    delete m_postProcessing;
+    m_postProcessing = new IndicatorPostProcessing( cg_ik3d );
+
+    //the output option and its parameter
+    GSLibParMultiValuedFixed *par2 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(2);
+    m_postProcessing->setOutput( (IKPostProcessingOutput)par2->getParameter<GSLibParOption*>(0)->_selected_value,
+                                 par2->getParameter<GSLibParDouble*>(1)->_value );
+
+    //the thresholds
+    std::vector<double> thresholds;
+    GSLibParMultiValuedVariable *par4 = m_gpf_postik->getParameter<GSLibParMultiValuedVariable*>(4);
+    for( uint i = 0; i < m_gpf_postik->getParameter<GSLibParUInt*>(3)->_value; ++i )
+        thresholds.push_back( par4->getParameter<GSLibParDouble*>(i)->_value );
+    m_postProcessing->setThresholds( thresholds );
+
+    //the volume support correction
+    GSLibParMultiValuedFixed *par5 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(5);
+    if( par5->getParameter<GSLibParOption*>(0)->_selected_value == 1 )
+        m_postProcessing->setSupportCorrection( (SupportCorrection)par5->getParameter<GSLibParOption*>(1)->_selected_value,
+                                                par5->getParameter<GSLibParDouble*>(2)->_value );
+
+    //the global distribution for the interpolation with quantiles from data
+    if( dataForDist ){
+        GSLibParMultiValuedFixed *par7 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(7);
+        m_postProcessing->setGlobalDistribution( dataForDist,
+                                                 par7->getParameter<GSLibParUInt*>(0)->_value,
+                                                 par7->getParameter<GSLibParUInt*>(1)->_value,
+                                                 par7->getParameter<GSLibParDouble*>(2)->_value,
+                                                 par7->getParameter<GSLibParDouble*>(3)->_value );
+    }
 
-    preview();
+    //the minimum and maximum values
+    GSLibParMultiValuedFixed *par8 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(8);
+    m_postProcessing->setValueLimits( par8->getParameter<GSLibParDouble*>(0)->_value,
+                                      par8->getParameter<GSLibParDouble*>(1)->_value );
+
+    //the interpolation options of the lower tail, middle classes and upper tail
+    GSLibParMultiValuedFixed *par9 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(9);
+    m_postProcessing->setLowerTail( (CDFInterpolationModel)par9->getParameter<GSLibParOption*>(0)->_selected_value,
+                                    par9->getParameter<GSLibParDouble*>(1)->_value );
+    GSLibParMultiValuedFixed *par10 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(10);
+    m_postProcessing->setMiddle( (CDFInterpolationModel)par10->getParameter<GSLibParOption*>(0)->_selected_value,
+                                 par10->getParameter<GSLibParDouble*>(1)->_value );
+    GSLibParMultiValuedFixed *par11 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(11);
+    m_postProcessing->setUpperTail( (CDFInterpolationModel)par11->getParameter<GSLibParOption*>(0)->_selected_value,
+                                    par11->getParameter<GSLibParDouble*>(1)->_value );
+
+    //the discretization of the local distributions
+    m_postProcessing->setMaxDiscretization( m_gpf_postik->getParameter<GSLibParUInt*>(12)->_value );
+
+    if( ! m_postProcessing->run() ){
+        QMessageBox::critical( this, "Error", "Post-processing failed.  Please, check the Output Message panel for recent messages in red.");
+        return false;
+    }
+
+    //write the results to the output file for preview
+    double NDV = cg_ik3d->hasNoDataValue() ? cg_ik3d->getNoDataValueAsDouble() : -9.9999;
+    m_postProcessing->saveInGEOEASFormat( m_gpf_postik->getParameter<GSLibParFile*>(1)->_path, NDV );
+    return true;
 }
 
 void PostikDialog::onSave()
 {
-    if( ! m_gpf_postik || ! m_cg_postprocess ){
+    if( ! m_gpf_postik || ! m_postProcessing ){
         QMessageBox::critical( this, "Error", "Please, run the post-processing at least once.");
         return;
     }
 
-    //get the selected estimation grid
-    CartesianGrid* estimation_grid = (CartesianGrid*)m_Ik3dGridSelector->getSelectedDataFile();
-    if( ! estimation_grid ){
-        QMessageBox::critical( this, "Error", "Please, select an ik3d-generated Cartesian grid to set the grid geometry from.");
-        return;
-    }
-
-    //suggest a name for the new grid based on which post-processed product the user selected
-    QString new_cg_name = estimation_grid->getName();
+    //suggest a name for the new variable(s) based on which post-processed product the user selected
+    QString new_var_name;
     GSLibParMultiValuedFixed *par2 = m_gpf_postik->getParameter<GSLibParMultiValuedFixed*>(2);
     double parameter = par2->getParameter<GSLibParDouble*>(1)->_value;
     switch( par2->getParameter<GSLibParOption*>(0)->_selected_value ){
     case 1: //mean
-        new_cg_name += "_eType";
+        new_var_name = "eType";
         break;
     case 2: //prob. above and mean above/below threshold
-        new_cg_name += "_ProbAndMeanAbove_" + QString::number( parameter );
+        new_var_name = "ProbAndMeanAbove_" + QString::number( parameter );
         break;
     case 3: //quantile
-        new_cg_name += "_P" + QString::number( parameter * 100 );
+        new_var_name = "P" + QString::number( parameter * 100 );
         break;
     case 4: //variance
-        new_cg_name += "_Variance";
+        new_var_name = "Variance";
         break;
     }
 
-    //presents a naming dialog with a suggested name for the new Cartesian grid.
+    //presents a naming dialog with a suggested name for the new variable(s).
     bool ok;
-    new_cg_name = QInputDialog::getText(this, "Name the new cartesian grid",
-                                             "Name for the new Cartesian grid:", QLineEdit::Normal,
-                                             new_cg_name, &ok);
+    new_var_name = QInputDialog::getText(this, "Name the new variable",
+                                             "Name for the new variable(s) in the ik3d grid:", QLineEdit::Normal,
+                                             new_var_name, &ok);
 
     //if the user didn't cancel the input dialog
     if( ok ){
-        //get the postik output file
-        QString tmp_file_path = m_gpf_postik->getParameter<GSLibParFile*>(1)->_path;
-
-        //create a new grid object corresponding to the file with the post-processed product
-        CartesianGrid* cg = new CartesianGrid( tmp_file_path );
-
-        //set the metadata info from the post-processed grid
-        cg->setInfoFromOtherCG( m_cg_postprocess, false );
-
-        //import the grid file with the IK estimates as a project item
-        Application::instance()->getProject()->importCartesianGrid( cg, new_cg_name );
+        //the post-processed values are written as new columns of the ik3d grid
+        //appendToGrid() also refreshes the project tree to show the new variable(s)
+        m_postProcessing->appendToGrid( new_var_name );
     }
 
 }
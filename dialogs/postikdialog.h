@@ -12,6 +12,8 @@ class FileSelectorWidget;
 class VariableSelector;
 class GSLibParameterFile;
 class CartesianGrid;
+class DataFile;
+class IndicatorPostProcessing;
 
 class PostikDialog : public QDialog
 {
@@ -23,7 +25,6 @@ public:
 
 private slots:
     void onConfigureAndRun();
-    void onPostikCompletes();
     void onSave();
 
 private:
@@ -35,7 +36,12 @@ private:
     VariableSelector* m_weightForDistSelector;
     GSLibParameterFile* m_gpf_postik;
     CartesianGrid* m_cg_postprocess;
+    IndicatorPostProcessing* m_postProcessing;
     void preview();
+
+    /** Performs the post-processing in-process with the postik parameters and writes the results to the postik
+     *  output file for preview.  Returns false if the post-processing failed. */
+    bool runPostProcessing( CartesianGrid* cg_ik3d, DataFile* dataForDist );
 };
 
 #endif // POSTIKDIALOG_H
@@ -13,6 +13,8 @@ SetupDialog::SetupDialog(QWidget *parent) :
     ui->txtGSLibPath->setText( Application::instance()->getGSLibPathSetting() );
     ui->txtGSPath->setText( Application::instance()->getGhostscriptPathSetting() );
     ui->spinMaxGridCells3DView->setValue( Application::instance()->getMaxGridCellCountFor3DVisualizationSetting() );
+    ui->spinMaxPoints3DView->setValue( Application::instance()->getMaxPointCountFor3DVisualizationSetting() );
+    ui->spinMaxGSLibJobs->setValue( Application::instance()->getMaxConcurrentGSLibJobsSetting() );
     adjustSize();
 }
 
@@ -41,6 +43,8 @@ void SetupDialog::accept()
     Application::instance()->setGSLibPathSetting( ui->txtGSLibPath->text() );
     Application::instance()->setGhostscriptPathSetting( ui->txtGSPath->text() );
     Application::instance()->setMaxGridCellCountFor3DVisualizationSetting( ui->spinMaxGridCells3DView->value() );
+    Application::instance()->setMaxPointCountFor3DVisualizationSetting( ui->spinMaxPoints3DView->value() );
+    Application::instance()->setMaxConcurrentGSLibJobsSetting( ui->spinMaxGSLibJobs->value() );
     //make dialog close.
     this->reject();
 }
@@ -19,6 +19,10 @@
 #include "widgets/variogrammodelselector.h"
 #include "widgets/distributionfieldselector.h"
 #include "dialogs/displayplotdialog.h"
+#include "dialogs/distributionplotdialog.h"
+#include "dialogs/variogramplotdialog.h"
+#include "geostats/ensemblestatistics.h"
+#include "geostats/griddedvariogramcalculator.h"
 #include "util.h"
 
 #include <QInputDialog>
@@ -143,6 +147,10 @@ void SGSIMDialog::updateVariogramParameters(VariogramModel *vm)
 
 void SGSIMDialog::preview()
 {
+    //the distribution plots of the previous run refer to the grid about to be deleted
+    for( DistributionPlotDialog* dpd : findChildren<DistributionPlotDialog*>() )
+        dpd->close();
+
     if( m_cg_simulation )
         delete m_cg_simulation;
 
@@ -387,47 +395,11 @@ void SGSIMDialog::onRealizationHistogram()
                        &ok);
     if(!ok) return;
 
-    //construct a parameter file for the addcoord program
-    //We use the addcoord program to extract data from a specific realization
-    //for the histogram
-    GSLibParameterFile gpf( "addcoord" );
-
-    //input file
-    GSLibParFile* par0 = gpf.getParameter<GSLibParFile*>( 0 );
-    par0->_path = cg->getPath();
-
-    //output file (temporary)
-    GSLibParFile* par1 = gpf.getParameter<GSLibParFile*>( 1 );
-    par1->_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "xyz" );
-
-    //realization number
-    GSLibParUInt* par2 = gpf.getParameter<GSLibParUInt*>( 2 );
-    par2->_value = realNumber;
-
-    //grid parameters
-    GSLibParGrid* par3 = gpf.getParameter<GSLibParGrid*>( 3 );
-    par3->setFromCG( cg );
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run addcoord program
-    Application::instance()->logInfo("Starting addcoord program...");
-    GSLib::instance()->runProgram( "addcoord", par_file_path );
-    Application::instance()->logInfo("addcoord completed.");
-
-    //make the point set object from the temporary point set file created by addcoord
-    PointSet *ps = new PointSet( par1->_path );
-
-    //addcoord always adds the X,Y,Z fields as 1st, 2nd and 3rd variables in the data file
-    //the ndv value is the same as the original Cartesian grid.
-    ps->setInfo( 1, 2, 3, cg->getNoDataValue() );
-
-    //the simulated values of the target realization is the 4th GEO-EAS column in the point set file
-    //generated by addcord
-    Attribute *at = ps->getAttributeFromGEOEASIndex( 4 );
-    Util::viewHistogram( at, this );
+    //the histogram is computed directly from the cells of the selected realization in the grid without
+    //extracting the realization to a point set file with addcoord
+    Attribute *at = cg->getAttributeFromGEOEASIndex( 1 );
+    DistributionPlotDialog* dpd = new DistributionPlotDialog( at, realNumber, this );
+    dpd->show();
 }
 
 void SGSIMDialog::onEnsembleHistogram()
@@ -436,6 +408,16 @@ void SGSIMDialog::onEnsembleHistogram()
     CartesianGrid* gridRealizations = m_cg_simulation;
     Attribute* realizationsAttribute = m_cg_simulation->getAttributeFromGEOEASIndex(1);
 
+    //if the input data are the reference distribution, the plot is made in-process
+    if( ! m_refDistFileSelector->getSelectedDistribution() ){
+        PointSet* pointSet = (PointSet*)m_primVarPSetSelector->getSelectedDataFile();
+        Attribute* refDistAttribute = pointSet->getAttributeFromGEOEASIndex( m_primVarSelector->getSelectedVariableGEOEASIndex() );
+        DistributionPlotDialog* dpd = new DistributionPlotDialog( realizationsAttribute, refDistAttribute,
+                                                                  DistributionPlotType::REALIZATIONS, this );
+        dpd->show();
+        return;
+    }
+
     //load the data in grid
     gridRealizations->loadData();
 
@@ -539,7 +521,7 @@ void SGSIMDialog::onEnsembleVariogram()
     uint nReals = m_cg_simulation->getNReal();
 
     //-------------------------------------------------------------------------------------------
-    //-----------1) Run gam on each realization--------------------------------------------------
+    //-----------1) Compute the variograms of the realizations----------------------------------
     //-------------------------------------------------------------------------------------------
 
     //if the parameter file object was not constructed
@@ -600,178 +582,99 @@ void SGSIMDialog::onEnsembleVariogram()
     }
     //--------------------------------------------------------------------------------
 
-    //show the parameter dialog so the user can adjust other settings before running gam
+    //show the parameter dialog so the user can adjust other settings before computing the variograms
     GSLibParametersDialog gslibpardiag( m_gpf_gam );
     int result = gslibpardiag.exec();
-    std::vector<QString> expVarFilePaths;
-    if( result == QDialog::Accepted ){
-        //save the realization number setting for the variogram modeling workflow
-        int oldNReal = m_gpf_gam->getParameter<GSLibParUInt*>(4)->_value;
-        //for each realization number...
-        for( uint iRealNum = 0 ; iRealNum < nReals; ++iRealNum ){
-            //...change the realization number parameter for gam
-            m_gpf_gam->getParameter<GSLibParUInt*>(4)->_value = iRealNum + 1;
-            //...set an output file with experimental variogram values
-            m_gpf_gam->getParameter<GSLibParFile*>(3)->_path =
-                    Application::instance()->getProject()->generateUniqueTmpFilePath("out");
-            expVarFilePaths.push_back( m_gpf_gam->getParameter<GSLibParFile*>(3)->_path );
-            //...Generate the parameter file
-            QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-            m_gpf_gam->save( par_file_path );
-            //...run gam program
-            Application::instance()->logInfo("Starting gam program for realization " +
-                                             QString::number(iRealNum + 1) + "...");
-            GSLib::instance()->runProgram( "gam", par_file_path );
-        }
-        //restore the realization number setting for the variogram modeling workflow
-        m_gpf_gam->getParameter<GSLibParUInt*>(4)->_value = oldNReal;
-    }
+    if( result != QDialog::Accepted )
+        return;
+
+    //the variograms of all realizations are computed in-process with the gam settings: the grid is read once and
+    //a single parallel pass over the cells computes the variograms of all realizations (one variable per realization)
+    GriddedVariogramCalculator calculator( m_cg_simulation );
+    calculator.setParametersFromGam( m_gpf_gam, true );
+    //the simulated variable is always the first one
+    Attribute* simulatedVariable = m_cg_simulation->getAttributeFromGEOEASIndex( 1 );
+    for( uint iRealNum = 0 ; iRealNum < nReals; ++iRealNum )
+        calculator.addVariable( simulatedVariable, iRealNum + 1 );
+    calculator.run();
+
+    //make plot/window title
+    QString title = m_primVarPSetSelector->getSelectedDataFile()->getName() + "/" +
+            m_primVarSelector->getSelectedVariableName() + ": SGSIM";
+
+    //the plot shows the first variogram along the first direction (like the first curve of the gam outputs)
+    VariogramPlotDialog *vpd = new VariogramPlotDialog( title, this );
+
+    //the variograms of the realizations (gray lines)
+    for( uint iRealNum = 0 ; iRealNum < nReals; ++iRealNum )
+        addVariogramCurve( vpd, calculator.getLags( iRealNum, 0, 0 ), Qt::gray, Qt::SolidLine );
+    //the mean (solid blue line) and the envelope (dashed green lines) of the realizations
+    addVariogramCurve( vpd, calculator.getEnsembleLags( GriddedVariogramEnsembleStatistic::MEAN, 0, 0 ),
+                       Qt::blue, Qt::SolidLine );
+    addVariogramCurve( vpd, calculator.getEnsembleLags( GriddedVariogramEnsembleStatistic::MIN, 0, 0 ),
+                       Qt::darkGreen, Qt::DashLine );
+    addVariogramCurve( vpd, calculator.getEnsembleLags( GriddedVariogramEnsembleStatistic::MAX, 0, 0 ),
+                       Qt::darkGreen, Qt::DashLine );
 
     //---------------------------------------------------------------------------------------------------------------
-    //-------------------------- 2) Run vmodel to generate the variogram model (reference)---------------------------
+    //-------------------------- 2) Make the variogram model (reference) curve---------------------------------------
     //---------------------------------------------------------------------------------------------------------------
 
     //these are useful to compute lag, azimuth and dip from gam regular grid parameters
-    double xsize = 1.0;
-    double ysize = 1.0;
-    double zsize = 1.0;
-    if( m_gpf_gam )
-    {
-        GSLibParGrid* par5 = m_gpf_gam->getParameter<GSLibParGrid*>(5);
-        xsize = par5->_specs_x->getParameter<GSLibParDouble*>(2)->_value; //cell size x
-        ysize = par5->_specs_y->getParameter<GSLibParDouble*>(2)->_value; //cell size y
-        zsize = par5->_specs_z->getParameter<GSLibParDouble*>(2)->_value; //cell size z
-    }
+    GSLibParGrid* par5 = m_gpf_gam->getParameter<GSLibParGrid*>(5);
+    double xsize = par5->_specs_x->getParameter<GSLibParDouble*>(2)->_value; //cell size x
+    double ysize = par5->_specs_y->getParameter<GSLibParDouble*>(2)->_value; //cell size y
+    double zsize = par5->_specs_z->getParameter<GSLibParDouble*>(2)->_value; //cell size z
 
     //get the selected variogram model
     VariogramModel* vm = m_vModelSelector->getSelectedVModel();
 
-    //Construct an object composition based on the parameter file template for the vmodel program.
-    GSLibParameterFile gpf_vmodel = GSLibParameterFile( "vmodel" );
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
+    //Construct an object composition based on the parameter file template for the vmodel program
+    //and fill the variogram model paramaters.
+    GSLibParameterFile gpf_vmodel( "vmodel" );
     gpf_vmodel.setDefaultValues();
-
-    //fills the variogram model paramaters.
     gpf_vmodel.setValuesFromParFile( vm->getPath() );
 
-    //output variography data for vargplt
-    gpf_vmodel.getParameter<GSLibParFile*>(0)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("var");
-
-    //match the number of lags and azimuths with that set for the gam on the realizations
+    //match the number of lags with that set for the gam on the realizations
     GSLibParMultiValuedFixed *gam_par6 = m_gpf_gam->getParameter<GSLibParMultiValuedFixed*>(6);
     GSLibParMultiValuedFixed *par1 = gpf_vmodel.getParameter<GSLibParMultiValuedFixed*>(1);
-    par1->getParameter<GSLibParUInt*>(0)->_value = gam_par6->getParameter<GSLibParUInt*>(0)->_value; //ndir
+    par1->getParameter<GSLibParUInt*>(0)->_value = 1; //ndir
     par1->getParameter<GSLibParUInt*>(1)->_value = gam_par6->getParameter<GSLibParUInt*>(1)->_value;
 
-    //get the number of directions
-    uint ndir = gam_par6->getParameter<GSLibParUInt*>(0)->_value;
-
-    //compute azimuth and dip from the grid cell dimensions and steps set in gam
+    //compute azimuth, dip and lag from the grid cell dimensions and steps set in gam for the first direction
     GSLibParRepeat *gam_par7 = m_gpf_gam->getParameter<GSLibParRepeat*>(7); //repeat ndir-times
-    QList<double> azimuths;
-    QList<double> dips;
-    QList<double> lags;
-    for(uint i = 0; i < ndir; ++i)
-    {
-        GSLibParMultiValuedFixed *par7_0 = gam_par7->getParameter<GSLibParMultiValuedFixed*>(i, 0);
-        int xstep = par7_0->getParameter<GSLibParInt*>(0)->_value;
-        int ystep = par7_0->getParameter<GSLibParInt*>(1)->_value;
-        int zstep = par7_0->getParameter<GSLibParInt*>(2)->_value;
-        azimuths.append( Util::getAzimuth( xsize, ysize, xstep, ystep ) );
-        dips.append( Util::getDip(xsize, ysize, zsize, xstep, ystep, zstep) );
-        double xlag = xstep * xsize;
-        double ylag = ystep * ysize;
-        double zlag = zstep * zsize;
-        double lag = std::sqrt( xlag*xlag + ylag*ylag + zlag*zlag );
-        lags.append( lag );
-    }
-
-    //match the azimuths, dips and lags with those of the gam
+    GSLibParMultiValuedFixed *par7_0 = gam_par7->getParameter<GSLibParMultiValuedFixed*>(0, 0);
+    int xstep = par7_0->getParameter<GSLibParInt*>(0)->_value;
+    int ystep = par7_0->getParameter<GSLibParInt*>(1)->_value;
+    int zstep = par7_0->getParameter<GSLibParInt*>(2)->_value;
+    double xlag = xstep * xsize;
+    double ylag = ystep * ysize;
+    double zlag = zstep * zsize;
     GSLibParRepeat *par2 = gpf_vmodel.getParameter<GSLibParRepeat*>(2); //repeat ndir-times
-    par2->setCount( ndir );
-    for( uint i = 0; i < ndir; ++i)
-    {
-        GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(i, 0);
-        par2_0->getParameter<GSLibParDouble*>(0)->_value = azimuths[i];
-        par2_0->getParameter<GSLibParDouble*>(1)->_value = dips[i];
-        par2_0->getParameter<GSLibParDouble*>(2)->_value = lags[i];
-    }
-
-    //Generate the vmodel parameter file
-    QString vmodel_par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf_vmodel.save( vmodel_par_file_path );
-    //run vmodel program )
-    Application::instance()->logInfo("Starting vmodel program...");
-    GSLib::instance()->runProgram( "vmodel", vmodel_par_file_path );
-
-    //-------------------------------------------------------------------------------------------
-    //-------------------------- 3) Run vargplt to show the variograms---------------------------
-    //-------------------------------------------------------------------------------------------
-
-    //make a GLSib parameter object if it wasn't done yet.
-    GSLibParameterFile gpf = GSLibParameterFile( "vargplt" );
-
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf.setDefaultValues();
-
-    //make plot/window title
-    QString title = m_primVarPSetSelector->getSelectedDataFile()->getName() + "/" +
-            m_primVarSelector->getSelectedVariableName() + ": SGSIM";
-
-    //--------------------set some parameter values-----------------------
-
-    //postscript file
-    gpf.getParameter<GSLibParFile*>(0)->_path =
-            Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //number of curves
-    gpf.getParameter<GSLibParUInt*>(1)->_value = nReals + 1; // nvarios (realizations + variogram model)
-
-    //plot title
-    gpf.getParameter<GSLibParString*>(5)->_value = title;
-
-    //suggest display settings for each variogram curve
-    GSLibParRepeat *par6 = gpf.getParameter<GSLibParRepeat*>(6); //repeat nvarios-times
-    par6->setCount( nReals + 1 ); //the realizations plus the variogram model (reference)
-    //the realization curves
-    for(uint iReal = 0; iReal < nReals; ++iReal){
-        par6->getParameter<GSLibParFile*>(iReal, 0)->_path = expVarFilePaths[iReal];
-        GSLibParMultiValuedFixed *par6_0_1 = par6->getParameter<GSLibParMultiValuedFixed*>(iReal, 1);
-        par6_0_1->getParameter<GSLibParUInt*>(0)->_value = 1;
-        par6_0_1->getParameter<GSLibParUInt*>(1)->_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(2)->_selected_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 1;
-        par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = 1;
-    }
-    par6->getParameter<GSLibParFile*>(nReals, 0)->_path = gpf_vmodel.getParameter<GSLibParFile*>(0)->_path;
-    GSLibParMultiValuedFixed *par6_0_1 = par6->getParameter<GSLibParMultiValuedFixed*>(nReals, 1);
-    par6_0_1->getParameter<GSLibParUInt*>(0)->_value = 1;
-    par6_0_1->getParameter<GSLibParUInt*>(1)->_value = 0;
-    par6_0_1->getParameter<GSLibParOption*>(2)->_selected_value = 1;
-    par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 0;
-    par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = 10;
-    //the variogram model curve
-
+    par2->setCount( 1 );
+    GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(0, 0);
+    par2_0->getParameter<GSLibParDouble*>(0)->_value = Util::getAzimuth( xsize, ysize, xstep, ystep );
+    par2_0->getParameter<GSLibParDouble*>(1)->_value = Util::getDip( xsize, ysize, zsize, xstep, ystep, zstep );
+    par2_0->getParameter<GSLibParDouble*>(2)->_value = std::sqrt( xlag*xlag + ylag*ylag + zlag*zlag );
 
     //----------------------display plot------------------------------------------------------------
+    //the model curve is computed in-process, so vmodel and vargplt are not needed
+    vpd->setVariogramModel( &gpf_vmodel );
+    vpd->show();
+}
 
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run vargplt program
-    Application::instance()->logInfo("Starting vargplt program...");
-    GSLib::instance()->runProgram( "vargplt", par_file_path );
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(0)->_path,
-                                                   gpf.getParameter<GSLibParString*>(5)->_value,
-                                                   gpf,
-                                                   this);
-    dpd->show();
-
+void SGSIMDialog::addVariogramCurve(VariogramPlotDialog *vpd, const std::vector<GriddedVariogramLag> &lags,
+                                    const QColor &color, Qt::PenStyle style)
+{
+    std::vector<double> distances, gammas;
+    for( const GriddedVariogramLag& lag : lags ){
+        //lags without pairs have no variogram value
+        if( lag.numberOfPairs <= 0 )
+            continue;
+        distances.push_back( lag.distance );
+        gammas.push_back( lag.value );
+    }
+    vpd->addExperimentalCurve( distances, gammas, color, true, style );
 }
 
 void SGSIMDialog::onSaveEnsemble()
@@ -792,14 +695,10 @@ void SGSIMDialog::onSaveEnsemble()
 
 void SGSIMDialog::onPostsim()
 {
-    //load the data in grid
-    m_cg_simulation->loadData();
-
-    //get the maximum and minimun of simulated values
-    double data_min = m_cg_simulation->min( 0 );
-    double data_max = m_cg_simulation->max( 0 );
-    data_min -= std::fabs( data_min / 100.0 );
-    data_max += std::fabs( data_max / 100.0 );
+    //the realizations are not loaded all at once to get the min and max for the trimming limits,
+    //so no trimming is set by default (the no-data values are ignored anyway)
+    double data_min = -1.0e20;
+    double data_max = 1.0e20;
 
     //create the parameters object if not created
     if( ! m_gpf_postsim ){
@@ -828,13 +727,22 @@ void SGSIMDialog::onPostsim()
 
     //if user didn't cancel the dialog
     if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "par" );
-        m_gpf_postsim->save( par_file_path );
-
-        //run postsim program asynchronously
-        Application::instance()->logInfo("Starting postsim program...");
-        GSLib::instance()->runProgram( "postsim", par_file_path );
+        //the post-processing is done in-process (the realizations are streamed one by one) with
+        //the settings entered in the postsim parameters
+        EnsembleStatistics ensemble( m_cg_simulation->getAttributeFromGEOEASIndex( 1 ) );
+        ensemble.setTrimmingLimits( par2->getParameter<GSLibParDouble*>(0)->_value,
+                                    par2->getParameter<GSLibParDouble*>(1)->_value );
+        GSLibParMultiValuedFixed* par5 = m_gpf_postsim->getParameter<GSLibParMultiValuedFixed*>(5);
+        int option = par5->getParameter<GSLibParOption*>(0)->_selected_value;
+        double outputParameter = par5->getParameter<GSLibParDouble*>(1)->_value;
+        switch( option ){
+        case 2: ensemble.setThreshold( outputParameter ); break;
+        case 3: ensemble.setQuantileProbabilities( { outputParameter } ); break;
+        case 4: ensemble.setQuantileProbabilities( { ( 1.0 - outputParameter ) / 2.0,
+                                                     ( 1.0 + outputParameter ) / 2.0 } ); break;
+        }
+        ensemble.run();
+        ensemble.saveCellStatistics( option, m_gpf_postsim->getParameter<GSLibParFile*>(4)->_path );
 
         previewPostsim();
     }
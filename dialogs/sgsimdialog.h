@@ -2,6 +2,7 @@
 #define SGSIMDIALOG_H
 
 #include <QDialog>
+#include <vector>
 
 namespace Ui {
 class SGSIMDialog;
@@ -19,6 +20,8 @@ class DataFile;
 class GSLibParameterFile;
 class VariogramModel;
 class CartesianGrid;
+class VariogramPlotDialog;
+struct GriddedVariogramLag;
 
 
 class SGSIMDialog : public QDialog
@@ -54,6 +57,9 @@ private:
     void updateVariogramParameters(VariogramModel *vm );
     void preview();
     void previewPostsim();
+    /** Adds the lags with pairs of an experimental variogram to the plot as a curve. */
+    void addVariogramCurve( VariogramPlotDialog* vpd, const std::vector<GriddedVariogramLag>& lags,
+                            const QColor& color, Qt::PenStyle style );
 
 private slots:
     void onGridCopySpectsSelected( DataFile* grid );
@@ -3,6 +3,8 @@
 #include "domain/pointset.h"
 #include "domain/cartesiangrid.h"
 #include "domain/experimentalvariogram.h"
+#include "geostats/variogramfitter.h"
+#include "domain/variogrammodel.h"
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslib.h"
@@ -13,6 +15,8 @@
 #include "realizationselectiondialog.h"
 #include <QMessageBox>
 #include "displayplotdialog.h"
+#include "variogramplotdialog.h"
+#include "plotting/variogramplot.h"
 #include <QDir>
 #include <QInputDialog>
 #include <cmath>
@@ -468,6 +472,27 @@ void VariogramAnalysisDialog::onOpenVariogramModelParamateres()
         return;
     }
 
+    makeVmodelParameters();
+
+    //the model curves are computed in-process and redrawn along with the experimental variogram
+    //while the parameters are edited
+    VariogramPlotDialog* vpd = makeVariogramModelPlot();
+    vpd->show();
+
+    //show the parameter dialog so the user can review and adjust the model
+    GSLibParametersDialog gslibpardiag( m_gpf_vmodel );
+    gslibpardiag.enableLiveUpdates();
+    connect( &gslibpardiag, SIGNAL(parametersUpdated()), vpd, SLOT(onVariogramModelChanged()) );
+    if( gslibpardiag.exec() != QDialog::Accepted )
+        vpd->close();
+}
+
+void VariogramAnalysisDialog::makeVmodelParameters()
+{
+    //the parameters are made once, then the user edits them
+    if( m_gpf_vmodel )
+        return;
+
     //suggest number of directions based on the previous experimental variogram computation
     uint ndir = 1; //default for variogram fitting mode
     if( m_gpf_gamv )
@@ -598,66 +623,147 @@ void VariogramAnalysisDialog::onOpenVariogramModelParamateres()
     }
 
     //now that the geometric parameters were defined, we can make
-    //a vmodel parameters object
-    if( ! m_gpf_vmodel )
+    //a vmodel parameters object: construct an object composition based on the parameter file template for the vmodel program.
+    m_gpf_vmodel = new GSLibParameterFile( "vmodel" );
+    //Set default values so we need to change less parameters and let
+    //the user change the others as one may see fit.
+    m_gpf_vmodel->setDefaultValues();
+
+    m_gpf_vmodel->getParameter<GSLibParFile*>(0)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("var");
+
+    GSLibParMultiValuedFixed *par1 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(1);
+    par1->getParameter<GSLibParUInt*>(0)->_value = ndir; //ndir
+    par1->getParameter<GSLibParUInt*>(1)->_value = nlags;
+
+    //suggests azimuths, dips and lags based on the experimental variogram computation parameters
+    GSLibParRepeat *par2 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(2); //repeat ndir-times
+    par2->setCount( ndir );
+    for( uint i = 0; i < ndir; ++i)
     {
-        //Construct an object composition based on the parameter file template for the vmodel program.
-        m_gpf_vmodel = new GSLibParameterFile( "vmodel" );
-        //Set default values so we need to change less parameters and let
-        //the user change the others as one may see fit.
-        m_gpf_vmodel->setDefaultValues();
+        GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        par2_0->getParameter<GSLibParDouble*>(0)->_value = azimuths[i];
+        par2_0->getParameter<GSLibParDouble*>(1)->_value = dips[i];
+        par2_0->getParameter<GSLibParDouble*>(2)->_value = lags[i];
+    }
+}
 
-        m_gpf_vmodel->getParameter<GSLibParFile*>(0)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("var");
+VariogramPlotDialog *VariogramAnalysisDialog::makeVariogramModelPlot()
+{
+    //make plot/window title
+    QString title( "Variogram model" );
+    if( m_head && m_tail )
+        title = m_head->getContainingFile()->getName() + " variogram model: " +
+                m_head->getName() + "(u) x " + m_tail->getName() + "(u+h)";
+    if( m_ev )
+        title = "Variogram model for " + m_ev->getName();
 
-        GSLibParMultiValuedFixed *par1 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(1);
-        par1->getParameter<GSLibParUInt*>(0)->_value = ndir; //ndir
-        par1->getParameter<GSLibParUInt*>(1)->_value = nlags;
+    VariogramPlotDialog* vpd = new VariogramPlotDialog( title, this );
 
-        //suggests azimuths, dips and lags based on the experimental variogram computation parameters
-        GSLibParRepeat *par2 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(2); //repeat ndir-times
-        par2->setCount( ndir );
-        for( uint i = 0; i < ndir; ++i)
-        {
-            GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(i, 0);
-            par2_0->getParameter<GSLibParDouble*>(0)->_value = azimuths[i];
-            par2_0->getParameter<GSLibParDouble*>(1)->_value = dips[i];
-            par2_0->getParameter<GSLibParDouble*>(2)->_value = lags[i];
-        }
-    }
+    //the experimental curves have the same colors of the model curves of the same directions
+    std::vector<ExperimentalVariogramCurve> curves;
+    if( ExperimentalVariogram::readCurves( getExperimentalVariogramPath(), curves ) )
+        for( size_t i = 0; i < curves.size(); ++i )
+            vpd->addExperimentalCurve( curves[i].distances, curves[i].gammas, VariogramPlot::getCurveColor( i ) );
 
-    //show the parameter dialog so the user can review and adjust other settings before running vmodel
-    GSLibParametersDialog gslibpardiag( m_gpf_vmodel );
-    int result = gslibpardiag.exec();
-    if( result == QDialog::Accepted ){
-        //Generate the parameter file
-        QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-        m_gpf_vmodel->save( par_file_path );
-        //to be notified when vmap completes.
-        connect( GSLib::instance(), SIGNAL(programFinished()), this, SLOT(onVmodelCompletion()) );
-        //run vmodel program asynchronously (user can see the program outputs while it runs)
-        Application::instance()->logInfo("Starting vmodel program...");
-        GSLib::instance()->runProgramAsync( "vmodel", par_file_path );
-    }
+    vpd->setVariogramModel( m_gpf_vmodel );
+    return vpd;
 }
 
-void VariogramAnalysisDialog::onVmodelCompletion()
+void VariogramAnalysisDialog::onVariogramModelPlot()
 {
-    //frees all signal connections to the GSLib singleton.
-    GSLib::instance()->disconnect();
     if( ! m_gpf_vmodel )
     {
         QMessageBox::critical( this, "Error", "You must first model the variogram at least once.");
         return;
     }
-    if( m_gpf_gamv ){
-        onVargplt( m_gpf_gamv->getParameter<GSLibParFile*>(4)->_path, m_gpf_vmodel->getParameter<GSLibParFile*>(0)->_path );
+    makeVariogramModelPlot()->show();
+}
+
+QString VariogramAnalysisDialog::getExperimentalVariogramPath()
+{
+    if( m_gpf_gamv )
+        return m_gpf_gamv->getParameter<GSLibParFile*>(4)->_path;
+    if( m_gpf_gam )
+        return m_gpf_gam->getParameter<GSLibParFile*>(3)->_path;
+    if( m_ev )
+        return m_ev->getPath();
+    return "";
+}
+
+void VariogramAnalysisDialog::onFitVariogramModel()
+{
+    if( !m_gpf_gam and !m_gpf_gamv and !m_ev ){
+        QMessageBox::critical( this, "Error", "To perform variogam fitting, you must first compute the experimental variogram at least once.");
+        return;
     }
-    if( m_gpf_gam ){
-        onVargplt( m_gpf_gam->getParameter<GSLibParFile*>(3)->_path, m_gpf_vmodel->getParameter<GSLibParFile*>(0)->_path );
+
+    makeVmodelParameters();
+
+    //read the experimental variogram curves
+    std::vector<ExperimentalVariogramCurve> curves;
+    if( ! ExperimentalVariogram::readCurves( getExperimentalVariogramPath(), curves ) || curves.empty() ){
+        QMessageBox::critical( this, "Error", "Could not read the experimental variogram curves.  Check the messages panel.");
+        return;
+    }
+
+    //the directions of the curves are those of the model curves (the first curves of the experimental
+    //variogram file are those of the first variogram type)
+    GSLibParRepeat *par2 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(2); //repeat ndir-times
+    uint ndir = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(1)->getParameter<GSLibParUInt*>(0)->_value;
+    std::vector<double> azimuths, dips;
+    for( uint i = 0; i < ndir && i < curves.size(); ++i ){
+        GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        azimuths.push_back( par2_0->getParameter<GSLibParDouble*>(0)->_value );
+        dips.push_back( par2_0->getParameter<GSLibParDouble*>(1)->_value );
+    }
+
+    //the number of structures and the anisotropy (angles and range ratios of the first structure)
+    //are kept from the current model parameters
+    GSLibParMultiValuedFixed *par3 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(3);
+    GSLibParRepeat *par4 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(4); //repeat nst-times
+    uint nst = par3->getParameter<GSLibParUInt*>(0)->_value;
+    double azimuth = 0.0, dip = 0.0, roll = 0.0, semiMinorRatio = 1.0, verticalRatio = 1.0;
+    if( nst > 0 ){
+        par4->setCount( nst );
+        GSLibParMultiValuedFixed *par4_0 = par4->getParameter<GSLibParMultiValuedFixed*>(0, 0);
+        GSLibParMultiValuedFixed *par4_1 = par4->getParameter<GSLibParMultiValuedFixed*>(0, 1);
+        azimuth = par4_0->getParameter<GSLibParDouble*>(2)->_value;
+        dip = par4_0->getParameter<GSLibParDouble*>(3)->_value;
+        roll = par4_0->getParameter<GSLibParDouble*>(4)->_value;
+        double a_hMax = par4_1->getParameter<GSLibParDouble*>(0)->_value;
+        if( a_hMax > 0.0 ){
+            semiMinorRatio = par4_1->getParameter<GSLibParDouble*>(1)->_value / a_hMax;
+            verticalRatio = par4_1->getParameter<GSLibParDouble*>(2)->_value / a_hMax;
+        }
+    }
+
+    //fit the model
+    VariogramFitter fitter;
+    fitter.addCurves( curves, azimuths, dips );
+    fitter.setNumberOfStructures( nst );
+    fitter.setAnisotropy( azimuth, dip, roll, semiMinorRatio, verticalRatio );
+    if( ! fitter.fit() ){
+        QMessageBox::critical( this, "Error", "Variogram fitting failed.  Check the messages panel.");
+        return;
     }
-    if( m_ev ){
-        onVargplt( m_ev->getPath(), m_gpf_vmodel->getParameter<GSLibParFile*>(0)->_path );
+
+    //update the model parameters with the fitted ones
+    par3->getParameter<GSLibParDouble*>(1)->_value = fitter.getNugget();
+    for( uint inst = 0; inst < nst; ++inst ){
+        GSLibParMultiValuedFixed *par4_0 = par4->getParameter<GSLibParMultiValuedFixed*>(inst, 0);
+        GSLibParMultiValuedFixed *par4_1 = par4->getParameter<GSLibParMultiValuedFixed*>(inst, 1);
+        par4_0->getParameter<GSLibParOption*>(0)->_selected_value = (int)fitter.getType( inst );
+        par4_0->getParameter<GSLibParDouble*>(1)->_value = fitter.getContribution( inst );
+        par4_0->getParameter<GSLibParDouble*>(2)->_value = azimuth;
+        par4_0->getParameter<GSLibParDouble*>(3)->_value = dip;
+        par4_0->getParameter<GSLibParDouble*>(4)->_value = roll;
+        par4_1->getParameter<GSLibParDouble*>(0)->_value = fitter.get_a_hMax( inst );
+        par4_1->getParameter<GSLibParDouble*>(1)->_value = fitter.get_a_hMin( inst );
+        par4_1->getParameter<GSLibParDouble*>(2)->_value = fitter.get_a_vert( inst );
     }
+
+    //display the fitted model along with the experimental variogram
+    makeVariogramModelPlot()->show();
 }
 
 void VariogramAnalysisDialog::onSaveVariogramModel()
@@ -842,7 +948,7 @@ void VariogramAnalysisDialog::onVargpltExperimentalIrregular()
         QMessageBox::critical( this, "Error", "You must first compute the experimental variogram at least once.");
         return;
     }
-    onVargplt( m_gpf_gamv->getParameter<GSLibParFile*>(4)->_path, "" );
+    onVargplt( m_gpf_gamv->getParameter<GSLibParFile*>(4)->_path );
 }
 
 void VariogramAnalysisDialog::onVargpltExperimentalRegular()
@@ -851,10 +957,10 @@ void VariogramAnalysisDialog::onVargpltExperimentalRegular()
         QMessageBox::critical( this, "Error", "You must first compute the experimental variogram at least once.");
         return;
     }
-    onVargplt( m_gpf_gam->getParameter<GSLibParFile*>(3)->_path, "" );
+    onVargplt( m_gpf_gam->getParameter<GSLibParFile*>(3)->_path );
 }
 
-void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data , const QString path_to_vmodel_output)
+void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data)
 {
 
     //compute a number of variogram curves to plot depending on
@@ -881,15 +987,6 @@ void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data
         //get the number of curves from it
         ncurves = gpf_accessory_vargplt.getParameter<GSLibParUInt*>(1)->_value;
     }
-    //if a variogram model is to be displayed during variogram model fitting, then
-    //the number of curved increases accordingly
-    uint ncurves_models = 0; //default is no variogram model curve to plot
-    if( ! path_to_vmodel_output.isEmpty() )
-    {
-        GSLibParMultiValuedFixed *par1 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(1);
-        ncurves_models = par1->getParameter<GSLibParUInt*>(0)->_value;
-    }
-
     //make list of captions for the legend text further down
     QStringList legendCaptions;
     for( uint i = 0; i < ndirections; ++i){
@@ -941,7 +1038,7 @@ void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data
 
         //suggest display settings for each variogram curve
         GSLibParRepeat *par6 = m_gpf_vargplt->getParameter<GSLibParRepeat*>(6); //repeat nvarios-times
-        par6->setCount( ncurves + ncurves_models );
+        par6->setCount( ncurves );
         //the experimental curves
         for(uint i = 0; i < ncurves; ++i)
         {
@@ -953,32 +1050,21 @@ void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data
             par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 0;
             par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = (i % 15) + 1; //cycle through the available colors (except the gray tones)
         }
-        //the model curves
-        for(uint i = ncurves; i < (ncurves + ncurves_models); ++i)
-        {
-            par6->getParameter<GSLibParFile*>(i, 0)->_path = path_to_vmodel_output;
-            GSLibParMultiValuedFixed *par6_0_1 = par6->getParameter<GSLibParMultiValuedFixed*>(i, 1);
-            par6_0_1->getParameter<GSLibParUInt*>(0)->_value = i - ncurves + 1;
-            par6_0_1->getParameter<GSLibParUInt*>(1)->_value = 0;
-            par6_0_1->getParameter<GSLibParOption*>(2)->_selected_value = 0;
-            par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 1;
-            par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = ((i - ncurves) % 15) + 1; //cycle through the available colors (except the gray tones)
-        }
 
         //plot title
         m_gpf_vargplt->getParameter<GSLibParString*>(5)->_value = title;
     }
 
     //suggest (number of directions * number of variograms) from the variogram calculation parameters
-    m_gpf_vargplt->getParameter<GSLibParUInt*>(1)->_value = ncurves + ncurves_models; // nvarios
+    m_gpf_vargplt->getParameter<GSLibParUInt*>(1)->_value = ncurves; // nvarios
 
     //adjust curve count as needed
     GSLibParRepeat *par6 = m_gpf_vargplt->getParameter<GSLibParRepeat*>(6); //repeat nvarios-times
     uint old_count = par6->getCount();
-    par6->setCount( ncurves + ncurves_models );
+    par6->setCount( ncurves );
 
     //determine wether the number of curves changed
-    bool curve_count_changed = ( old_count != ncurves + ncurves_models );
+    bool curve_count_changed = ( old_count != ncurves );
 
     //suggest experimental variogram visual parameters if the number of curves changes
     //also updates color legend
@@ -999,28 +1085,12 @@ void VariogramAnalysisDialog::onVargplt(const QString path_to_exp_variogram_data
             Application::instance()->logWarn("VariogramAnalysisDialog::onVargplt(): Generation or update of color legend text in variogram plot not available.");
     }
 
-    //suggest model curves visual parameters after vmodel runs (only if curve count changed)
-    for(uint i = ncurves; i < (ncurves + ncurves_models) && curve_count_changed; ++i)
-    {
-        par6->getParameter<GSLibParFile*>(i, 0)->_path = path_to_vmodel_output;
-        GSLibParMultiValuedFixed *par6_0_1 = par6->getParameter<GSLibParMultiValuedFixed*>(i, 1);
-        par6_0_1->getParameter<GSLibParUInt*>(0)->_value = i - ncurves + 1;
-        par6_0_1->getParameter<GSLibParUInt*>(1)->_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(2)->_selected_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 1;
-        par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = ((i - ncurves) % 15) + 1; //cycle through the available colors (except the gray tones)
-    }
-
     //input is the output of gamv/gam
     //FIXME: handle different experimental variogram data files (repeat tag)
     for(uint i = 0; i < ncurves; ++i)
     {
         par6->getParameter<GSLibParFile*>(i, 0)->_path = path_to_exp_variogram_data;
     }
-    for(uint i = ncurves; i < (ncurves + ncurves_models); ++i)
-    {
-        par6->getParameter<GSLibParFile*>(i, 0)->_path = path_to_vmodel_output;
-    }
 
     //save and use a txt file to serve as legend
     if( ! legendCaptions.isEmpty() ){
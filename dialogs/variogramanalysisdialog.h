@@ -12,6 +12,7 @@ class GSLibParameterFile;
 class CartesianGrid;
 class ExperimentalVariogram;
 class RealizationSelectionDialog;
+class VariogramPlotDialog;
 
 class VariogramAnalysisDialog : public QDialog
 {
@@ -51,6 +52,13 @@ private:
     /** Does some UI details not in ui->setup(). */
     void finishUISetup();
     bool isCrossVariography();
+    /** Returns the path to the file with the last experimental variogram curves (output of gamv or gam). */
+    QString getExperimentalVariogramPath();
+    /** Creates the vmodel parameters with the directions and lags of the experimental variogram if not made yet. */
+    void makeVmodelParameters();
+    /** Creates a plot window with the experimental variogram and the curves of the current model computed
+     *  in-process.  The window is not shown. */
+    VariogramPlotDialog* makeVariogramModelPlot();
 
 private slots:
     void onOpenVarMapParameters();
@@ -60,8 +68,9 @@ private slots:
     void onSaveVarmapGrid();
     void onSaveExpVariogram();
     void onOpenVariogramModelParamateres();
-    void onVmodelCompletion();
+    void onVariogramModelPlot();
     void onSaveVariogramModel();
+    void onFitVariogramModel();
     void onVarNReals();
     // the slots below are called indirectly.
     void onGamv();
@@ -69,8 +78,7 @@ private slots:
     void onVarmapCompletion();
     void onVargpltExperimentalIrregular();
     void onVargpltExperimentalRegular();
-    /** @param path_to_vmodel_output If empty, only the experimental variogram is plotted. */
-    void onVargplt(const QString path_to_exp_variogram_data, const QString path_to_vmodel_output);
+    void onVargplt(const QString path_to_exp_variogram_data);
     /** @param forMultipleRealizations onGam is used for simulation validation, to generate a single plot
      *  of several realization variograms instead of for modeling purposes.
      */
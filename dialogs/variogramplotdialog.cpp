@@ -0,0 +1,148 @@
+#include "variogramplotdialog.h"
+#include "ui_variogramplotdialog.h"
+
+#include "domain/variogrammodel.h"
+#include "geostats/variogrammodelcurves.h"
+#include "gslib/gslibparameterfiles/gslibparameterfile.h"
+#include "gslib/gslibparameterfiles/gslibparamtypes.h"
+#include "plotting/variogramplot.h"
+#include "util.h"
+
+#include <QFileDialog>
+#include <algorithm>
+
+namespace {
+
+    /** The number of points computed per lag of the model curves, so they look smooth. */
+    const int MODEL_POINTS_PER_LAG = 10;
+}
+
+VariogramPlotDialog::VariogramPlotDialog(const QString title, QWidget *parent) :
+    QDialog(parent),
+    ui(new Ui::VariogramPlotDialog),
+    m_plot( nullptr ),
+    m_gpf_vmodel( nullptr ),
+    m_modelCurves( nullptr )
+{
+    ui->setupUi(this);
+
+    //deletes dialog from memory upon user closing it
+    this->setAttribute(Qt::WA_DeleteOnClose);
+
+    setWindowTitle( title );
+
+    //add the plot widget (not originally present in .UI file)
+    m_plot = new VariogramPlot();
+    m_plot->setTitle( title );
+    ui->frmPlot->layout()->addWidget( m_plot );
+
+    connect( ui->btnSaveImage, SIGNAL(clicked()), this, SLOT(onSaveImage()) );
+
+    if( Util::getDisplayResolutionClass() == DisplayResolution::HIGH_DPI )
+        ui->btnSaveImage->setIcon( QIcon(":icons32/snapshot32") );
+}
+
+VariogramPlotDialog::~VariogramPlotDialog()
+{
+    delete m_modelCurves;
+    delete ui;
+}
+
+void VariogramPlotDialog::addExperimentalCurve(const std::vector<double> &distances, const std::vector<double> &gammas,
+                                               const QColor &color, bool joinPoints, Qt::PenStyle style)
+{
+    ExperimentalCurve curve;
+    curve.distances = distances;
+    curve.gammas = gammas;
+    curve.color = color;
+    curve.joinPoints = joinPoints;
+    curve.style = style;
+    m_experimentalCurves.push_back( curve );
+}
+
+void VariogramPlotDialog::setVariogramModel(GSLibParameterFile *gpf_vmodel)
+{
+    m_gpf_vmodel = gpf_vmodel;
+    onVariogramModelChanged();
+}
+
+void VariogramPlotDialog::refresh()
+{
+    m_plot->clear();
+
+    for( const ExperimentalCurve& curve : m_experimentalCurves )
+        m_plot->addExperimentalCurve( curve.distances, curve.gammas, curve.color, curve.joinPoints, curve.style );
+
+    if( m_modelCurves ){
+        for( int i = 0; i < m_modelCurves->getCurveCount(); ++i )
+            m_plot->addModelCurve( m_modelCurves->getDistances( i ), m_modelCurves->getGammas( i ),
+                                   VariogramPlot::getCurveColor( i ) );
+        m_plot->setSill( m_modelCurves->getSill() );
+    }
+
+    m_plot->replot();
+}
+
+void VariogramPlotDialog::onVariogramModelChanged()
+{
+    delete m_modelCurves;
+    m_modelCurves = nullptr;
+    if( ! m_gpf_vmodel ){
+        refresh();
+        return;
+    }
+    m_modelCurves = new VariogramModelCurves();
+
+    //the directions and lags of the curves
+    GSLibParMultiValuedFixed *par1 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(1);
+    uint ndir = par1->getParameter<GSLibParUInt*>(0)->_value;
+    m_modelCurves->setNumberOfLags( par1->getParameter<GSLibParUInt*>(1)->_value );
+    m_modelCurves->setPointsPerLag( MODEL_POINTS_PER_LAG );
+    GSLibParRepeat *par2 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(2); //repeat ndir-times
+    //the repeats may lag behind the counts while the parameters are being edited, so only what exists is plotted
+    ndir = std::min( ndir, par2->getCount() );
+    for( uint i = 0; i < ndir; ++i ){
+        GSLibParMultiValuedFixed *par2_0 = par2->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        m_modelCurves->addDirection( par2_0->getParameter<GSLibParDouble*>(0)->_value,
+                                     par2_0->getParameter<GSLibParDouble*>(1)->_value,
+                                     par2_0->getParameter<GSLibParDouble*>(2)->_value );
+    }
+
+    //the nugget effect and the structures
+    GSLibParMultiValuedFixed *par3 = m_gpf_vmodel->getParameter<GSLibParMultiValuedFixed*>(3);
+    m_modelCurves->setNugget( par3->getParameter<GSLibParDouble*>(1)->_value );
+    uint nst = par3->getParameter<GSLibParUInt*>(0)->_value;
+    GSLibParRepeat *par4 = m_gpf_vmodel->getParameter<GSLibParRepeat*>(4); //repeat nst-times
+    nst = std::min( nst, par4->getCount() );
+    for( uint inst = 0; inst < nst; ++inst ){
+        GSLibParMultiValuedFixed *par4_0 = par4->getParameter<GSLibParMultiValuedFixed*>(inst, 0);
+        GSLibParMultiValuedFixed *par4_1 = par4->getParameter<GSLibParMultiValuedFixed*>(inst, 1);
+        //skip the structures whose ranges are still being entered
+        if( par4_1->getParameter<GSLibParDouble*>(0)->_value <= 0.0 ||
+            par4_1->getParameter<GSLibParDouble*>(1)->_value <= 0.0 ||
+            par4_1->getParameter<GSLibParDouble*>(2)->_value <= 0.0 )
+            continue;
+        m_modelCurves->addStructure( (VariogramStructureType)par4_0->getParameter<GSLibParOption*>(0)->_selected_value,
+                                     par4_0->getParameter<GSLibParDouble*>(1)->_value,
+                                     par4_1->getParameter<GSLibParDouble*>(0)->_value,
+                                     par4_1->getParameter<GSLibParDouble*>(1)->_value,
+                                     par4_1->getParameter<GSLibParDouble*>(2)->_value,
+                                     par4_0->getParameter<GSLibParDouble*>(2)->_value,
+                                     par4_0->getParameter<GSLibParDouble*>(3)->_value,
+                                     par4_0->getParameter<GSLibParDouble*>(4)->_value );
+    }
+
+    m_modelCurves->compute();
+
+    refresh();
+}
+
+void VariogramPlotDialog::onSaveImage()
+{
+    QString path = QFileDialog::getSaveFileName( this, "Save plot image", Util::getLastBrowsedDirectory(),
+                                                 "PNG image (*.png)" );
+    if( path.isEmpty() )
+        return;
+    Util::saveLastBrowsedDirectoryOfFile( path );
+    m_plot->grab().save( path, "PNG" );
+}
@@ -0,0 +1,69 @@
+#ifndef VARIOGRAMPLOTDIALOG_H
+#define VARIOGRAMPLOTDIALOG_H
+
+#include <QDialog>
+#include <QColor>
+#include <vector>
+
+namespace Ui {
+class VariogramPlotDialog;
+}
+
+class VariogramPlot;
+class VariogramModelCurves;
+class GSLibParameterFile;
+
+/**
+ * The VariogramPlotDialog displays experimental variograms and the curves of a variogram model with VariogramPlot.
+ * The model curves are computed in-process with VariogramModelCurves from vmodel parameters, so no vmodel or vargplt
+ * runs are needed.  Connecting GSLibParametersDialog::parametersUpdated() (see GSLibParametersDialog::enableLiveUpdates())
+ * to onVariogramModelChanged() redraws the model while its parameters are edited.
+ */
+class VariogramPlotDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit VariogramPlotDialog( const QString title, QWidget *parent = 0 );
+    ~VariogramPlotDialog();
+
+    /** Adds an experimental variogram curve drawn as points (see VariogramPlot::addExperimentalCurve()). */
+    void addExperimentalCurve( const std::vector<double>& distances, const std::vector<double>& gammas,
+                               const QColor& color, bool joinPoints = false, Qt::PenStyle style = Qt::SolidLine );
+
+    /**
+     * Sets the vmodel parameters with the variogram model and the directions and lags of its curves, computes the
+     * model curves and redraws the plot.  The parameter object is read again by onVariogramModelChanged(), so it must
+     * exist while that slot can be called.
+     */
+    void setVariogramModel( GSLibParameterFile* gpf_vmodel );
+
+    /** Redraws the plot. */
+    void refresh();
+
+public slots:
+    /** Recomputes the model curves from the vmodel parameters and redraws the plot. */
+    void onVariogramModelChanged();
+
+private:
+    Ui::VariogramPlotDialog *ui;
+    VariogramPlot* m_plot;
+    GSLibParameterFile* m_gpf_vmodel;
+    /** The model curves computed from m_gpf_vmodel or null if there is no model to display. */
+    VariogramModelCurves* m_modelCurves;
+
+    /** The experimental variogram curves, kept to redraw the plot when the model changes. */
+    struct ExperimentalCurve{
+        std::vector<double> distances;
+        std::vector<double> gammas;
+        QColor color;
+        bool joinPoints;
+        Qt::PenStyle style;
+    };
+    std::vector<ExperimentalCurve> m_experimentalCurves;
+
+private slots:
+    void onSaveImage();
+};
+
+#endif // VARIOGRAMPLOTDIALOG_H
@@ -3,6 +3,8 @@
 #include <QDir>
 #include <QSettings>
 #include <QMessageBox>
+#include <QThread>
+#include <algorithm>
 
 //global instance pointer in the heap.
 Application* Application::_instance = nullptr;
@@ -77,6 +79,46 @@ void Application::setMaxGridCellCountFor3DVisualizationSetting(int value)
     qs.setValue("maxcellgrid3dview", value);
 }
 
+int Application::getMaxPointCountFor3DVisualizationSetting()
+{
+    QSettings qs;
+    bool ok;
+    int setting = qs.value("maxpoints3dview").toInt( &ok );
+    if( ! ok )
+        return 1000000; //default
+    else
+        return setting;
+}
+
+void Application::setMaxPointCountFor3DVisualizationSetting(int value)
+{
+    QSettings qs;
+    qs.setValue("maxpoints3dview", value);
+}
+
+int Application::getMaxConcurrentGSLibJobsSetting()
+{
+    QSettings qs;
+    bool ok;
+    int setting = qs.value("maxgslibjobs").toInt( &ok );
+    if( ! ok || setting < 1 )
+        return getDefaultMaxConcurrentGSLibJobs();
+    else
+        return setting;
+}
+
+int Application::getDefaultMaxConcurrentGSLibJobs()
+{
+    //idealThreadCount() returns -1 if the number of cores cannot be detected
+    return std::max( 1, QThread::idealThreadCount() );
+}
+
+void Application::setMaxConcurrentGSLibJobsSetting(int value)
+{
+    QSettings qs;
+    qs.setValue("maxgslibjobs", value);
+}
+
 void Application::logInfo(const QString text, bool showMessageBox)
 {
     Q_ASSERT(_mw != 0);
@@ -79,6 +79,23 @@ public:
     void setMaxGridCellCountFor3DVisualizationSetting(int value);
     //!@}
 
+    //!@{
+    //! Reads and saves the maximum number of points of a point set rendered in the 3D viewer
+    //! while the camera is being manipulated.
+    int getMaxPointCountFor3DVisualizationSetting();
+    void setMaxPointCountFor3DVisualizationSetting(int value);
+    //!@}
+
+    //!@{
+    //! Reads and saves the maximum number of GSLib programs run concurrently by GSLibJobRunner.
+    int getMaxConcurrentGSLibJobsSetting();
+    void setMaxConcurrentGSLibJobsSetting(int value);
+    //!@}
+
+    /** Returns the number of concurrent GSLib programs used when the user has not set one:
+     *  one program per processor core. */
+    static int getDefaultMaxConcurrentGSLibJobs();
+
     /**
      * @brief Treats the text as an information text.
      */
@@ -72,6 +72,10 @@ void DataLoader::doLoad() { /* do what you need and emit progress signal */
                //add the line to the list
                _data.push_back( std::move( data_line ) );
                ++_data_line_count;
+               //no need to read the rest of the file beyond the target interval (e.g. when reading a single
+               //realization of a multi-realization grid)
+               if( _data_line_count > _lastDataLineToRead )
+                   break;
            }
        } else { //if the data line is not within the target interval
            ++_data_line_count; //just count it as parsed.
@@ -0,0 +1,79 @@
+#include "geoeasheadercache.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include "util.h"
+
+/*static*/ QHash<QString, GEOEASHeaderCache::Entry> GEOEASHeaderCache::s_entries;
+/*static*/ QMutex GEOEASHeaderCache::s_mutex;
+
+GEOEASHeader GEOEASHeaderCache::getHeader(const QString file_path)
+{
+    QFileInfo info( file_path );
+    QString key = info.absoluteFilePath();
+    QDateTime lastModified = info.lastModified();
+    qint64 size = info.size();
+
+    {
+        QMutexLocker locker( &s_mutex );
+        QHash<QString, Entry>::const_iterator it = s_entries.constFind( key );
+        if( it != s_entries.constEnd() && it->lastModified == lastModified && it->size == size )
+            return it->header;
+    }
+
+    //the file is read outside the lock, so other files can be served meanwhile
+    Entry entry;
+    entry.header = readHeader( file_path );
+    entry.lastModified = lastModified;
+    entry.size = size;
+
+    QMutexLocker locker( &s_mutex );
+    s_entries.insert( key, entry );
+    return entry.header;
+}
+
+void GEOEASHeaderCache::invalidate(const QString file_path)
+{
+    QMutexLocker locker( &s_mutex );
+    s_entries.remove( QFileInfo( file_path ).absoluteFilePath() );
+}
+
+GEOEASHeader GEOEASHeaderCache::readHeader(const QString file_path)
+{
+    GEOEASHeader header;
+    QFile file( file_path );
+    //read in binary mode so the file position is the actual byte offset
+    if( ! file.open( QFile::ReadOnly ) )
+        return header;
+    int n_vars = 0;
+    int var_count = 0;
+    for (uint i = 0; !file.atEnd(); ++i)
+    {
+       qint64 lineStart = file.pos();
+       //read file line by line
+       QString line = QString::fromLocal8Bit( file.readLine() );
+       //remove the line break (may be CR+LF)
+       while( line.endsWith('\n') || line.endsWith('\r') )
+           line.chop( 1 );
+
+       if( i == 0 ){ //first line is the description
+           header.description = line;
+       //second line is the number of variables
+       //TODO: second line may contain other information in grid files, so it will fail for such cases
+       } else if( i == 1 ){
+           n_vars = Util::getFirstNumber( line );
+       } else if ( var_count < n_vars ){ //the variables names
+           header.fieldNames << line;
+           ++var_count;
+       } else { //begin lines containing data
+           header.headerLineCount = i;
+           header.firstDataByteOffset = lineStart;
+           break;
+       }
+    }
+    //files without data lines
+    if( header.firstDataByteOffset < 0 )
+        header.headerLineCount = 2 + var_count;
+    file.close();
+    return header;
+}
@@ -0,0 +1,52 @@
+#ifndef GEOEASHEADERCACHE_H
+#define GEOEASHEADERCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QDateTime>
+#include <QMutex>
+
+/** The information in the header of a GEO-EAS file. */
+struct GEOEASHeader{
+    /** The first line of the file. */
+    QString description;
+    /** The names of the columns, in the same order as in the file (untrimmed). */
+    QStringList fieldNames;
+    /** The number of text lines before the first data line. */
+    uint headerLineCount = 0;
+    /** The position in bytes of the first data line in the file or -1 if the file has no data lines. */
+    qint64 firstDataByteOffset = -1;
+};
+
+/**
+ * This is an auxiliary class that keeps the headers of the GEO-EAS files read so far, so the many calls
+ * to Util::getFieldNames(), DataFile::getFieldGEOEASIndex() and the like do not reopen and reparse the file
+ * each time.  A cached header is discarded when the file's timestamp or size change.
+ * This class is thread-safe.
+ */
+class GEOEASHeaderCache
+{
+public:
+    /** Returns the header of the given file, reading it only if needed. */
+    static GEOEASHeader getHeader( const QString file_path );
+
+    /** Forces the header of the given file to be reread in the next call to getHeader(). Code that changes
+     * a file should call this, since file timestamps may have a coarse resolution.
+     */
+    static void invalidate( const QString file_path );
+
+private:
+    struct Entry{
+        GEOEASHeader header;
+        QDateTime lastModified;
+        qint64 size;
+    };
+    static QHash<QString, Entry> s_entries;
+    static QMutex s_mutex;
+
+    /** Parses the header of the given file. */
+    static GEOEASHeader readHeader( const QString file_path );
+};
+
+#endif // GEOEASHEADERCACHE_H
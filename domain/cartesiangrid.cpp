@@ -10,6 +10,7 @@
 #include <boost/geometry/geometries/point_xy.hpp>
 #include <boost/geometry/geometries/polygon.hpp>
 #include <boost/scoped_array.hpp>
+#include <cmath>
 
 CartesianGrid::CartesianGrid( QString path )  : DataFile( path )
 {
@@ -56,8 +57,13 @@ void CartesianGrid::setInfo(double x0, double y0, double z0,
 
 void CartesianGrid::setInfoFromMetadataFile()
 {
-    QString md_file_path( this->_path );
-    QFile md_file( md_file_path.append(".md") );
+    QStringList lines;
+    if( readMetadataLines( lines ) )
+        setInfoFromMetadataLines( lines );
+}
+
+void CartesianGrid::setInfoFromMetadataLines(const QStringList &lines)
+{
     double x0 = 0.0, y0 = 0.0, z0 = 0.0;
     double dx = 0.0, dy = 0.0, dz = 0.0;
     uint nx = 0, ny = 0, nz = 0;
@@ -66,67 +72,61 @@ void CartesianGrid::setInfoFromMetadataFile()
     QString ndv;
     QMap<uint, QPair<uint,QString> > nsvar_var_trn;
     QList< QPair<uint,QString> > categorical_attributes;
-    if( md_file.exists() ){
-        md_file.open( QFile::ReadOnly | QFile::Text );
-        QTextStream in(&md_file);
-        for (int i = 0; !in.atEnd(); ++i)
-        {
-           QString line = in.readLine();
-           if( line.startsWith( "X0:" ) ){
-               QString value = line.split(":")[1];
-               x0 = value.toDouble();
-           }else if( line.startsWith( "Y0:" ) ){
-               QString value = line.split(":")[1];
-               y0 = value.toDouble();
-           }else if( line.startsWith( "Z0:" ) ){
-               QString value = line.split(":")[1];
-               z0 = value.toDouble();
-           }else if( line.startsWith( "NX:" ) ){
-               QString value = line.split(":")[1];
-               nx = value.toInt();
-           }else if( line.startsWith( "NY:" ) ){
-               QString value = line.split(":")[1];
-               ny = value.toInt();
-           }else if( line.startsWith( "NZ:" ) ){
-               QString value = line.split(":")[1];
-               nz = value.toInt();
-           }else if( line.startsWith( "DX:" ) ){
-               QString value = line.split(":")[1];
-               dx = value.toDouble();
-           }else if( line.startsWith( "DY:" ) ){
-               QString value = line.split(":")[1];
-               dy = value.toDouble();
-           }else if( line.startsWith( "DZ:" ) ){
-               QString value = line.split(":")[1];
-               dz = value.toDouble();
-           }else if( line.startsWith( "ROT:" ) ){
-               QString value = line.split(":")[1];
-               rot = value.toDouble();
-           }else if( line.startsWith( "NREAL:" ) ){
-               QString value = line.split(":")[1];
-               nreal = value.toInt();
-           }else if( line.startsWith( "NDV:" ) ){
-               QString value = line.split(":")[1];
-               ndv = value;
-           }else if( line.startsWith( "NSCORE:" ) ){
-               QString triad = line.split(":")[1];
-               QString var = triad.split(">")[0];
-               QString pair = triad.split(">")[1];
-               QString ns_var = pair.split("=")[0];
-               QString trn_filename = pair.split("=")[1];
-               //normal variable index is key
-               //variable index and transform table filename are the value
-               nsvar_var_trn.insert( ns_var.toUInt(), QPair<uint,QString>(var.toUInt(), trn_filename ));
-           }else if( line.startsWith( "CATEGORICAL:" ) ){
-               QString var_and_catDefName = line.split(":")[1];
-               QString var = var_and_catDefName.split(",")[0];
-               QString catDefName = var_and_catDefName.split(",")[1];
-               categorical_attributes.append( QPair<uint,QString>(var.toUInt(), catDefName) );
-           }
+    for( const QString& line : lines )
+    {
+        if( line.startsWith( "X0:" ) ){
+            QString value = line.split(":")[1];
+            x0 = value.toDouble();
+        }else if( line.startsWith( "Y0:" ) ){
+            QString value = line.split(":")[1];
+            y0 = value.toDouble();
+        }else if( line.startsWith( "Z0:" ) ){
+            QString value = line.split(":")[1];
+            z0 = value.toDouble();
+        }else if( line.startsWith( "NX:" ) ){
+            QString value = line.split(":")[1];
+            nx = value.toInt();
+        }else if( line.startsWith( "NY:" ) ){
+            QString value = line.split(":")[1];
+            ny = value.toInt();
+        }else if( line.startsWith( "NZ:" ) ){
+            QString value = line.split(":")[1];
+            nz = value.toInt();
+        }else if( line.startsWith( "DX:" ) ){
+            QString value = line.split(":")[1];
+            dx = value.toDouble();
+        }else if( line.startsWith( "DY:" ) ){
+            QString value = line.split(":")[1];
+            dy = value.toDouble();
+        }else if( line.startsWith( "DZ:" ) ){
+            QString value = line.split(":")[1];
+            dz = value.toDouble();
+        }else if( line.startsWith( "ROT:" ) ){
+            QString value = line.split(":")[1];
+            rot = value.toDouble();
+        }else if( line.startsWith( "NREAL:" ) ){
+            QString value = line.split(":")[1];
+            nreal = value.toInt();
+        }else if( line.startsWith( "NDV:" ) ){
+            QString value = line.split(":")[1];
+            ndv = value;
+        }else if( line.startsWith( "NSCORE:" ) ){
+            QString triad = line.split(":")[1];
+            QString var = triad.split(">")[0];
+            QString pair = triad.split(">")[1];
+            QString ns_var = pair.split("=")[0];
+            QString trn_filename = pair.split("=")[1];
+            //normal variable index is key
+            //variable index and transform table filename are the value
+            nsvar_var_trn.insert( ns_var.toUInt(), QPair<uint,QString>(var.toUInt(), trn_filename ));
+        }else if( line.startsWith( "CATEGORICAL:" ) ){
+            QString var_and_catDefName = line.split(":")[1];
+            QString var = var_and_catDefName.split(",")[0];
+            QString catDefName = var_and_catDefName.split(",")[1];
+            categorical_attributes.append( QPair<uint,QString>(var.toUInt(), catDefName) );
         }
-        md_file.close();
-        this->setInfo( x0, y0, z0, dx, dy, dz, nx, ny, nz, rot, nreal, ndv, nsvar_var_trn, categorical_attributes);
     }
+    this->setInfo( x0, y0, z0, dx, dy, dz, nx, ny, nz, rot, nreal, ndv, nsvar_var_trn, categorical_attributes);
 }
 
 void CartesianGrid::setInfoFromOtherCG(CartesianGrid *other_cg, bool copyCategoricalAttributesList)
@@ -420,26 +420,114 @@ void CartesianGrid::equalizeValues(QList<QPointF> &area, double delta_dB, uint d
 
 bool CartesianGrid::XYZtoIJK(double x, double y, double z, uint &i, uint &j, uint &k)
 {
-    //TODO: add support for rotations
-    if( ! Util::almostEqual2sComplement( this->_rot, 0.0, 1) ){
-        Application::instance()->logError("CartesianGrid::XYZtoIJK(): rotation not supported yet.  Returning false (invalid return values).");
+    double fi, fj, fk;
+    XYZtoFractionalIJK( x, y, z, fi, fj, fk );
+
+    //the cell centers are at the integer coordinates
+    fi += 0.5;
+    fj += 0.5;
+    fk += 0.5;
+
+    //check whether the location is outside the grid
+    if( fi < 0.0 || fj < 0.0 || fk < 0.0 || fi >= _nx || fj >= _ny || fk >= _nz ){
         return false;
     }
+    i = fi;
+    j = fj;
+    k = fk;
+    return true;
+}
+
+void CartesianGrid::XYZtoFractionalIJK(double x, double y, double z, double &i, double &j, double &k)
+{
+    //undo the grid rotation, which is about the center of the first cell (see View3DBuilders)
+    if( ! Util::almostEqual2sComplement( this->_rot, 0.0, 1) ){
+        double rotRad = _rot * Util::PI_OVER_180;
+        double cosRot = std::cos( rotRad );
+        double sinRot = std::sin( rotRad );
+        double xRel = x - _x0;
+        double yRel = y - _y0;
+        x = _x0 + cosRot * xRel - sinRot * yRel;
+        y = _y0 + sinRot * xRel + cosRot * yRel;
+    }
 
     //compute the indexes from the spatial location.
-    double xWest = _x0 - _dx/2.0;
-    double ySouth = _y0 - _dy/2.0;
-    double zBottom = _z0 - _dz/2.0;
-    i = (x - xWest) / _dx;
-    j = (y - ySouth) / _dy;
-    k = 0;
+    i = (x - _x0) / _dx;
+    j = (y - _y0) / _dy;
+    k = 0.0;
     if( _nz > 1 )
-        k = (z - zBottom) / _dz;
+        k = (z - _z0) / _dz;
+}
 
-    //check whether the location is outside the grid
-    if( /*i < 0 ||*/ i >= _nx || /*j < 0 ||*/ j >= _ny || /*k < 0 ||*/ k >= _nz ){
+void CartesianGrid::IJKtoXYZ(uint i, uint j, uint k, double &x, double &y, double &z)
+{
+    x = _x0 + i * _dx;
+    y = _y0 + j * _dy;
+    z = _z0 + k * _dz;
+
+    //apply the grid rotation, which is about the center of the first cell (see View3DBuilders)
+    if( ! Util::almostEqual2sComplement( this->_rot, 0.0, 1) ){
+        double rotRad = _rot * Util::PI_OVER_180;
+        double cosRot = std::cos( rotRad );
+        double sinRot = std::sin( rotRad );
+        double xRel = x - _x0;
+        double yRel = y - _y0;
+        x = _x0 + cosRot * xRel + sinRot * yRel;
+        y = _y0 - sinRot * xRel + cosRot * yRel;
+    }
+}
+
+bool CartesianGrid::writeRealizationAsPointSet(uint realization, const QString path)
+{
+    if( realization >= _nreal ){
+        Application::instance()->logError("CartesianGrid::writeRealizationAsPointSet(): invalid realization number: " +
+                                          QString::number( realization ) + " (max. == " + QString::number( _nreal ) + ").");
+        return false;
+    }
+
+    QFile file( path );
+    if( ! file.open( QFile::WriteOnly | QFile::Text ) ){
+        Application::instance()->logError("CartesianGrid::writeRealizationAsPointSet(): could not create file " + path );
         return false;
     }
+    QTextStream out( &file );
+    //the default precision (6 digits) is not enough for coordinates like UTM's
+    out.setRealNumberPrecision( 12 );
+
+    //load only the cells of the realization
+    setDataPageToRealization( realization );
+    loadData();
+    uint nDataColumns = getDataColumnCount();
+
+    //write out the GEO-EAS point set header
+    out << getName() << " (realization " << realization + 1 << ")\n";
+    out << nDataColumns + 3 << '\n';
+    out << "X\nY\nZ\n";
+    for( uint d = 0; d < nDataColumns; ++d ){
+        Attribute* at = getAttributeFromGEOEASIndex( d + 1 );
+        if( at )
+            out << at->getName() << '\n';
+        else
+            out << "var" << d + 1 << '\n';
+    }
+
+    //write out the cells, with the coordinates computed on the fly
+    double x, y, z;
+    for( uint k = 0; k < _nz; ++k )
+        for( uint j = 0; j < _ny; ++j )
+            for( uint i = 0; i < _nx; ++i ){
+                IJKtoXYZ( i, j, k, x, y, z );
+                out << x << '\t' << y << '\t' << z;
+                for( uint d = 0; d < nDataColumns; ++d )
+                    out << '\t' << dataIJK( d, i, j, k );
+                out << '\n';
+            }
+
+    file.close();
+
+    //TODO: remove this when all GammaRay features become realization-aware.
+    setDataPageToAll();
+
     return true;
 }
 
@@ -25,6 +25,9 @@ public:
      #setInfo() with the metadata read from the .md file.*/
     void setInfoFromMetadataFile();
 
+    /** Sets the metadata from the lines of the .md file, already read with File::readMetadataLines(). */
+    void setInfoFromMetadataLines( const QStringList& lines );
+
     /** Sets the cartesian grid metadata by copying the values from another grid, specified by
      * the given pointer.
      * @param copyCategoricalAttributesList If false, unlink any categorical variables to category definitions
@@ -124,11 +127,36 @@ public:
 
     /**
      * Returns, via output variables (i,j and k), the IJK coordinates corresponding to a XYZ spatial coordinate.
-     * Returns false if the spatial coordinate lies outside the grid.
+     * Returns false if the spatial coordinate lies outside the grid.  The grid rotation is taken into account.
+     * This method does not log messages, so it can be called from worker threads.
      */
     bool XYZtoIJK( double x, double y, double z,
                    uint& i,   uint& j,   uint& k );
 
+    /**
+     * Returns, via output variables (i,j and k), the continuous IJK coordinates corresponding to a XYZ spatial
+     * coordinate, with the cell centers at integer values (e.g. i == 0.5 is the boundary between the first and the
+     * second columns).  The location may lie outside the grid.  Z is ignored if the grid is 2D (k is zero).
+     */
+    void XYZtoFractionalIJK( double x, double y, double z,
+                             double& i, double& j, double& k );
+
+    /**
+     * Returns, via output variables (x, y and z), the spatial coordinates of the center of the cell given by its
+     * IJK coordinates.  The grid rotation is taken into account.  This is the inverse of XYZtoFractionalIJK().
+     */
+    void IJKtoXYZ( uint i, uint j, uint k,
+                   double& x, double& y, double& z );
+
+    /**
+     * Writes a realization (first is 0) to a GEO-EAS point set file, like the GSLib program addcoord: the X, Y and Z
+     * coordinates of the cell centers in the first three columns followed by the grid variables.  The coordinates
+     * are computed from the grid geometry as the lines are written, so no intermediate array is built.  The data
+     * page is restored to the entire file afterwards.
+     * @return False if the file could not be created.
+     */
+    bool writeRealizationAsPointSet( uint realization, const QString path );
+
     /** Sets the number of realizations.
      * This is declarative only.  No check is performed whether there are actually the number of
      * realizations informed.
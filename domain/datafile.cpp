@@ -22,6 +22,7 @@
 #include "project.h"
 #include "objectgroup.h"
 #include "auxiliary/dataloader.h"
+#include "auxiliary/geoeasheadercache.h"
 
 DataFile::DataFile(QString path) : File( path ),
     _lastModifiedDateTimeLastLoad( ),
@@ -90,6 +91,9 @@ void DataFile::loadData()
     if( this->getFileType() == "CARTESIANGRID"){
         CartesianGrid* cg = (CartesianGrid*)this;
         uint expected_total_lines = cg->getNX() * cg->getNY() * cg->getNZ() * cg->getNReal();
+        //the file reading stops at the last line of the data page
+        if( _dataPageLastLine >= 0 && (ulong)_dataPageLastLine < expected_total_lines )
+            expected_total_lines = _dataPageLastLine + 1;
         if( data_line_count != expected_total_lines ){
             Application::instance()->logWarn( QString("DataFile::loadData(): number of parsed data lines (" +
                                                       QString::number( data_line_count ) +
@@ -193,11 +197,32 @@ double DataFile::mean(uint column)
         return 0.0;
 }
 
+QStringList DataFile::getFieldNames()
+{
+    return GEOEASHeaderCache::getHeader( this->_path ).fieldNames;
+}
+
+QString DataFile::getFileDescription()
+{
+    return GEOEASHeaderCache::getHeader( this->_path ).description;
+}
+
+uint DataFile::getHeaderLineCount()
+{
+    return GEOEASHeaderCache::getHeader( this->_path ).headerLineCount;
+}
+
+qint64 DataFile::getFirstDataByteOffset()
+{
+    return GEOEASHeaderCache::getHeader( this->_path ).firstDataByteOffset;
+}
+
 uint DataFile::getFieldGEOEASIndex(QString field_name)
 {
-    QStringList field_names = Util::getFieldNames( this->_path );
+    QStringList field_names = getFieldNames();
+    QString trimmed_field_name = field_name.trimmed();
     for( int i = 0; i < field_names.size(); ++i){
-        if( field_names.at(i).trimmed() == field_name.trimmed() )
+        if( field_names.at(i).trimmed() == trimmed_field_name )
             return i+1;
     }
     return 0;
@@ -205,13 +230,20 @@ uint DataFile::getFieldGEOEASIndex(QString field_name)
 
 Attribute *DataFile::getAttributeFromGEOEASIndex(uint index)
 {
+    //the attribute in the given index has the field name in the given position
+    QStringList field_names = getFieldNames();
+    if( index < 1 || index > (uint)field_names.size() )
+        return nullptr;
+    QString field_name = field_names.at( index - 1 ).trimmed();
+    //in case of repeated field names, attributes are found by the first occurrence (see getFieldGEOEASIndex())
+    if( getFieldGEOEASIndex( field_name ) != index )
+        return nullptr;
     std::vector<ProjectComponent*>::iterator it = this->_children.begin();
     for( ; it != this->_children.end(); ++it ){
         ProjectComponent* pi = *it;
         if( pi->isAttribute() ){
             Attribute* at = (Attribute*)pi;
-            uint at_index = this->getFieldGEOEASIndex( at->getName() );
-            if( at_index == index )
+            if( at->getName().trimmed() == field_name )
                 return at;
         }
     }
@@ -220,8 +252,7 @@ Attribute *DataFile::getAttributeFromGEOEASIndex(uint index)
 
 uint DataFile::getLastFieldGEOEASIndex()
 {
-    QStringList field_names = Util::getFieldNames( this->_path );
-    return field_names.count();
+    return getFieldNames().count();
 }
 
 QString DataFile::getNoDataValue()
@@ -292,6 +323,14 @@ Attribute *DataFile::getVariableOfNScoreVar(Attribute *at)
     return variable;
 }
 
+QString DataFile::getTransformTableOfNScoreVar(Attribute *at)
+{
+    uint ns_var_index_in_GEOEAS_file = this->getFieldGEOEASIndex( at->getName() );
+    if( _nsvar_var_trn.contains( ns_var_index_in_GEOEAS_file ) )
+        return _nsvar_var_trn[ ns_var_index_in_GEOEAS_file ].second;
+    return QString();
+}
+
 void DataFile::deleteFromFS()
 {
     File::deleteFromFS(); //delete the file itself.
@@ -310,7 +349,7 @@ void DataFile::writeToFS()
     //if file already exists, keep copy of the file description or make up one otherwise
     QString comment;
     if( this->exists() )
-        comment = Util::getGEOEAScomment( this->getPath() );
+        comment = getFileDescription();
     else
         comment = this->getFileType() + " created by GammaRay";
     out << comment << endl;
@@ -375,6 +414,7 @@ void DataFile::writeToFS()
     currentFile.remove();
     //renames the .new file, effectively replacing the current file.
     outputFile.rename( this->getPath() );
+    GEOEASHeaderCache::invalidate( this->getPath() );
     //updates properties list so any changes appear in the project tree.
     updatePropertyCollection();
     //update the project tree in the main window.
@@ -385,7 +425,7 @@ void DataFile::updatePropertyCollection()
 {
     //updates attribute collection
     this->_children.clear(); //TODO: deallocate elements/deep delete (minor memory leak)
-    QStringList fields = Util::getFieldNames( this->_path );
+    QStringList fields = getFieldNames();
     for( int i = 0; i < fields.size(); ++i ){
         int index_in_file = i + 1;
         //do not include the x,y,z coordinates among the attributes
@@ -427,6 +467,7 @@ void DataFile::replacePhysicalFile(const QString from_file_path)
 {
     //copies the source file over the current physical file in project.
     Util::copyFile( from_file_path, _path );
+    GEOEASHeaderCache::invalidate( _path );
     //updates properties list so any changes appear in the project tree.
     updatePropertyCollection();
     //update the project tree in the main window.
@@ -442,119 +483,183 @@ void DataFile::addVariableNScoreVariableRelationship(uint variableGEOEASindex, u
 
 void DataFile::addGEOEASColumn(Attribute *at, const QString new_name, bool categorical, CategoryDefinition *cd)
 {
-    //set the variable name in the destination file
-    QString var_name;
-    if( new_name.isEmpty() )
-        var_name = at->getName();
-    else
-        var_name = new_name;
+    NewGEOEASColumn column;
+    column.attribute = at;
+    column.name = new_name;
+    column.categorical = categorical;
+    column.categoryDefinition = cd;
+    addGEOEASColumns( { column } );
+}
+
+void DataFile::addGEOEASColumns(const std::vector<NewGEOEASColumn> &columns)
+{
+    if( columns.empty() )
+        return;
 
     //get the destination file path
     QString file_path = this->getPath();
 
-    //get the source file
-    DataFile* attributes_file = (DataFile*)at->getContainingFile();
-
-    //loads the data in source file
-    attributes_file->loadData();
-
-    //get the variable's column index in the source file
-    uint column_index_in_original_file = attributes_file->getFieldGEOEASIndex( at->getName() ) - 1;
+    //set the no-data value to be used
+    QString NDV;
+    if( this->hasNoDataValue() ) //the expected no-data value is from the destination file (this object)
+        NDV = this->getNoDataValue();
+    else { //try the one from a source file
+        for( const NewGEOEASColumn& column : columns ){
+            if( column.attribute && ((DataFile*)column.attribute->getContainingFile())->hasNoDataValue() ){
+                NDV = ((DataFile*)column.attribute->getContainingFile())->getNoDataValue();
+                Application::instance()->logWarn("WARNING: DataFile::addGEOEASColumns(): no-data value not set for the destination file.  Using the no-data value from the source file: " + NDV);
+                break;
+            }
+        }
+        if( NDV.isEmpty() ){
+            NDV = "-9999999";
+            Application::instance()->logWarn("WARNING: DataFile::addGEOEASColumns(): no-data value not set for the destination nor the source files.  Using -9999999.");
+        }
+    }
 
-    //get the number of data lines in the source file
-    uint data_line_count = attributes_file->getDataLineCount();
+    //gather the values to add before touching the destination file (a source attribute may belong to this file)
+    //no-data values of the source files are marked with NaN
+    std::vector< std::vector<double> > values( columns.size() );
+    QStringList names;
+    for( size_t iColumn = 0; iColumn < columns.size(); ++iColumn ){
+        const NewGEOEASColumn& column = columns[iColumn];
+        if( column.attribute ){
+            //get the source file
+            DataFile* attributes_file = (DataFile*)column.attribute->getContainingFile();
+            //loads the data in source file
+            attributes_file->loadData();
+            //get the variable's column index in the source file
+            uint column_index_in_original_file = attributes_file->getFieldGEOEASIndex( column.attribute->getName() ) - 1;
+            bool has_ndv = attributes_file->hasNoDataValue();
+            double source_ndv = attributes_file->getNoDataValueAsDouble();
+            uint data_line_count = attributes_file->getDataLineCount();
+            std::vector<double>& columnValues = values[iColumn];
+            columnValues.reserve( data_line_count );
+            for( uint iLine = 0; iLine < data_line_count; ++iLine ){
+                double value = attributes_file->data( iLine, column_index_in_original_file );
+                if( has_ndv && Util::almostEqual2sComplement( source_ndv, value, 1 ) )
+                    columnValues.push_back( std::nan("") );
+                else
+                    columnValues.push_back( value );
+            }
+            names << ( column.name.isEmpty() ? column.attribute->getName() : column.name );
+        } else {
+            values[iColumn] = column.values;
+            names << column.name;
+        }
+    }
 
     //create a new file for output
     QFile outputFile( QString(file_path).append(".new") );
     outputFile.open( QFile::WriteOnly | QFile::Text );
     QTextStream out(&outputFile);
 
-    //set the no-data value to be used
-    QString NDV;
-    if( this->hasNoDataValue() ) //the expected no-data value is from the destination file (this object)
-        NDV = this->getNoDataValue();
-    else if( attributes_file->hasNoDataValue() ){ //try the one from the source file
-        NDV = attributes_file->getNoDataValue();
-        Application::instance()->logWarn("WARNING: DataFile::addGEOEASColumn(): no-data value not set for the destination file.  Using the no-data value from the source file: " + NDV);
-    } else {
-        NDV = "-9999999";
-        Application::instance()->logWarn("WARNING: DataFile::addGEOEASColumn(): no-data value not set for both files.  Using -9999999.");
-    }
-
     //open the destination file for reading
     QFile inputFile( file_path );
-    if ( inputFile.open(QIODevice::ReadOnly | QFile::Text ) ) {
-       QTextStream in(&inputFile);
-       uint line_index = 0;
-       uint data_line_index = 0;
-       uint n_vars = 0;
-       uint var_count = 0;
-       uint indexGEOEAS_new_variable = 0;
-       //for each line in the destination file...
-       while ( !in.atEnd() ){
-           //...read its line
-          QString line = in.readLine();
-          //simply copy the first line (title)
-          if( line_index == 0 ){
-              out << line << '\n';
-          //first number of second line holds the variable count
-          //writes an increased number of variables.
-          //TODO: try to keep the rest of the second line (not critical, but desirable)
-          } else if( line_index == 1 ) {
-              n_vars = Util::getFirstNumber( line );
-              out << ( n_vars+1 ) << '\n';
-              indexGEOEAS_new_variable = n_vars+1; //the GEO-EAS index of the added column equals the new number of columns
-          //simply copy the current variable names
-          } else if ( var_count < n_vars ) {
-              out << line << '\n';
-              //if we're at the last existing variable, adds an extra line for the new variable
-              if( (var_count+1) == n_vars ){
-                  out << var_name << '\n';
-              }
-              ++var_count;
-          //treat the data lines until EOF
-          } else {
-              //if we didn't overshoot the source file...
-              if( data_line_index < data_line_count ) {
-                  double value = attributes_file->data( data_line_index, column_index_in_original_file );
-                  //if the value was NOT defined as no-data value according to its parent file
-                  if( ! attributes_file->isNDV( value ) ){
-                      out << line << '\t' << QString::number( value ) << '\n';
-                  //if the value is no-data value according to the source file
-                  } else {
-                      out << line << '\t' << NDV << '\n';
-                  }
-              } else {
-                  //...otherwise append the no-data value of the destination file (this object).
-                  out << line << '\t' << NDV << '\n';
-              }
-              //keep count of the source file data lines
-              ++data_line_index;
-          } //if's and else's for each file line case (header, var. count, var. name and data line)
-          //keep count of the source file lines
-          ++line_index;
-       } // for each line in destination file (this)
-       //close the destination file
-       inputFile.close();
-       //close the newly created file
-       outputFile.close();
-       //deletes the destination file
-       inputFile.remove();
-       //renames the new file, effectively replacing the destination file.
-       outputFile.rename( QFile( file_path ).fileName() );
-       //if the added column was deemed categorical, adds its GEO-EAS index and name of the category definition
-       //to the list of pairs for metadata keeping.
-       if( categorical ){
-           //TODO: guard against cd being nullptr
-           _categorical_attributes.append( QPair<uint,QString>( indexGEOEAS_new_variable , cd->getName() ) );
-           //update the metadata file
-           this->updateMetaDataFile();
-       }
-       //updates properties list so any changes appear in the project tree.
-       updatePropertyCollection();
-       //update the project tree in the main window.
-       Application::instance()->refreshProjectTree();
+    if ( ! inputFile.open(QIODevice::ReadOnly | QFile::Text ) ) {
+        Application::instance()->logError("DataFile::addGEOEASColumns(): could not open " + file_path + " for reading.");
+        outputFile.close();
+        outputFile.remove();
+        return;
     }
+
+    //rewrite the destination file once, appending all the new columns to each data line
+    QTextStream in(&inputFile);
+    uint line_index = 0;
+    uint data_line_index = 0;
+    uint n_vars = 0;
+    uint var_count = 0;
+    //for each line in the destination file...
+    while ( !in.atEnd() ){
+        //...read its line
+        QString line = in.readLine();
+        //simply copy the first line (title)
+        if( line_index == 0 ){
+            out << line << '\n';
+        //first number of second line holds the variable count
+        //writes an increased number of variables.
+        //TODO: try to keep the rest of the second line (not critical, but desirable)
+        } else if( line_index == 1 ) {
+            n_vars = Util::getFirstNumber( line );
+            out << ( n_vars + columns.size() ) << '\n';
+        //simply copy the current variable names
+        } else if ( var_count < n_vars ) {
+            out << line << '\n';
+            //if we're at the last existing variable, adds the names of the new variables
+            if( (var_count+1) == n_vars ){
+                for( const QString& name : names )
+                    out << name << '\n';
+            }
+            ++var_count;
+        //treat the data lines until EOF
+        } else {
+            out << line;
+            for( const std::vector<double>& columnValues : values ){
+                //if we didn't overshoot the source values and the value is not a no-data value...
+                if( data_line_index < columnValues.size() && ! std::isnan( columnValues[data_line_index] ) )
+                    out << '\t' << QString::number( columnValues[data_line_index], 'g', 12 );
+                else //...otherwise append the no-data value of the destination file (this object).
+                    out << '\t' << NDV;
+            }
+            out << '\n';
+            //keep count of the destination file data lines
+            ++data_line_index;
+        } //if's and else's for each file line case (header, var. count, var. name and data line)
+        //keep count of the destination file lines
+        ++line_index;
+    } // for each line in destination file (this)
+    //close the destination file
+    inputFile.close();
+    //close the newly created file
+    outputFile.close();
+    //deletes the destination file
+    inputFile.remove();
+    //renames the new file, effectively replacing the destination file.
+    outputFile.rename( QFile( file_path ).fileName() );
+    GEOEASHeaderCache::invalidate( file_path );
+
+    //if the data are loaded, append the new columns to the in-memory data table, so it matches the new file
+    //contents without having to reload the file.
+    if( ! _data.empty() ){
+        double ndv = NDV.toDouble();
+        for( size_t iRow = 0; iRow < _data.size(); ++iRow ){
+            size_t data_line = _dataPageFirstLine + iRow;
+            std::vector<double>& row = _data[iRow];
+            for( const std::vector<double>& columnValues : values ){
+                if( data_line < columnValues.size() && ! std::isnan( columnValues[data_line] ) )
+                    row.push_back( columnValues[data_line] );
+                else
+                    row.push_back( ndv );
+            }
+        }
+        _lastModifiedDateTimeLastLoad = QFileInfo( file_path ).lastModified();
+    }
+
+    //if an added column was deemed categorical, adds its GEO-EAS index and name of the category definition
+    //to the list of pairs for metadata keeping.
+    bool hasCategorical = false;
+    for( size_t iColumn = 0; iColumn < columns.size(); ++iColumn ){
+        if( ! columns[iColumn].categorical )
+            continue;
+        if( ! columns[iColumn].categoryDefinition ){
+            Application::instance()->logError("DataFile::addGEOEASColumns(): categorical column " + names[iColumn] +
+                                              " has no category definition.  It will be handled as a continuous variable.");
+            continue;
+        }
+        //the GEO-EAS index of an added column follows the previous number of columns
+        uint indexGEOEAS_new_variable = n_vars + iColumn + 1;
+        _categorical_attributes.append( QPair<uint,QString>( indexGEOEAS_new_variable,
+                                                             columns[iColumn].categoryDefinition->getName() ) );
+        hasCategorical = true;
+    }
+    //update the metadata file
+    if( hasCategorical )
+        this->updateMetaDataFile();
+
+    //updates properties list so any changes appear in the project tree.
+    updatePropertyCollection();
+    //update the project tree in the main window.
+    Application::instance()->refreshProjectTree();
 }
 
 uint DataFile::getDataLineCount()
@@ -586,24 +691,34 @@ void DataFile::classify(uint column, UnivariateCategoryClassification *ucc, cons
     //load the current data from the file system
     loadData();
 
-    //for each data row...
-    std::vector< std::vector <double> >::iterator it = _data.begin();
-    for( ; it != _data.end(); ++it){
-        //define the default value (for class not found)
-        int noClassFoundValue = -1;
-        if( hasNoDataValue() )
-            //hopefully the file's NDV is integer
-            noClassFoundValue = (int)getNoDataValue().toDouble();
-        //...get the input value
-        double value = (*it).at( column );
-        //...get the category code corresponding to the value
-        int categoryId = ucc->getCategory( value, noClassFoundValue );
-        //...append the code to the current row.
-        (*it).push_back( categoryId );
-    }
+    //define the default value (for class not found)
+    int noClassFoundValue = -1;
+    if( hasNoDataValue() )
+        //hopefully the file's NDV is integer
+        noClassFoundValue = (int)getNoDataValueAsDouble();
+    bool has_ndv = hasNoDataValue();
+    double ndv = getNoDataValueAsDouble();
+
+    //compile the classification intervals for fast lookup
+    CategoryLookupTable lookupTable = ucc->makeLookupTable();
+
+    //for each data row (in parallel)...
+    Util::parallelFor( _data.size(), [&]( long first, long last ){
+        for( long iRow = first; iRow < last; ++iRow ){
+            std::vector<double>& row = _data[iRow];
+            //...get the input value
+            double value = row[column];
+            //...get the category code corresponding to the value (no-data values are not classified)
+            int categoryId = noClassFoundValue;
+            if( ! has_ndv || ! Util::almostEqual2sComplement( ndv, value, 1 ) )
+                categoryId = lookupTable.getCategory( value, noClassFoundValue );
+            //...append the code to the current row.
+            row.push_back( categoryId );
+        }
+    });
 
     //create and add a new Attribute object the represents the new column
-    uint newIndexGEOEAS = Util::getFieldNames( this->getPath() ).count() + 1;
+    uint newIndexGEOEAS = getLastFieldGEOEASIndex() + 1;
     Attribute* at = new Attribute( name_for_new_column, newIndexGEOEAS, true );
     //adds the attribute's GEO-EAS index (with the name of the category definition file) to the metadata as a categorical attribute
     _categorical_attributes.append(
@@ -640,6 +755,67 @@ void DataFile::setDataPageToAll()
     setDataPage(0, std::numeric_limits<long>::max() );
 }
 
+long DataFile::readDataPages(long linesPerPage, std::function<bool (long)> onPage)
+{
+    QFile file( this->_path );
+    if( linesPerPage <= 0 || ! file.open( QFile::ReadOnly | QFile::Text ) ){
+        Application::instance()->logError( "DataFile::readDataPages(): could not read " + this->_path + "." );
+        return -1;
+    }
+    //the pages are read as they were loaded, so loadData() does not reload them in the calls made by onPage
+    QFileInfo info( _path );
+    freeLoadedData();
+    _data.reserve( linesPerPage );
+
+    //same parsing of DataLoader::doLoad()
+    QTextStream in( &file );
+    int n_vars = 0;
+    long nPages = 0;
+    for( long i = 0; !in.atEnd(); ++i ){
+        QString line = in.readLine();
+        if( i == 0 ) //first line is ignored
+            continue;
+        if( i == 1 ){ //second line is the number of variables
+            n_vars = Util::getFirstNumber( line );
+            continue;
+        }
+        if( i < 2 + n_vars ) //the variables names
+            continue;
+        QStringList values = Util::fastSplit( line );
+        if( values.size() != n_vars ){
+            Application::instance()->logError( "DataFile::readDataPages(): wrong number of values in line " +
+                                               QString::number( i ) + " of " + this->_path + "." );
+            continue;
+        }
+        std::vector<double> data_line;
+        data_line.reserve( n_vars );
+        for( QStringList::Iterator it = values.begin(); it != values.end(); ++it )
+            data_line.push_back( (*it).toDouble() );
+        _data.push_back( std::move( data_line ) );
+        if( (long)_data.size() == linesPerPage ){
+            _dataPageFirstLine = nPages * linesPerPage;
+            _dataPageLastLine = _dataPageFirstLine + linesPerPage - 1;
+            _lastModifiedDateTimeLastLoad = info.lastModified();
+            ++nPages;
+            bool proceed = onPage( nPages - 1 );
+            _data.clear();
+            if( ! proceed )
+                break;
+        }
+    }
+    file.close();
+
+    if( ! _data.empty() )
+        Application::instance()->logWarn( "DataFile::readDataPages(): the last " + QString::number( _data.size() ) +
+                                          " data lines of " + this->_path + " do not make a complete page." );
+
+    //back to the entire file, unloaded
+    freeLoadedData();
+    _dataPageFirstLine = 0;
+    _dataPageLastLine = std::numeric_limits<long>::max();
+    return nPages;
+}
+
 void DataFile::addDataColumns(std::vector< std::complex<double> > &columns,
                               const QString nameForNewAttributeOfRealPart,
                               const QString nameForNewAttributeOfImaginaryPart)
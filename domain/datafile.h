@@ -6,11 +6,27 @@
 #include <QMap>
 #include <QDateTime>
 #include <complex>
+#include <functional>
 
 class Attribute;
 class UnivariateCategoryClassification;
 class CategoryDefinition;
 
+/**
+ * A column to be appended to a data file with DataFile::addGEOEASColumns().  The values are taken either
+ * from an Attribute (of any data file) or, if attribute is null, from the values vector (one value per data line,
+ * std::nan("") denotes no-data).
+ */
+struct NewGEOEASColumn{
+    Attribute* attribute = nullptr;
+    std::vector<double> values;
+    /** If empty, the attribute name is used. */
+    QString name;
+    /** If true, the column is handled as a categorical variable defined by categoryDefinition. */
+    bool categorical = false;
+    CategoryDefinition* categoryDefinition = nullptr;
+};
+
 /**
  * @brief The DataFile class is the base class of all project components that are
  *  files with scientific data, namely Point Set and Cartesian Grid.
@@ -35,6 +51,12 @@ public:
       */
     double data(uint line, uint column);
 
+    /**
+      *  Returns a line of the data loaded with loadData() (same line numbering of data()).  Unlike data(), this
+      *  neither loads the data nor checks the bounds, so it is cheap to call in tight (e.g. parallel) loops.
+      */
+    const std::vector<double>& getDataLine( long line ) const { return _data[line]; }
+
     /**
      * Returns the maximum value in the given column.
      * First column is 0.
@@ -65,6 +87,18 @@ public:
      */
     double mean( uint column );
 
+    //@{
+    /** Information from the GEO-EAS file header.  The header is cached (see GEOEASHeaderCache) and only reread
+     * if the file changes, so these are cheap to call repeatedly.
+     * getFieldNames() returns the column names in the same order as in the file.
+     * getFirstDataByteOffset() returns -1 if the file has no data lines.
+     */
+    QStringList getFieldNames();
+    QString getFileDescription();
+    uint getHeaderLineCount();
+    qint64 getFirstDataByteOffset();
+    //@}
+
     /**
      * Returns the index of the given field in GEO-EAS convention (first is 1).
      * If the given field name does not exist, returns zero.
@@ -135,6 +169,12 @@ public:
      */
     Attribute* getVariableOfNScoreVar( Attribute* at );
 
+    /**
+     * Returns the file name of the transform table (.trn file in the project directory) of the given
+     * normal score variable or an empty string if the attribute is not a normal score variable.
+     */
+    QString getTransformTableOfNScoreVar( Attribute* at );
+
     /** Replaces the contents of the current physical file with the contents
       * of the given file.
       */
@@ -185,6 +225,14 @@ public:
                          bool categorical = false,
                          CategoryDefinition *cd = nullptr);
 
+    /**
+     * Adds several columns at once to this data file with a single rewrite of the file, which is much faster than
+     * calling addGEOEASColumn() for each column in large files.  The no-data value and value count rules are the
+     * same of addGEOEASColumn().  If the data of this file are loaded, the new columns are also appended to the
+     * in-memory data table, so no reload is necessary.
+     */
+    void addGEOEASColumns( const std::vector<NewGEOEASColumn>& columns );
+
     /**
      * Returns the number of data lines read from file.
      * Make sure to have called loadData() prior to this call, otherwise zero will be returned.
@@ -234,6 +282,19 @@ public:
      */
     void setDataPageToAll();
 
+    /**
+     * Reads the file once from start to end in pages of the given number of data lines and calls onPage after
+     * each page is read.  During the call, the data page is the page just read, so data() and getDataLine()
+     * address its lines (0 == first line of the page) and only one page is in memory at a time.  Use this instead
+     * of setDataPage() followed by loadData() for each page, which re-scans the file from the start every time
+     * (e.g. to process the realizations of a Cartesian grid in order).
+     * An incomplete last page is not passed to onPage.  Upon return, the data is unloaded and the data page
+     * covers the entire file.
+     * @param onPage Receives the page number (0 == first); returning false stops the reading.
+     * @return The number of pages passed to onPage or -1 if the file could not be opened.
+     */
+    long readDataPages( long linesPerPage, std::function<bool(long)> onPage );
+
     /**
      * Adds the given values in a vector of complex numbers as new or the first two columns of the in-memory data
      * array (_data member variable). New Attribute objects are created to match the newly added data columns.  So,
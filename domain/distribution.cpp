@@ -12,25 +12,24 @@ Distribution::Distribution(const QString path) : File( path )
 
 void Distribution::setInfoFromMetadataFile()
 {
-    QString md_file_path( this->_path );
-    QFile md_file( md_file_path.append(".md") );
+    QStringList lines;
+    if( readMetadataLines( lines ) )
+        setInfoFromMetadataLines( lines );
+}
+
+void Distribution::setInfoFromMetadataLines(const QStringList &lines)
+{
     QMap<uint, Roles::DistributionColumnRole> varIndex_role_pairs;
-    if( md_file.exists() ){
-        md_file.open( QFile::ReadOnly | QFile::Text );
-        QTextStream in(&md_file);
-        for (int i = 0; !in.atEnd(); ++i)
-        {
-           QString line = in.readLine();
-           if( line.startsWith( "ROLE:" ) ){
-               QString pair = line.split(":")[1];
-               uint var_index = pair.split("=")[0].toUInt();
-               Roles::DistributionColumnRole role_code = (Roles::DistributionColumnRole)pair.split("=")[1].toUInt();
-               varIndex_role_pairs.insert( var_index, role_code );
-           }
+    for( const QString& line : lines )
+    {
+        if( line.startsWith( "ROLE:" ) ){
+            QString pair = line.split(":")[1];
+            uint var_index = pair.split("=")[0].toUInt();
+            Roles::DistributionColumnRole role_code = (Roles::DistributionColumnRole)pair.split("=")[1].toUInt();
+            varIndex_role_pairs.insert( var_index, role_code );
         }
-        md_file.close();
-        this->setInfo( varIndex_role_pairs );
     }
+    this->setInfo( varIndex_role_pairs );
 }
 
 uint Distribution::getTheColumnWithValueRole()
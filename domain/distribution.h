@@ -23,6 +23,9 @@ public:
      #setInfo(...) with the metadata read from the .md file.*/
     void setInfoFromMetadataFile();
 
+    /** Sets the metadata from the lines of the .md file, already read with File::readMetadataLines(). */
+    void setInfoFromMetadataLines( const QStringList& lines );
+
     /** Returns the GEO-EAS index (1 == first) of the column, if there is one, and only one, column with a
      *  value role (linear or log scale).   Returns zero if there is none or more than one.
      *  @see Roles */
@@ -2,6 +2,7 @@
 #include <QFile>
 #include <QTextStream>
 #include "util.h"
+#include "domain/application.h"
 
 ExperimentalVariogram::ExperimentalVariogram(const QString path) : File( path )
 {
@@ -14,28 +15,27 @@ void ExperimentalVariogram::setInfo(const QString vargplt_par_file)
 
 void ExperimentalVariogram::setInfoFromMetadataFile()
 {
-    QString md_file_path( this->_path );
-    QFile md_file( md_file_path.append(".md") );
+    QStringList lines;
+    if( readMetadataLines( lines ) )
+        setInfoFromMetadataLines( lines );
+}
+
+void ExperimentalVariogram::setInfoFromMetadataLines(const QStringList &lines)
+{
     QString vargplt_par_path;
-    if( md_file.exists() ){
-        md_file.open( QFile::ReadOnly | QFile::Text );
-        QTextStream in(&md_file);
-        for (int i = 0; !in.atEnd(); ++i)
-        {
-           QString line = in.readLine();
-           if( line.startsWith( "VARGPLT_PAR:" ) ){
-               QStringList line_parts = line.split(":");
-               QString value = line_parts[1];
-               //under Windows may have an extra colon in paths e.g. "C:/FOO/WOO.vargplt"
-               //this extra colon is stripped and the split operation results in a three-element list
-               if( line_parts.size() == 3 )
-                   value.append( ":" + line_parts[2] );
-               vargplt_par_path = value;
-           }
+    for( const QString& line : lines )
+    {
+        if( line.startsWith( "VARGPLT_PAR:" ) ){
+            QStringList line_parts = line.split(":");
+            QString value = line_parts[1];
+            //under Windows may have an extra colon in paths e.g. "C:/FOO/WOO.vargplt"
+            //this extra colon is stripped and the split operation results in a three-element list
+            if( line_parts.size() == 3 )
+                value.append( ":" + line_parts[2] );
+            vargplt_par_path = value;
         }
-        md_file.close();
-        this->setInfo( vargplt_par_path );
     }
+    this->setInfo( vargplt_par_path );
 }
 
 QString ExperimentalVariogram::getPathToVargpltPar()
@@ -68,3 +68,40 @@ void ExperimentalVariogram::save(QTextStream *txt_stream)
     //also saves the metadata file.
     this->updateMetaDataFile();
 }
+
+bool ExperimentalVariogram::readCurves(const QString path, std::vector<ExperimentalVariogramCurve> &curves)
+{
+    curves.clear();
+    QFile file( path );
+    if( ! file.open( QFile::ReadOnly | QFile::Text ) ){
+        Application::instance()->logError( "ExperimentalVariogram::readCurves(): could not open " + path );
+        return false;
+    }
+    QTextStream in( &file );
+    while( ! in.atEnd() ){
+        QString line = in.readLine();
+        if( line.trimmed().isEmpty() )
+            continue;
+        QStringList fields = Util::fastSplit( line );
+        bool isLag = false;
+        fields[0].toDouble( &isLag );
+        //a line that does not begin with a number is the title of a new curve
+        if( ! isLag ){
+            curves.push_back( ExperimentalVariogramCurve() );
+            continue;
+        }
+        //incomplete numeric lines are skipped
+        if( fields.size() < 4 )
+            continue;
+        if( curves.empty() )
+            curves.push_back( ExperimentalVariogramCurve() );
+        double pairCount = fields[3].toDouble();
+        if( pairCount <= 0.0 )
+            continue;
+        curves.back().distances.push_back( fields[1].toDouble() );
+        curves.back().gammas.push_back( fields[2].toDouble() );
+        curves.back().pairCounts.push_back( pairCount );
+    }
+    file.close();
+    return true;
+}
@@ -2,6 +2,14 @@
 #define EXPERIMENTALVARIOGRAM_H
 
 #include "file.h"
+#include <vector>
+
+/** The lags of one curve (e.g. a direction) of an experimental variogram. */
+struct ExperimentalVariogramCurve {
+    std::vector<double> distances;
+    std::vector<double> gammas;
+    std::vector<double> pairCounts;
+};
 
 /**
  * @brief The ExperimentalVariogram class represents a file with experimental variogram files saved by the user.
@@ -18,12 +26,25 @@ public:
      #setInfo(const QString) with the metadata read from the .md file.*/
     void setInfoFromMetadataFile();
 
+    /** Sets the metadata from the lines of the .md file, already read with File::readMetadataLines(). */
+    void setInfoFromMetadataLines( const QStringList& lines );
+
     /** Returns the path to associated vargplt par file (if exists) so it is possible
      * to plot a saved experimental variogram again without going through the variogram
      * analysis workflow.
      */
     QString getPathToVargpltPar();
 
+    /** Reads the curves of this experimental variogram (see readCurves(const QString, ...)). */
+    bool readCurves( std::vector<ExperimentalVariogramCurve>& curves ){ return readCurves( getPath(), curves ); }
+
+    /** Reads the curves of an experimental variogram file in the format output by the GSLib programs gamv and gam:
+     * each curve begins with a title line followed by one line per lag (lag number, average distance, variogram
+     * value, number of pairs and the means of the heads and tails).  The lags without pairs are skipped.
+     * Returns false if the file could not be read.
+     */
+    static bool readCurves( const QString path, std::vector<ExperimentalVariogramCurve>& curves );
+
 // File interface
 public:
     QString getFileType(){ return "EXPVARIOGRAM"; }
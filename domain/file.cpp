@@ -1,7 +1,9 @@
 #include "file.h"
+#include "auxiliary/geoeasheadercache.h"
 #include <QFile>
 #include <QFileInfo>
 #include <QDir>
+#include <QTextStream>
 
 File::File(QString path)
 {
@@ -28,6 +30,7 @@ void File::changeDir(QString dir_path)
     QFile dest_file( dest_dir.absoluteFilePath( fileInfo.fileName() ) );
     //perform copy
     QFile::copy( file.fileName(), dest_file.fileName() );
+    GEOEASHeaderCache::invalidate( dest_file.fileName() );
     //change path property
     this->_path = dest_file.fileName();
 }
@@ -48,6 +51,9 @@ void File::rename(QString new_name)
         dest_file.remove();
     //perform the renaming
     file.rename( newPath );
+    //the headers cached for both paths are stale
+    GEOEASHeaderCache::invalidate( original.filePath() );
+    GEOEASHeaderCache::invalidate( file.fileName() );
     //updates the _path member.
     this->_path = file.fileName();
 }
@@ -70,6 +76,18 @@ QString File::getMetaDataFilePath()
     return md_file_path.append(".md");
 }
 
+bool File::readMetadataLines(QStringList &lines)
+{
+    QFile md_file( getMetaDataFilePath() );
+    if( ! md_file.open( QFile::ReadOnly | QFile::Text ) )
+        return false;
+    QTextStream in(&md_file);
+    while( ! in.atEnd() )
+        lines << in.readLine();
+    md_file.close();
+    return true;
+}
+
 void File::setPath(QString path)
 {
     _path = path;
@@ -2,6 +2,7 @@
 #define __VVVV___FILE_H
 #include "projectcomponent.h"
 #include <QString>
+#include <QStringList>
 #include <QIcon>
 #include <vector>
 #include "exceptions/invalidmethodexception.h"
@@ -40,6 +41,17 @@ public:
     /** Returns the path to the metadata file. */
     QString getMetaDataFilePath();
 
+    /** Reads the text lines of the metadata file into the given list.  Returns false if there is no metadata
+     * file.  This method only does file I/O, so it can be called from worker threads (e.g. when a project with
+     * many files is opened) and the lines passed later to setInfoFromMetadataLines() in the GUI thread.
+     */
+    bool readMetadataLines( QStringList& lines );
+
+    /** Sets the object's metadata from the lines of its metadata file (see readMetadataLines()).
+     * Subclasses without metadata can keep this default empty implementation.
+     */
+    virtual void setInfoFromMetadataLines( const QStringList& /*lines*/ ){}
+
     /** Returns a string with the file type (e.g.: "POINTSET") */
     virtual QString getFileType() = 0;
 
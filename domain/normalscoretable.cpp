@@ -0,0 +1,19 @@
+#include "normalscoretable.h"
+#include "util.h"
+
+NormalScoreTable::NormalScoreTable(QString path) : DoublesPairs( path )
+{
+}
+
+QIcon NormalScoreTable::getIcon()
+{
+    if( Util::getDisplayResolutionClass() == DisplayResolution::NORMAL_DPI )
+        return QIcon(":icons/nscore16");
+    else
+        return QIcon(":icons32/nscore32");
+}
+
+void NormalScoreTable::save(QTextStream *txt_stream)
+{
+    (*txt_stream) << this->getFileType() << ":" << this->getFileName() << '\n';
+}
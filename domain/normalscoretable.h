@@ -0,0 +1,29 @@
+#ifndef NORMALSCORETABLE_H
+#define NORMALSCORETABLE_H
+
+#include "valuepairs.h"
+
+typedef ValuePairs<double,double> DoublesPairs;
+
+/** The NormalScoreTable class represents the transform table of a normal score transform (.trn file) saved in the
+ *  project: pairs of values and their normal scores.  See NormalScoreTransform.
+ */
+class NormalScoreTable : public DoublesPairs
+{
+public:
+    NormalScoreTable( QString path );
+
+    // ProjectComponent interface
+public:
+    QIcon getIcon();
+    void save(QTextStream *txt_stream);
+
+    // File interface
+public:
+    bool canHaveMetaData(){ return false; }
+    QString getFileType(){ return "NSCORETABLE"; }
+    void updateMetaDataFile(){}
+    bool isDataFile(){ return false; }
+};
+
+#endif // NORMALSCORETABLE_H
@@ -85,57 +85,56 @@ Attribute *PointSet::getVariableOfWeight(Attribute *weight)
 
 void PointSet::setInfoFromMetadataFile()
 {
-    QString md_file_path( this->_path );
-    QFile md_file( md_file_path.append(".md") );
+    QStringList lines;
+    if( readMetadataLines( lines ) )
+        setInfoFromMetadataLines( lines );
+}
+
+void PointSet::setInfoFromMetadataLines(const QStringList &lines)
+{
     int x_index = 0, y_index = 0, z_index = 0;
     QMap<uint, uint> wgt_var_pairs;
     QMap<uint, QPair<uint,QString> > nsvar_var_trn;
     QList< QPair<uint,QString> > categorical_attributes;
     QString ndv;
-    if( md_file.exists() ){
-        md_file.open( QFile::ReadOnly | QFile::Text );
-        QTextStream in(&md_file);
-        for (int i = 0; !in.atEnd(); ++i)
-        {
-           QString line = in.readLine();
-           if( line.startsWith( "X:" ) ){
-               QString value = line.split(":")[1];
-               x_index = value.toInt();
-           }else if( line.startsWith( "Y:" ) ){
-               QString value = line.split(":")[1];
-               y_index = value.toInt();
-           }else if( line.startsWith( "Z:" ) ){
-               QString value = line.split(":")[1];
-               z_index = value.toInt();
-           }else if( line.startsWith( "NDV:" ) ){
-               QString value = line.split(":")[1];
-               ndv = value;
-           }else if( line.startsWith( "WEIGHT:" ) ){
-               QString pair = line.split(":")[1];
-               QString var = pair.split(">")[0];
-               QString wgt = pair.split(">")[1];
-               //weight index is key
-               //variable index is value
-               wgt_var_pairs.insert( wgt.toUInt(), var.toUInt() );
-           }else if( line.startsWith( "NSCORE:" ) ){
-               QString triad = line.split(":")[1];
-               QString var = triad.split(">")[0];
-               QString pair = triad.split(">")[1];
-               QString ns_var = pair.split("=")[0];
-               QString trn_filename = pair.split("=")[1];
-               //normal variable index is key
-               //variable index and transform table filename are the value
-               nsvar_var_trn.insert( ns_var.toUInt(), QPair<uint,QString>(var.toUInt(), trn_filename ));
-           }else if( line.startsWith( "CATEGORICAL:" ) ){
-               QString var_and_catDefName = line.split(":")[1];
-               QString var = var_and_catDefName.split(",")[0];
-               QString catDefName = var_and_catDefName.split(",")[1];
-               categorical_attributes.append( QPair<uint,QString>( var.toUInt(), catDefName ) );
-           }
+    for( const QString& line : lines )
+    {
+        if( line.startsWith( "X:" ) ){
+            QString value = line.split(":")[1];
+            x_index = value.toInt();
+        }else if( line.startsWith( "Y:" ) ){
+            QString value = line.split(":")[1];
+            y_index = value.toInt();
+        }else if( line.startsWith( "Z:" ) ){
+            QString value = line.split(":")[1];
+            z_index = value.toInt();
+        }else if( line.startsWith( "NDV:" ) ){
+            QString value = line.split(":")[1];
+            ndv = value;
+        }else if( line.startsWith( "WEIGHT:" ) ){
+            QString pair = line.split(":")[1];
+            QString var = pair.split(">")[0];
+            QString wgt = pair.split(">")[1];
+            //weight index is key
+            //variable index is value
+            wgt_var_pairs.insert( wgt.toUInt(), var.toUInt() );
+        }else if( line.startsWith( "NSCORE:" ) ){
+            QString triad = line.split(":")[1];
+            QString var = triad.split(">")[0];
+            QString pair = triad.split(">")[1];
+            QString ns_var = pair.split("=")[0];
+            QString trn_filename = pair.split("=")[1];
+            //normal variable index is key
+            //variable index and transform table filename are the value
+            nsvar_var_trn.insert( ns_var.toUInt(), QPair<uint,QString>(var.toUInt(), trn_filename ));
+        }else if( line.startsWith( "CATEGORICAL:" ) ){
+            QString var_and_catDefName = line.split(":")[1];
+            QString var = var_and_catDefName.split(",")[0];
+            QString catDefName = var_and_catDefName.split(",")[1];
+            categorical_attributes.append( QPair<uint,QString>( var.toUInt(), catDefName ) );
         }
-        md_file.close();
-        this->setInfo( x_index, y_index, z_index, ndv, wgt_var_pairs, nsvar_var_trn, categorical_attributes );
     }
+    this->setInfo( x_index, y_index, z_index, ndv, wgt_var_pairs, nsvar_var_trn, categorical_attributes );
 }
 
 int PointSet::getXindex()
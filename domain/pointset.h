@@ -31,6 +31,9 @@ public:
      Nothing happens if the metadata file does not exist.  If it exists, it calls
      #setInfo(int,int,int,const QString) with the metadata read from the .md file.*/
     void setInfoFromMetadataFile();
+
+    /** Sets the metadata from the lines of the .md file, already read with File::readMetadataLines(). */
+    void setInfoFromMetadataLines( const QStringList& lines );
     int getXindex();
     int getYindex();
     int getZindex();
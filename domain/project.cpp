@@ -19,10 +19,12 @@
 #include "util.h"
 #include "domain/application.h"
 #include "domain/thresholdcdf.h"
+#include "domain/normalscoretable.h"
 #include "domain/categorypdf.h"
 #include "domain/categorydefinition.h"
 #include "domain/univariatecategoryclassification.h"
 #include "plot.h"
+#include "domain/auxiliary/geoeasheadercache.h"
 
 Project::Project(const QString path) : QAbstractItemModel()
 {
@@ -60,6 +62,15 @@ Project::Project(const QString path) : QAbstractItemModel()
     this->_resources->setParent( this->_root );
     this->_root->addChild( this->_resources );
 
+    //the files whose metadata (.md files) and GEO-EAS headers are read in parallel once gammaray.prj is parsed.
+    //Reading them one by one in the GUI thread makes opening projects with many files on network shares very slow.
+    std::vector<File*> files_with_metadata;
+    std::vector<char> is_GEOEAS;
+    auto enrollForMetadataLoading = [&files_with_metadata, &is_GEOEAS]( File* file, bool isGEOEASfile ){
+        files_with_metadata.push_back( file );
+        is_GEOEAS.push_back( isGEOEASfile );
+    };
+
     //load project metadata file, if there is one.
     //make path to gammaray.prj
     QFile prj_file( this->_project_directory->absoluteFilePath( "gammaray.prj" ) );
@@ -82,8 +93,8 @@ Project::Project(const QString path) : QAbstractItemModel()
                 //add the object to project tree structure
                 this->_data_files->addChild( ps );
                 ps->setParent( this->_data_files );
-                //reads point set metadata from the .md file
-                ps->setInfoFromMetadataFile();
+                //the point set metadata are read from the .md file later (see below)
+                enrollForMetadataLoading( ps, true );
            }
            //found a cartesian grid file reference in gammaray.prj
            if( line.startsWith( "CARTESIANGRID:" ) ){
@@ -96,8 +107,8 @@ Project::Project(const QString path) : QAbstractItemModel()
                 //add the object to project tree structure
                 this->_data_files->addChild( cg );
                 cg->setParent( this->_data_files );
-                //reads point set metadata from the .md file
-                cg->setInfoFromMetadataFile();
+                //the cartesian grid metadata are read from the .md file later (see below)
+                enrollForMetadataLoading( cg, true );
            }
            //found a plot file reference in gammaray.prj
            if( line.startsWith( "PLOT:" ) ){
@@ -122,8 +133,8 @@ Project::Project(const QString path) : QAbstractItemModel()
                 //add the object to project tree structure
                 this->_variograms->addChild( exp_var );
                 exp_var->setParent( this->_variograms );
-                //reads experimental variogram metadata from the .md file
-                exp_var->setInfoFromMetadataFile();
+                //the experimental variogram metadata are read from the .md file later (see below)
+                enrollForMetadataLoading( exp_var, false );
            }
            //found variogram model file reference in gammaray.prj
            if( line.startsWith( "VMODEL:" ) ){
@@ -153,8 +164,8 @@ Project::Project(const QString path) : QAbstractItemModel()
                 //add the object to project tree structure
                 this->_distributions->addChild( dist );
                 dist->setParent( this->_distributions );
-                //reads the distribution metadata from the .md file
-                dist->setInfoFromMetadataFile();
+                //the distribution metadata are read from the .md file later (see below)
+                enrollForMetadataLoading( dist, true );
            }
            //found a threshold c.d.f. or category p.d.f. file reference in gammaray.prj
            if( line.startsWith( "CATEGORYPDF:" ) ){
@@ -186,6 +197,18 @@ Project::Project(const QString path) : QAbstractItemModel()
                 this->_resources->addChild( file );
                 file->setParent( this->_resources );
            }
+           //found a normal score transform table file reference in gammaray.prj
+           if( line.startsWith( "NSCORETABLE:" ) ){
+                //get file name
+                QString file_name = line.split(":")[1];
+                //make file path
+                QFile file_obj( this->_project_directory->absoluteFilePath( file_name ) );
+                //create transform table object from file
+                NormalScoreTable *file = new NormalScoreTable( file_obj.fileName() );
+                //add the object to project tree structure
+                this->_resources->addChild( file );
+                file->setParent( this->_resources );
+           }
            //found a category definition file reference in gammaray.prj
            if( line.startsWith( "CATEGORYDEFINITION:" )){
                 //get file name
@@ -218,6 +241,24 @@ Project::Project(const QString path) : QAbstractItemModel()
         prj_file.close();
     }
 
+    //read the .md files and the headers of the GEO-EAS files in parallel (file I/O only)
+    long n_files = files_with_metadata.size();
+    std::vector<QStringList> metadata_lines( n_files );
+    std::vector<char> has_metadata( n_files, 0 );
+    Util::parallelFor( n_files, [&]( long first, long last ){
+        for( long i = first; i < last; ++i ){
+            has_metadata[i] = files_with_metadata[i]->readMetadataLines( metadata_lines[i] );
+            //the header is kept in GEOEASHeaderCache, so building the attribute trees below does not reread the files
+            if( is_GEOEAS[i] )
+                GEOEASHeaderCache::getHeader( files_with_metadata[i]->getPath() );
+        }
+    });
+
+    //set the metadata and build the attribute trees in the GUI thread, as the latter creates the project tree objects
+    for( long i = 0; i < n_files; ++i )
+        if( has_metadata[i] )
+            files_with_metadata[i]->setInfoFromMetadataLines( metadata_lines[i] );
+
     this->save();
 }
 
@@ -43,6 +43,54 @@ int UnivariateCategoryClassification::getCategory(double value, int noClassValue
     return noClassValue;
 }
 
+CategoryLookupTable UnivariateCategoryClassification::makeLookupTable()
+{
+    CategoryLookupTable table;
+
+    //if there are no triplets, it's possible that they were not read from file.
+    if( getTripletCount() == 0 ){
+        this->loadTriplets();
+        if( getTripletCount() == 0 )
+            Application::instance()->logError("ERROR: UnivariateCategoryClassification::makeLookupTable(): file is empty or not found.");
+    }
+    int tot = getTripletCount();
+
+    //collect the distinct interval bounds in ascending order
+    for( int i = 0; i < tot; ++i ){
+        table.m_boundaries.push_back( get1stValue( i ) );
+        table.m_boundaries.push_back( get2ndValue( i ) );
+        table.m_categories.push_back( get3rdValue( i ) );
+    }
+    std::sort( table.m_boundaries.begin(), table.m_boundaries.end() );
+    table.m_boundaries.erase( std::unique( table.m_boundaries.begin(), table.m_boundaries.end() ),
+                              table.m_boundaries.end() );
+
+    //assign each boundary and each open interval between boundaries to the first triplet that contains it
+    //(same precedence as getCategory())
+    size_t nBoundaries = table.m_boundaries.size();
+    table.m_boundaryTriplets.assign( nBoundaries, -1 );
+    table.m_intervalTriplets.assign( nBoundaries, -1 );
+    for( size_t k = 0; k < nBoundaries; ++k ){
+        double boundary = table.m_boundaries[k];
+        for( int i = 0; i < tot; ++i )
+            if( boundary >= get1stValue( i ) && boundary <= get2ndValue( i ) ){
+                table.m_boundaryTriplets[k] = i;
+                break;
+            }
+        //the open interval after the last boundary is not in any triplet
+        if( k + 1 < nBoundaries ){
+            double nextBoundary = table.m_boundaries[k+1];
+            for( int i = 0; i < tot; ++i )
+                if( boundary >= get1stValue( i ) && nextBoundary <= get2ndValue( i ) ){
+                    table.m_intervalTriplets[k] = i;
+                    break;
+                }
+        }
+    }
+
+    return table;
+}
+
 void UnivariateCategoryClassification::save(QTextStream *txt_stream)
 {
     QString usedCategoryDefinitionName;
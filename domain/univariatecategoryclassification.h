@@ -2,11 +2,61 @@
 #define UNIVARIATECATEGORYCLASSIFICATION_H
 
 #include "triads.h"
+#include <vector>
+#include <algorithm>
 
 typedef Triads<double,double,int> DoubleDoubeIntTriplets;
 
 class CategoryDefinition;
 
+/**
+ * The CategoryLookupTable class is a compiled, read-only form of a UnivariateCategoryClassification
+ * (see UnivariateCategoryClassification::makeLookupTable()) for classifying many values.  The interval bounds are
+ * stored as a sorted array of boundaries, so a value is classified with a binary search (or, for few boundaries,
+ * with a branchless count that the compiler can vectorize) instead of testing every interval.  The boundaries split
+ * the real line into pieces (the boundaries themselves and the open intervals between them) and each piece is
+ * assigned the category of the first interval that contains it, so the results are the same of
+ * UnivariateCategoryClassification::getCategory() even if the intervals overlap or have gaps.
+ * getCategory() is thread-safe.
+ */
+class CategoryLookupTable
+{
+public:
+    /** Returns the category id corresponding to the given value or noClassValue if no category is found. */
+    inline int getCategory( double value, int noClassValue ) const {
+        //index of the last boundary less than or equal to the value (-1 if none)
+        int k;
+        if( m_boundaries.size() <= SMALL_TABLE_SIZE ){
+            k = -1;
+            for( size_t i = 0; i < m_boundaries.size(); ++i )
+                k += ( m_boundaries[i] <= value );
+        } else {
+            k = std::upper_bound( m_boundaries.begin(), m_boundaries.end(), value ) - m_boundaries.begin() - 1;
+        }
+        if( k < 0 ) //value is below all intervals or is NaN
+            return noClassValue;
+        int triplet = ( value == m_boundaries[k] ) ? m_boundaryTriplets[k] : m_intervalTriplets[k];
+        if( triplet < 0 )
+            return noClassValue;
+        return m_categories[triplet];
+    }
+
+private:
+    friend class UnivariateCategoryClassification;
+
+    /** Tables with up to this many boundaries are searched linearly. */
+    static const size_t SMALL_TABLE_SIZE = 16;
+
+    /** The distinct interval bounds in ascending order. */
+    std::vector<double> m_boundaries;
+    /** The index of the triplet that contains each boundary or -1. */
+    std::vector<int> m_boundaryTriplets;
+    /** The index of the triplet that contains the open interval after each boundary or -1. */
+    std::vector<int> m_intervalTriplets;
+    /** The category id of each triplet. */
+    std::vector<int> m_categories;
+};
+
 /**
  * @brief The UnivariateCategoryClassification class is a set of triplets of double, double, int representing
  * value intervals (the two doubles) that must be mapped to a certain category id (the integer).
@@ -27,9 +77,17 @@ public:
     /**
      * Returns the category id corresponding to the given value.
      * Returns noDataValue if no category is found.
+     * To classify many values, use makeLookupTable() instead.
      */
     int getCategory(double value , int noClassValue);
 
+    /**
+     * Returns the intervals compiled for fast classification of many values (e.g. all the values of a column).
+     * The triplets are loaded from the file if needed.  The returned object does not reflect later changes
+     * to the triplets.
+     */
+    CategoryLookupTable makeLookupTable();
+
     /**
      * Returns the categorical definition used to build this categorical classification.
      */
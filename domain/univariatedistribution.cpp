@@ -1,5 +1,10 @@
 #include "univariatedistribution.h"
 #include "util.h"
+#include "domain/application.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
 
 
 UnivariateDistribution::UnivariateDistribution(const QString path) : Distribution( path )
@@ -14,4 +19,33 @@ QIcon UnivariateDistribution::getIcon()
         return QIcon(":icons32/unidist32");
 }
 
-
+bool UnivariateDistribution::readValuesAndProbabilities(std::vector<double> &values, std::vector<double> &probabilities)
+{
+    values.clear();
+    probabilities.clear();
+    uint valueColumn = getTheColumnWithValueRole();
+    uint probabilityColumn = getTheColumnWithProbabilityRole();
+    if( valueColumn == 0 || probabilityColumn == 0 ){
+        Application::instance()->logError( "UnivariateDistribution::readValuesAndProbabilities(): the value and probability "
+                                           "roles of the columns of " + getName() + " are not set." );
+        return false;
+    }
+    QFile file( getPath() );
+    if( ! file.open( QFile::ReadOnly | QFile::Text ) ){
+        Application::instance()->logError( "UnivariateDistribution::readValuesAndProbabilities(): could not open " + getPath() );
+        return false;
+    }
+    QTextStream in( &file );
+    uint headerLineCount = Util::getHeaderLineCount( getPath() );
+    for( uint i = 0; i < headerLineCount && ! in.atEnd(); ++i )
+        in.readLine();
+    while( ! in.atEnd() ){
+        QStringList fields = Util::fastSplit( in.readLine() );
+        if( fields.size() < (int)std::max( valueColumn, probabilityColumn ) )
+            continue;
+        values.push_back( fields[valueColumn - 1].toDouble() );
+        probabilities.push_back( fields[probabilityColumn - 1].toDouble() );
+    }
+    file.close();
+    return ! values.empty();
+}
@@ -2,6 +2,7 @@
 #define UNIVARIATEDISTRIBUTION_H
 
 #include "distribution.h"
+#include <vector>
 
 /**
  * @brief The UnivariateDistribution class represents a univariate distribution model, normally
@@ -14,6 +15,10 @@ class UnivariateDistribution : public Distribution
 public:
     UnivariateDistribution( const QString path );
 
+    /** Reads the values and the probabilities from the columns with the value and probability roles.
+     *  Returns false if those roles are not set or the file could not be read. */
+    bool readValuesAndProbabilities( std::vector<double>& values, std::vector<double>& probabilities );
+
 // File interface
 public:
     QString getFileType(){ return "UNIDIST"; }
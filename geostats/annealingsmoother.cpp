@@ -0,0 +1,242 @@
+#include "annealingsmoother.h"
+
+#include "domain/application.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+AnnealingSmoother::AnnealingSmoother() :
+    m_maxPerturbations( 100.0 ),
+    m_reportingInterval( 10.0 ),
+    m_minObjective( 0.0 ),
+    m_seed( 69069 ),
+    m_nReplicas( 1 ),
+    m_initialObjective( 0.0 ),
+    m_finalObjective( 0.0 ),
+    m_perturbationCount( 0 ),
+    m_averageChange( 0.0 )
+{
+    for( int i = 0; i < 4; ++i ){
+        m_componentEnabled[i] = true;
+        m_componentWeights[i] = 1.0;
+        m_componentScales[i] = 1.0;
+    }
+}
+
+AnnealingSmoother::~AnnealingSmoother()
+{
+}
+
+void AnnealingSmoother::setComponents(bool first, bool second, bool third, bool fourth)
+{
+    m_componentEnabled[0] = first;
+    m_componentEnabled[1] = second;
+    m_componentEnabled[2] = third;
+    m_componentEnabled[3] = fourth;
+}
+
+void AnnealingSmoother::setComponentWeights(double first, double second, double third, double fourth)
+{
+    m_componentWeights[0] = first;
+    m_componentWeights[1] = second;
+    m_componentWeights[2] = third;
+    m_componentWeights[3] = fourth;
+}
+
+double AnnealingSmoother::getObjective(const double *components) const
+{
+    double objective = 0.0;
+    for( int i = 0; i < 4; ++i )
+        if( m_componentEnabled[i] )
+            objective += m_componentWeights[i] * m_componentScales[i] * components[i];
+    return objective;
+}
+
+void AnnealingSmoother::setComponentScales(const State *state)
+{
+    //average the absolute changes of the components over random perturbations of a copy of the state
+    State* probe = state->clone();
+    std::mt19937 generator( m_seed );
+    std::uniform_int_distribution<long> pick( 0, m_activeClasses.size() - 1 );
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    double before[4], after[4], changes[4] = { 0.0, 0.0, 0.0, 0.0 };
+    long nProbes = std::min( 10000L, 20L * (long)m_activeClasses.size() );
+    for( long n = 0; n < nProbes; ++n ){
+        long from = m_activeClasses[ pick( generator ) ];
+        long to = m_activeClasses[ pick( generator ) ];
+        double amount = uniform( generator ) * probe->probabilities[from];
+        if( from == to || amount <= 0.0 )
+            continue;
+        probe->getComponents( before );
+        probe->move( from, to, amount );
+        probe->getComponents( after );
+        probe->move( to, from, amount );
+        for( int i = 0; i < 4; ++i )
+            changes[i] += std::abs( after[i] - before[i] );
+    }
+    delete probe;
+    for( int i = 0; i < 4; ++i )
+        m_componentScales[i] = changes[i] > 0.0 ? nProbes / changes[i] : 1.0;
+    m_averageChange = 0.0;
+    for( int i = 0; i < 4; ++i )
+        if( m_componentEnabled[i] && changes[i] > 0.0 )
+            m_averageChange += m_componentWeights[i];
+
+    //scale the objective function to start at one
+    //a zero objective means the initial state already meets the targets: the scales are kept as they are
+    double components[4];
+    state->getComponents( components );
+    double objective = getObjective( components );
+    if( objective <= 0.0 )
+        return;
+    for( int i = 0; i < 4; ++i )
+        m_componentScales[i] /= objective;
+    m_averageChange /= objective;
+}
+
+void AnnealingSmoother::makeCDF(std::vector<std::pair<double, double> > &valuesAndWeights,
+                                std::vector<double> &values, std::vector<double> &cdf)
+{
+    std::sort( valuesAndWeights.begin(), valuesAndWeights.end() );
+    double totalWeight = 0.0;
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights )
+        totalWeight += valueAndWeight.second;
+    values.clear();
+    cdf.clear();
+    double cumulativeWeight = 0.0;
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights ){
+        values.push_back( valueAndWeight.first );
+        cdf.push_back( ( cumulativeWeight + 0.5 * valueAndWeight.second ) / totalWeight );
+        cumulativeWeight += valueAndWeight.second;
+    }
+}
+
+double AnnealingSmoother::getQuantile(const std::vector<double> &values, const std::vector<double> &cdf, double p)
+{
+    if( values.empty() )
+        return 0.0;
+    if( p <= cdf.front() )
+        return values.front();
+    if( p >= cdf.back() )
+        return values.back();
+    long i = std::upper_bound( cdf.begin(), cdf.end(), p ) - cdf.begin();
+    double t = ( p - cdf[i-1] ) / ( cdf[i] - cdf[i-1] );
+    return values[i-1] + t * ( values[i] - values[i-1] );
+}
+
+bool AnnealingSmoother::isFromData(double value)
+{
+    return std::abs( value + 999.0 ) < 1E-6;
+}
+
+bool AnnealingSmoother::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    State* initialState = makeInitialState();
+    if( ! initialState )
+        return false;
+    long nClasses = m_activeClasses.size();
+    if( nClasses < 2 ){
+        Application::instance()->logError( QString( getName() ) + "::run(): there must be at least two classes to perturb." );
+        delete initialState;
+        return false;
+    }
+    for( int i = 0; i < 4; ++i )
+        m_componentScales[i] = 1.0;
+    initialState->recompute();
+    setComponentScales( initialState );
+    m_initialObjective = initialState->recompute();
+
+    //the replicas, each with its own random number generator, so the results do not depend on the thread scheduling
+    int nReplicas = std::max( 1, m_nReplicas );
+    std::vector<State*> replicas( 1, initialState );
+    std::vector<std::mt19937> generators( 1, std::mt19937( m_seed ) );
+    for( int r = 1; r < nReplicas; ++r ){
+        replicas.push_back( initialState->clone() );
+        generators.push_back( std::mt19937( m_seed + 7919u * r ) );
+    }
+    std::vector<double> objectives( nReplicas, m_initialObjective );
+    //the temperatures of the hotter replicas go from 1% to 100% of the average change of the objective function
+    std::vector<double> temperatures( nReplicas, 0.0 );
+    for( int r = 1; r < nReplicas; ++r )
+        temperatures[r] = m_averageChange * 0.01 * std::pow( 100.0, ( r - 1.0 ) / std::max( 1, nReplicas - 2 ) );
+    std::mt19937 exchangeGenerator( m_seed + 1u );
+    std::uniform_real_distribution<double> exchangeUniform( 0.0, 1.0 );
+
+    long maxPerturbations = std::max( 1.0, m_maxPerturbations * nClasses );
+    long roundLength = std::max( 1L, (long)( m_reportingInterval * nClasses ) );
+    std::vector<double> best = initialState->probabilities;
+    double bestObjective = m_initialObjective;
+    long nExchanges = 0;
+    m_perturbationCount = 0;
+
+    while( m_perturbationCount < maxPerturbations && bestObjective > m_minObjective ){
+        long nPerturbations = std::min( roundLength, maxPerturbations - m_perturbationCount );
+
+        //each replica is perturbed in a thread
+        Util::parallelFor( nReplicas, [&]( long first, long last ){
+            std::uniform_int_distribution<long> pick( 0, nClasses - 1 );
+            std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+            for( long r = first; r < last; ++r ){
+                State* state = replicas[r];
+                std::mt19937& generator = generators[r];
+                double objective = objectives[r];
+                double temperature = temperatures[r];
+                for( long n = 0; n < nPerturbations; ++n ){
+                    long from = m_activeClasses[ pick( generator ) ];
+                    long to = m_activeClasses[ pick( generator ) ];
+                    double amount = uniform( generator ) * state->probabilities[from];
+                    if( from == to || amount <= 0.0 )
+                        continue;
+                    double newObjective = state->move( from, to, amount );
+                    if( newObjective <= objective ||
+                        ( temperature > 0.0 && uniform( generator ) < std::exp( ( objective - newObjective ) / temperature ) ) )
+                        objective = newObjective;
+                    else
+                        state->move( to, from, amount );
+                }
+                objectives[r] = state->recompute();
+            }
+        });
+        m_perturbationCount += nPerturbations;
+
+        //exchange the states of adjacent replicas (the coldest replica only takes better states)
+        for( int r = 0; r + 1 < nReplicas; ++r ){
+            bool exchange;
+            if( temperatures[r] <= 0.0 )
+                exchange = objectives[r+1] < objectives[r];
+            else {
+                double delta = ( 1.0 / temperatures[r] - 1.0 / temperatures[r+1] ) * ( objectives[r] - objectives[r+1] );
+                exchange = delta >= 0.0 || exchangeUniform( exchangeGenerator ) < std::exp( delta );
+            }
+            if( exchange ){
+                std::swap( replicas[r], replicas[r+1] );
+                std::swap( objectives[r], objectives[r+1] );
+                ++nExchanges;
+            }
+        }
+
+        for( int r = 0; r < nReplicas; ++r )
+            if( objectives[r] < bestObjective ){
+                bestObjective = objectives[r];
+                best = replicas[r]->probabilities;
+            }
+    }
+
+    for( State* state : replicas )
+        delete state;
+    m_probabilities = best;
+    m_finalObjective = bestObjective;
+
+    Application::instance()->logInfo( QString( getName() ) + "::run(): objective reduced from " +
+                                      QString::number( m_initialObjective ) + " to " + QString::number( m_finalObjective ) +
+                                      " with " + QString::number( m_perturbationCount ) + " perturbations per replica (" +
+                                      QString::number( nReplicas ) + " replica(s), " + QString::number( nExchanges ) +
+                                      " exchange(s)) in " + QString::number( timer.elapsed() ) + "ms." );
+    return true;
+}
@@ -0,0 +1,124 @@
+#ifndef ANNEALINGSMOOTHER_H
+#define ANNEALINGSMOOTHER_H
+
+#include <vector>
+#include <utility>
+#include <QtGlobal>
+
+/**
+ * The AnnealingSmoother class is the base class of the in-process distribution smoothers (DistributionSmoother and
+ * BidistributionSmoother).  Like in the GSLib programs histsmth and scatsmth, the probabilities of a discretized
+ * distribution are perturbed by moving probability from one class to another, and a perturbation is kept if it
+ * decreases an objective function made of weighted components (e.g. the reproduction of the mean, smoothness...).
+ * The subclasses update the components incrementally, recomputing only the terms affected by the two classes
+ * changed, so a perturbation costs much less than a full evaluation of the objective function.
+ *
+ * Optionally, several replicas of the distribution are annealed in parallel at increasing temperatures (parallel
+ * tempering): the coldest replica accepts only favorable perturbations, like GSLib, while the hotter ones also accept
+ * unfavorable ones with the Metropolis probability.  The replicas of adjacent temperatures exchange their states
+ * from time to time, which lets the search escape the local minima where the greedy search stalls.
+ */
+class AnnealingSmoother
+{
+public:
+    AnnealingSmoother();
+    virtual ~AnnealingSmoother();
+
+    /** Sets the maximum number of perturbations per class (the total is this times the number of classes). */
+    void setMaxPerturbations( double value ){ m_maxPerturbations = value; }
+
+    /** Sets the number of perturbations per class between objective recomputations and replica exchanges. */
+    void setReportingInterval( double value ){ m_reportingInterval = value; }
+
+    /** The annealing stops when the objective function falls below this value.  The components of the objective
+     *  function are weighted by the inverse of their average change upon a perturbation (so all of them drive the
+     *  search) and the objective function is scaled to start at one, thus this is a fraction of the initial value. */
+    void setMinObjective( double value ){ m_minObjective = value; }
+
+    /** Enables or disables the four components of the objective function (their meaning depends on the subclass). */
+    void setComponents( bool first, bool second, bool third, bool fourth );
+
+    /** Sets the weights of the four components of the objective function. */
+    void setComponentWeights( double first, double second, double third, double fourth );
+
+    void setSeed( uint value ){ m_seed = value; }
+
+    /** Sets the number of replicas annealed in parallel.  Default is 1 (greedy search like GSLib). */
+    void setNumberOfReplicas( int value ){ m_nReplicas = value; }
+
+    /** Performs the smoothing.  Returns false if the parameters are inconsistent. */
+    bool run();
+
+    /** The smoothed probabilities. */
+    const std::vector<double>& getProbabilities() const { return m_probabilities; }
+
+    double getInitialObjective() const { return m_initialObjective; }
+    double getFinalObjective() const { return m_finalObjective; }
+    long getPerturbationCount() const { return m_perturbationCount; }
+
+protected:
+    /**
+     * A replica of the distribution being smoothed.  The subclasses keep the components of the objective function
+     * and whatever sums are needed to update them incrementally.
+     */
+    class State
+    {
+    public:
+        virtual ~State(){}
+        virtual State* clone() const = 0;
+        /** Recomputes the objective function from scratch, resetting the accumulated rounding errors. */
+        virtual double recompute() = 0;
+        /** Moves the given amount of probability from one class to another, updates the objective function
+         *  incrementally and returns its new value. */
+        virtual double move( long from, long to, double amount ) = 0;
+        /** Returns the values of the four components of the objective function before weighting. */
+        virtual void getComponents( double* components ) const = 0;
+        std::vector<double> probabilities;
+    };
+
+    /** Reads the data and the parameters and returns the initial state of the distribution or nullptr on error.
+     *  This is called in the GUI thread, so it may log messages. */
+    virtual State* makeInitialState() = 0;
+
+    /** Returns the name of the class for the log messages. */
+    virtual const char* getName() const = 0;
+
+    /** Returns the objective function given the values of its components. */
+    double getObjective( const double* components ) const;
+
+    /** Sorts the given values and weights and returns the sorted values and their cumulative probabilities (taken
+     *  at the middle of the weight of each value). */
+    static void makeCDF( std::vector< std::pair<double, double> >& valuesAndWeights,
+                         std::vector<double>& values, std::vector<double>& cdf );
+
+    /** Returns the quantile of a distribution made with makeCDF() for the given cumulative probability. */
+    static double getQuantile( const std::vector<double>& values, const std::vector<double>& cdf, double p );
+
+    /** Returns whether a target is -999, which means taking it from the data like in GSLib. */
+    static bool isFromData( double value );
+
+    /** The classes whose probabilities can be changed (e.g. those inside the envelope of scatsmth). */
+    std::vector<long> m_activeClasses;
+
+    bool m_componentEnabled[4];
+    double m_componentWeights[4];
+
+private:
+    double m_maxPerturbations;
+    double m_reportingInterval;
+    double m_minObjective;
+    uint m_seed;
+    int m_nReplicas;
+    std::vector<double> m_probabilities;
+    double m_initialObjective;
+    double m_finalObjective;
+    long m_perturbationCount;
+    double m_componentScales[4];
+    //the average absolute change of the objective function upon a perturbation
+    double m_averageChange;
+
+    /** Sets the scales of the components from the average changes caused by random perturbations of the state. */
+    void setComponentScales( const State* state );
+};
+
+#endif // ANNEALINGSMOOTHER_H
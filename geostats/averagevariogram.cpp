@@ -0,0 +1,119 @@
+#include "averagevariogram.h"
+
+#include "domain/application.h"
+#include "domain/variogrammodel.h"
+#include "geostats/geostatsutils.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+AverageVariogram::AverageVariogram(VariogramModel *model) :
+    m_nugget( model->getNugget() ),
+    m_sill( model->getSill() ),
+    m_nx( 1 ), m_ny( 1 ), m_nz( 1 )
+{
+    for( uint i = 0; i < model->getNst(); ++i ){
+        Structure structure;
+        structure.type = model->getIt( i );
+        structure.range = model->get_a_hMax( i );
+        structure.contribution = model->getCC( i );
+        structure.anisoTransform = GeostatsUtils::getAnisoTransform( model->get_a_hMax( i ), model->get_a_hMin( i ),
+                                                                     model->get_a_vert( i ), model->getAzimuth( i ),
+                                                                     model->getDip( i ), model->getRoll( i ) );
+        m_structures.push_back( structure );
+    }
+}
+
+void AverageVariogram::setBlockDiscretization(int nx, int ny, int nz)
+{
+    m_nx = std::max( 1, nx );
+    m_ny = std::max( 1, ny );
+    m_nz = std::max( 1, nz );
+}
+
+double AverageVariogram::compute(double sizeX, double sizeY, double sizeZ) const
+{
+    //the discretization points are the centers of the nx*ny*nz sub-blocks (see gammabar.for)
+    long n = (long)m_nx * m_ny * m_nz;
+    std::vector<double> x( n ), y( n ), z( n );
+    for( int iz = 0; iz < m_nz; ++iz )
+        for( int iy = 0; iy < m_ny; ++iy )
+            for( int ix = 0; ix < m_nx; ++ix ){
+                long i = ix + iy * m_nx + (long)iz * m_nx * m_ny;
+                x[i] = -sizeX / 2.0 + ( ix + 0.5 ) * sizeX / m_nx;
+                y[i] = -sizeY / 2.0 + ( iy + 0.5 ) * sizeY / m_ny;
+                z[i] = -sizeZ / 2.0 + ( iz + 0.5 ) * sizeZ / m_nz;
+            }
+
+    //the nugget effect applies to every pair of distinct points
+    double sum = 0.0;
+    if( n > 1 && ( sizeX > 0.0 || sizeY > 0.0 || sizeZ > 0.0 ) )
+        sum += m_nugget * n * ( n - 1 ) / 2.0;
+
+    //the contribution of each structure
+    std::vector<double> tx( n ), ty( n ), tz( n );
+    //the separations of a point to the points after it and the sums of the variogram values of all the pairs
+    //(the gammas of the pairs of each point are added to the same buffer, which is summed up only at the end)
+    std::vector<double> h( std::max( 0L, n - 1 ) );
+    std::vector<double> gammas( std::max( 0L, n - 1 ), 0.0 );
+    for( const Structure& structure : m_structures ){
+        //transform the points once, so the anisotropic separations are Euclidean distances in the new space
+        for( long i = 0; i < n; ++i ){
+            tx[i] = x[i]; ty[i] = y[i]; tz[i] = z[i];
+            GeostatsUtils::transform( structure.anisoTransform, tx[i], ty[i], tz[i] );
+        }
+        //the variogram is symmetric and zero for a point with itself, so only the pairs i < j are evaluated:
+        //the separations of each point to the following ones fill a buffer, which is evaluated in a tight loop
+        //that tests the structure type only once
+        for( long i = 0; i < n - 1; ++i ){
+            long m = n - i - 1;
+            const double* txj = &tx[i+1];
+            const double* tyj = &ty[i+1];
+            const double* tzj = &tz[i+1];
+            for( long k = 0; k < m; ++k ){
+                double dx = txj[k] - tx[i];
+                double dy = tyj[k] - ty[i];
+                double dz = tzj[k] - tz[i];
+                h[k] = std::sqrt( dx*dx + dy*dy + dz*dz );
+            }
+            GeostatsUtils::addGammas( structure.type, h.data(), m, structure.range, structure.contribution,
+                                      gammas.data() );
+        }
+    }
+    for( double gamma : gammas )
+        sum += gamma;
+
+    //average over all n*n pairs
+    return 2.0 * sum / ( (double)n * n );
+}
+
+std::vector<double> AverageVariogram::computeSweep(double sizeX, double sizeY, double sizeZ,
+                                                   const std::vector<double> &scaleFactors) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    long nSizes = scaleFactors.size();
+    std::vector<double> result( nSizes );
+    Util::parallelFor( nSizes, [&]( long first, long last ){
+        for( long i = first; i < last; ++i ){
+            double factor = scaleFactors[i];
+            result[i] = compute( sizeX * factor, sizeY * factor, sizeZ * factor );
+        }
+    });
+
+    Application::instance()->logInfo( "AverageVariogram::computeSweep(): " + QString::number( nSizes ) +
+                                      " block sizes with " + QString::number( m_nx ) + "x" + QString::number( m_ny ) +
+                                      "x" + QString::number( m_nz ) + " discretization computed in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+    return result;
+}
+
+double AverageVariogram::getVarianceLoss(double averageVariogram) const
+{
+    if( m_sill <= 0.0 )
+        return 0.0;
+    return averageVariogram / m_sill * 100.0;
+}
@@ -0,0 +1,56 @@
+#ifndef AVERAGEVARIOGRAM_H
+#define AVERAGEVARIOGRAM_H
+
+#include <vector>
+#include "matrix3x3.h"
+
+class VariogramModel;
+enum class VariogramStructureType : int;
+
+/**
+ * The AverageVariogram class computes the average variogram (gamma-bar) within a block in-process, like the GSLib
+ * program gammabar: the block is discretized in nx*ny*nz points and the variogram model is averaged over all pairs
+ * of points.  The result divided by the sill is the fraction of the variance lost by averaging point values into
+ * blocks (e.g. grid cells) of that size.
+ *
+ * The model parameters and the anisotropy transforms are read once in the constructor.  The discretization points
+ * of a block are transformed to the isotropic space of each structure once, so the separation of each pair is a
+ * plain Euclidean distance computed from contiguous coordinates.  The separations of a point to the others are
+ * evaluated in batches with GeostatsUtils::addGammas(), which tests the structure type once per batch.  Several block
+ * sizes can be evaluated in parallel with computeSweep(), which makes it practical to choose a grid resolution
+ * interactively.
+ */
+class AverageVariogram
+{
+public:
+    AverageVariogram( VariogramModel* model );
+
+    /** Sets the number of discretization points of the blocks along each axis. Default is 1 (no discretization). */
+    void setBlockDiscretization( int nx, int ny, int nz );
+
+    /** Returns the average variogram within a block of the given dimensions. */
+    double compute( double sizeX, double sizeY, double sizeZ ) const;
+
+    /** Returns the average variograms of blocks with the given dimensions scaled by each factor. The blocks are
+     * computed in parallel.
+     */
+    std::vector<double> computeSweep( double sizeX, double sizeY, double sizeZ,
+                                      const std::vector<double>& scaleFactors ) const;
+
+    /** Returns the average variogram as a percentage of the sill of the variogram model (variance loss). */
+    double getVarianceLoss( double averageVariogram ) const;
+
+private:
+    struct Structure{
+        VariogramStructureType type;
+        double range;
+        double contribution;
+        Matrix3X3<double> anisoTransform;
+    };
+    std::vector<Structure> m_structures;
+    double m_nugget;
+    double m_sill;
+    int m_nx, m_ny, m_nz;
+};
+
+#endif // AVERAGEVARIOGRAM_H
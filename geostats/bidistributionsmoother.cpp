@@ -0,0 +1,409 @@
+#include "bidistributionsmoother.h"
+
+#include "domain/application.h"
+#include "domain/datafile.h"
+#include "domain/univariatedistribution.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * The probabilities of the cells of the bivariate grid along with the sums needed to update the components of the
+ * objective function of scatsmth when probability is moved between two cells.
+ */
+class BidistributionSmoother::SmoothingState : public AnnealingSmoother::State
+{
+public:
+    SmoothingState( const BidistributionSmoother* smoother ) :
+        m_smoother( smoother ),
+        m_nx( smoother->m_xValues.size() ),
+        m_ny( smoother->m_yValues.size() )
+    {}
+
+    State* clone() const { return new SmoothingState( *this ); }
+
+    double recompute(){
+        const BidistributionSmoother* s = m_smoother;
+        m_rowSums.assign( m_nx, 0.0 );
+        m_columnSums.assign( m_ny, 0.0 );
+        m_sx = m_sxx = m_sy = m_syy = m_sxy = 0.0;
+        for( long iy = 0; iy < m_ny; ++iy )
+            for( long ix = 0; ix < m_nx; ++ix ){
+                double p = probabilities[ ix + iy * m_nx ];
+                double x = s->m_xScaled[ix];
+                double y = s->m_yScaled[iy];
+                m_rowSums[ix] += p;
+                m_columnSums[iy] += p;
+                m_sx += p * x;
+                m_sxx += p * x * x;
+                m_sy += p * y;
+                m_syy += p * y * y;
+                m_sxy += p * x * y;
+            }
+        m_marginalError = 0.0;
+        for( long ix = 0; ix < m_nx; ++ix )
+            m_marginalError += ( m_rowSums[ix] - s->m_xMarginal[ix] ) * ( m_rowSums[ix] - s->m_xMarginal[ix] );
+        for( long iy = 0; iy < m_ny; ++iy )
+            m_marginalError += ( m_columnSums[iy] - s->m_yMarginal[iy] ) * ( m_columnSums[iy] - s->m_yMarginal[iy] );
+
+        m_windowSums.assign( m_nx * m_ny, 0.0 );
+        m_residuals.assign( m_nx * m_ny, 0.0 );
+        m_sumOfSquaredResiduals = 0.0;
+        for( long iy = 0; iy < m_ny; ++iy )
+            for( long ix = 0; ix < m_nx; ++ix ){
+                long k = ix + iy * m_nx;
+                if( ! s->m_active[k] )
+                    continue;
+                for( long jy = std::max( 0L, iy - s->m_halfWindowY ); jy <= std::min( m_ny - 1, iy + s->m_halfWindowY ); ++jy )
+                    for( long jx = std::max( 0L, ix - s->m_halfWindowX ); jx <= std::min( m_nx - 1, ix + s->m_halfWindowX ); ++jx )
+                        m_windowSums[k] += probabilities[ jx + jy * m_nx ];
+                m_residuals[k] = getResidual( k );
+                m_sumOfSquaredResiduals += m_residuals[k] * m_residuals[k];
+            }
+
+        long nqx = s->m_quantileLastX.size();
+        long nqy = s->m_quantileLastY.size();
+        m_quantileCDFs.assign( nqx * nqy, 0.0 );
+        m_quantileError = 0.0;
+        for( long b = 0; b < nqy; ++b )
+            for( long a = 0; a < nqx; ++a ){
+                double& cdf = m_quantileCDFs[ a + b * nqx ];
+                for( long iy = 0; iy <= s->m_quantileLastY[b]; ++iy )
+                    for( long ix = 0; ix <= s->m_quantileLastX[a]; ++ix )
+                        cdf += probabilities[ ix + iy * m_nx ];
+                double error = cdf - s->m_quantileCDFs[ a + b * nqx ];
+                m_quantileError += error * error;
+            }
+        return getObjective();
+    }
+
+    double move( long from, long to, double amount ){
+        change( from, -amount );
+        change( to, amount );
+        return getObjective();
+    }
+
+    /** Returns the (unscaled) marginal, correlation, smoothness and quantile components. */
+    void getComponents( double* components ) const {
+        double varianceX = m_sxx - m_sx * m_sx;
+        double varianceY = m_syy - m_sy * m_sy;
+        double correlation = 0.0;
+        if( varianceX > 0.0 && varianceY > 0.0 )
+            correlation = ( m_sxy - m_sx * m_sy ) / std::sqrt( varianceX * varianceY );
+        components[0] = m_marginalError;
+        components[1] = ( correlation - m_smoother->m_correlation ) * ( correlation - m_smoother->m_correlation );
+        components[2] = m_sumOfSquaredResiduals;
+        components[3] = m_quantileError;
+    }
+
+private:
+    const BidistributionSmoother* m_smoother;
+    long m_nx;
+    long m_ny;
+    //the marginals of the current probabilities
+    std::vector<double> m_rowSums;
+    std::vector<double> m_columnSums;
+    double m_marginalError;
+    //the moments needed for the correlation (the probabilities add up to one)
+    double m_sx, m_sxx, m_sy, m_syy, m_sxy;
+    //sums of the probabilities within the smoothing window centered at each active cell
+    std::vector<double> m_windowSums;
+    std::vector<double> m_residuals;
+    double m_sumOfSquaredResiduals;
+    //current joint cumulative probabilities at the quantiles of X and Y
+    std::vector<double> m_quantileCDFs;
+    double m_quantileError;
+
+    double getResidual( long k ) const {
+        int count = m_smoother->m_windowCounts[k];
+        if( count < 2 )
+            return 0.0;
+        return probabilities[k] - ( m_windowSums[k] - probabilities[k] ) / ( count - 1 );
+    }
+
+    double getObjective() const {
+        double components[4];
+        getComponents( components );
+        return m_smoother->getObjective( components );
+    }
+
+    /** Changes the probability of a cell, updating only the terms affected by it. */
+    void change( long k, double delta ){
+        const BidistributionSmoother* s = m_smoother;
+        long ix = k % m_nx;
+        long iy = k / m_nx;
+        probabilities[k] += delta;
+
+        double errorX = m_rowSums[ix] - s->m_xMarginal[ix];
+        double errorY = m_columnSums[iy] - s->m_yMarginal[iy];
+        m_marginalError += ( errorX + delta ) * ( errorX + delta ) - errorX * errorX +
+                           ( errorY + delta ) * ( errorY + delta ) - errorY * errorY;
+        m_rowSums[ix] += delta;
+        m_columnSums[iy] += delta;
+
+        double x = s->m_xScaled[ix];
+        double y = s->m_yScaled[iy];
+        m_sx += delta * x;
+        m_sxx += delta * x * x;
+        m_sy += delta * y;
+        m_syy += delta * y * y;
+        m_sxy += delta * x * y;
+
+        if( s->m_componentEnabled[2] ){
+            for( long jy = std::max( 0L, iy - s->m_halfWindowY ); jy <= std::min( m_ny - 1, iy + s->m_halfWindowY ); ++jy )
+                for( long jx = std::max( 0L, ix - s->m_halfWindowX ); jx <= std::min( m_nx - 1, ix + s->m_halfWindowX ); ++jx ){
+                    long j = jx + jy * m_nx;
+                    if( ! s->m_active[j] )
+                        continue;
+                    m_windowSums[j] += delta;
+                    double residual = getResidual( j );
+                    m_sumOfSquaredResiduals += residual * residual - m_residuals[j] * m_residuals[j];
+                    m_residuals[j] = residual;
+                }
+        }
+
+        long nqx = s->m_quantileLastX.size();
+        long nqy = s->m_quantileLastY.size();
+        for( long b = 0; b < nqy; ++b ){
+            if( iy > s->m_quantileLastY[b] )
+                continue;
+            for( long a = 0; a < nqx; ++a ){
+                if( ix > s->m_quantileLastX[a] )
+                    continue;
+                long q = a + b * nqx;
+                double error = m_quantileCDFs[q] - s->m_quantileCDFs[q];
+                m_quantileError += ( error + delta ) * ( error + delta ) - error * error;
+                m_quantileCDFs[q] += delta;
+            }
+        }
+    }
+};
+
+BidistributionSmoother::BidistributionSmoother() :
+    AnnealingSmoother(),
+    m_dataFile( nullptr ),
+    m_xGEOEASIndex( 0 ),
+    m_yGEOEASIndex( 0 ),
+    m_weightGEOEASIndex( 0 ),
+    m_xDistribution( nullptr ),
+    m_yDistribution( nullptr ),
+    m_logX( false ),
+    m_logY( false ),
+    m_windowSize( 25.0 ),
+    m_targetCorrelation( -999.0 ),
+    m_nQuantilesX( 0 ),
+    m_nQuantilesY( 0 ),
+    m_correlation( 0.0 ),
+    m_halfWindowX( 1 ),
+    m_halfWindowY( 1 )
+{
+}
+
+void BidistributionSmoother::setData(DataFile *dataFile, uint xGEOEASIndex, uint yGEOEASIndex, uint weightGEOEASIndex)
+{
+    m_dataFile = dataFile;
+    m_xGEOEASIndex = xGEOEASIndex;
+    m_yGEOEASIndex = yGEOEASIndex;
+    m_weightGEOEASIndex = weightGEOEASIndex;
+}
+
+void BidistributionSmoother::setMarginals(UnivariateDistribution *xDistribution, UnivariateDistribution *yDistribution)
+{
+    m_xDistribution = xDistribution;
+    m_yDistribution = yDistribution;
+}
+
+void BidistributionSmoother::saveInGEOEASFormat(const QString &path, const QString &title) const
+{
+    const std::vector<double>& probabilities = getProbabilities();
+    long nx = m_xValues.size();
+    std::vector< std::vector<double> > array;
+    for( uint k = 0; k < probabilities.size(); ++k )
+        array.push_back( { m_xValues[ k % nx ], m_yValues[ k / nx ], probabilities[k] } );
+    Util::createGEOEASGridFile( title, { "x", "y", "probability" }, array, path );
+}
+
+void BidistributionSmoother::saveXMarginalInGEOEASFormat(const QString &path, const QString &title) const
+{
+    saveMarginal( m_xValues, true, path, title );
+}
+
+void BidistributionSmoother::saveYMarginalInGEOEASFormat(const QString &path, const QString &title) const
+{
+    saveMarginal( m_yValues, false, path, title );
+}
+
+void BidistributionSmoother::saveMarginal(const std::vector<double> &values, bool alongX,
+                                          const QString &path, const QString &title) const
+{
+    const std::vector<double>& probabilities = getProbabilities();
+    long nx = m_xValues.size();
+    std::vector<double> marginal( values.size(), 0.0 );
+    for( uint k = 0; k < probabilities.size(); ++k )
+        marginal[ alongX ? k % nx : k / nx ] += probabilities[k];
+    std::vector< std::vector<double> > array;
+    for( uint i = 0; i < values.size(); ++i )
+        array.push_back( { values[i], marginal[i] } );
+    Util::createGEOEASGridFile( title, { "value", "probability" }, array, path );
+}
+
+bool BidistributionSmoother::isInsideEnvelope(double x, double y) const
+{
+    if( m_envelope.size() < 3 )
+        return true;
+    //crossing number test
+    bool inside = false;
+    for( uint i = 0, j = m_envelope.size() - 1; i < m_envelope.size(); j = i++ ){
+        double xi = m_envelope[i].first, yi = m_envelope[i].second;
+        double xj = m_envelope[j].first, yj = m_envelope[j].second;
+        if( ( yi > y ) != ( yj > y ) && x < ( xj - xi ) * ( y - yi ) / ( yj - yi ) + xi )
+            inside = ! inside;
+    }
+    return inside;
+}
+
+AnnealingSmoother::State *BidistributionSmoother::makeInitialState()
+{
+    if( ! m_xDistribution || ! m_yDistribution ){
+        Application::instance()->logError( "BidistributionSmoother::makeInitialState(): the distributions of X and Y were not set." );
+        return nullptr;
+    }
+    if( ! m_dataFile || m_xGEOEASIndex == 0 || m_yGEOEASIndex == 0 ){
+        Application::instance()->logError( "BidistributionSmoother::makeInitialState(): no data were set." );
+        return nullptr;
+    }
+
+    //the grid of the model is given by the marginal distributions
+    if( ! m_xDistribution->readValuesAndProbabilities( m_xValues, m_xMarginal ) ||
+        ! m_yDistribution->readValuesAndProbabilities( m_yValues, m_yMarginal ) )
+        return nullptr;
+    long nx = m_xValues.size();
+    long ny = m_yValues.size();
+    for( std::vector<double>* marginal : { &m_xMarginal, &m_yMarginal } ){
+        double sum = 0.0;
+        for( double probability : *marginal )
+            sum += probability;
+        for( double& probability : *marginal )
+            probability /= sum;
+    }
+    if( ( m_logX && m_xValues.front() <= 0.0 ) || ( m_logY && m_yValues.front() <= 0.0 ) ){
+        Application::instance()->logError( "BidistributionSmoother::makeInitialState(): log scaling requires positive values." );
+        return nullptr;
+    }
+    m_xScaled = m_xValues;
+    m_yScaled = m_yValues;
+    if( m_logX )
+        for( double& value : m_xScaled )
+            value = std::log10( value );
+    if( m_logY )
+        for( double& value : m_yScaled )
+            value = std::log10( value );
+
+    //the data pairs
+    m_dataFile->loadData();
+    bool hasNDV = m_dataFile->hasNoDataValue();
+    double NDV = m_dataFile->getNoDataValueAsDouble();
+    std::vector<double> xData, yData, weights;
+    std::vector< std::pair<double, double> > xValuesAndWeights, yValuesAndWeights;
+    for( uint iLine = 0; iLine < m_dataFile->getDataLineCount(); ++iLine ){
+        double x = m_dataFile->data( iLine, m_xGEOEASIndex - 1 );
+        double y = m_dataFile->data( iLine, m_yGEOEASIndex - 1 );
+        double weight = m_weightGEOEASIndex > 0 ? m_dataFile->data( iLine, m_weightGEOEASIndex - 1 ) : 1.0;
+        if( hasNDV && ( Util::almostEqual2sComplement( NDV, x, 1 ) || Util::almostEqual2sComplement( NDV, y, 1 ) ) )
+            continue;
+        if( weight <= 0.0 || ( m_logX && x <= 0.0 ) || ( m_logY && y <= 0.0 ) )
+            continue;
+        xData.push_back( x );
+        yData.push_back( y );
+        weights.push_back( weight );
+        xValuesAndWeights.push_back( { x, weight } );
+        yValuesAndWeights.push_back( { y, weight } );
+    }
+    if( xData.empty() ){
+        Application::instance()->logError( "BidistributionSmoother::makeInitialState(): there are no valid data pairs." );
+        return nullptr;
+    }
+
+    //the correlation of the data is the default target
+    double totalWeight = 0.0, mx = 0.0, my = 0.0, mxx = 0.0, myy = 0.0, mxy = 0.0;
+    for( uint i = 0; i < xData.size(); ++i ){
+        double x = m_logX ? std::log10( xData[i] ) : xData[i];
+        double y = m_logY ? std::log10( yData[i] ) : yData[i];
+        totalWeight += weights[i];
+        mx += weights[i] * x;
+        my += weights[i] * y;
+        mxx += weights[i] * x * x;
+        myy += weights[i] * y * y;
+        mxy += weights[i] * x * y;
+    }
+    mx /= totalWeight; my /= totalWeight; mxx /= totalWeight; myy /= totalWeight; mxy /= totalWeight;
+    double dataCorrelation = 0.0;
+    if( mxx - mx * mx > 0.0 && myy - my * my > 0.0 )
+        dataCorrelation = ( mxy - mx * my ) / std::sqrt( ( mxx - mx * mx ) * ( myy - my * my ) );
+    m_correlation = isFromData( m_targetCorrelation ) ? dataCorrelation : m_targetCorrelation;
+
+    //the bivariate quantiles: the joint cumulative probabilities of the data at the quantiles of X and Y
+    m_quantileLastX.clear();
+    m_quantileLastY.clear();
+    m_quantileCDFs.clear();
+    if( m_componentEnabled[3] && m_nQuantilesX > 0 && m_nQuantilesY > 0 ){
+        std::vector<double> values, cdf, xQuantiles, yQuantiles;
+        makeCDF( xValuesAndWeights, values, cdf );
+        for( int a = 1; a <= m_nQuantilesX; ++a ){
+            xQuantiles.push_back( getQuantile( values, cdf, a / ( m_nQuantilesX + 1.0 ) ) );
+            m_quantileLastX.push_back( std::upper_bound( m_xValues.begin(), m_xValues.end(), xQuantiles.back() ) - m_xValues.begin() - 1 );
+        }
+        makeCDF( yValuesAndWeights, values, cdf );
+        for( int b = 1; b <= m_nQuantilesY; ++b ){
+            yQuantiles.push_back( getQuantile( values, cdf, b / ( m_nQuantilesY + 1.0 ) ) );
+            m_quantileLastY.push_back( std::upper_bound( m_yValues.begin(), m_yValues.end(), yQuantiles.back() ) - m_yValues.begin() - 1 );
+        }
+        m_quantileCDFs.assign( m_nQuantilesX * m_nQuantilesY, 0.0 );
+        for( uint i = 0; i < xData.size(); ++i )
+            for( int b = 0; b < m_nQuantilesY; ++b )
+                for( int a = 0; a < m_nQuantilesX; ++a )
+                    if( xData[i] <= xQuantiles[a] && yData[i] <= yQuantiles[b] )
+                        m_quantileCDFs[ a + b * m_nQuantilesX ] += weights[i] / totalWeight;
+    }
+
+    //the cells inside the envelope
+    m_active.assign( nx * ny, false );
+    m_activeClasses.clear();
+    for( long iy = 0; iy < ny; ++iy )
+        for( long ix = 0; ix < nx; ++ix )
+            if( isInsideEnvelope( m_xValues[ix], m_yValues[iy] ) ){
+                m_active[ ix + iy * nx ] = true;
+                m_activeClasses.push_back( ix + iy * nx );
+            }
+
+    //the smoothing window is a square with about the given number of cells
+    int halfWindow = std::max( 1, (int)( ( std::sqrt( m_windowSize ) - 1.0 ) / 2.0 + 0.5 ) );
+    m_halfWindowX = std::min<long>( halfWindow, nx - 1 );
+    m_halfWindowY = std::min<long>( halfWindow, ny - 1 );
+    m_windowCounts.assign( nx * ny, 0 );
+    for( long iy = 0; iy < ny; ++iy )
+        for( long ix = 0; ix < nx; ++ix )
+            for( long jy = std::max( 0L, iy - m_halfWindowY ); jy <= std::min( ny - 1, iy + m_halfWindowY ); ++jy )
+                for( long jx = std::max( 0L, ix - m_halfWindowX ); jx <= std::min( nx - 1, ix + m_halfWindowX ); ++jx )
+                    if( m_active[ jx + jy * nx ] )
+                        ++m_windowCounts[ ix + iy * nx ];
+
+    //the initial probabilities are those of independent variables within the envelope
+    SmoothingState* state = new SmoothingState( this );
+    state->probabilities.assign( nx * ny, 0.0 );
+    double sum = 0.0;
+    for( long k : m_activeClasses ){
+        state->probabilities[k] = m_xMarginal[ k % nx ] * m_yMarginal[ k / nx ];
+        sum += state->probabilities[k];
+    }
+    if( sum <= 0.0 ){
+        Application::instance()->logError( "BidistributionSmoother::makeInitialState(): there is no probability within the envelope." );
+        delete state;
+        return nullptr;
+    }
+    for( double& probability : state->probabilities )
+        probability /= sum;
+
+    return state;
+}
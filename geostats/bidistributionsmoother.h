@@ -0,0 +1,99 @@
+#ifndef BIDISTRIBUTIONSMOOTHER_H
+#define BIDISTRIBUTIONSMOOTHER_H
+
+#include "annealingsmoother.h"
+#include <QString>
+
+class DataFile;
+class UnivariateDistribution;
+
+/**
+ * The BidistributionSmoother class models a smooth bivariate distribution in-process, like the GSLib program
+ * scatsmth: the probabilities of the grid of values of two smooth univariate distributions (e.g. modeled with
+ * DistributionSmoother) are annealed (see AnnealingSmoother) to reproduce those marginal distributions, the
+ * correlation and the bivariate quantiles of the data pairs while keeping the probabilities smooth.  The four
+ * components of the objective function are, in this order, the marginals, the correlation, the smoothness and the
+ * quantiles, like in the scatsmth parameters.  Only the cells within the envelope polygon are perturbed.
+ */
+class BidistributionSmoother : public AnnealingSmoother
+{
+public:
+    BidistributionSmoother();
+
+    /**
+     * Sets the data pairs.  The pairs with a no-data value are ignored.
+     * @param weightGEOEASIndex The GEO-EAS index of the declustering weights, zero means equal weights.
+     */
+    void setData( DataFile* dataFile, uint xGEOEASIndex, uint yGEOEASIndex, uint weightGEOEASIndex );
+
+    /** Sets the smooth univariate distributions of X and Y, which define the grid of the model. */
+    void setMarginals( UnivariateDistribution* xDistribution, UnivariateDistribution* yDistribution );
+
+    /** Sets whether the correlation is computed with the logarithms of X and Y. */
+    void setLogScaling( bool x, bool y ){ m_logX = x; m_logY = y; }
+
+    /** Sets the size of the smoothing window in number of cells. */
+    void setSmoothingWindow( double size ){ m_windowSize = size; }
+
+    /** Sets the target correlation.  -999 means that of the data. */
+    void setTargetCorrelation( double value ){ m_targetCorrelation = value; }
+
+    /** Sets the number of quantiles of X and Y whose joint cumulative probabilities are reproduced. */
+    void setNumberOfQuantiles( int nx, int ny ){ m_nQuantilesX = nx; m_nQuantilesY = ny; }
+
+    /** Adds a vertex of the envelope polygon.  If there are less than three vertices, all cells are perturbed. */
+    void addEnvelopeVertex( double x, double y ){ m_envelope.push_back( { x, y } ); }
+
+    //@{
+    /** Saves the bivariate model as a GEO-EAS file with the X, Y and probability columns (like scatsmth). */
+    void saveInGEOEASFormat( const QString& path, const QString& title ) const;
+    /** Saves the marginal distributions of the bivariate model with the value and the probability columns. */
+    void saveXMarginalInGEOEASFormat( const QString& path, const QString& title ) const;
+    void saveYMarginalInGEOEASFormat( const QString& path, const QString& title ) const;
+    //@}
+
+protected:
+    State* makeInitialState();
+    const char* getName() const { return "BidistributionSmoother"; }
+
+private:
+    class SmoothingState;
+
+    DataFile* m_dataFile;
+    uint m_xGEOEASIndex;
+    uint m_yGEOEASIndex;
+    uint m_weightGEOEASIndex;
+    UnivariateDistribution* m_xDistribution;
+    UnivariateDistribution* m_yDistribution;
+    bool m_logX;
+    bool m_logY;
+    double m_windowSize;
+    double m_targetCorrelation;
+    int m_nQuantilesX;
+    int m_nQuantilesY;
+    std::vector< std::pair<double, double> > m_envelope;
+
+    //set up by makeInitialState()
+    std::vector<double> m_xValues;
+    std::vector<double> m_yValues;
+    std::vector<double> m_xMarginal;
+    std::vector<double> m_yMarginal;
+    //the values used to compute the correlation (the logarithms if log scaling is on)
+    std::vector<double> m_xScaled;
+    std::vector<double> m_yScaled;
+    double m_correlation;
+    std::vector<bool> m_active;
+    int m_halfWindowX;
+    int m_halfWindowY;
+    std::vector<int> m_windowCounts;
+    std::vector<long> m_quantileLastX;
+    std::vector<long> m_quantileLastY;
+    std::vector<double> m_quantileCDFs;
+
+    /** Returns whether a point is inside the envelope polygon. */
+    bool isInsideEnvelope( double x, double y ) const;
+
+    void saveMarginal( const std::vector<double>& values, bool alongX, const QString& path, const QString& title ) const;
+};
+
+#endif // BIDISTRIBUTIONSMOOTHER_H
@@ -0,0 +1,184 @@
+#include "celldeclustering.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/pointset.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+CellDeclustering::CellDeclustering(Attribute *at) :
+    m_at( at ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_anisY( 1.0 ),
+    m_anisZ( 1.0 ),
+    m_lookForMaximum( false ),
+    m_nCellSizes( 20 ),
+    m_cellSizeMin( 1.0 ),
+    m_cellSizeMax( 1.0 ),
+    m_nOffsets( 5 ),
+    m_optimalCellSize( 0.0 ),
+    m_optimalMean( 0.0 ),
+    m_naiveMean( 0.0 )
+{
+}
+
+bool CellDeclustering::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PointSet* pointSet = (PointSet*)m_at->getContainingFile();
+    pointSet->loadData();
+    long nLines = pointSet->getDataLineCount();
+    uint column = pointSet->getFieldGEOEASIndex( m_at->getName() ) - 1;
+    int xColumn = pointSet->getXindex() - 1;
+    int yColumn = pointSet->getYindex() - 1;
+    int zColumn = pointSet->is3D() ? pointSet->getZindex() - 1 : -1;
+    bool hasNDV = pointSet->hasNoDataValue();
+    double NDV = pointSet->getNoDataValueAsDouble();
+
+    //gather the valid data
+    m_x.clear(); m_y.clear(); m_z.clear(); m_values.clear(); m_lines.clear();
+    m_naiveMean = 0.0;
+    for( long iLine = 0; iLine < nLines; ++iLine ){
+        double value = pointSet->data( iLine, column );
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            continue;
+        if( value < m_trimMin || value > m_trimMax )
+            continue;
+        m_x.push_back( pointSet->data( iLine, xColumn ) );
+        m_y.push_back( pointSet->data( iLine, yColumn ) );
+        m_z.push_back( zColumn >= 0 ? pointSet->data( iLine, zColumn ) : 0.0 );
+        m_values.push_back( value );
+        m_lines.push_back( iLine );
+        m_naiveMean += value;
+    }
+    long nData = m_values.size();
+    m_cellSizes.clear();
+    m_means.clear();
+    m_weights.assign( nLines, std::nan("") );
+    if( nData == 0 ){
+        Application::instance()->logWarn( "CellDeclustering::run(): no valid data in " + m_at->getName() + "." );
+        return false;
+    }
+    m_naiveMean /= nData;
+
+    //the cell sizes to evaluate (the same as declus)
+    int nSizes = std::max( 0, m_nCellSizes ) + 1;
+    double increment = m_nCellSizes > 0 ? ( m_cellSizeMax - m_cellSizeMin ) / m_nCellSizes : 0.0;
+    for( int iSize = 0; iSize < nSizes; ++iSize )
+        m_cellSizes.push_back( m_cellSizeMin + iSize * increment );
+    m_means.resize( nSizes );
+
+    //evaluate the cell sizes in parallel (each range of cell sizes reuses its own weights array)
+    Util::parallelFor( nSizes, [&]( long first, long last ){
+        std::vector<double> weights;
+        for( long iSize = first; iSize < last; ++iSize )
+            m_means[iSize] = computeWeights( m_cellSizes[iSize], weights );
+    });
+
+    //find the optimal cell size
+    int iOptimal = 0;
+    for( int iSize = 1; iSize < nSizes; ++iSize )
+        if( ( m_lookForMaximum && m_means[iSize] > m_means[iOptimal] ) ||
+            ( ! m_lookForMaximum && m_means[iSize] < m_means[iOptimal] ) )
+            iOptimal = iSize;
+    m_optimalCellSize = m_cellSizes[iOptimal];
+    m_optimalMean = m_means[iOptimal];
+
+    //recompute the weights of the optimal cell size and standardize them to an average of 1.0
+    std::vector<double> weights;
+    computeWeights( m_optimalCellSize, weights );
+    double sumOfWeights = 0.0;
+    for( double weight : weights )
+        sumOfWeights += weight;
+    double factor = nData / sumOfWeights;
+    for( long i = 0; i < nData; ++i )
+        m_weights[ m_lines[i] ] = weights[i] * factor;
+
+    Application::instance()->logInfo( "CellDeclustering::run(): " + QString::number( nSizes ) + " cell sizes evaluated with " +
+                                      QString::number( nData ) + " data in " + QString::number( timer.elapsed() ) + "ms." );
+    return true;
+}
+
+double CellDeclustering::computeWeights(double cellSize, std::vector<double> &weights) const
+{
+    long nData = m_values.size();
+    weights.assign( nData, 0.0 );
+
+    double xmin = *std::min_element( m_x.begin(), m_x.end() );
+    double xmax = *std::max_element( m_x.begin(), m_x.end() );
+    double ymin = *std::min_element( m_y.begin(), m_y.end() );
+    double ymax = *std::max_element( m_y.begin(), m_y.end() );
+    double zmin = *std::min_element( m_z.begin(), m_z.end() );
+    double zmax = *std::max_element( m_z.begin(), m_z.end() );
+
+    double xcs = cellSize;
+    double ycs = cellSize * m_anisY;
+    double zcs = cellSize * m_anisZ;
+    if( ! ( xcs > 0.0 ) || ! ( ycs > 0.0 ) || ! ( zcs > 0.0 ) ){
+        //no declustering: all data have the same weight
+        weights.assign( nData, 1.0 );
+        return m_naiveMean;
+    }
+
+    //the origin offsets (the same as declus)
+    int nOffsets = std::max( 1, m_nOffsets );
+    double xfac = std::min( xcs / nOffsets, 0.5 * ( xmax - xmin ) );
+    double yfac = std::min( ycs / nOffsets, 0.5 * ( ymax - ymin ) );
+    double zfac = std::min( zcs / nOffsets, 0.5 * ( zmax - zmin ) );
+
+    std::vector<long long> cellOfDatum( nData );
+    std::unordered_map<long long, int> dataCountInCell;
+    dataCountInCell.reserve( nData );
+    for( int iOffset = 0; iOffset < nOffsets; ++iOffset ){
+        double xo = xmin - 0.01 - iOffset * xfac;
+        double yo = ymin - 0.01 - iOffset * yfac;
+        double zo = zmin - 0.01 - iOffset * zfac;
+        long long ncellx = (long long)( ( xmax - xo ) / xcs ) + 1;
+        long long ncelly = (long long)( ( ymax - yo ) / ycs ) + 1;
+
+        //assign the data to cells (hashing the integer cell coordinates)
+        dataCountInCell.clear();
+        for( long i = 0; i < nData; ++i ){
+            long long ix = (long long)( ( m_x[i] - xo ) / xcs );
+            long long iy = (long long)( ( m_y[i] - yo ) / ycs );
+            long long iz = (long long)( ( m_z[i] - zo ) / zcs );
+            long long cell = ix + iy * ncellx + iz * ncellx * ncelly;
+            cellOfDatum[i] = cell;
+            ++dataCountInCell[cell];
+        }
+
+        //each occupied cell gets the same total weight, which is shared equally by its data
+        double nOccupiedCells = dataCountInCell.size();
+        for( long i = 0; i < nData; ++i )
+            weights[i] += 1.0 / ( dataCountInCell[ cellOfDatum[i] ] * nOccupiedCells );
+    }
+
+    //the declustered mean
+    double sumOfWeights = 0.0;
+    double sumOfWeightedValues = 0.0;
+    for( long i = 0; i < nData; ++i ){
+        sumOfWeights += weights[i];
+        sumOfWeightedValues += weights[i] * m_values[i];
+    }
+    return sumOfWeightedValues / sumOfWeights;
+}
+
+QString CellDeclustering::getSummary() const
+{
+    QString result;
+    result += "Naive mean: " + QString::number( m_naiveMean ) + "\n";
+    result += "Optimal cell size: " + QString::number( m_optimalCellSize ) + "\n";
+    result += "Declustered mean: " + QString::number( m_optimalMean ) + "\n\n";
+    result += "Cell size\tDeclustered mean\n";
+    for( size_t i = 0; i < m_cellSizes.size(); ++i )
+        result += QString::number( m_cellSizes[i] ) + "\t" + QString::number( m_means[i] ) + "\n";
+    return result;
+}
@@ -0,0 +1,90 @@
+#ifndef CELLDECLUSTERING_H
+#define CELLDECLUSTERING_H
+
+#include <vector>
+#include <QString>
+
+class Attribute;
+
+/**
+ * The CellDeclustering class computes cell declustering weights in-process with the same algorithm of the GSLib
+ * program declus: for each cell size, the data are assigned to cells (averaging several grid origin offsets), each
+ * datum is weighted by the inverse of the number of data in its cell and the declustered mean is computed.  The
+ * weights of the cell size yielding the minimum (or maximum) declustered mean are kept.
+ *
+ * The cell sizes are evaluated in parallel and the data are assigned to cells by hashing their integer cell
+ * coordinates, so only the occupied cells take memory.
+ */
+class CellDeclustering
+{
+public:
+    /** @param at A variable of a point set. */
+    CellDeclustering( Attribute* at );
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** Sets the cell anisotropy: the Y and Z cell sizes are the X cell size times these factors. Default is 1.0. */
+    void setCellAnisotropy( double yFactor, double zFactor ){ m_anisY = yFactor; m_anisZ = zFactor; }
+
+    /** Sets whether the optimal cell size is that of the minimum declustered mean (default, for data clustered
+     *  in high values) or of the maximum (for data clustered in low values). */
+    void setLookForMaximum( bool value ){ m_lookForMaximum = value; }
+
+    /** Sets the cell sizes (in X) to evaluate: nCellSizes + 1 sizes regularly spaced between min and max. */
+    void setCellSizes( int nCellSizes, double min, double max ){ m_nCellSizes = nCellSizes; m_cellSizeMin = min; m_cellSizeMax = max; }
+
+    /** Sets the number of grid origin offsets averaged for each cell size. Default is 5. */
+    void setNumberOfOriginOffsets( int value ){ m_nOffsets = value; }
+
+    /** Computes the declustering.  Returns false if there are no valid data. */
+    bool run();
+
+    //@{
+    /** The declustered means (see getDeclusteredMeans()) as a function of the cell sizes (X sizes). */
+    const std::vector<double>& getCellSizes() const { return m_cellSizes; }
+    const std::vector<double>& getDeclusteredMeans() const { return m_means; }
+    //@}
+
+    /** The size of the cell yielding the optimal declustered mean. */
+    double getOptimalCellSize() const { return m_optimalCellSize; }
+    double getOptimalDeclusteredMean() const { return m_optimalMean; }
+    /** The mean of the data without declustering. */
+    double getNaiveMean() const { return m_naiveMean; }
+
+    /** The weights for the optimal cell size, one per data line, standardized to an average of 1.0 like
+     *  those of declus.  Lines with no-data or trimmed values have std::nan("") (see NewGEOEASColumn). */
+    const std::vector<double>& getWeights() const { return m_weights; }
+
+    /** Returns a text with the declustered means for each cell size, like the summary file of declus. */
+    QString getSummary() const;
+
+private:
+    Attribute* m_at;
+    double m_trimMin;
+    double m_trimMax;
+    double m_anisY;
+    double m_anisZ;
+    bool m_lookForMaximum;
+    int m_nCellSizes;
+    double m_cellSizeMin;
+    double m_cellSizeMax;
+    int m_nOffsets;
+
+    std::vector<double> m_cellSizes;
+    std::vector<double> m_means;
+    double m_optimalCellSize;
+    double m_optimalMean;
+    double m_naiveMean;
+    std::vector<double> m_weights;
+
+    /** The valid data gathered by run(). */
+    std::vector<double> m_x, m_y, m_z, m_values;
+    /** The data line of each valid datum. */
+    std::vector<long> m_lines;
+
+    /** Computes the (non-standardized) weights of the valid data for a cell size and returns the declustered mean. */
+    double computeWeights( double cellSize, std::vector<double>& weights ) const;
+};
+
+#endif // CELLDECLUSTERING_H
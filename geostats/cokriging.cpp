@@ -0,0 +1,401 @@
+#include "cokriging.h"
+
+#include "domain/application.h"
+#include "domain/pointset.h"
+#include "geostats/geostatsutils.h"
+#include "geostats/neighborhoodsearch.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    //separations whose square is below this are considered zero (see cova3.for)
+    const double EPSLON = 1.0E-10;
+
+    //a datum of one of the variables
+    struct Sample{
+        double x, y, z;
+        double value;
+        int var;
+    };
+}
+
+Cokriging::Cokriging(PointSet *pointSet, const std::vector<uint> &variablesGEOEASIndexes) :
+    m_pointSet( pointSet ),
+    m_variablesGEOEASIndexes( variablesGEOEASIndexes ),
+    m_models( variablesGEOEASIndexes.size() * variablesGEOEASIndexes.size() ),
+    m_modelsSet( variablesGEOEASIndexes.size() * variablesGEOEASIndexes.size(), false ),
+    m_means( variablesGEOEASIndexes.size(), 0.0 ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_nx( 0 ), m_ny( 0 ), m_nz( 0 ),
+    m_x0( 0.0 ), m_y0( 0.0 ), m_z0( 0.0 ),
+    m_dx( 1.0 ), m_dy( 1.0 ), m_dz( 1.0 ),
+    m_ndiscX( 1 ), m_ndiscY( 1 ), m_ndiscZ( 1 ),
+    m_ndMinPrimary( 1 ),
+    m_ndMaxPrimary( 12 ),
+    m_ndMaxSecondary( 12 ),
+    m_type( CokrigingType::SIMPLE )
+{
+    setSearchEllipsoids( 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 0.0, 0.0, 0.0 );
+}
+
+void Cokriging::setCovarianceModel(uint head, uint tail, const CovarianceModel &model)
+{
+    uint nVars = m_variablesGEOEASIndexes.size();
+    if( head >= nVars || tail >= nVars )
+        return;
+    //the cross covariances are assumed symmetric (no lag effect)
+    m_models[ head * nVars + tail ] = model;
+    m_models[ tail * nVars + head ] = model;
+    m_modelsSet[ head * nVars + tail ] = true;
+    m_modelsSet[ tail * nVars + head ] = true;
+}
+
+void Cokriging::setGridGeometry(uint nx, uint ny, uint nz, double x0, double y0, double z0, double dx, double dy, double dz)
+{
+    m_nx = nx; m_ny = ny; m_nz = nz;
+    m_x0 = x0; m_y0 = y0; m_z0 = z0;
+    m_dx = dx; m_dy = dy; m_dz = dz;
+}
+
+void Cokriging::setBlockDiscretization(int nx, int ny, int nz)
+{
+    m_ndiscX = std::max( 1, nx );
+    m_ndiscY = std::max( 1, ny );
+    m_ndiscZ = std::max( 1, nz );
+}
+
+void Cokriging::setNumberOfData(int minPrimary, int maxPrimary, int maxSecondary)
+{
+    m_ndMinPrimary = minPrimary;
+    m_ndMaxPrimary = maxPrimary;
+    m_ndMaxSecondary = maxSecondary;
+}
+
+void Cokriging::setSearchEllipsoids(double primaryHMax, double primaryHMin, double primaryVert,
+                                    double secondaryHMax, double secondaryHMin, double secondaryVert,
+                                    double azimuth, double dip, double roll)
+{
+    m_search[0] = primaryHMax; m_search[1] = primaryHMin; m_search[2] = primaryVert;
+    m_search[3] = secondaryHMax; m_search[4] = secondaryHMin; m_search[5] = secondaryVert;
+    m_search[6] = azimuth; m_search[7] = dip; m_search[8] = roll;
+}
+
+bool Cokriging::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int nVars = m_variablesGEOEASIndexes.size();
+    long nNodes = (long)m_nx * m_ny * m_nz;
+    bool collocated = ! m_collocated.empty();
+    m_estimates.clear();
+    m_variances.clear();
+
+    //check the parameters
+    if( nVars < 1 || (int)m_means.size() != nVars ){
+        Application::instance()->logError( "Cokriging::run(): the numbers of variables and means differ." );
+        return false;
+    }
+    if( collocated && ( nVars < 2 || (long)m_collocated.size() != nNodes ) ){
+        Application::instance()->logError( "Cokriging::run(): collocated cokriging requires a secondary variable and "
+                                           "a secondary value for each grid node." );
+        return false;
+    }
+    //collocated cokriging uses just the primary and the first secondary variable
+    int nUsedVars = collocated ? 2 : nVars;
+    for( int u = 0; u < nUsedVars; ++u )
+        for( int v = u; v < nUsedVars; ++v )
+            if( ! m_modelsSet[ u * nVars + v ] ){
+                Application::instance()->logError( "Cokriging::run(): missing auto or cross covariance for variables " +
+                                                   QString::number( u + 1 ) + " and " + QString::number( v + 1 ) + "." );
+                return false;
+            }
+    //all covariances must share the same basic structures (LMC)
+    const CovarianceModel& basicStructures = m_models[0];
+    bool threadSafe = true;
+    for( int u = 0; u < nUsedVars; ++u )
+        for( int v = u; v < nUsedVars; ++v ){
+            const CovarianceModel& model = m_models[ u * nVars + v ];
+            if( ! model.hasSameStructures( basicStructures ) ){
+                Application::instance()->logError( "Cokriging::run(): the covariances do not form a linear model of "
+                                                   "coregionalization (different structures for variables " +
+                                                   QString::number( u + 1 ) + " and " + QString::number( v + 1 ) + ")." );
+                return false;
+            }
+            threadSafe = threadSafe && model.isThreadSafe();
+        }
+    for( int i = 0; i < 3; ++i )
+        if( m_search[i] <= 0.0 || ( ! collocated && nVars > 1 && m_search[3 + i] <= 0.0 ) ){
+            Application::instance()->logError( "Cokriging::run(): the search radii must be positive." );
+            return false;
+        }
+
+    //the LMC coefficients: the nugget and the contribution of each basic structure for each pair of variables
+    int nst = basicStructures.getStructureCount();
+    std::vector<double> nuggets( nVars * nVars, 0.0 );
+    std::vector<double> contributions( nVars * nVars * nst, 0.0 );
+    for( int u = 0; u < nUsedVars; ++u )
+        for( int v = 0; v < nUsedVars; ++v ){
+            const CovarianceModel& model = m_models[ u * nVars + v ];
+            nuggets[ u * nVars + v ] = model.getNugget();
+            for( int s = 0; s < nst; ++s )
+                contributions[ ( u * nVars + v ) * nst + s ] = model.getContribution( s );
+        }
+    //Markov model 1: the cross covariance is the primary covariance scaled by the ratio of the sills
+    double markovRatio = collocated ? m_models[1].getSill() / m_models[0].getSill() : 0.0;
+    double secondarySill = collocated ? m_models[ nVars + 1 ].getSill() : 0.0;
+
+    //gather the valid data of each variable
+    m_pointSet->loadData();
+    long nLines = m_pointSet->getDataLineCount();
+    int xColumn = m_pointSet->getXindex() - 1;
+    int yColumn = m_pointSet->getYindex() - 1;
+    int zColumn = m_pointSet->is3D() ? m_pointSet->getZindex() - 1 : -1;
+    bool hasNDV = m_pointSet->hasNoDataValue();
+    double NDV = m_pointSet->getNoDataValueAsDouble();
+    std::vector<Sample> primaries, secondaries;
+    for( long iLine = 0; iLine < nLines; ++iLine ){
+        for( int v = 0; v < ( collocated ? 1 : nVars ); ++v ){
+            double value = m_pointSet->data( iLine, m_variablesGEOEASIndexes[v] - 1 );
+            if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+                continue;
+            if( value < m_trimMin || value > m_trimMax )
+                continue;
+            Sample sample;
+            sample.x = m_pointSet->data( iLine, xColumn );
+            sample.y = m_pointSet->data( iLine, yColumn );
+            sample.z = zColumn >= 0 ? m_pointSet->data( iLine, zColumn ) : 0.0;
+            sample.value = value;
+            sample.var = v;
+            if( v == 0 )
+                primaries.push_back( sample );
+            else
+                secondaries.push_back( sample );
+        }
+    }
+    if( primaries.empty() ){
+        Application::instance()->logWarn( "Cokriging::run(): no valid primary data." );
+        return false;
+    }
+
+    //index the data for the neighborhood searches
+    std::vector<double> x, y, z;
+    for( const Sample& sample : primaries ){
+        x.push_back( sample.x ); y.push_back( sample.y ); z.push_back( sample.z );
+    }
+    NeighborhoodSearch primarySearch( m_search[0], m_search[1], m_search[2], m_search[6], m_search[7], m_search[8] );
+    primarySearch.build( x, y, z );
+    x.clear(); y.clear(); z.clear();
+    for( const Sample& sample : secondaries ){
+        x.push_back( sample.x ); y.push_back( sample.y ); z.push_back( sample.z );
+    }
+    NeighborhoodSearch secondarySearch( m_search[3], m_search[4], m_search[5], m_search[6], m_search[7], m_search[8] );
+    secondarySearch.build( x, y, z );
+
+    //the covariance between two variables from the basic structure correlations of their separation
+    auto lmcCovariance = [&]( int u, int v, bool zeroSeparation, const double* rho ){
+        int pair = u * nVars + v;
+        double result = zeroSeparation ? nuggets[pair] : 0.0;
+        for( int s = 0; s < nst; ++s )
+            result += contributions[ pair * nst + s ] * rho[s];
+        return result;
+    };
+    //the covariance for the current kind of cokriging (in collocated cokriging, variable 1 is the collocated datum)
+    auto covariance = [&]( int u, int v, bool zeroSeparation, const double* rho ){
+        if( collocated && u + v == 1 )
+            return markovRatio * lmcCovariance( 0, 0, zeroSeparation, rho );
+        if( collocated && u + v == 2 )
+            return secondarySill;
+        return lmcCovariance( u, v, zeroSeparation, rho );
+    };
+
+    //the block discretization points relative to the node
+    std::vector<double> offX, offY, offZ;
+    for( int iz = 0; iz < m_ndiscZ; ++iz )
+        for( int iy = 0; iy < m_ndiscY; ++iy )
+            for( int ix = 0; ix < m_ndiscX; ++ix ){
+                offX.push_back( -m_dx / 2.0 + ( ix + 0.5 ) * m_dx / m_ndiscX );
+                offY.push_back( -m_dy / 2.0 + ( iy + 0.5 ) * m_dy / m_ndiscY );
+                offZ.push_back( -m_dz / 2.0 + ( iz + 0.5 ) * m_dz / m_ndiscZ );
+            }
+    int ndisc = offX.size();
+
+    //the average primary covariance within a block (without the nugget effect in blocks, see kt3d.for)
+    double cbb = 0.0;
+    {
+        std::vector<double> rho( nst );
+        for( int i = 0; i < ndisc; ++i )
+            for( int j = 0; j < ndisc; ++j ){
+                double ex = offX[j] - offX[i], ey = offY[j] - offY[i], ez = offZ[j] - offZ[i];
+                bool zeroSeparation = ex*ex + ey*ey + ez*ez < EPSLON;
+                basicStructures.getStructureCorrelations( ex, ey, ez, rho.data() );
+                double cov = lmcCovariance( 0, 0, zeroSeparation, rho.data() );
+                if( i == j && ndisc > 1 )
+                    cov -= nuggets[0];
+                cbb += cov;
+            }
+        cbb /= (double)ndisc * ndisc;
+    }
+
+    //the traditional ordinary cokriging cannot be used in collocated cokriging (the collocated weight would be zero)
+    CokrigingType type = m_type;
+    if( collocated && type == CokrigingType::ORDINARY_TRADITIONAL )
+        type = CokrigingType::ORDINARY_STANDARDIZED;
+
+    m_estimates.assign( nNodes, std::nan("") );
+    m_variances.assign( nNodes, std::nan("") );
+    std::vector<char> singular( nNodes, 0 );
+    auto body = [&]( long first, long last ){
+        //per-thread work buffers
+        std::vector< std::pair<double, long> > candidates;
+        std::vector<Sample> samples;
+        std::vector<double> rho( std::max( 1, nst ) );
+        std::vector<double> a, b, rhs;
+        std::vector<int> constraintOfVar( nVars );
+        for( long node = first; node < last; ++node ){
+            long ix = node % m_nx;
+            long iy = ( node / m_nx ) % m_ny;
+            long iz = node / ( (long)m_nx * m_ny );
+            double nodeX = m_x0 + ix * m_dx, nodeY = m_y0 + iy * m_dy, nodeZ = m_z0 + iz * m_dz;
+
+            //the nearest primary data
+            samples.clear();
+            primarySearch.find( nodeX, nodeY, nodeZ, m_ndMaxPrimary, candidates );
+            for( const std::pair<double, long>& candidate : candidates ){
+                if( (int)samples.size() >= m_ndMaxPrimary )
+                    break;
+                samples.push_back( primaries[ candidate.second ] );
+            }
+            if( (int)samples.size() < m_ndMinPrimary || samples.empty() )
+                continue;
+            //the nearest secondary data or the collocated secondary
+            if( collocated ){
+                if( ! std::isnan( m_collocated[node] ) ){
+                    Sample sample;
+                    sample.x = nodeX; sample.y = nodeY; sample.z = nodeZ;
+                    sample.value = m_collocated[node];
+                    sample.var = 1;
+                    samples.push_back( sample );
+                }
+            } else if( ! secondaries.empty() ){
+                secondarySearch.find( nodeX, nodeY, nodeZ, m_ndMaxSecondary, candidates );
+                int nSecondaries = 0;
+                for( const std::pair<double, long>& candidate : candidates ){
+                    if( nSecondaries++ >= m_ndMaxSecondary )
+                        break;
+                    samples.push_back( secondaries[ candidate.second ] );
+                }
+            }
+            int n = samples.size();
+
+            //the unbiasedness constraints
+            int nConstraints = 0;
+            std::fill( constraintOfVar.begin(), constraintOfVar.end(), -1 );
+            if( type == CokrigingType::ORDINARY_STANDARDIZED ){
+                std::fill( constraintOfVar.begin(), constraintOfVar.end(), 0 );
+                nConstraints = 1;
+            } else if( type == CokrigingType::ORDINARY_TRADITIONAL ){
+                for( const Sample& sample : samples )
+                    if( constraintOfVar[ sample.var ] < 0 )
+                        constraintOfVar[ sample.var ] = nConstraints++;
+            }
+            int neq = n + nConstraints;
+
+            //the data-to-data covariances: the basic structures are evaluated once per pair of samples
+            a.assign( neq * neq, 0.0 );
+            rhs.assign( neq, 0.0 );
+            for( int i = 0; i < n; ++i ){
+                const Sample& si = samples[i];
+                for( int j = i; j < n; ++j ){
+                    const Sample& sj = samples[j];
+                    double ex = sj.x - si.x, ey = sj.y - si.y, ez = sj.z - si.z;
+                    bool zeroSeparation = ex*ex + ey*ey + ez*ez < EPSLON;
+                    basicStructures.getStructureCorrelations( ex, ey, ez, rho.data() );
+                    double cov = covariance( si.var, sj.var, zeroSeparation, rho.data() );
+                    a[i * neq + j] = cov;
+                    a[j * neq + i] = cov;
+                }
+                //the data-to-block covariances
+                double cov = 0.0;
+                for( int k = 0; k < ndisc; ++k ){
+                    double ex = nodeX + offX[k] - si.x, ey = nodeY + offY[k] - si.y, ez = nodeZ + offZ[k] - si.z;
+                    bool zeroSeparation = ex*ex + ey*ey + ez*ez < EPSLON;
+                    basicStructures.getStructureCorrelations( ex, ey, ez, rho.data() );
+                    cov += covariance( si.var, 0, zeroSeparation, rho.data() );
+                }
+                rhs[i] = cov / ndisc;
+                //the constraint rows
+                int constraint = constraintOfVar[ si.var ];
+                if( constraint >= 0 ){
+                    a[i * neq + n + constraint] = 1.0;
+                    a[( n + constraint ) * neq + i] = 1.0;
+                }
+            }
+            //the primary weights sum up to 1, the secondary weights to 0
+            if( nConstraints > 0 )
+                rhs[ n + constraintOfVar[0] ] = 1.0;
+
+            b = rhs;
+            if( ! GeostatsUtils::solveLinearSystem( a, b, neq ) ){
+                singular[node] = 1;
+                continue;
+            }
+
+            //the estimate and the kriging variance
+            double estimate = type == CokrigingType::SIMPLE ? m_means[0] : 0.0;
+            for( int i = 0; i < n; ++i ){
+                const Sample& sample = samples[i];
+                double value = sample.value;
+                if( type == CokrigingType::SIMPLE )
+                    value -= m_means[ sample.var ];
+                else if( type == CokrigingType::ORDINARY_STANDARDIZED && sample.var > 0 )
+                    value = value - m_means[ sample.var ] + m_means[0];
+                estimate += b[i] * value;
+            }
+            double variance = cbb;
+            for( int i = 0; i < neq; ++i )
+                variance -= b[i] * rhs[i];
+            m_estimates[node] = estimate;
+            m_variances[node] = variance;
+        }
+    };
+    if( threadSafe )
+        Util::parallelFor( nNodes, body );
+    else
+        body( 0, nNodes );
+
+    long nEstimated = 0, nSingular = 0;
+    for( long node = 0; node < nNodes; ++node ){
+        if( ! std::isnan( m_estimates[node] ) )
+            ++nEstimated;
+        nSingular += singular[node];
+    }
+    if( nSingular > 0 )
+        Application::instance()->logWarn( "Cokriging::run(): singular cokriging systems in " + QString::number( nSingular ) +
+                                          " node(s).  They were not estimated." );
+    Application::instance()->logInfo( "Cokriging::run(): " + QString::number( nEstimated ) + " of " +
+                                      QString::number( nNodes ) + " nodes estimated with " +
+                                      QString::number( primaries.size() ) + " primary and " +
+                                      ( collocated ? QString( "collocated" ) : QString::number( secondaries.size() ) ) +
+                                      " secondary data in " + QString::number( timer.elapsed() ) + "ms." );
+    return true;
+}
+
+void Cokriging::saveInGEOEASFormat(const QString &path, double noDataValue) const
+{
+    std::vector<QString> names;
+    names.push_back( "Estimate" );
+    names.push_back( "EstimationVariance" );
+    long nNodes = m_estimates.size();
+    std::vector< std::vector<double> > array( nNodes, std::vector<double>( 2 ) );
+    for( long node = 0; node < nNodes; ++node ){
+        array[node][0] = std::isnan( m_estimates[node] ) ? noDataValue : m_estimates[node];
+        array[node][1] = std::isnan( m_variances[node] ) ? noDataValue : m_variances[node];
+    }
+    Util::createGEOEASGridFile( "Cokriging estimates", names, array, path );
+}
@@ -0,0 +1,110 @@
+#ifndef COKRIGING_H
+#define COKRIGING_H
+
+#include <vector>
+#include <QString>
+#include "covariancemodel.h"
+
+class PointSet;
+
+/*! The kriging systems of Cokriging (same options of cokb3d). */
+enum class CokrigingType : uint {
+    SIMPLE = 0,              /*!< Simple cokriging with the means of the variables. */
+    ORDINARY_STANDARDIZED,   /*!< Ordinary cokriging with a single unbiasedness constraint on all weights and
+                                  the secondary data shifted to the mean of the primary. */
+    ORDINARY_TRADITIONAL     /*!< Ordinary cokriging with the primary weights summing up to 1 and the weights of
+                                  each secondary variable summing up to 0. */
+};
+
+/**
+ * The Cokriging class estimates a primary variable in-process with the same algorithm of the GSLib program
+ * cokb3d: full cokriging with the secondary variables in the point set or collocated cokriging with a secondary
+ * variable given at each grid node under the Markov model 1 (the cross covariance is the primary covariance
+ * scaled by the ratio of the cross and primary sills).
+ *
+ * The covariances must form a linear model of coregionalization (see Util::isLMC()), so every auto and cross
+ * covariance is a combination of the same basic structures.  The basic structures are evaluated once for each
+ * pair of samples and the covariances of all variable pairs are combined from them.  The grid nodes are estimated
+ * in parallel.
+ */
+class Cokriging
+{
+public:
+    /**
+     * @param variablesGEOEASIndexes The GEO-EAS indexes (first is 1) of the primary variable followed by those of
+     *        the secondary variables in the point set.
+     */
+    Cokriging( PointSet* pointSet, const std::vector<uint>& variablesGEOEASIndexes );
+
+    /** Sets the auto (head == tail) or cross covariance model of a pair of variables (0 is the primary). */
+    void setCovarianceModel( uint head, uint tail, const CovarianceModel& model );
+
+    /** Sets the means of the variables (used by simple cokriging and ordinary standardized cokriging). */
+    void setMeans( const std::vector<double>& means ){ m_means = means; }
+
+    /**
+     * Sets the secondary variable at each grid node (in GEO-EAS order) for collocated cokriging.  The secondary
+     * variables of the point set are not used in this case and only the auto covariance of the secondary and the
+     * cross covariance sills are used.  Nodes whose values are std::nan("") are estimated with the primary alone.
+     */
+    void setCollocatedSecondary( const std::vector<double>& values ){ m_collocated = values; }
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** Sets the geometry of the estimation grid like in the GSLib parameter files (x0, y0, z0 are the
+     *  coordinates of the first cell center).  The grid is not rotated, like in cokb3d. */
+    void setGridGeometry( uint nx, uint ny, uint nz, double x0, double y0, double z0, double dx, double dy, double dz );
+
+    /** Sets the number of points discretizing each block. Default is 1 (point cokriging). */
+    void setBlockDiscretization( int nx, int ny, int nz );
+
+    /** Sets the minimum and maximum number of primary data and the maximum number of secondary data. */
+    void setNumberOfData( int minPrimary, int maxPrimary, int maxSecondary );
+
+    /** Sets the search radii for the primary and the secondary data and the angles of the search ellipsoids. */
+    void setSearchEllipsoids( double primaryHMax, double primaryHMin, double primaryVert,
+                              double secondaryHMax, double secondaryHMin, double secondaryVert,
+                              double azimuth, double dip, double roll );
+
+    void setType( CokrigingType type ){ m_type = type; }
+
+    /** Performs the estimation.  Returns false if the parameters are inconsistent (e.g. the covariances do not
+     *  form a linear model of coregionalization) or there are no valid primary data. */
+    bool run();
+
+    //@{
+    /** The results for each node (in GEO-EAS order).  Nodes that were not estimated have std::nan(""). */
+    const std::vector<double>& getEstimates() const { return m_estimates; }
+    const std::vector<double>& getKrigingVariances() const { return m_variances; }
+    //@}
+
+    /** Saves the estimates and kriging variances as a GEO-EAS grid file like that of cokb3d. */
+    void saveInGEOEASFormat( const QString& path, double noDataValue = -999.0 ) const;
+
+private:
+    PointSet* m_pointSet;
+    std::vector<uint> m_variablesGEOEASIndexes;
+    //models by variable pair (index head * nVars + tail)
+    std::vector<CovarianceModel> m_models;
+    std::vector<bool> m_modelsSet;
+    std::vector<double> m_means;
+    std::vector<double> m_collocated;
+    double m_trimMin;
+    double m_trimMax;
+    uint m_nx, m_ny, m_nz;
+    double m_x0, m_y0, m_z0;
+    double m_dx, m_dy, m_dz;
+    int m_ndiscX, m_ndiscY, m_ndiscZ;
+    int m_ndMinPrimary;
+    int m_ndMaxPrimary;
+    int m_ndMaxSecondary;
+    //hMax, hMin, vert of the primary and secondary search ellipsoids followed by the angles
+    double m_search[9];
+    CokrigingType m_type;
+
+    std::vector<double> m_estimates;
+    std::vector<double> m_variances;
+};
+
+#endif // COKRIGING_H
@@ -0,0 +1,136 @@
+#include "covariancemodel.h"
+
+#include "domain/variogrammodel.h"
+#include "geostats/geostatsutils.h"
+#include "gslib/gslibparameterfiles/gslibparamtypes.h"
+
+#include <cmath>
+
+namespace {
+    //the maximum covariance assumed for the power model (see cova3.for)
+    const double PMX = 999.0;
+    //separations whose square is below this are considered zero (see cova3.for)
+    const double EPSLON = 1.0E-10;
+}
+
+CovarianceModel::CovarianceModel(double nugget) :
+    m_nugget( nugget ),
+    m_sill( nugget ),
+    m_threadSafe( true )
+{
+}
+
+CovarianceModel::CovarianceModel(VariogramModel *model) :
+    CovarianceModel( model->getNugget() )
+{
+    for( uint i = 0; i < model->getNst(); ++i )
+        addStructure( model->getIt( i ), model->getCC( i ),
+                      model->get_a_hMax( i ), model->get_a_hMin( i ), model->get_a_vert( i ),
+                      model->getAzimuth( i ), model->getDip( i ), model->getRoll( i ) );
+}
+
+CovarianceModel::CovarianceModel(GSLibParVModel *par) :
+    CovarianceModel( par->_nst_and_nugget->getParameter<GSLibParDouble*>(1)->_value )
+{
+    uint nst = par->_nst_and_nugget->getParameter<GSLibParUInt*>(0)->_value;
+    for( uint i = 0; i < nst; ++i ){
+        GSLibParMultiValuedFixed *par0 = par->_variogram_structures->getParameter<GSLibParMultiValuedFixed*>(i, 0);
+        GSLibParMultiValuedFixed *par1 = par->_variogram_structures->getParameter<GSLibParMultiValuedFixed*>(i, 1);
+        addStructure( (VariogramStructureType)par0->getParameter<GSLibParOption*>(0)->_selected_value, //structure type
+                      par0->getParameter<GSLibParDouble*>(1)->_value, //covariance contribution
+                      par1->getParameter<GSLibParDouble*>(0)->_value, //range along azimuth
+                      par1->getParameter<GSLibParDouble*>(1)->_value, //range orthogonal to azimuth
+                      par1->getParameter<GSLibParDouble*>(2)->_value, //range along vertical
+                      par0->getParameter<GSLibParDouble*>(2)->_value, //azimuth
+                      par0->getParameter<GSLibParDouble*>(3)->_value, //dip
+                      par0->getParameter<GSLibParDouble*>(4)->_value ); //roll
+    }
+}
+
+void CovarianceModel::addStructure(VariogramStructureType type, double contribution,
+                                   double a_hMax, double a_hMin, double a_vert,
+                                   double azimuth, double dip, double roll)
+{
+    Structure structure;
+    structure.type = type;
+    structure.contribution = contribution;
+    structure.range = a_hMax;
+    structure.params[0] = a_hMax;
+    structure.params[1] = a_hMin;
+    structure.params[2] = a_vert;
+    structure.params[3] = azimuth;
+    structure.params[4] = dip;
+    structure.params[5] = roll;
+    structure.anisoTransform = GeostatsUtils::getAnisoTransform( a_hMax, a_hMin, a_vert, azimuth, dip, roll );
+    m_structures.push_back( structure );
+    if( type == VariogramStructureType::POWER_LAW )
+        m_sill += PMX;
+    else
+        m_sill += contribution;
+    //GeostatsUtils::getGamma() logs messages for these, which must not be done from worker threads
+    if( type != VariogramStructureType::SPHERIC &&
+        type != VariogramStructureType::EXPONENTIAL &&
+        type != VariogramStructureType::GAUSSIAN &&
+        type != VariogramStructureType::COSINE_HOLE_EFFECT )
+        m_threadSafe = false;
+}
+
+double CovarianceModel::getCovariance(double dx, double dy, double dz) const
+{
+    if( dx*dx + dy*dy + dz*dz < EPSLON )
+        return m_sill;
+    double result = 0.0;
+    for( const Structure& structure : m_structures ){
+        double tx = dx, ty = dy, tz = dz;
+        GeostatsUtils::transform( structure.anisoTransform, tx, ty, tz );
+        double h = std::sqrt( tx*tx + ty*ty + tz*tz );
+        double gamma = GeostatsUtils::getGamma( structure.type, h, structure.range, structure.contribution );
+        if( structure.type == VariogramStructureType::POWER_LAW )
+            result += PMX - gamma;
+        else
+            result += structure.contribution - gamma;
+    }
+    return result;
+}
+
+void CovarianceModel::getStructureCorrelations(double dx, double dy, double dz, double *values) const
+{
+    bool zeroSeparation = dx*dx + dy*dy + dz*dz < EPSLON;
+    for( size_t i = 0; i < m_structures.size(); ++i ){
+        const Structure& structure = m_structures[i];
+        if( zeroSeparation ){
+            values[i] = 1.0;
+            continue;
+        }
+        double tx = dx, ty = dy, tz = dz;
+        GeostatsUtils::transform( structure.anisoTransform, tx, ty, tz );
+        double h = std::sqrt( tx*tx + ty*ty + tz*tz );
+        values[i] = 1.0 - GeostatsUtils::getGamma( structure.type, h, structure.range, 1.0 );
+    }
+}
+
+bool CovarianceModel::hasSameStructures(const CovarianceModel &other) const
+{
+    if( m_structures.size() != other.m_structures.size() )
+        return false;
+    for( size_t i = 0; i < m_structures.size(); ++i ){
+        const Structure& a = m_structures[i];
+        const Structure& b = other.m_structures[i];
+        if( a.type != b.type )
+            return false;
+        for( int j = 0; j < 6; ++j )
+            if( a.params[j] != b.params[j] )
+                return false;
+    }
+    return true;
+}
+
+bool CovarianceModel::isSameAs(const CovarianceModel &other) const
+{
+    if( m_nugget != other.m_nugget || ! hasSameStructures( other ) )
+        return false;
+    for( size_t i = 0; i < m_structures.size(); ++i )
+        if( m_structures[i].contribution != other.m_structures[i].contribution )
+            return false;
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef COVARIANCEMODEL_H
+#define COVARIANCEMODEL_H
+
+#include <vector>
+#include "matrix3x3.h"
+
+class VariogramModel;
+class GSLibParVModel;
+enum class VariogramStructureType : int;
+
+/**
+ * The CovarianceModel class evaluates the covariance of a variogram model like the GSLib routine cova3: the sill
+ * minus the variogram value, the sill being returned for a zero separation.  The model parameters and the
+ * anisotropy transforms are read once when the object is built, so evaluating the covariance does not read the
+ * variogram model file and, for the usual structure types, can be done from worker threads (see isThreadSafe()).
+ */
+class CovarianceModel
+{
+public:
+    /** Builds a model with just the nugget effect.  Add structures with addStructure(). */
+    CovarianceModel( double nugget = 0.0 );
+
+    /** Builds a model with the parameters of a variogram model. */
+    CovarianceModel( VariogramModel* model );
+
+    /** Builds a model with the parameters of a variogram model in a GSLib parameter file. */
+    CovarianceModel( GSLibParVModel* par );
+
+    /** Adds a nested structure.  The parameters have the same meaning as in the vmodel parameter files. */
+    void addStructure( VariogramStructureType type, double contribution,
+                       double a_hMax, double a_hMin, double a_vert,
+                       double azimuth, double dip, double roll );
+
+    /** Returns the covariance for the given separation vector. */
+    double getCovariance( double dx, double dy, double dz ) const;
+
+    /** Returns the covariance at zero separation (nugget plus the contributions). */
+    double getSill() const { return m_sill; }
+
+    double getNugget() const { return m_nugget; }
+    int getStructureCount() const { return m_structures.size(); }
+    double getContribution( int structure ) const { return m_structures[structure].contribution; }
+
+    /** Returns the covariance of each structure for the given separation vector as if its contribution were 1.0
+     *  (values must have getStructureCount() elements).  The covariance of a model sharing the same structures
+     *  is its nugget (for a zero separation) plus the sum of these values times the contributions.
+     */
+    void getStructureCorrelations( double dx, double dy, double dz, double* values ) const;
+
+    /** Returns whether both models have the same structure types, ranges and angles, such as the auto and cross
+     *  variograms of a linear model of coregionalization (see Util::isLMC()). */
+    bool hasSameStructures( const CovarianceModel& other ) const;
+
+    /** Returns whether getCovariance() can be called from worker threads (GeostatsUtils::getGamma() logs
+     *  messages for some structure types). */
+    bool isThreadSafe() const { return m_threadSafe; }
+
+    /** Returns whether both objects have the same parameters, so kriging systems built with them are the same. */
+    bool isSameAs( const CovarianceModel& other ) const;
+
+private:
+    struct Structure{
+        VariogramStructureType type;
+        double contribution;
+        double range;
+        double params[6];
+        Matrix3X3<double> anisoTransform;
+    };
+    std::vector<Structure> m_structures;
+    double m_nugget;
+    double m_sill;
+    bool m_threadSafe;
+};
+
+#endif // COVARIANCEMODEL_H
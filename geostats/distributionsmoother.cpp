@@ -0,0 +1,285 @@
+#include "distributionsmoother.h"
+
+#include "domain/application.h"
+#include "domain/datafile.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * The probabilities of the values along with the sums needed to update the components of the objective function
+ * of histsmth when probability is moved between two values.
+ */
+class DistributionSmoother::SmoothingState : public AnnealingSmoother::State
+{
+public:
+    SmoothingState( const DistributionSmoother* smoother ) : m_smoother( smoother ) {}
+
+    State* clone() const { return new SmoothingState( *this ); }
+
+    double recompute(){
+        const std::vector<double>& z = m_smoother->m_values;
+        long n = probabilities.size();
+        m_sum = m_sumOfSquares = 0.0;
+        for( long i = 0; i < n; ++i ){
+            m_sum += probabilities[i] * z[i];
+            m_sumOfSquares += probabilities[i] * z[i] * z[i];
+        }
+        int h = m_smoother->m_halfWindow;
+        m_windowSums.assign( n, 0.0 );
+        m_residuals.assign( n, 0.0 );
+        m_sumOfSquaredResiduals = 0.0;
+        for( long i = 0; i < n; ++i ){
+            for( long j = std::max( 0L, i - h ); j <= std::min( n - 1, i + h ); ++j )
+                m_windowSums[i] += probabilities[j];
+        }
+        for( long i = 0; i < n; ++i ){
+            m_residuals[i] = getResidual( i );
+            m_sumOfSquaredResiduals += m_residuals[i] * m_residuals[i];
+        }
+        const std::vector<long>& lastClasses = m_smoother->m_quantileLastClasses;
+        m_quantileCDFs.assign( lastClasses.size(), 0.0 );
+        m_quantileError = 0.0;
+        for( uint q = 0; q < lastClasses.size(); ++q ){
+            for( long i = 0; i <= lastClasses[q]; ++i )
+                m_quantileCDFs[q] += probabilities[i];
+            double error = m_quantileCDFs[q] - m_smoother->m_quantileCDFs[q];
+            m_quantileError += error * error;
+        }
+        return getObjective();
+    }
+
+    double move( long from, long to, double amount ){
+        change( from, -amount );
+        change( to, amount );
+        return getObjective();
+    }
+
+    /** Returns the (unscaled) mean, variance, smoothness and quantile components. */
+    void getComponents( double* components ) const {
+        double variance = m_sumOfSquares - m_sum * m_sum;
+        components[0] = ( m_sum - m_smoother->m_mean ) * ( m_sum - m_smoother->m_mean );
+        components[1] = ( variance - m_smoother->m_variance ) * ( variance - m_smoother->m_variance );
+        components[2] = m_sumOfSquaredResiduals;
+        components[3] = m_quantileError;
+    }
+
+private:
+    const DistributionSmoother* m_smoother;
+    //sums of p*z and p*z^2 (the probabilities add up to one)
+    double m_sum;
+    double m_sumOfSquares;
+    //sums of the probabilities within the smoothing window centered at each value
+    std::vector<double> m_windowSums;
+    //differences between each probability and the average of its neighbors in the window
+    std::vector<double> m_residuals;
+    double m_sumOfSquaredResiduals;
+    //current cumulative probabilities at the target quantiles
+    std::vector<double> m_quantileCDFs;
+    double m_quantileError;
+
+    double getResidual( long i ) const {
+        int count = m_smoother->m_windowCounts[i];
+        if( count < 2 )
+            return 0.0;
+        return probabilities[i] - ( m_windowSums[i] - probabilities[i] ) / ( count - 1 );
+    }
+
+    double getObjective() const {
+        double components[4];
+        getComponents( components );
+        return m_smoother->getObjective( components );
+    }
+
+    /** Changes the probability of a value, updating only the terms affected by it. */
+    void change( long i, double delta ){
+        double z = m_smoother->m_values[i];
+        probabilities[i] += delta;
+        m_sum += delta * z;
+        m_sumOfSquares += delta * z * z;
+        if( m_smoother->m_componentEnabled[2] ){
+            long n = probabilities.size();
+            int h = m_smoother->m_halfWindow;
+            for( long j = std::max( 0L, i - h ); j <= std::min( n - 1, i + h ); ++j ){
+                m_windowSums[j] += delta;
+                double residual = getResidual( j );
+                m_sumOfSquaredResiduals += residual * residual - m_residuals[j] * m_residuals[j];
+                m_residuals[j] = residual;
+            }
+        }
+        const std::vector<long>& lastClasses = m_smoother->m_quantileLastClasses;
+        for( uint q = 0; q < lastClasses.size(); ++q ){
+            if( i > lastClasses[q] )
+                continue;
+            double target = m_smoother->m_quantileCDFs[q];
+            double error = m_quantileCDFs[q] - target;
+            m_quantileError -= error * error;
+            m_quantileCDFs[q] += delta;
+            error = m_quantileCDFs[q] - target;
+            m_quantileError += error * error;
+        }
+    }
+};
+
+DistributionSmoother::DistributionSmoother() :
+    AnnealingSmoother(),
+    m_dataFile( nullptr ),
+    m_variableGEOEASIndex( 0 ),
+    m_weightGEOEASIndex( 0 ),
+    m_trimMin( -1E21 ),
+    m_trimMax( 1E21 ),
+    m_nValues( 100 ),
+    m_min( 0.0 ),
+    m_max( 1.0 ),
+    m_logScale( false ),
+    m_windowSize( 5.0 ),
+    m_targetMean( -999.0 ),
+    m_targetVariance( -999.0 ),
+    m_nDataQuantiles( 0 ),
+    m_mean( 0.0 ),
+    m_variance( 0.0 ),
+    m_halfWindow( 1 )
+{
+}
+
+void DistributionSmoother::setData(DataFile *dataFile, uint variableGEOEASIndex, uint weightGEOEASIndex,
+                                   double trimMin, double trimMax)
+{
+    m_dataFile = dataFile;
+    m_variableGEOEASIndex = variableGEOEASIndex;
+    m_weightGEOEASIndex = weightGEOEASIndex;
+    m_trimMin = trimMin;
+    m_trimMax = trimMax;
+}
+
+void DistributionSmoother::setValues(int nValues, double min, double max, bool logScale)
+{
+    m_nValues = nValues;
+    m_min = min;
+    m_max = max;
+    m_logScale = logScale;
+}
+
+void DistributionSmoother::addUserQuantile(double cumulativeProbability, double value)
+{
+    m_userQuantiles.push_back( { cumulativeProbability, value } );
+}
+
+void DistributionSmoother::saveInGEOEASFormat(const QString &path, const QString &title) const
+{
+    const std::vector<double>& probabilities = getProbabilities();
+    std::vector< std::vector<double> > array;
+    for( uint i = 0; i < m_values.size() && i < probabilities.size(); ++i )
+        array.push_back( { m_values[i], probabilities[i] } );
+    Util::createGEOEASGridFile( title, { "value", "probability" }, array, path );
+}
+
+AnnealingSmoother::State *DistributionSmoother::makeInitialState()
+{
+    if( m_nValues < 2 || m_max <= m_min ){
+        Application::instance()->logError( "DistributionSmoother::makeInitialState(): invalid number of values or value limits." );
+        return nullptr;
+    }
+    if( m_logScale && m_min <= 0.0 ){
+        Application::instance()->logError( "DistributionSmoother::makeInitialState(): the minimum must be positive for a logarithmic scale." );
+        return nullptr;
+    }
+    if( ! m_dataFile || m_variableGEOEASIndex == 0 ){
+        Application::instance()->logError( "DistributionSmoother::makeInitialState(): no data were set." );
+        return nullptr;
+    }
+
+    //the values of the distribution model
+    m_values.resize( m_nValues );
+    for( int i = 0; i < m_nValues; ++i ){
+        double t = i / ( m_nValues - 1.0 );
+        if( m_logScale )
+            m_values[i] = std::pow( 10.0, std::log10( m_min ) + t * ( std::log10( m_max ) - std::log10( m_min ) ) );
+        else
+            m_values[i] = m_min + t * ( m_max - m_min );
+    }
+
+    //the data
+    m_dataFile->loadData();
+    bool hasNDV = m_dataFile->hasNoDataValue();
+    double NDV = m_dataFile->getNoDataValueAsDouble();
+    std::vector< std::pair<double, double> > valuesAndWeights;
+    for( uint iLine = 0; iLine < m_dataFile->getDataLineCount(); ++iLine ){
+        double value = m_dataFile->data( iLine, m_variableGEOEASIndex - 1 );
+        double weight = m_weightGEOEASIndex > 0 ? m_dataFile->data( iLine, m_weightGEOEASIndex - 1 ) : 1.0;
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            continue;
+        if( value < m_trimMin || value >= m_trimMax || weight <= 0.0 )
+            continue;
+        valuesAndWeights.push_back( { value, weight } );
+    }
+    if( valuesAndWeights.empty() ){
+        Application::instance()->logError( "DistributionSmoother::makeInitialState(): there are no valid data." );
+        return nullptr;
+    }
+
+    //the data statistics are the default targets
+    double totalWeight = 0.0, dataMean = 0.0, dataMeanOfSquares = 0.0;
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights ){
+        totalWeight += valueAndWeight.second;
+        dataMean += valueAndWeight.first * valueAndWeight.second;
+        dataMeanOfSquares += valueAndWeight.first * valueAndWeight.first * valueAndWeight.second;
+    }
+    dataMean /= totalWeight;
+    dataMeanOfSquares /= totalWeight;
+    m_mean = isFromData( m_targetMean ) ? dataMean : m_targetMean;
+    m_variance = isFromData( m_targetVariance ) ? dataMeanOfSquares - dataMean * dataMean : m_targetVariance;
+    std::vector<double> dataValues, dataCDF;
+    makeCDF( valuesAndWeights, dataValues, dataCDF );
+
+    //the target quantiles, each with the last value of the model that contributes to its cumulative probability
+    std::vector< std::pair<double, double> > quantiles;
+    for( int i = 1; i <= m_nDataQuantiles; ++i ){
+        double p = i / ( m_nDataQuantiles + 1.0 );
+        quantiles.push_back( { p, getQuantile( dataValues, dataCDF, p ) } );
+    }
+    for( const std::pair<double, double>& userQuantile : m_userQuantiles ){
+        double p = userQuantile.first;
+        quantiles.push_back( { p, isFromData( userQuantile.second ) ? getQuantile( dataValues, dataCDF, p ) : userQuantile.second } );
+    }
+    m_quantileCDFs.clear();
+    m_quantileLastClasses.clear();
+    if( m_componentEnabled[3] )
+        for( const std::pair<double, double>& quantile : quantiles ){
+            m_quantileCDFs.push_back( quantile.first );
+            m_quantileLastClasses.push_back( std::upper_bound( m_values.begin(), m_values.end(), quantile.second ) - m_values.begin() - 1 );
+        }
+
+    //the smoothing window
+    m_halfWindow = std::max( 1, (int)( m_windowSize / 2.0 ) );
+    m_windowCounts.resize( m_nValues );
+    for( int i = 0; i < m_nValues; ++i )
+        m_windowCounts[i] = std::min( m_nValues - 1, i + m_halfWindow ) - std::max( 0, i - m_halfWindow ) + 1;
+
+    //the initial probabilities are the data histogram (each datum assigned to the nearest value) smoothed once
+    std::vector<double> histogram( m_nValues, 0.0 );
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights ){
+        long i = std::lower_bound( m_values.begin(), m_values.end(), valueAndWeight.first ) - m_values.begin();
+        if( i == m_nValues || ( i > 0 && valueAndWeight.first - m_values[i-1] < m_values[i] - valueAndWeight.first ) )
+            --i;
+        histogram[i] += valueAndWeight.second;
+    }
+    SmoothingState* state = new SmoothingState( this );
+    state->probabilities.assign( m_nValues, 0.0 );
+    double sum = 0.0;
+    for( int i = 0; i < m_nValues; ++i ){
+        for( int j = std::max( 0, i - m_halfWindow ); j <= std::min( m_nValues - 1, i + m_halfWindow ); ++j )
+            state->probabilities[i] += histogram[j];
+        state->probabilities[i] /= m_windowCounts[i];
+        sum += state->probabilities[i];
+    }
+    for( double& probability : state->probabilities )
+        probability /= sum;
+
+    m_activeClasses.resize( m_nValues );
+    for( int i = 0; i < m_nValues; ++i )
+        m_activeClasses[i] = i;
+
+    return state;
+}
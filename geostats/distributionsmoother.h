@@ -0,0 +1,81 @@
+#ifndef DISTRIBUTIONSMOOTHER_H
+#define DISTRIBUTIONSMOOTHER_H
+
+#include "annealingsmoother.h"
+#include <QString>
+
+class DataFile;
+
+/**
+ * The DistributionSmoother class models a smooth univariate distribution in-process, like the GSLib program histsmth:
+ * the distribution is discretized in a number of values between a minimum and a maximum and their probabilities are
+ * annealed (see AnnealingSmoother) to reproduce the mean, the variance and some quantiles of the data (or given
+ * targets) while keeping the probabilities smooth.  The four components of the objective function are, in this
+ * order, the mean, the variance, the smoothness and the quantiles, like in the histsmth parameters.
+ */
+class DistributionSmoother : public AnnealingSmoother
+{
+public:
+    DistributionSmoother();
+
+    /**
+     * Sets the data.  The values outside [trimMin, trimMax) and the no-data values are ignored.
+     * @param weightGEOEASIndex The GEO-EAS index of the declustering weights, zero means equal weights.
+     */
+    void setData( DataFile* dataFile, uint variableGEOEASIndex, uint weightGEOEASIndex, double trimMin, double trimMax );
+
+    /** Sets the values of the distribution model: nValues between min and max, equally spaced in arithmetic or,
+     *  if logScale is true, in logarithmic scale. */
+    void setValues( int nValues, double min, double max, bool logScale );
+
+    /** Sets the size of the smoothing window in number of values. */
+    void setSmoothingWindow( double size ){ m_windowSize = size; }
+
+    /** Sets the target mean and variance.  -999 means those of the data. */
+    void setTargetMeanAndVariance( double mean, double variance ){ m_targetMean = mean; m_targetVariance = variance; }
+
+    /** Sets the number of quantiles of the data to reproduce (at equally spaced cumulative probabilities). */
+    void setNumberOfDataQuantiles( int value ){ m_nDataQuantiles = value; }
+
+    /** Adds a quantile to reproduce.  -999 as value means the quantile of the data. */
+    void addUserQuantile( double cumulativeProbability, double value );
+
+    /** The values of the distribution model.  Their probabilities are returned by getProbabilities(). */
+    const std::vector<double>& getValues() const { return m_values; }
+
+    /** Saves the distribution model as a GEO-EAS file with the value and the probability columns. */
+    void saveInGEOEASFormat( const QString& path, const QString& title ) const;
+
+protected:
+    State* makeInitialState();
+    const char* getName() const { return "DistributionSmoother"; }
+
+private:
+    class SmoothingState;
+
+    DataFile* m_dataFile;
+    uint m_variableGEOEASIndex;
+    uint m_weightGEOEASIndex;
+    double m_trimMin;
+    double m_trimMax;
+    int m_nValues;
+    double m_min;
+    double m_max;
+    bool m_logScale;
+    double m_windowSize;
+    double m_targetMean;
+    double m_targetVariance;
+    int m_nDataQuantiles;
+    std::vector< std::pair<double, double> > m_userQuantiles;
+
+    //set up by makeInitialState()
+    std::vector<double> m_values;
+    double m_mean;
+    double m_variance;
+    int m_halfWindow;
+    std::vector<int> m_windowCounts;
+    std::vector<double> m_quantileCDFs;
+    std::vector<long> m_quantileLastClasses;
+};
+
+#endif // DISTRIBUTIONSMOOTHER_H
@@ -0,0 +1,331 @@
+#include "ensemblestatistics.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/cartesiangrid.h"
+#include "univariatestatistics.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+const double EnsembleStatistics::NDV = -999.0;
+
+EnsembleStatistics::EnsembleStatistics(Attribute *realizationsAttribute) :
+    m_at( realizationsAttribute ),
+    m_cg( (CartesianGrid*)realizationsAttribute->getContainingFile() ),
+    m_computeCellStatistics( true ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_useThreshold( false ),
+    m_threshold( 0.0 )
+{
+}
+
+void EnsembleStatistics::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    uint nReal = m_cg->getNReal();
+    long nCells = (long)m_cg->getNX() * m_cg->getNY() * m_cg->getNZ();
+    uint column = m_cg->getFieldGEOEASIndex( m_at->getName() ) - 1;
+    bool hasNDV = m_cg->hasNoDataValue();
+    double gridNDV = m_cg->getNoDataValueAsDouble();
+    int nQuantiles = m_quantileProbabilities.size();
+    std::vector<double> cdfProbabilities = getCDFProbabilities();
+
+    //initialize the accumulators
+    m_realizationSummaries.clear();
+    m_realizationSummaries.reserve( nReal );
+    m_count.clear();
+    m_mean.clear();
+    m_M2.clear();
+    m_countAbove.clear();
+    m_sumAbove.clear();
+    m_markers.clear();
+    if( m_computeCellStatistics ){
+        m_count.assign( nCells, 0 );
+        m_mean.assign( nCells, 0.0 );
+        m_M2.assign( nCells, 0.0 );
+        if( m_useThreshold ){
+            m_countAbove.assign( nCells, 0 );
+            m_sumAbove.assign( nCells, 0.0 );
+        }
+        m_markers.resize( nCells * nQuantiles );
+    }
+
+    Application::instance()->logInfo( "EnsembleStatistics::run(): processing " + QString::number( nReal ) +
+                                      " realizations of " + m_at->getName() + "..." );
+
+    //stream the realizations in a single read of the file: only one is in memory at a time
+    long nRead = m_cg->readDataPages( nCells, [&]( long iReal ){
+        //the distribution of the realization
+        UnivariateStatistics stats( m_at );
+        stats.setTrimmingLimits( m_trimMin, m_trimMax );
+        stats.compute();
+        RealizationSummary summary;
+        summary.mean = stats.getMean();
+        summary.variance = stats.getVariance();
+        summary.count = stats.getCount();
+        summary.quantiles.reserve( cdfProbabilities.size() );
+        for( double p : cdfProbabilities )
+            summary.quantiles.push_back( stats.getQuantile( p ) );
+        m_realizationSummaries.push_back( summary );
+
+        if( ! m_computeCellStatistics )
+            return iReal + 1 < nReal;
+
+        //update the per-cell statistics (each cell is updated by a single thread)
+        Util::parallelFor( nCells, [&]( long first, long last ){
+            for( long iCell = first; iCell < last; ++iCell ){
+                double value = m_cg->data( iCell, column );
+                if( hasNDV && Util::almostEqual2sComplement( gridNDV, value, 1 ) )
+                    continue;
+                if( value < m_trimMin || value > m_trimMax )
+                    continue;
+                int count = ++m_count[iCell];
+                //incremental mean and sum of squared deviations (Welford, 1962)
+                double delta = value - m_mean[iCell];
+                m_mean[iCell] += delta / count;
+                m_M2[iCell] += delta * ( value - m_mean[iCell] );
+                if( m_useThreshold && value > m_threshold ){
+                    ++m_countAbove[iCell];
+                    m_sumAbove[iCell] += value;
+                }
+                for( int iQuantile = 0; iQuantile < nQuantiles; ++iQuantile )
+                    updateMarkers( m_markers[ iCell * nQuantiles + iQuantile ],
+                                   m_quantileProbabilities[iQuantile], count, value );
+            }
+        });
+        return iReal + 1 < nReal;
+    });
+
+    if( nRead >= 0 && nRead < nReal )
+        Application::instance()->logWarn( "EnsembleStatistics::run(): only " + QString::number( nRead ) + " of " +
+                                          QString::number( nReal ) + " realizations found in " + m_cg->getPath() + "." );
+
+    Application::instance()->logInfo( "EnsembleStatistics::run(): finished in " +
+                                      QString::number( timer.elapsed() / 1000.0 ) + "s." );
+}
+
+std::vector<double> EnsembleStatistics::getCDFProbabilities()
+{
+    //percentiles, from 0.5% to 99.5%
+    std::vector<double> result( 100 );
+    for( int i = 0; i < 100; ++i )
+        result[i] = ( i + 0.5 ) / 100.0;
+    return result;
+}
+
+std::vector<double> EnsembleStatistics::getETypeMean() const
+{
+    std::vector<double> result( m_count.size() );
+    for( size_t iCell = 0; iCell < m_count.size(); ++iCell )
+        result[iCell] = getCellETypeMean( iCell );
+    return result;
+}
+
+std::vector<double> EnsembleStatistics::getConditionalVariance() const
+{
+    std::vector<double> result( m_count.size() );
+    for( size_t iCell = 0; iCell < m_count.size(); ++iCell )
+        result[iCell] = getCellConditionalVariance( iCell );
+    return result;
+}
+
+std::vector<double> EnsembleStatistics::getProbabilityAboveThreshold() const
+{
+    std::vector<double> result( m_countAbove.size() );
+    for( size_t iCell = 0; iCell < m_countAbove.size(); ++iCell )
+        result[iCell] = getCellProbabilityAboveThreshold( iCell );
+    return result;
+}
+
+std::vector<double> EnsembleStatistics::getMeanAboveThreshold() const
+{
+    std::vector<double> result( m_countAbove.size() );
+    for( size_t iCell = 0; iCell < m_countAbove.size(); ++iCell )
+        result[iCell] = getCellMeanAboveThreshold( iCell );
+    return result;
+}
+
+std::vector<double> EnsembleStatistics::getConditionalQuantile(int iQuantile) const
+{
+    long nCells = m_count.size();
+    std::vector<double> result( nCells );
+    Util::parallelFor( nCells, [&]( long first, long last ){
+        for( long iCell = first; iCell < last; ++iCell )
+            result[iCell] = getCellConditionalQuantile( iCell, iQuantile );
+    });
+    return result;
+}
+
+void EnsembleStatistics::saveCellStatistics(int option, const QString path) const
+{
+    //the functions returning the value of each output column for a cell
+    std::vector<QString> columnNames;
+    std::vector< std::function<double(long)> > columns;
+    switch( option ){
+    case 1:
+        columnNames = { "E-type mean", "Conditional variance" };
+        columns.push_back( [this]( long iCell ){ return getCellETypeMean( iCell ); } );
+        columns.push_back( [this]( long iCell ){ return getCellConditionalVariance( iCell ); } );
+        break;
+    case 2:
+        columnNames = { "Probability above " + QString::number( m_threshold ),
+                        "Mean above " + QString::number( m_threshold ) };
+        columns.push_back( [this]( long iCell ){ return getCellProbabilityAboveThreshold( iCell ); } );
+        columns.push_back( [this]( long iCell ){ return getCellMeanAboveThreshold( iCell ); } );
+        break;
+    case 3:
+        columnNames = { "Z-value for P=" + QString::number( m_quantileProbabilities.front() ) };
+        columns.push_back( [this]( long iCell ){ return getCellConditionalQuantile( iCell, 0 ); } );
+        break;
+    case 4:
+        columnNames = { "Lower prob. interval", "Upper prob. interval" };
+        columns.push_back( [this]( long iCell ){ return getCellConditionalQuantile( iCell, 0 ); } );
+        columns.push_back( [this]( long iCell ){ return getCellConditionalQuantile( iCell, 1 ); } );
+        break;
+    default:
+        Application::instance()->logError( "EnsembleStatistics::saveCellStatistics(): invalid option: " +
+                                           QString::number( option ) + ".  Nothing done." );
+        return;
+    }
+
+    QFile file( path );
+    if( ! file.open( QFile::WriteOnly | QFile::Text ) ){
+        Application::instance()->logError( "EnsembleStatistics::saveCellStatistics(): could not write to " +
+                                           path + ".  Nothing done." );
+        return;
+    }
+    QTextStream out( &file );
+
+    //write out the GEO-EAS grid header (same layout of Util::createGEOEASGridFile())
+    out << "Post-processed realizations of " << m_at->getName() << '\n';
+    out << columnNames.size() << '\n';
+    for( const QString& columnName : columnNames )
+        out << columnName << '\n';
+
+    //each line is written as soon as it is computed, so no copy of the results is built
+    long nCells = m_count.size();
+    for( long iCell = 0; iCell < nCells; ++iCell ){
+        for( const std::function<double(long)>& column : columns )
+            out << column( iCell ) << '\t';
+        out << '\n';
+    }
+
+    file.close();
+}
+
+double EnsembleStatistics::getCellETypeMean(long iCell) const
+{
+    if( m_count[iCell] > 0 )
+        return m_mean[iCell];
+    return NDV;
+}
+
+double EnsembleStatistics::getCellConditionalVariance(long iCell) const
+{
+    if( m_count[iCell] > 0 )
+        return m_M2[iCell] / m_count[iCell];
+    return NDV;
+}
+
+double EnsembleStatistics::getCellProbabilityAboveThreshold(long iCell) const
+{
+    if( ! m_countAbove.empty() && m_count[iCell] > 0 )
+        return m_countAbove[iCell] / (double)m_count[iCell];
+    return NDV;
+}
+
+double EnsembleStatistics::getCellMeanAboveThreshold(long iCell) const
+{
+    if( ! m_countAbove.empty() && m_countAbove[iCell] > 0 )
+        return m_sumAbove[iCell] / m_countAbove[iCell];
+    return NDV;
+}
+
+double EnsembleStatistics::getCellConditionalQuantile(long iCell, int iQuantile) const
+{
+    int nQuantiles = m_quantileProbabilities.size();
+    if( iQuantile < 0 || iQuantile >= nQuantiles || m_count[iCell] <= 0 )
+        return NDV;
+    return getQuantileFromMarkers( m_markers[ iCell * nQuantiles + iQuantile ],
+                                   m_quantileProbabilities[iQuantile], m_count[iCell] );
+}
+
+void EnsembleStatistics::updateMarkers(EnsembleStatistics::P2Markers &markers, double p, int count, float value)
+{
+    float* q = markers.heights;
+    int* n = markers.positions;
+
+    //the first five observations are kept sorted and become the initial markers
+    if( count <= 5 ){
+        int i = count - 1;
+        for( ; i > 0 && q[i-1] > value; --i )
+            q[i] = q[i-1];
+        q[i] = value;
+        for( int j = 0; j < count; ++j )
+            n[j] = j + 1;
+        return;
+    }
+
+    //find the cell k such that q[k] <= value < q[k+1], adjusting the extreme markers if necessary
+    int k;
+    if( value < q[0] ){
+        q[0] = value;
+        k = 0;
+    } else if( value >= q[4] ){
+        q[4] = value;
+        k = 3;
+    } else {
+        k = 0;
+        while( k < 3 && value >= q[k+1] )
+            ++k;
+    }
+
+    //increment the positions of the markers above k
+    for( int i = k + 1; i < 5; ++i )
+        ++n[i];
+
+    //adjust the heights of the middle markers if they are off their desired positions
+    const double increments[5] = { 0.0, p / 2.0, p, ( 1.0 + p ) / 2.0, 1.0 };
+    for( int i = 1; i < 4; ++i ){
+        double desired = 1.0 + ( count - 1 ) * increments[i];
+        double d = desired - n[i];
+        if( ( d >= 1.0 && n[i+1] - n[i] > 1 ) || ( d <= -1.0 && n[i-1] - n[i] < -1 ) ){
+            int s = d >= 0.0 ? 1 : -1;
+            //piecewise-parabolic prediction
+            double qp = q[i] + (double)s / ( n[i+1] - n[i-1] ) *
+                               ( ( n[i] - n[i-1] + s ) * ( q[i+1] - q[i] ) / ( n[i+1] - n[i] ) +
+                                 ( n[i+1] - n[i] - s ) * ( q[i] - q[i-1] ) / ( n[i] - n[i-1] ) );
+            if( q[i-1] < qp && qp < q[i+1] )
+                q[i] = qp;
+            else //linear prediction if the parabolic one is not monotonic
+                q[i] = q[i] + (double)s * ( q[i+s] - q[i] ) / ( n[i+s] - n[i] );
+            n[i] += s;
+        }
+    }
+}
+
+double EnsembleStatistics::getQuantileFromMarkers(const EnsembleStatistics::P2Markers &markers, double p, int count)
+{
+    if( count <= 0 )
+        return NDV;
+    //with up to five observations the markers are the sorted observations: the quantile is exact
+    if( count <= 5 ){
+        double position = p * ( count - 1 );
+        int i = std::min( (int)position, count - 1 );
+        if( i == count - 1 )
+            return markers.heights[i];
+        return markers.heights[i] + ( markers.heights[i+1] - markers.heights[i] ) * ( position - i );
+    }
+    //the middle marker tracks the p-quantile
+    return markers.heights[2];
+}
@@ -0,0 +1,131 @@
+#ifndef ENSEMBLESTATISTICS_H
+#define ENSEMBLESTATISTICS_H
+
+#include <vector>
+#include <QString>
+
+class Attribute;
+class CartesianGrid;
+
+/** Summary of the distribution of a single realization. */
+struct RealizationSummary{
+    double mean = 0.0;
+    double variance = 0.0;
+    long count = 0;
+    /** The values corresponding to EnsembleStatistics::getCDFProbabilities(). */
+    std::vector<double> quantiles;
+};
+
+/**
+ * The EnsembleStatistics class post-processes the realizations of a simulated variable stored in a Cartesian grid
+ * (CartesianGrid::getNReal() realizations one after the other in the file) in-process.  It replaces the GSLib
+ * programs histpltsim (per-realization distributions) and postsim (per-cell statistics across realizations).
+ *
+ * The realizations are streamed: only one realization is loaded at a time (see CartesianGrid::setDataPageToRealization())
+ * and the per-cell statistics are updated in parallel across the cells of the loaded realization, so the memory
+ * used does not depend on the number of realizations:
+ * - E-type mean and conditional variance (postsim option 1);
+ * - probability and mean above a threshold (postsim option 2), if a threshold is set;
+ * - conditional quantiles (postsim options 3 and 4), if quantile probabilities are set.  The quantiles are estimated
+ *   with the P-square algorithm (Jain and Chlamtac, 1985), which keeps five markers per cell and per quantile
+ *   instead of all the simulated values.  With fewer than six realizations the quantiles are exact.
+ */
+class EnsembleStatistics
+{
+public:
+    /** The no-data value written for cells without valid simulated values (same as postsim). */
+    static const double NDV;
+
+    /**
+     * @param realizationsAttribute The simulated variable.  Its parent file must be a CartesianGrid.
+     */
+    EnsembleStatistics( Attribute* realizationsAttribute );
+
+    /** Sets whether the per-cell statistics are computed.  Default is true.  If only the per-realization
+     * summaries are needed (e.g. for plotting), set this to false to save memory.
+     */
+    void setComputeCellStatistics( bool value ){ m_computeCellStatistics = value; }
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** Enables the computation of the per-cell probability and mean above the given threshold. */
+    void setThreshold( double threshold ){ m_threshold = threshold; m_useThreshold = true; }
+
+    /** Sets the probabilities (0.0 to 1.0) of the per-cell conditional quantiles to compute. */
+    void setQuantileProbabilities( const std::vector<double>& probabilities ){ m_quantileProbabilities = probabilities; }
+
+    /** Streams the realizations and computes the statistics.  When this returns, the data page of the grid
+     *  is reset to the entire file (no data remains loaded).
+     */
+    void run();
+
+    /** Returns the per-realization summaries (available after run()). */
+    const std::vector<RealizationSummary>& getRealizationSummaries() const { return m_realizationSummaries; }
+
+    /** Returns the cumulative probabilities at which the per-realization quantiles are computed. */
+    static std::vector<double> getCDFProbabilities();
+
+    //@{
+    /** Per-cell results (available after run()).  Cells without valid values have NDV. */
+    std::vector<double> getETypeMean() const;
+    std::vector<double> getConditionalVariance() const;
+    std::vector<double> getProbabilityAboveThreshold() const;
+    std::vector<double> getMeanAboveThreshold() const;
+    std::vector<double> getConditionalQuantile( int iQuantile ) const;
+    //@}
+
+    /**
+     * Saves per-cell results as a GEO-EAS grid file in the same layout of the postsim output.
+     * @param option The postsim output option: 1 = E-type mean and variance; 2 = probability and mean
+     *        above the threshold; 3 = the first conditional quantile; 4 = the first two conditional quantiles
+     *        (the bounds of a symmetric probability interval).
+     */
+    void saveCellStatistics( int option, const QString path ) const;
+
+private:
+    Attribute* m_at;
+    CartesianGrid* m_cg;
+    bool m_computeCellStatistics;
+    double m_trimMin;
+    double m_trimMax;
+    bool m_useThreshold;
+    double m_threshold;
+    std::vector<double> m_quantileProbabilities;
+
+    std::vector<RealizationSummary> m_realizationSummaries;
+
+    //@{
+    /** Per-cell accumulators. */
+    std::vector<int> m_count;
+    std::vector<double> m_mean;
+    std::vector<double> m_M2;
+    std::vector<int> m_countAbove;
+    std::vector<double> m_sumAbove;
+    //@}
+
+    /** The P-square markers of a quantile in a cell. */
+    struct P2Markers{
+        float heights[5];
+        int positions[5];
+    };
+    /** The P-square markers of all cells and quantiles: m_markers[ iCell * nQuantiles + iQuantile ]. */
+    std::vector<P2Markers> m_markers;
+
+    /** Adds the value as the count-th (1st == 1) observation of a cell to the P-square markers. */
+    static void updateMarkers( P2Markers& markers, double p, int count, float value );
+
+    /** Returns the quantile estimate from the P-square markers given the number of observations. */
+    static double getQuantileFromMarkers( const P2Markers& markers, double p, int count );
+
+    //@{
+    /** The per-cell results of a single cell (NDV if the cell has no valid values). */
+    double getCellETypeMean( long iCell ) const;
+    double getCellConditionalVariance( long iCell ) const;
+    double getCellProbabilityAboveThreshold( long iCell ) const;
+    double getCellMeanAboveThreshold( long iCell ) const;
+    double getCellConditionalQuantile( long iCell, int iQuantile ) const;
+    //@}
+};
+
+#endif // ENSEMBLESTATISTICS_H
@@ -0,0 +1,108 @@
+#include "faciesmapbuilder.h"
+
+#include "domain/application.h"
+#include "domain/datafile.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <atomic>
+#include <cmath>
+
+FaciesMapBuilder::FaciesMapBuilder(DataFile *probabilities, const std::vector<int> &categoryCodes) :
+    m_probabilities( probabilities ),
+    m_categoryCodes( categoryCodes ),
+    m_correctOrderRelations( true ),
+    m_correctedCellCount( 0 )
+{
+}
+
+void FaciesMapBuilder::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    //data must be loaded before the parallel section
+    m_probabilities->loadData();
+    long nCells = m_probabilities->getDataLineCount();
+    uint nCategories = std::min<uint>( m_categoryCodes.size(), m_probabilities->getDataColumnCount() );
+    if( nCategories < m_categoryCodes.size() )
+        Application::instance()->logWarn( "FaciesMapBuilder::run(): there are fewer probability columns than categories.  "
+                                          "The last categories are ignored." );
+    bool hasNDV = m_probabilities->hasNoDataValue();
+    double ndv = m_probabilities->getNoDataValueAsDouble();
+    double logNCategories = std::log( (double)nCategories );
+
+    m_categories.assign( nCells, std::nan("") );
+    m_maxProbabilities.assign( nCells, std::nan("") );
+    m_entropies.assign( nCells, std::nan("") );
+    std::atomic<long> correctedCellCount( 0 );
+
+    Util::parallelFor( nCells, [&]( long first, long last ){
+        std::vector<double> p( nCategories );
+        long corrected = 0;
+        for( long iCell = first; iCell < last; ++iCell ){
+            //read the probabilities of the cell
+            bool isNDV = false;
+            for( uint iCategory = 0; iCategory < nCategories; ++iCategory ){
+                p[iCategory] = m_probabilities->data( iCell, iCategory );
+                if( hasNDV && Util::almostEqual2sComplement( ndv, p[iCategory], 1 ) ){
+                    isNDV = true;
+                    break;
+                }
+            }
+            if( isNDV )
+                continue;
+
+            //order relations correction: reset to [0,1] and restandardize
+            if( m_correctOrderRelations ){
+                bool changed = false;
+                double sum = 0.0;
+                for( uint iCategory = 0; iCategory < nCategories; ++iCategory ){
+                    double value = std::min( 1.0, std::max( 0.0, p[iCategory] ) );
+                    changed |= ( value != p[iCategory] );
+                    p[iCategory] = value;
+                    sum += value;
+                }
+                if( sum > 0.0 ){
+                    changed |= std::abs( sum - 1.0 ) > 1E-6;
+                    for( uint iCategory = 0; iCategory < nCategories; ++iCategory )
+                        p[iCategory] /= sum;
+                }
+                if( changed )
+                    ++corrected;
+            }
+
+            //find the most likely category (cells without positive probabilities are not classified)
+            int mostLikely = -1;
+            double maxProbability = 0.0;
+            for( uint iCategory = 0; iCategory < nCategories; ++iCategory )
+                if( p[iCategory] > maxProbability ){
+                    maxProbability = p[iCategory];
+                    mostLikely = iCategory;
+                }
+            if( mostLikely < 0 )
+                continue;
+            m_categories[iCell] = m_categoryCodes[mostLikely];
+            m_maxProbabilities[iCell] = maxProbability;
+
+            //normalized entropy (probabilities outside ]0,1] do not contribute)
+            if( nCategories > 1 ){
+                double entropy = 0.0;
+                for( uint iCategory = 0; iCategory < nCategories; ++iCategory )
+                    if( p[iCategory] > 0.0 && p[iCategory] <= 1.0 )
+                        entropy -= p[iCategory] * std::log( p[iCategory] );
+                m_entropies[iCell] = entropy / logNCategories;
+            } else
+                m_entropies[iCell] = 0.0;
+        }
+        correctedCellCount += corrected;
+    });
+
+    m_correctedCellCount = correctedCellCount;
+
+    Application::instance()->logInfo( "FaciesMapBuilder::run(): " + QString::number( nCells ) + " cells classified in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+    if( m_correctOrderRelations )
+        Application::instance()->logInfo( "FaciesMapBuilder::run(): order relations corrected in " +
+                                          QString::number( m_correctedCellCount ) + " cells." );
+}
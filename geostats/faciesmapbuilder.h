@@ -0,0 +1,58 @@
+#ifndef FACIESMAPBUILDER_H
+#define FACIESMAPBUILDER_H
+
+#include <vector>
+
+class DataFile;
+
+/**
+ * The FaciesMapBuilder class converts the category probabilities estimated by indicator kriging (one column per
+ * category, such as the output of ik3d for categorical variables) into a facies map: each cell is assigned the
+ * category with the highest probability.  Optionally, the probabilities are corrected for order relation
+ * deviations first and the uncertainty of the classification (maximum probability and entropy) is computed.
+ * The cells are processed in parallel directly from the data loaded in memory.
+ */
+class FaciesMapBuilder
+{
+public:
+    /**
+     * @param probabilities The data file with the probabilities.
+     * @param categoryCodes The category code corresponding to each column of the data file (first column first).
+     */
+    FaciesMapBuilder( DataFile* probabilities, const std::vector<int>& categoryCodes );
+
+    /** If true, before classification, the probabilities are reset to the [0,1] interval and restandardized to sum
+     *  up to one (same as the order relations correction of ik3d for categorical variables).  Default is true.
+     */
+    void setCorrectOrderRelations( bool value ){ m_correctOrderRelations = value; }
+
+    /** Classifies the cells.  The data file's data are loaded if needed. */
+    void run();
+
+    //@{
+    /** Results (one value per data line, available after run()).  Cells with no-data values in any probability or
+     *  without positive probabilities have std::nan("") (see NewGEOEASColumn).
+     */
+    /** The code of the most likely category. */
+    const std::vector<double>& getCategories() const { return m_categories; }
+    /** The probability of the most likely category (after correction, if enabled). */
+    const std::vector<double>& getMaxProbabilities() const { return m_maxProbabilities; }
+    /** The entropy of the probabilities normalized to the [0,1] interval: 0 means certainty and 1 means all
+     *  categories are equally likely. */
+    const std::vector<double>& getEntropies() const { return m_entropies; }
+    //@}
+
+    /** Returns the number of cells whose probabilities were changed by the order relations correction. */
+    long getCorrectedCellCount() const { return m_correctedCellCount; }
+
+private:
+    DataFile* m_probabilities;
+    std::vector<int> m_categoryCodes;
+    bool m_correctOrderRelations;
+    std::vector<double> m_categories;
+    std::vector<double> m_maxProbabilities;
+    std::vector<double> m_entropies;
+    long m_correctedCellCount;
+};
+
+#endif // FACIESMAPBUILDER_H
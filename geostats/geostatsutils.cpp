@@ -7,6 +7,7 @@
 #include "util.h"
 #include "ijkdeltascache.h"
 
+#include <algorithm>
 #include <cmath>
 #include <limits>
 
@@ -52,7 +53,7 @@ Matrix3X3<double> GeostatsUtils::getAnisoTransform(double aSemiMajor,
     return       S * Troll * Tpitch * Tyaw;
 }
 
-void GeostatsUtils::transform(Matrix3X3<double> &t, double &a1, double &a2, double &a3)
+void GeostatsUtils::transform(const Matrix3X3<double> &t, double &a1, double &a2, double &a3)
 {
     double temp_a1 = t._a11 * a1 + t._a12 * a2 + t._a13 * a3;
     double temp_a2 = t._a21 * a1 + t._a22 * a2 + t._a23 * a3;
@@ -105,6 +106,41 @@ double GeostatsUtils::getGamma(VariogramStructureType permissiveModel, double h,
     return std::numeric_limits<double>::quiet_NaN();
 }
 
+void GeostatsUtils::addGammas(VariogramStructureType permissiveModel, const double *h, long n, double range,
+                              double contribution, double *gammas)
+{
+    double inverseRange = 1.0 / range;
+    switch( permissiveModel ){
+    case VariogramStructureType::SPHERIC:
+        for( long i = 0; i < n; ++i ){
+            double h_over_a = h[i] * inverseRange;
+            gammas[i] += h_over_a >= 1.0 ? contribution : contribution * ( 1.5*h_over_a - 0.5*(h_over_a*h_over_a*h_over_a) );
+        }
+        break;
+    case VariogramStructureType::EXPONENTIAL:
+        for( long i = 0; i < n; ++i )
+            gammas[i] += contribution * ( 1.0 - std::exp( -3.0 * h[i] * inverseRange ) );
+        break;
+    case VariogramStructureType::GAUSSIAN:
+        for( long i = 0; i < n; ++i ){
+            double h_over_a = h[i] * inverseRange;
+            gammas[i] += contribution * ( 1.0 - std::exp( -9.0*(h_over_a*h_over_a) ) );
+        }
+        break;
+    case VariogramStructureType::COSINE_HOLE_EFFECT:
+        for( long i = 0; i < n; ++i )
+            gammas[i] += contribution * ( 1.0 - std::cos( h[i] * inverseRange * Util::PI ) );
+        break;
+    case VariogramStructureType::POWER_LAW:
+        //same constant power (1.5) of getGamma()
+        for( long i = 0; i < n; ++i )
+            gammas[i] += contribution * std::pow( h[i], 1.5 );
+        break;
+    default:
+        break;
+    }
+}
+
 double GeostatsUtils::getGamma(VariogramModel *model, SpatialLocation &locA, SpatialLocation &locB)
 {
     //lesser bottleneck
@@ -323,3 +359,118 @@ void GeostatsUtils::getValuedNeighborsTopoOrdered(GridCell &cell,
         }
     }
 }
+
+double GeostatsUtils::getGaussianQuantile(double p)
+{
+    //coefficients of the rational approximation (same as in GSLib's gauinv.for)
+    const double lim = 1.0e-10;
+    const double p0 = -0.322232431088;
+    const double p1 = -1.0;
+    const double p2 = -0.342242088547;
+    const double p3 = -0.0204231210245;
+    const double p4 = -0.0000453642210148;
+    const double q0 = 0.0993484626060;
+    const double q1 = 0.588581570495;
+    const double q2 = 0.531103462366;
+    const double q3 = 0.103537752850;
+    const double q4 = 0.0038560700634;
+
+    //the tails
+    if( p < lim )
+        return -1.0e10;
+    if( p > 1.0 - lim )
+        return 1.0e10;
+
+    //the median
+    if( p == 0.5 )
+        return 0.0;
+
+    //the approximation is made for the lower half and mirrored for the upper half
+    double pp = p > 0.5 ? 1.0 - p : p;
+    double y = std::sqrt( std::log( 1.0 / ( pp * pp ) ) );
+    double xp = y + ((((y*p4+p3)*y+p2)*y+p1)*y+p0) / ((((y*q4+q3)*y+q2)*y+q1)*y+q0);
+    if( p < 0.5 )
+        xp = -xp;
+    return xp;
+}
+
+double GeostatsUtils::getGaussianCumulativeProbability(double x)
+{
+    return 0.5 * std::erfc( -x / std::sqrt( 2.0 ) );
+}
+
+bool GeostatsUtils::solveLinearSystem(std::vector<double> &a, std::vector<double> &b, int n, int nRHS)
+{
+    //forward elimination
+    for( int k = 0; k < n; ++k ){
+        //find the pivot row
+        int pivot = k;
+        double big = std::abs( a[k * n + k] );
+        for( int i = k + 1; i < n; ++i )
+            if( std::abs( a[i * n + k] ) > big ){
+                big = std::abs( a[i * n + k] );
+                pivot = i;
+            }
+        if( big < 1.0e-20 )
+            return false;
+        if( pivot != k ){
+            for( int j = 0; j < n; ++j )
+                std::swap( a[k * n + j], a[pivot * n + j] );
+            for( int j = 0; j < nRHS; ++j )
+                std::swap( b[k * nRHS + j], b[pivot * nRHS + j] );
+        }
+        //eliminate the elements below the pivot
+        for( int i = k + 1; i < n; ++i ){
+            double factor = a[i * n + k] / a[k * n + k];
+            if( factor == 0.0 )
+                continue;
+            for( int j = k; j < n; ++j )
+                a[i * n + j] -= factor * a[k * n + j];
+            for( int j = 0; j < nRHS; ++j )
+                b[i * nRHS + j] -= factor * b[k * nRHS + j];
+        }
+    }
+    //back substitution
+    for( int k = n - 1; k >= 0; --k )
+        for( int j = 0; j < nRHS; ++j ){
+            double sum = b[k * nRHS + j];
+            for( int i = k + 1; i < n; ++i )
+                sum -= a[k * n + i] * b[i * nRHS + j];
+            b[k * nRHS + j] = sum / a[k * n + k];
+        }
+    return true;
+}
+
+bool GeostatsUtils::correctOrderRelations(double *ccdf, int nThresholds, bool categorical)
+{
+    const double TOLERANCE = 1.0E-6;
+    bool changed = false;
+    //all probabilities must be within [0,1]
+    std::vector<double> original( ccdf, ccdf + nThresholds );
+    for( int k = 0; k < nThresholds; ++k )
+        ccdf[k] = std::max( 0.0, std::min( 1.0, ccdf[k] ) );
+    if( categorical ){
+        //the probabilities of the categories must sum up to 1
+        double sum = 0.0;
+        for( int k = 0; k < nThresholds; ++k )
+            sum += ccdf[k];
+        if( sum > 0.0 )
+            for( int k = 0; k < nThresholds; ++k )
+                ccdf[k] /= sum;
+    } else {
+        //the c.d.f. must be non-decreasing: average the upward and downward corrections (see ordrel.for)
+        std::vector<double> upward( nThresholds ), downward( nThresholds );
+        upward[0] = ccdf[0];
+        for( int k = 1; k < nThresholds; ++k )
+            upward[k] = std::max( upward[k-1], ccdf[k] );
+        downward[nThresholds-1] = ccdf[nThresholds-1];
+        for( int k = nThresholds - 2; k >= 0; --k )
+            downward[k] = std::min( downward[k+1], ccdf[k] );
+        for( int k = 0; k < nThresholds; ++k )
+            ccdf[k] = 0.5 * ( upward[k] + downward[k] );
+    }
+    for( int k = 0; k < nThresholds; ++k )
+        if( std::abs( ccdf[k] - original[k] ) > TOLERANCE )
+            changed = true;
+    return changed;
+}
@@ -36,7 +36,7 @@ public:
                                                 double azimuth, double dip, double roll );
 
     /** Transforms the 3x1 vector-column (a1, a2, a3) with the given 3x3 matrix. */
-    static void transform( Matrix3X3<double>& t, double& a1, double& a2, double& a3 );
+    static void transform( const Matrix3X3<double>& t, double& a1, double& a2, double& a3 );
 
     /** Returns a value for h (separation) given an anisotropy transform (obtained with getAnisoTranform() with
      * the aniso ellipsoid parameters) between two locations.  The h value is then entered into a variogram model
@@ -55,6 +55,16 @@ public:
      */
     static double getGamma( VariogramStructureType permissiveModel, double h, double range, double contribution );
 
+    /**
+     * Vectorized version of getGamma( VariogramStructureType, double, double, double ): adds the values of a
+     * variogram structure for n separations to the values in gammas, so nested structures can be summed.
+     * The structure type is tested once, so the loops over the separations are tight.  Unlike getGamma(), this
+     * function does not log messages, so it can be called from worker threads (the power model uses the same
+     * constant power of getGamma() and unknown types add nothing).
+     */
+    static void addGammas( VariogramStructureType permissiveModel, const double* h, long n, double range,
+                           double contribution, double* gammas );
+
     /**
      * Returns the total covariance according to a variogram model between two locations.
      * Includes the nugget effet contribution, if any.
@@ -94,6 +104,38 @@ public:
                                                             bool hasNDV,
                                                             double NDV,
                                                             std::multiset<GridCell>& list);
+
+    /**
+     * Returns the quantile of the standard normal distribution (mean 0.0, variance 1.0) for the given
+     * cumulative probability.  This is the same rational approximation (Kennedy and Gentle, 1980) used
+     * by GSLib's gauinv() subroutine.  Probabilities very close to 0.0 or 1.0 return -1.0e10 or 1.0e10.
+     */
+    static double getGaussianQuantile( double p );
+
+    /**
+     * Returns the cumulative probability of the standard normal distribution for the given value
+     * (the inverse of getGaussianQuantile(), like GSLib's gcum() function).
+     */
+    static double getGaussianCumulativeProbability( double x );
+
+    /**
+     * Solves the linear system a.x = b by Gaussian elimination with partial pivoting.  Several right-hand sides
+     * can be solved at once (e.g. the kriging systems of several variables sharing the same data configuration).
+     * Unlike MatrixNXM::invert(), this function does not log messages, so it can be called from worker threads.
+     * @param a The n x n matrix in row-major order.  It is overwritten.
+     * @param b The n x nRHS right-hand sides in row-major order.  It is overwritten with the solutions.
+     * @return False if the matrix is singular.
+     */
+    static bool solveLinearSystem( std::vector<double>& a, std::vector<double>& b, int n, int nRHS = 1 );
+
+    /**
+     * Corrects the order relation deviations of the local distribution of a location like the GSLib routine
+     * ordrel: the probabilities are reset into [0,1] and then either made non-decreasing (c.d.f. values of a
+     * continuous variable) or scaled to sum up to 1 (p.d.f. values of a categorical variable).
+     * This function does not log messages, so it can be called from worker threads.
+     * @return Whether some value was changed.
+     */
+    static bool correctOrderRelations( double* ccdf, int nThresholds, bool categorical );
 };
 
 #endif // GEOSTATSUTILS_H
@@ -0,0 +1,414 @@
+#include "griddedvariogramcalculator.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/cartesiangrid.h"
+#include "gslib/gslibparameterfiles/gslibparameterfile.h"
+#include "gslib/gslibparameterfiles/gslibparamtypes.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace {
+
+    /** The sums accumulated for a lag (see gam.for). */
+    struct LagSums{
+        long np = 0;
+        double gam = 0.0;
+        double hm = 0.0;
+        double tm = 0.0;
+        double hv = 0.0;
+        double tv = 0.0;
+    };
+
+    /** Returns the indicator transform of a value for indicator variograms or the value itself otherwise. */
+    inline double transformValue( double value, const GriddedVariogramSpec& spec ){
+        switch( spec.type ){
+            case GriddedVariogramType::INDICATOR_CONTINUOUS:
+                return value <= spec.cutoff ? 1.0 : 0.0;
+            case GriddedVariogramType::INDICATOR_CATEGORICAL:
+                return (int)std::round( value ) == (int)std::round( spec.cutoff ) ? 1.0 : 0.0;
+            default:
+                return value;
+        }
+    }
+
+    /** Returns the name of the variogram type used in the headers of the gam output. */
+    QString getTypeName( GriddedVariogramType type ){
+        switch( type ){
+            case GriddedVariogramType::SEMIVARIOGRAM: return "Semivariogram";
+            case GriddedVariogramType::CROSS_SEMIVARIOGRAM: return "Cross Semivariogram";
+            case GriddedVariogramType::COVARIANCE: return "Covariance";
+            case GriddedVariogramType::CORRELOGRAM: return "Correlogram";
+            case GriddedVariogramType::GENERAL_RELATIVE: return "General Relative";
+            case GriddedVariogramType::PAIRWISE_RELATIVE: return "Pairwise Relative";
+            case GriddedVariogramType::LOG_SEMIVARIOGRAM: return "Variogram of Logarithms";
+            case GriddedVariogramType::SEMIMADOGRAM: return "Semimadogram";
+            default: return "Indicator 1/2 Variogram";
+        }
+    }
+
+    const double EPSLON = 1.0E-20;
+}
+
+GriddedVariogramCalculator::GriddedVariogramCalculator(CartesianGrid *cg) :
+    m_cg( cg ),
+    m_nLags( 10 ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_standardizeSill( false )
+{
+}
+
+int GriddedVariogramCalculator::addVariable(Attribute *at, uint realization)
+{
+    Variable variable;
+    variable.attribute = at;
+    variable.realization = std::max( 1U, realization );
+    m_variables.push_back( variable );
+    return m_variables.size() - 1;
+}
+
+void GriddedVariogramCalculator::addDirection(int stepX, int stepY, int stepZ)
+{
+    Direction direction;
+    direction.stepX = stepX;
+    direction.stepY = stepY;
+    direction.stepZ = stepZ;
+    m_directions.push_back( direction );
+}
+
+void GriddedVariogramCalculator::setParametersFromGam(GSLibParameterFile *gpf_gam, bool useTrimmingLimits)
+{
+    //trimming limits
+    if( useTrimmingLimits ){
+        GSLibParMultiValuedFixed *par2 = gpf_gam->getParameter<GSLibParMultiValuedFixed*>(2);
+        setTrimmingLimits( par2->getParameter<GSLibParDouble*>(0)->_value,
+                           par2->getParameter<GSLibParDouble*>(1)->_value );
+    }
+
+    //number of directions and lags
+    GSLibParMultiValuedFixed *par6 = gpf_gam->getParameter<GSLibParMultiValuedFixed*>(6);
+    uint nDirections = par6->getParameter<GSLibParUInt*>(0)->_value;
+    setNumberOfLags( par6->getParameter<GSLibParUInt*>(1)->_value );
+
+    //directions as grid steps
+    GSLibParRepeat *par7 = gpf_gam->getParameter<GSLibParRepeat*>(7); //repeat ndir-times
+    for( uint iDir = 0; iDir < nDirections; ++iDir ){
+        GSLibParMultiValuedFixed *par7_0 = par7->getParameter<GSLibParMultiValuedFixed*>(iDir, 0);
+        addDirection( par7_0->getParameter<GSLibParInt*>(0)->_value,
+                      par7_0->getParameter<GSLibParInt*>(1)->_value,
+                      par7_0->getParameter<GSLibParInt*>(2)->_value );
+    }
+
+    //standardize sill?
+    setStandardizeSill( gpf_gam->getParameter<GSLibParOption*>(8)->_selected_value == 1 );
+
+    //the variograms (tail and head are the variable itself)
+    uint nVariograms = gpf_gam->getParameter<GSLibParUInt*>(9)->_value;
+    GSLibParRepeat *par10 = gpf_gam->getParameter<GSLibParRepeat*>(10); //repeat nvarios-times
+    for( uint iVarg = 0; iVarg < nVariograms; ++iVarg ){
+        GSLibParMultiValuedFixed *par10_0 = par10->getParameter<GSLibParMultiValuedFixed*>(iVarg, 0);
+        GriddedVariogramSpec spec;
+        spec.type = (GriddedVariogramType)par10_0->getParameter<GSLibParOption*>(2)->_selected_value;
+        spec.cutoff = par10_0->getParameter<GSLibParDouble*>(3)->_value;
+        addVariogram( spec );
+    }
+}
+
+void GriddedVariogramCalculator::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    long nx = m_cg->getNX();
+    long ny = m_cg->getNY();
+    long nz = m_cg->getNZ();
+    long nCells = nx * ny * nz;
+    int nVariables = m_variables.size();
+    int nVariograms = m_variograms.size();
+    int nDirections = m_directions.size();
+    int nLags = std::max( 0, m_nLags );
+
+    //the grid is read once, one realization at a time, and the values are read directly from the realization
+    //in memory (no copies are made)
+    bool hasNDV = m_cg->hasNoDataValue();
+    double NDV = m_cg->getNoDataValueAsDouble();
+    std::vector<uint> columns( nVariables );
+    std::vector<bool> available( nVariables, false );
+    uint nRealizations = 0;
+    for( int iVar = 0; iVar < nVariables; ++iVar ){
+        columns[iVar] = m_cg->getFieldGEOEASIndex( m_variables[iVar].attribute->getName() ) - 1;
+        nRealizations = std::max( nRealizations, m_variables[iVar].realization );
+    }
+    //returns the value of a variable in a cell of the realization in memory or NaN for no-data and trimmed values
+    auto valueOf = [&]( int iVar, long iCell ){
+        double value = m_cg->getDataLine( iCell )[ columns[iVar] ];
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            return std::nan("");
+        if( value < m_trimMin || value > m_trimMax )
+            return std::nan("");
+        return value;
+    };
+
+    //the sums of the (transformed) values of each variable and variogram, used to standardize the sill
+    std::vector<double> sumsOfValues( nVariables * nVariograms, 0.0 );
+    std::vector<double> sumsOfSquares( nVariables * nVariograms, 0.0 );
+    std::vector<long> counts( nVariables * nVariograms, 0 );
+
+    //a single parallel pass over the cells of each realization: each range of cells accumulates its own sums,
+    //which are then added up
+    long nSums = (long)nVariables * nVariograms * nDirections * nLags;
+    std::vector<LagSums> sums( nSums );
+    QMutex mutex;
+    m_cg->readDataPages( nCells, [&]( long iRealization ){
+        //the variables in this realization
+        std::vector<int> variables;
+        for( int iVar = 0; iVar < nVariables; ++iVar )
+            if( m_variables[iVar].realization == iRealization + 1 ){
+                variables.push_back( iVar );
+                available[iVar] = true;
+            }
+        if( variables.empty() )
+            return iRealization + 1 < nRealizations;
+
+        Util::parallelFor( nCells, [&]( long first, long last ){
+            std::vector<LagSums> localSums( nSums );
+            for( long index = first; index < last; ++index ){
+                long ix = index % nx;
+                long iy = ( index / nx ) % ny;
+                long iz = index / ( nx * ny );
+                for( int iVar : variables ){
+                    //the tail value is read once for all directions and lags
+                    double vrt = valueOf( iVar, index );
+                    if( std::isnan( vrt ) )
+                        continue;
+                    for( int iDir = 0; iDir < nDirections; ++iDir ){
+                        const Direction& direction = m_directions[iDir];
+                        for( int iLag = 0; iLag < nLags; ++iLag ){
+                            long ix1 = ix + direction.stepX * ( iLag + 1 );
+                            long iy1 = iy + direction.stepY * ( iLag + 1 );
+                            long iz1 = iz + direction.stepZ * ( iLag + 1 );
+                            if( ix1 < 0 || ix1 >= nx || iy1 < 0 || iy1 >= ny || iz1 < 0 || iz1 >= nz )
+                                continue;
+                            double vrh = valueOf( iVar, ix1 + iy1 * nx + iz1 * nx * ny );
+                            if( std::isnan( vrh ) )
+                                continue;
+                            for( int iVarg = 0; iVarg < nVariograms; ++iVarg ){
+                                const GriddedVariogramSpec& spec = m_variograms[iVarg];
+                                LagSums& s = localSums[ (long)getResultIndex( iVar, iVarg, iDir ) * nLags + iLag ];
+                                double t = transformValue( vrt, spec );
+                                double h = transformValue( vrh, spec );
+                                switch( spec.type ){
+                                    case GriddedVariogramType::PAIRWISE_RELATIVE:
+                                        if( std::abs( t + h ) < EPSLON )
+                                            continue;
+                                        s.gam += std::pow( ( t - h ) / ( ( t + h ) / 2.0 ), 2.0 );
+                                        break;
+                                    case GriddedVariogramType::LOG_SEMIVARIOGRAM:
+                                        if( t < EPSLON || h < EPSLON )
+                                            continue;
+                                        s.gam += std::pow( std::log( t ) - std::log( h ), 2.0 );
+                                        break;
+                                    case GriddedVariogramType::SEMIMADOGRAM:
+                                        s.gam += std::abs( h - t );
+                                        break;
+                                    case GriddedVariogramType::COVARIANCE:
+                                    case GriddedVariogramType::CORRELOGRAM:
+                                        s.gam += h * t;
+                                        s.hv += h * h;
+                                        s.tv += t * t;
+                                        break;
+                                    default:
+                                        s.gam += ( h - t ) * ( h - t );
+                                }
+                                ++s.np;
+                                s.hm += h;
+                                s.tm += t;
+                            }
+                        }
+                    }
+                }
+            }
+            QMutexLocker locker( &mutex );
+            for( long i = 0; i < nSums; ++i ){
+                sums[i].np += localSums[i].np;
+                sums[i].gam += localSums[i].gam;
+                sums[i].hm += localSums[i].hm;
+                sums[i].tm += localSums[i].tm;
+                sums[i].hv += localSums[i].hv;
+                sums[i].tv += localSums[i].tv;
+            }
+        });
+
+        //the variance of the (transformed) variables, while the realization is in memory
+        if( m_standardizeSill )
+            for( int iVar : variables )
+                for( int iVarg = 0; iVarg < nVariograms; ++iVarg ){
+                    int i = iVar * nVariograms + iVarg;
+                    for( long iCell = 0; iCell < nCells; ++iCell ){
+                        double value = valueOf( iVar, iCell );
+                        if( std::isnan( value ) )
+                            continue;
+                        double t = transformValue( value, m_variograms[iVarg] );
+                        sumsOfValues[i] += t;
+                        sumsOfSquares[i] += t * t;
+                        ++counts[i];
+                    }
+                }
+        return iRealization + 1 < nRealizations;
+    });
+
+    for( int iVar = 0; iVar < nVariables; ++iVar )
+        if( ! available[iVar] )
+            Application::instance()->logError( "GriddedVariogramCalculator::run(): realization " +
+                                               QString::number( m_variables[iVar].realization ) + " of " +
+                                               m_variables[iVar].attribute->getName() + " not found in the grid." );
+
+    //finish the statistics of each lag (see gam.for)
+    m_results.assign( nVariables * nVariograms * nDirections, std::vector<GriddedVariogramLag>( nLags ) );
+    for( int iVar = 0; iVar < nVariables; ++iVar ){
+        for( int iVarg = 0; iVarg < nVariograms; ++iVarg ){
+            const GriddedVariogramSpec& spec = m_variograms[iVarg];
+            //the variance of the (transformed) variable, used to standardize the sill
+            double variance = 1.0;
+            if( m_standardizeSill ){
+                long n = counts[ iVar * nVariograms + iVarg ];
+                double mean = n > 0 ? sumsOfValues[ iVar * nVariograms + iVarg ] / n : 0.0;
+                if( n > 0 )
+                    variance = sumsOfSquares[ iVar * nVariograms + iVarg ] / n - mean * mean;
+                if( variance <= 0.0 )
+                    variance = 1.0;
+            }
+            for( int iDir = 0; iDir < nDirections; ++iDir ){
+                const Direction& direction = m_directions[iDir];
+                double step = std::sqrt( std::pow( direction.stepX * m_cg->getDX(), 2 ) +
+                                         std::pow( direction.stepY * m_cg->getDY(), 2 ) +
+                                         std::pow( direction.stepZ * m_cg->getDZ(), 2 ) );
+                int iResult = getResultIndex( iVar, iVarg, iDir );
+                for( int iLag = 0; iLag < nLags; ++iLag ){
+                    const LagSums& s = sums[ (long)iResult * nLags + iLag ];
+                    GriddedVariogramLag& lag = m_results[iResult][iLag];
+                    lag.distance = ( iLag + 1 ) * step;
+                    lag.numberOfPairs = s.np;
+                    if( s.np == 0 )
+                        continue;
+                    double np = s.np;
+                    lag.headMean = s.hm / np;
+                    lag.tailMean = s.tm / np;
+                    switch( spec.type ){
+                        case GriddedVariogramType::COVARIANCE:
+                            lag.value = s.gam / np - lag.headMean * lag.tailMean;
+                            break;
+                        case GriddedVariogramType::CORRELOGRAM:
+                            {
+                                double hv = s.hv / np - lag.headMean * lag.headMean;
+                                double tv = s.tv / np - lag.tailMean * lag.tailMean;
+                                double cov = s.gam / np - lag.headMean * lag.tailMean;
+                                lag.value = ( hv > 0.0 && tv > 0.0 ) ? cov / std::sqrt( hv * tv ) : 0.0;
+                            }
+                            break;
+                        case GriddedVariogramType::GENERAL_RELATIVE:
+                            {
+                                double mean = ( lag.headMean + lag.tailMean ) / 2.0;
+                                lag.value = mean * mean > EPSLON ? 0.5 * s.gam / np / ( mean * mean ) : 0.0;
+                            }
+                            break;
+                        case GriddedVariogramType::SEMIVARIOGRAM:
+                        case GriddedVariogramType::CROSS_SEMIVARIOGRAM:
+                        case GriddedVariogramType::INDICATOR_CONTINUOUS:
+                        case GriddedVariogramType::INDICATOR_CATEGORICAL:
+                            lag.value = 0.5 * s.gam / np / variance;
+                            break;
+                        default:
+                            lag.value = 0.5 * s.gam / np;
+                    }
+                }
+            }
+        }
+    }
+
+    Application::instance()->logInfo( "GriddedVariogramCalculator::run(): " + QString::number( nVariables ) +
+                                      " variable(s) x " + QString::number( nVariograms ) + " variogram(s) x " +
+                                      QString::number( nDirections ) + " direction(s) computed in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+}
+
+const std::vector<GriddedVariogramLag> &GriddedVariogramCalculator::getLags(int variable, int variogram, int direction) const
+{
+    return m_results[ getResultIndex( variable, variogram, direction ) ];
+}
+
+std::vector<GriddedVariogramLag> GriddedVariogramCalculator::getEnsembleLags(GriddedVariogramEnsembleStatistic statistic,
+                                                                             int variogram, int direction) const
+{
+    std::vector<GriddedVariogramLag> result( std::max( 0, m_nLags ) );
+    std::vector<long> count( result.size(), 0 );
+    for( size_t iVar = 0; iVar < m_variables.size(); ++iVar ){
+        const std::vector<GriddedVariogramLag>& lags = getLags( iVar, variogram, direction );
+        for( size_t iLag = 0; iLag < lags.size(); ++iLag ){
+            const GriddedVariogramLag& lag = lags[iLag];
+            GriddedVariogramLag& summary = result[iLag];
+            summary.distance = lag.distance;
+            if( lag.numberOfPairs == 0 )
+                continue;
+            if( count[iLag] == 0 )
+                summary.value = lag.value;
+            else if( statistic == GriddedVariogramEnsembleStatistic::MEAN )
+                summary.value += lag.value;
+            else if( statistic == GriddedVariogramEnsembleStatistic::MIN )
+                summary.value = std::min( summary.value, lag.value );
+            else
+                summary.value = std::max( summary.value, lag.value );
+            summary.numberOfPairs += lag.numberOfPairs;
+            summary.headMean += lag.headMean;
+            summary.tailMean += lag.tailMean;
+            ++count[iLag];
+        }
+    }
+    for( size_t iLag = 0; iLag < result.size(); ++iLag ){
+        if( count[iLag] == 0 )
+            continue;
+        if( statistic == GriddedVariogramEnsembleStatistic::MEAN )
+            result[iLag].value /= count[iLag];
+        result[iLag].headMean /= count[iLag];
+        result[iLag].tailMean /= count[iLag];
+    }
+    return result;
+}
+
+bool GriddedVariogramCalculator::saveInGamFormat(int variable, const QString path) const
+{
+    QFile file( path );
+    if( ! file.open( QFile::WriteOnly | QFile::Text ) ){
+        Application::instance()->logError( "GriddedVariogramCalculator::saveInGamFormat(): could not write to " + path + "." );
+        return false;
+    }
+    QTextStream out( &file );
+    QString name = m_variables[variable].attribute->getName();
+    //the variograms are written in the same order as gam: for each variogram, each direction
+    for( size_t iVarg = 0; iVarg < m_variograms.size(); ++iVarg ){
+        for( size_t iDir = 0; iDir < m_directions.size(); ++iDir ){
+            out << getTypeName( m_variograms[iVarg].type ) << " tail:" << name << " head:" << name
+                << " direction " << ( iDir + 1 ) << '\n';
+            const std::vector<GriddedVariogramLag>& lags = getLags( variable, iVarg, iDir );
+            for( size_t iLag = 0; iLag < lags.size(); ++iLag ){
+                const GriddedVariogramLag& lag = lags[iLag];
+                char line[128];
+                std::snprintf( line, sizeof(line), " %3d %12.3f %12.5f %8ld %14.5f %14.5f\n", (int)iLag + 1,
+                               lag.distance, lag.value, lag.numberOfPairs, lag.headMean, lag.tailMean );
+                out << line;
+            }
+        }
+    }
+    file.close();
+    return true;
+}
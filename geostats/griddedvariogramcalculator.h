@@ -0,0 +1,132 @@
+#ifndef GRIDDEDVARIOGRAMCALCULATOR_H
+#define GRIDDEDVARIOGRAMCALCULATOR_H
+
+#include <vector>
+#include <QString>
+
+class CartesianGrid;
+class Attribute;
+class GSLibParameterFile;
+
+/*! The variogram types, with the same codes as those of the GSLib program gam. */
+enum class GriddedVariogramType : int {
+    SEMIVARIOGRAM = 1,             /*!< Traditional semivariogram. */
+    CROSS_SEMIVARIOGRAM = 2,       /*!< Traditional cross semivariogram (of a variable with itself here). */
+    COVARIANCE = 3,                /*!< Covariance. */
+    CORRELOGRAM = 4,               /*!< Correlogram. */
+    GENERAL_RELATIVE = 5,          /*!< General relative semivariogram. */
+    PAIRWISE_RELATIVE = 6,         /*!< Pairwise relative semivariogram. */
+    LOG_SEMIVARIOGRAM = 7,         /*!< Semivariogram of logarithms. */
+    SEMIMADOGRAM = 8,              /*!< Semimadogram. */
+    INDICATOR_CONTINUOUS = 9,      /*!< Indicator semivariogram for a threshold of a continuous variable. */
+    INDICATOR_CATEGORICAL = 10     /*!< Indicator semivariogram for a category code. */
+};
+
+/** A variogram to compute for each variable (see GriddedVariogramCalculator::addVariogram()). */
+struct GriddedVariogramSpec{
+    GriddedVariogramType type = GriddedVariogramType::SEMIVARIOGRAM;
+    /** The threshold or category code of indicator variograms. */
+    double cutoff = 0.0;
+};
+
+/** A lag of an experimental variogram, with the same information as the lines of gam output files. */
+struct GriddedVariogramLag{
+    double distance = 0.0;
+    double value = 0.0;
+    long numberOfPairs = 0;
+    double headMean = 0.0;
+    double tailMean = 0.0;
+};
+
+/*! The statistics of the variograms of all variables (e.g. realizations) computed lag by lag
+ * (see GriddedVariogramCalculator::getEnsembleLags()). */
+enum class GriddedVariogramEnsembleStatistic : int {
+    MEAN = 0, /*!< The average of the variograms. */
+    MIN,      /*!< The lower envelope of the variograms. */
+    MAX       /*!< The upper envelope of the variograms. */
+};
+
+/**
+ * The GriddedVariogramCalculator class computes experimental variograms of regularly gridded data in-process, like the
+ * GSLib program gam.  Any number of variables of the same grid (different attributes or realizations) are computed
+ * together: the grid is read once, one realization at a time, and a single parallel pass over the cells of each
+ * realization accumulates the pairs of all its variables, variograms, directions and lags, reading the values
+ * directly from the realization in memory, so the memory used does not grow with the number of realizations.
+ *
+ * Each variogram set with addVariogram() is computed for each variable added with addVariable() (tail and head are
+ * the variable itself).
+ */
+class GriddedVariogramCalculator
+{
+public:
+    GriddedVariogramCalculator( CartesianGrid* cg );
+
+    /** Adds a variable of the grid.
+     * @param realization The realization number (1 == first), for grids with multiple realizations.
+     * @return The index of the variable, to be used to get the results.
+     */
+    int addVariable( Attribute* at, uint realization = 1 );
+
+    /** Adds a direction given as grid steps (e.g. 1, 0, 0 for the X axis). */
+    void addDirection( int stepX, int stepY, int stepZ );
+
+    /** Adds a variogram to compute for every variable. */
+    void addVariogram( const GriddedVariogramSpec& spec ){ m_variograms.push_back( spec ); }
+
+    void setNumberOfLags( int value ){ m_nLags = value; }
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** If true, semivariograms are divided by the variance of the variable. Default is false. */
+    void setStandardizeSill( bool value ){ m_standardizeSill = value; }
+
+    /** Sets the directions, the number of lags, the sill standardization and the variograms from the parameters
+     *  of the gam program.
+     * @param useTrimmingLimits If true, the trimming limits of the parameters are also set.
+     */
+    void setParametersFromGam( GSLibParameterFile* gpf_gam, bool useTrimmingLimits );
+
+    /** Computes the variograms of all variables. */
+    void run();
+
+    /** Returns the lags of the variogram for a variable, variogram and direction (indexes in order of addition). */
+    const std::vector<GriddedVariogramLag>& getLags( int variable, int variogram, int direction ) const;
+
+    /** Returns a statistic of the variograms of all variables lag by lag for a variogram and direction.  This is useful
+     * to summarize the variograms of the realizations of a simulation (one variable per realization).  Lags without
+     * pairs in a variable are not considered for it.  The number of pairs returned is the total of all variables.
+     */
+    std::vector<GriddedVariogramLag> getEnsembleLags( GriddedVariogramEnsembleStatistic statistic,
+                                                      int variogram, int direction ) const;
+
+    /** Writes the variograms of a variable in the format of the output files of gam, so they can be plotted with vargplt. */
+    bool saveInGamFormat( int variable, const QString path ) const;
+
+private:
+    struct Variable{
+        Attribute* attribute;
+        uint realization;
+    };
+    struct Direction{
+        int stepX, stepY, stepZ;
+    };
+
+    CartesianGrid* m_cg;
+    std::vector<Variable> m_variables;
+    std::vector<Direction> m_directions;
+    std::vector<GriddedVariogramSpec> m_variograms;
+    int m_nLags;
+    double m_trimMin;
+    double m_trimMax;
+    bool m_standardizeSill;
+
+    /** The results indexed by getResultIndex(). */
+    std::vector< std::vector<GriddedVariogramLag> > m_results;
+
+    int getResultIndex( int variable, int variogram, int direction ) const {
+        return ( variable * m_variograms.size() + variogram ) * m_directions.size() + direction;
+    }
+};
+
+#endif // GRIDDEDVARIOGRAMCALCULATOR_H
@@ -0,0 +1,112 @@
+#include "gridpointsampler.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/cartesiangrid.h"
+#include "domain/pointset.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+GridPointSampler::GridPointSampler(CartesianGrid *grid, PointSet *pointSet) :
+    m_grid( grid ),
+    m_pointSet( pointSet ),
+    m_mode( GridSamplingMode::NEAREST ),
+    m_outsideCount( 0 )
+{
+}
+
+void GridPointSampler::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    m_grid->loadData();
+    m_pointSet->loadData();
+    long nPoints = m_pointSet->getDataLineCount();
+    int xColumn = m_pointSet->getXindex() - 1;
+    int yColumn = m_pointSet->getYindex() - 1;
+    int zColumn = m_pointSet->is3D() ? m_pointSet->getZindex() - 1 : -1;
+    long nx = m_grid->getNX(), ny = m_grid->getNY(), nz = m_grid->getNZ();
+    uint nVariables = m_grid->getDataColumnCount();
+    bool hasNDV = m_grid->hasNoDataValue();
+    double NDV = m_grid->getNoDataValueAsDouble();
+
+    //one column per grid variable
+    m_columns.clear();
+    m_columns.resize( nVariables );
+    for( uint iVar = 0; iVar < nVariables; ++iVar ){
+        m_columns[iVar].name = m_grid->getAttributeFromGEOEASIndex( iVar + 1 )->getName();
+        m_columns[iVar].values.assign( nPoints, std::nan("") );
+    }
+
+    //returns the grid value or NaN if it is a no-data value
+    auto gridValue = [&]( uint iVar, long i, long j, long k ){
+        double value = m_grid->data( i + j * nx + k * nx * ny, iVar );
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            return std::nan("");
+        return value;
+    };
+
+    std::vector<char> outside( nPoints, 0 );
+    Util::parallelFor( nPoints, [&]( long first, long last ){
+        for( long iPoint = first; iPoint < last; ++iPoint ){
+            double x = m_pointSet->data( iPoint, xColumn );
+            double y = m_pointSet->data( iPoint, yColumn );
+            double z = zColumn >= 0 ? m_pointSet->data( iPoint, zColumn ) : 0.0;
+            uint i, j, k;
+            if( ! m_grid->XYZtoIJK( x, y, z, i, j, k ) ){
+                outside[iPoint] = 1;
+                continue;
+            }
+            if( m_mode == GridSamplingMode::NEAREST ){
+                for( uint iVar = 0; iVar < nVariables; ++iVar )
+                    m_columns[iVar].values[iPoint] = gridValue( iVar, i, j, k );
+                continue;
+            }
+            //trilinear interpolation between the centers of the surrounding cells (clamped at the grid borders)
+            double fi, fj, fk;
+            m_grid->XYZtoFractionalIJK( x, y, z, fi, fj, fk );
+            long i0 = std::floor( fi ), j0 = std::floor( fj ), k0 = std::floor( fk );
+            double ti = fi - i0, tj = fj - j0, tk = fk - k0;
+            for( uint iVar = 0; iVar < nVariables; ++iVar ){
+                double sum = 0.0, sumOfWeights = 0.0;
+                for( int dk = 0; dk < 2; ++dk )
+                    for( int dj = 0; dj < 2; ++dj )
+                        for( int di = 0; di < 2; ++di ){
+                            double weight = ( di ? ti : 1.0 - ti ) * ( dj ? tj : 1.0 - tj ) * ( dk ? tk : 1.0 - tk );
+                            if( weight <= 0.0 )
+                                continue;
+                            long ci = std::max( 0L, std::min( nx - 1, i0 + di ) );
+                            long cj = std::max( 0L, std::min( ny - 1, j0 + dj ) );
+                            long ck = std::max( 0L, std::min( nz - 1, k0 + dk ) );
+                            double value = gridValue( iVar, ci, cj, ck );
+                            //no-data values do not take part in the interpolation
+                            if( std::isnan( value ) )
+                                continue;
+                            sum += weight * value;
+                            sumOfWeights += weight;
+                        }
+                if( sumOfWeights > 0.0 )
+                    m_columns[iVar].values[iPoint] = sum / sumOfWeights;
+            }
+        }
+    });
+
+    m_outsideCount = 0;
+    for( char isOutside : outside )
+        m_outsideCount += isOutside;
+
+    Application::instance()->logInfo( "GridPointSampler::run(): " + QString::number( nVariables ) + " grid variable(s) taken at " +
+                                      QString::number( nPoints ) + " points (" + QString::number( m_outsideCount ) +
+                                      " outside the grid) in " + QString::number( timer.elapsed() ) + "ms." );
+}
+
+void GridPointSampler::appendToPointSet()
+{
+    if( m_columns.empty() )
+        return;
+    m_pointSet->addGEOEASColumns( m_columns );
+}
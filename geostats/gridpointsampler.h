@@ -0,0 +1,47 @@
+#ifndef GRIDPOINTSAMPLER_H
+#define GRIDPOINTSAMPLER_H
+
+#include <vector>
+#include "domain/datafile.h"
+
+class CartesianGrid;
+class PointSet;
+
+/*! How GridPointSampler takes the grid values at the points. */
+enum class GridSamplingMode : unsigned {
+    NEAREST = 0, /*!< The value of the cell containing the point (like getpoints). */
+    TRILINEAR    /*!< Interpolated from the centers of the eight surrounding cells (four in 2D grids). */
+};
+
+/**
+ * The GridPointSampler class transfers the values of all the variables of a Cartesian grid to the locations of
+ * a point set, like the GSLib program getpoints, but in-process: each point is mapped to the grid cells with
+ * CartesianGrid::XYZtoIJK() (which handles rotated grids) and the points are processed in parallel.  The values
+ * are then appended to the point set file with a single rewrite.
+ */
+class GridPointSampler
+{
+public:
+    GridPointSampler( CartesianGrid* grid, PointSet* pointSet );
+
+    void setMode( GridSamplingMode mode ){ m_mode = mode; }
+
+    /** Takes the grid values at the points.  Points outside the grid and cells with no-data values yield
+     *  std::nan("") (see NewGEOEASColumn).  Only the first realization of the grid is used. */
+    void run();
+
+    /** Appends the values computed by run() to the point set (one column per grid variable). */
+    void appendToPointSet();
+
+    /** The number of points outside the grid in the last run(). */
+    long getOutsideCount() const { return m_outsideCount; }
+
+private:
+    CartesianGrid* m_grid;
+    PointSet* m_pointSet;
+    GridSamplingMode m_mode;
+    std::vector<NewGEOEASColumn> m_columns;
+    long m_outsideCount;
+};
+
+#endif // GRIDPOINTSAMPLER_H
@@ -0,0 +1,270 @@
+#include "indicatorkriging.h"
+
+#include "domain/application.h"
+#include "domain/pointset.h"
+#include "geostats/geostatsutils.h"
+#include "geostats/neighborhoodsearch.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+IndicatorKriging::IndicatorKriging(PointSet *pointSet, uint variableGEOEASIndex) :
+    m_pointSet( pointSet ),
+    m_variableGEOEASIndex( variableGEOEASIndex ),
+    m_nx( 0 ), m_ny( 0 ), m_nz( 0 ),
+    m_x0( 0.0 ), m_y0( 0.0 ), m_z0( 0.0 ),
+    m_dx( 1.0 ), m_dy( 1.0 ), m_dz( 1.0 ),
+    m_categorical( false ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_ndMin( 1 ),
+    m_ndMax( 12 ),
+    m_maxPerOctant( 0 ),
+    m_ordinaryKriging( false ),
+    m_estimatedCount( 0 ),
+    m_correctedCount( 0 )
+{
+    setSearchEllipsoid( 1.0, 1.0, 1.0, 0.0, 0.0, 0.0 );
+}
+
+void IndicatorKriging::setGridGeometry(uint nx, uint ny, uint nz, double x0, double y0, double z0,
+                                       double dx, double dy, double dz)
+{
+    m_nx = nx; m_ny = ny; m_nz = nz;
+    m_x0 = x0; m_y0 = y0; m_z0 = z0;
+    m_dx = dx; m_dy = dy; m_dz = dz;
+}
+
+void IndicatorKriging::setThresholds(const std::vector<double> &thresholds, const std::vector<double> &globalProbabilities)
+{
+    m_thresholds = thresholds;
+    m_globalProbabilities = globalProbabilities;
+}
+
+void IndicatorKriging::setSearchEllipsoid(double hMax, double hMin, double vert, double azimuth, double dip, double roll)
+{
+    m_search[0] = hMax; m_search[1] = hMin; m_search[2] = vert;
+    m_search[3] = azimuth; m_search[4] = dip; m_search[5] = roll;
+}
+
+bool IndicatorKriging::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int nThresholds = m_thresholds.size();
+    m_probabilities.clear();
+    m_estimatedCount = 0;
+    m_correctedCount = 0;
+    if( nThresholds == 0 || (int)m_globalProbabilities.size() != nThresholds || (int)m_models.size() != nThresholds ){
+        Application::instance()->logError( "IndicatorKriging::run(): the numbers of thresholds, global probabilities "
+                                           "and covariance models differ." );
+        return false;
+    }
+    if( m_search[0] <= 0.0 || m_search[1] <= 0.0 || m_search[2] <= 0.0 ){
+        Application::instance()->logError( "IndicatorKriging::run(): the search radii must be positive." );
+        return false;
+    }
+
+    //gather the valid data and code them as indicators
+    m_pointSet->loadData();
+    long nLines = m_pointSet->getDataLineCount();
+    uint column = m_variableGEOEASIndex - 1;
+    int xColumn = m_pointSet->getXindex() - 1;
+    int yColumn = m_pointSet->getYindex() - 1;
+    int zColumn = m_pointSet->is3D() ? m_pointSet->getZindex() - 1 : -1;
+    bool hasNDV = m_pointSet->hasNoDataValue();
+    double NDV = m_pointSet->getNoDataValueAsDouble();
+    m_x.clear(); m_y.clear(); m_z.clear();
+    m_indicators.clear();
+    for( long iLine = 0; iLine < nLines; ++iLine ){
+        double value = m_pointSet->data( iLine, column );
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            continue;
+        if( value < m_trimMin || value > m_trimMax )
+            continue;
+        double x = m_pointSet->data( iLine, xColumn );
+        double y = m_pointSet->data( iLine, yColumn );
+        double z = zColumn >= 0 ? m_pointSet->data( iLine, zColumn ) : 0.0;
+        m_x.push_back( x ); m_y.push_back( y ); m_z.push_back( z );
+        for( int k = 0; k < nThresholds; ++k ){
+            bool indicator;
+            if( m_categorical ) //category codes are compared as integers (see ik3d.for)
+                indicator = std::lround( value ) == std::lround( m_thresholds[k] );
+            else
+                indicator = value <= m_thresholds[k];
+            m_indicators.push_back( indicator ? 1.0 : 0.0 );
+        }
+    }
+    long nData = m_x.size();
+    if( nData == 0 ){
+        Application::instance()->logWarn( "IndicatorKriging::run(): no valid data." );
+        return false;
+    }
+
+    //index the data for the neighborhood searches
+    NeighborhoodSearch search( m_search[0], m_search[1], m_search[2], m_search[3], m_search[4], m_search[5] );
+    search.build( m_x, m_y, m_z );
+
+    //thresholds with the same covariance model share the kriging weights
+    std::vector< std::vector<int> > groups;
+    for( int k = 0; k < nThresholds; ++k ){
+        bool grouped = false;
+        for( std::vector<int>& group : groups )
+            if( m_models[ group.front() ].isSameAs( m_models[k] ) ){
+                group.push_back( k );
+                grouped = true;
+                break;
+            }
+        if( ! grouped )
+            groups.push_back( std::vector<int>( 1, k ) );
+    }
+    bool threadSafe = true;
+    for( const CovarianceModel& model : m_models )
+        threadSafe = threadSafe && model.isThreadSafe();
+
+    //the grid geometry (like ik3d, the grid is not rotated)
+    long nx = m_nx, ny = m_ny, nz = m_nz;
+    double x0 = m_x0, y0 = m_y0, z0 = m_z0;
+    double dx = m_dx, dy = m_dy, dz = m_dz;
+    long nNodes = nx * ny * nz;
+    m_probabilities.assign( nNodes * nThresholds, std::nan("") );
+    std::vector<char> estimated( nNodes, 0 ), corrected( nNodes, 0 );
+    std::vector<char> singular( nNodes, 0 );
+
+    auto body = [&]( long first, long last ){
+        //per-thread work buffers
+        std::vector< std::pair<double, long> > candidates;
+        std::vector<long> selected;
+        std::vector<double> pdx, pdy, pdz, ndx, ndy, ndz;
+        std::vector<double> a, b;
+        for( long node = first; node < last; ++node ){
+            long ix = node % nx;
+            long iy = ( node / nx ) % ny;
+            long iz = node / ( nx * ny );
+            double x = x0 + ix * dx, y = y0 + iy * dy, z = z0 + iz * dz;
+
+            //the single neighborhood search of this node, shared by all thresholds
+            //the octant filter may discard candidates, so it needs all of them rather than the ndMax nearest
+            search.find( x, y, z, m_maxPerOctant > 0 ? -1 : m_ndMax, candidates );
+            selected.clear();
+            int perOctant[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+            for( const std::pair<double, long>& candidate : candidates ){
+                if( (int)selected.size() >= m_ndMax )
+                    break;
+                long iData = candidate.second;
+                if( m_maxPerOctant > 0 ){
+                    int octant = ( m_x[iData] > x ? 1 : 0 ) + ( m_y[iData] > y ? 2 : 0 ) + ( m_z[iData] > z ? 4 : 0 );
+                    if( perOctant[octant] >= m_maxPerOctant )
+                        continue;
+                    ++perOctant[octant];
+                }
+                selected.push_back( iData );
+            }
+            int n = selected.size();
+            if( n < m_ndMin || n == 0 )
+                continue;
+
+            //the data-to-data and data-to-node separations, shared by all thresholds
+            pdx.resize( n * n ); pdy.resize( n * n ); pdz.resize( n * n );
+            ndx.resize( n ); ndy.resize( n ); ndz.resize( n );
+            for( int i = 0; i < n; ++i ){
+                long iData = selected[i];
+                for( int j = i; j < n; ++j ){
+                    long jData = selected[j];
+                    pdx[i * n + j] = m_x[jData] - m_x[iData];
+                    pdy[i * n + j] = m_y[jData] - m_y[iData];
+                    pdz[i * n + j] = m_z[jData] - m_z[iData];
+                }
+                ndx[i] = x - m_x[iData];
+                ndy[i] = y - m_y[iData];
+                ndz[i] = z - m_z[iData];
+            }
+
+            //solve one system per covariance model and estimate its thresholds
+            double* ccdf = &m_probabilities[ node * nThresholds ];
+            int neq = m_ordinaryKriging ? n + 1 : n;
+            for( const std::vector<int>& group : groups ){
+                const CovarianceModel& model = m_models[ group.front() ];
+                a.assign( neq * neq, 0.0 );
+                b.assign( neq, 0.0 );
+                for( int i = 0; i < n; ++i ){
+                    for( int j = i; j < n; ++j ){
+                        double cov = model.getCovariance( pdx[i * n + j], pdy[i * n + j], pdz[i * n + j] );
+                        a[i * neq + j] = cov;
+                        a[j * neq + i] = cov;
+                    }
+                    b[i] = model.getCovariance( ndx[i], ndy[i], ndz[i] );
+                }
+                if( m_ordinaryKriging ){
+                    for( int i = 0; i < n; ++i ){
+                        a[i * neq + n] = 1.0;
+                        a[n * neq + i] = 1.0;
+                    }
+                    b[n] = 1.0;
+                }
+                bool solved = GeostatsUtils::solveLinearSystem( a, b, neq );
+                if( ! solved )
+                    singular[node] = 1;
+                double sumOfWeights = 0.0;
+                if( solved )
+                    for( int i = 0; i < n; ++i )
+                        sumOfWeights += b[i];
+                for( int k : group ){
+                    //a singular system yields the global probability
+                    double estimate = 0.0;
+                    if( solved )
+                        for( int i = 0; i < n; ++i )
+                            estimate += b[i] * m_indicators[ selected[i] * nThresholds + k ];
+                    if( ! m_ordinaryKriging || ! solved )
+                        estimate += ( 1.0 - sumOfWeights ) * m_globalProbabilities[k];
+                    ccdf[k] = estimate;
+                }
+            }
+            estimated[node] = 1;
+            corrected[node] = GeostatsUtils::correctOrderRelations( ccdf, nThresholds, m_categorical ) ? 1 : 0;
+        }
+    };
+    if( threadSafe )
+        Util::parallelFor( nNodes, body );
+    else
+        body( 0, nNodes );
+
+    long nSingular = 0;
+    for( long node = 0; node < nNodes; ++node ){
+        m_estimatedCount += estimated[node];
+        m_correctedCount += corrected[node];
+        nSingular += singular[node];
+    }
+    if( nSingular > 0 )
+        Application::instance()->logWarn( "IndicatorKriging::run(): singular kriging systems in " + QString::number( nSingular ) +
+                                          " node(s).  The global probabilities were used instead." );
+    Application::instance()->logInfo( "IndicatorKriging::run(): " + QString::number( m_estimatedCount ) + " of " +
+                                      QString::number( nNodes ) + " nodes estimated for " + QString::number( nThresholds ) +
+                                      " thresholds (" + QString::number( groups.size() ) + " distinct covariance model(s)) with " +
+                                      QString::number( nData ) + " data in " + QString::number( timer.elapsed() ) + "ms.  " +
+                                      QString::number( m_correctedCount ) + " node(s) had order relation corrections." );
+    return true;
+}
+
+void IndicatorKriging::saveInGEOEASFormat(const QString &path, double noDataValue) const
+{
+    int nThresholds = m_thresholds.size();
+    std::vector<QString> names;
+    for( int k = 0; k < nThresholds; ++k )
+        if( m_categorical )
+            names.push_back( "Probability of category " + QString::number( m_thresholds[k] ) );
+        else
+            names.push_back( "Probability of <= " + QString::number( m_thresholds[k] ) );
+    long nNodes = nThresholds > 0 ? m_probabilities.size() / nThresholds : 0;
+    std::vector< std::vector<double> > array( nNodes, std::vector<double>( nThresholds ) );
+    for( long node = 0; node < nNodes; ++node )
+        for( int k = 0; k < nThresholds; ++k ){
+            double value = m_probabilities[ node * nThresholds + k ];
+            array[node][k] = std::isnan( value ) ? noDataValue : value;
+        }
+    Util::createGEOEASGridFile( "Indicator kriging estimates", names, array, path );
+}
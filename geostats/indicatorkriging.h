@@ -0,0 +1,99 @@
+#ifndef INDICATORKRIGING_H
+#define INDICATORKRIGING_H
+
+#include <vector>
+#include <QString>
+#include "covariancemodel.h"
+
+class PointSet;
+
+/**
+ * The IndicatorKriging class performs indicator kriging in-process with the same algorithm of the GSLib program
+ * ik3d (without soft indicators): for each grid node, the probabilities of the variable being below each
+ * threshold (continuous variables) or of each category (categorical variables) are estimated by simple or
+ * ordinary kriging of the indicator-coded data.  The estimates are then corrected for order relation deviations.
+ *
+ * The neighborhood search, the data-to-data and the data-to-node separations do not depend on the threshold, so
+ * they are computed once per node and shared by all thresholds.  Thresholds with identical covariance models
+ * (e.g. all of them in median IK) share the same kriging weights, so their system is solved only once.  The nodes
+ * are estimated in parallel.
+ */
+class IndicatorKriging
+{
+public:
+    /** @param variableGEOEASIndex The GEO-EAS index (first is 1) of the variable in the point set. */
+    IndicatorKriging( PointSet* pointSet, uint variableGEOEASIndex );
+
+    /** Sets the geometry of the estimation grid like in the GSLib parameter files (x0, y0, z0 are the
+     *  coordinates of the first cell center).  The grid is not rotated, like in ik3d. */
+    void setGridGeometry( uint nx, uint ny, uint nz, double x0, double y0, double z0, double dx, double dy, double dz );
+
+    /** Sets whether the variable holds category codes.  Default is false (continuous variable). */
+    void setCategorical( bool value ){ m_categorical = value; }
+
+    /** Sets the thresholds (or category codes) and their global c.d.f. (or p.d.f.) values, which are the means
+     *  of simple kriging. */
+    void setThresholds( const std::vector<double>& thresholds, const std::vector<double>& globalProbabilities );
+
+    /** Sets the indicator covariance models, one per threshold. */
+    void setCovarianceModels( const std::vector<CovarianceModel>& models ){ m_models = models; }
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** Sets the minimum and maximum number of data used to estimate a node.  Nodes with fewer data than the
+     *  minimum are not estimated. */
+    void setNumberOfData( int min, int max ){ m_ndMin = min; m_ndMax = max; }
+
+    /** Sets the search ellipsoid.  The parameters have the same meaning as in the ik3d parameter files. */
+    void setSearchEllipsoid( double hMax, double hMin, double vert, double azimuth, double dip, double roll );
+
+    /** Sets the maximum number of data per octant.  Zero (default) means no octant search. */
+    void setMaxDataPerOctant( int value ){ m_maxPerOctant = value; }
+
+    /** Sets whether ordinary kriging (true) or simple kriging (false, default) is used. */
+    void setOrdinaryKriging( bool value ){ m_ordinaryKriging = value; }
+
+    /** Performs the estimation.  Returns false if the parameters are inconsistent or there are no valid data. */
+    bool run();
+
+    /** The estimated probabilities, one per threshold for each node (in GEO-EAS order).  The probabilities of
+     *  the nodes that were not estimated are std::nan(""). */
+    const std::vector<double>& getProbabilities() const { return m_probabilities; }
+
+    long getEstimatedNodeCount() const { return m_estimatedCount; }
+    /** The number of nodes whose probabilities were changed by the order relation corrections. */
+    long getCorrectedNodeCount() const { return m_correctedCount; }
+
+    /** Saves the estimates as a GEO-EAS grid file like that of ik3d (one column per threshold). */
+    void saveInGEOEASFormat( const QString& path, double noDataValue = -9.9999 ) const;
+
+private:
+    PointSet* m_pointSet;
+    uint m_variableGEOEASIndex;
+    uint m_nx, m_ny, m_nz;
+    double m_x0, m_y0, m_z0;
+    double m_dx, m_dy, m_dz;
+    bool m_categorical;
+    std::vector<double> m_thresholds;
+    std::vector<double> m_globalProbabilities;
+    std::vector<CovarianceModel> m_models;
+    double m_trimMin;
+    double m_trimMax;
+    int m_ndMin;
+    int m_ndMax;
+    //hMax, hMin, vert, azimuth, dip and roll of the search ellipsoid
+    double m_search[6];
+    int m_maxPerOctant;
+    bool m_ordinaryKriging;
+
+    //the valid data and their indicators (nThresholds per datum)
+    std::vector<double> m_x, m_y, m_z;
+    std::vector<double> m_indicators;
+
+    std::vector<double> m_probabilities;
+    long m_estimatedCount;
+    long m_correctedCount;
+};
+
+#endif // INDICATORKRIGING_H
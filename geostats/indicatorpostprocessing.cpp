@@ -0,0 +1,487 @@
+#include "indicatorpostprocessing.h"
+
+#include "domain/application.h"
+#include "domain/cartesiangrid.h"
+#include "domain/datafile.h"
+#include "geostats/geostatsutils.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+IndicatorPostProcessing::IndicatorPostProcessing(CartesianGrid *ikGrid) :
+    m_grid( ikGrid ),
+    m_output( IKPostProcessingOutput::ETYPE ),
+    m_outputParameter( 0.0 ),
+    m_zMin( 0.0 ),
+    m_zMax( 1.0 ),
+    m_lowerTail( CDFInterpolationModel::LINEAR ),
+    m_lowerTailParameter( 1.0 ),
+    m_middle( CDFInterpolationModel::LINEAR ),
+    m_middleParameter( 1.0 ),
+    m_upperTail( CDFInterpolationModel::LINEAR ),
+    m_upperTailParameter( 1.0 ),
+    m_supportCorrection( SupportCorrection::NONE ),
+    m_varianceReduction( 1.0 ),
+    m_maxDiscretization( 50 ),
+    m_processedCount( 0 )
+{
+}
+
+void IndicatorPostProcessing::setGlobalDistribution(DataFile *dataFile, uint variableGEOEASIndex, uint weightGEOEASIndex,
+                                                    double trimMin, double trimMax)
+{
+    m_globalValues.clear();
+    m_globalCDF.clear();
+    if( ! dataFile || variableGEOEASIndex == 0 )
+        return;
+    dataFile->loadData();
+    bool hasNDV = dataFile->hasNoDataValue();
+    double NDV = dataFile->getNoDataValueAsDouble();
+    std::vector< std::pair<double, double> > valuesAndWeights;
+    for( uint iLine = 0; iLine < dataFile->getDataLineCount(); ++iLine ){
+        double value = dataFile->data( iLine, variableGEOEASIndex - 1 );
+        double weight = weightGEOEASIndex > 0 ? dataFile->data( iLine, weightGEOEASIndex - 1 ) : 1.0;
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            continue;
+        if( value < trimMin || value >= trimMax || weight <= 0.0 )
+            continue;
+        valuesAndWeights.push_back( { value, weight } );
+    }
+    std::sort( valuesAndWeights.begin(), valuesAndWeights.end() );
+
+    //the cumulative probability of each value is taken at the middle of its weight
+    double totalWeight = 0.0;
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights )
+        totalWeight += valueAndWeight.second;
+    double cumulativeWeight = 0.0;
+    for( const std::pair<double, double>& valueAndWeight : valuesAndWeights ){
+        m_globalValues.push_back( valueAndWeight.first );
+        m_globalCDF.push_back( ( cumulativeWeight + 0.5 * valueAndWeight.second ) / totalWeight );
+        cumulativeWeight += valueAndWeight.second;
+    }
+}
+
+bool IndicatorPostProcessing::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int nThresholds = m_thresholds.size();
+    if( nThresholds == 0 ){
+        Application::instance()->logError( "IndicatorPostProcessing::run(): no thresholds were set." );
+        return false;
+    }
+    m_grid->loadData();
+    if( m_grid->getDataColumnCount() < (uint)nThresholds ){
+        Application::instance()->logError( "IndicatorPostProcessing::run(): the grid has fewer columns than the "
+                                           "number of thresholds (" + QString::number( nThresholds ) + ")." );
+        return false;
+    }
+    if( m_zMin > m_thresholds.front() || m_zMax < m_thresholds.back() ){
+        Application::instance()->logError( "IndicatorPostProcessing::run(): the minimum and maximum values must "
+                                           "bound the thresholds." );
+        return false;
+    }
+    if( ( m_lowerTail == CDFInterpolationModel::TABULATED || m_middle == CDFInterpolationModel::TABULATED ||
+          m_upperTail == CDFInterpolationModel::TABULATED ) && m_globalValues.empty() ){
+        Application::instance()->logError( "IndicatorPostProcessing::run(): interpolation with quantiles from data "
+                                           "requires a global distribution with valid data." );
+        return false;
+    }
+    if( m_output == IKPostProcessingOutput::QUANTILE && ( m_outputParameter <= 0.0 || m_outputParameter >= 1.0 ) ){
+        Application::instance()->logError( "IndicatorPostProcessing::run(): the cumulative probability of the quantile "
+                                           "must be between 0.0 and 1.0." );
+        return false;
+    }
+
+    long nCells = m_grid->getDataLineCount();
+    int nDiscretization = std::max( 1, m_maxDiscretization );
+    bool hasNDV = m_grid->hasNoDataValue();
+    double NDV = m_grid->getNoDataValueAsDouble();
+    int nOutputs = m_output == IKPostProcessingOutput::PROBABILITY_AND_MEANS ? 3 : 1;
+    m_outputs.assign( nOutputs, std::vector<double>( nCells, std::nan("") ) );
+
+    //without support correction, a quantile or the probability and means about a cutoff are computed
+    //directly from the c.d.f. values
+    bool discretize = ( m_output != IKPostProcessingOutput::QUANTILE &&
+                        m_output != IKPostProcessingOutput::PROBABILITY_AND_MEANS ) ||
+                      m_supportCorrection != SupportCorrection::NONE;
+
+    std::vector<char> processed( nCells, 0 );
+    Util::parallelFor( nCells, [&]( long first, long last ){
+        std::vector<double> ccdf( nThresholds );
+        std::vector<double> quantiles( nDiscretization );
+        for( long cell = first; cell < last; ++cell ){
+            //cells that were not estimated are skipped
+            bool valid = true;
+            for( int k = 0; k < nThresholds && valid; ++k ){
+                ccdf[k] = m_grid->data( cell, k );
+                if( std::isnan( ccdf[k] ) || ( hasNDV && Util::almostEqual2sComplement( NDV, ccdf[k], 1 ) ) )
+                    valid = false;
+            }
+            if( ! valid )
+                continue;
+            GeostatsUtils::correctOrderRelations( ccdf.data(), nThresholds, false );
+            processed[cell] = 1;
+
+            if( ! discretize ){
+                if( m_output == IKPostProcessingOutput::QUANTILE )
+                    m_outputs[0][cell] = getQuantile( ccdf.data(), m_outputParameter );
+                else {
+                    //the class means are the partial expectations divided by the class probabilities
+                    double p = getCDF( ccdf.data(), m_outputParameter );
+                    m_outputs[0][cell] = 1.0 - p;
+                    if( p < 1.0 )
+                        m_outputs[1][cell] = integrateQuantiles( ccdf.data(), p, 1.0 ) / ( 1.0 - p );
+                    if( p > 0.0 )
+                        m_outputs[2][cell] = integrateQuantiles( ccdf.data(), 0.0, p ) / p;
+                }
+                continue;
+            }
+
+            //discretize the local distribution into equally probable classes
+            double mean = 0.0;
+            for( int l = 0; l < nDiscretization; ++l ){
+                quantiles[l] = getQuantile( ccdf.data(), ( l + 0.5 ) / nDiscretization );
+                mean += quantiles[l];
+            }
+            mean /= nDiscretization;
+            double variance = 0.0;
+            for( int l = 0; l < nDiscretization; ++l )
+                variance += ( quantiles[l] - mean ) * ( quantiles[l] - mean );
+            variance /= nDiscretization;
+            if( m_supportCorrection != SupportCorrection::NONE ){
+                correctSupport( quantiles, mean, variance );
+                variance = 0.0;
+                for( int l = 0; l < nDiscretization; ++l )
+                    variance += ( quantiles[l] - mean ) * ( quantiles[l] - mean );
+                variance /= nDiscretization;
+            }
+
+            switch( m_output ){
+            case IKPostProcessingOutput::ETYPE:
+                m_outputs[0][cell] = mean;
+                break;
+            case IKPostProcessingOutput::VARIANCE:
+                m_outputs[0][cell] = variance;
+                break;
+            case IKPostProcessingOutput::QUANTILE:
+            {
+                //interpolate between the corrected quantiles
+                double t = m_outputParameter * nDiscretization - 0.5;
+                if( t <= 0.0 )
+                    m_outputs[0][cell] = quantiles.front();
+                else if( t >= nDiscretization - 1 )
+                    m_outputs[0][cell] = quantiles.back();
+                else {
+                    int l = t;
+                    m_outputs[0][cell] = quantiles[l] + ( t - l ) * ( quantiles[l+1] - quantiles[l] );
+                }
+                break;
+            }
+            case IKPostProcessingOutput::PROBABILITY_AND_MEANS:
+            {
+                double cutoff = m_outputParameter;
+                //the cumulative probability of the cutoff is interpolated between the quantiles
+                double p;
+                if( cutoff < quantiles.front() ){
+                    double lower = std::min( m_zMin, quantiles.front() );
+                    p = cutoff <= lower ? 0.0 : 0.5 / nDiscretization * ( cutoff - lower ) / ( quantiles.front() - lower );
+                } else if( cutoff >= quantiles.back() ){
+                    double upper = std::max( m_zMax, quantiles.back() );
+                    p = cutoff >= upper ? 1.0 : 1.0 - 0.5 / nDiscretization * ( upper - cutoff ) / ( upper - quantiles.back() );
+                } else {
+                    int l = std::upper_bound( quantiles.begin(), quantiles.end(), cutoff ) - quantiles.begin() - 1;
+                    p = ( l + 0.5 + ( cutoff - quantiles[l] ) / ( quantiles[l+1] - quantiles[l] ) ) / nDiscretization;
+                }
+                double sumAbove = 0.0, sumBelow = 0.0;
+                int nAbove = 0, nBelow = 0;
+                for( double quantile : quantiles )
+                    if( quantile > cutoff ){
+                        sumAbove += quantile;
+                        ++nAbove;
+                    } else {
+                        sumBelow += quantile;
+                        ++nBelow;
+                    }
+                m_outputs[0][cell] = 1.0 - p;
+                if( nAbove > 0 )
+                    m_outputs[1][cell] = sumAbove / nAbove;
+                if( nBelow > 0 )
+                    m_outputs[2][cell] = sumBelow / nBelow;
+                break;
+            }
+            }
+        }
+    });
+
+    m_processedCount = 0;
+    for( char isProcessed : processed )
+        m_processedCount += isProcessed;
+
+    Application::instance()->logInfo( "IndicatorPostProcessing::run(): " + QString::number( m_processedCount ) + " of " +
+                                      QString::number( nCells ) + " cells post-processed in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+    return true;
+}
+
+std::vector<QString> IndicatorPostProcessing::getOutputNames() const
+{
+    switch( m_output ){
+    case IKPostProcessingOutput::ETYPE:
+        return { "E-type" };
+    case IKPostProcessingOutput::VARIANCE:
+        return { "Conditional variance" };
+    case IKPostProcessingOutput::QUANTILE:
+        return { "P" + QString::number( m_outputParameter * 100 ) };
+    case IKPostProcessingOutput::PROBABILITY_AND_MEANS:
+        return { "Prob > " + QString::number( m_outputParameter ),
+                 "Mean > " + QString::number( m_outputParameter ),
+                 "Mean <= " + QString::number( m_outputParameter ) };
+    }
+    return {};
+}
+
+void IndicatorPostProcessing::saveInGEOEASFormat(const QString &path, double noDataValue) const
+{
+    int nOutputs = m_outputs.size();
+    long nCells = nOutputs > 0 ? m_outputs[0].size() : 0;
+    std::vector< std::vector<double> > array( nCells, std::vector<double>( nOutputs ) );
+    for( long cell = 0; cell < nCells; ++cell )
+        for( int iOutput = 0; iOutput < nOutputs; ++iOutput ){
+            double value = m_outputs[iOutput][cell];
+            array[cell][iOutput] = std::isnan( value ) ? noDataValue : value;
+        }
+    Util::createGEOEASGridFile( "Indicator kriging post-processing", getOutputNames(), array, path );
+}
+
+void IndicatorPostProcessing::appendToGrid(const QString &name)
+{
+    std::vector<QString> names = getOutputNames();
+    std::vector<NewGEOEASColumn> columns( m_outputs.size() );
+    for( size_t iOutput = 0; iOutput < m_outputs.size(); ++iOutput ){
+        columns[iOutput].values = m_outputs[iOutput];
+        columns[iOutput].name = m_outputs.size() == 1 ? name : name + " " + names[iOutput];
+    }
+    if( ! columns.empty() )
+        m_grid->addGEOEASColumns( columns );
+}
+
+double IndicatorPostProcessing::getQuantile(const double *ccdf, double p) const
+{
+    int nThresholds = m_thresholds.size();
+
+    //lower tail
+    if( p <= ccdf[0] )
+        return interpolate( m_lowerTail, m_lowerTailParameter, m_zMin, m_thresholds[0], 0.0, ccdf[0], p );
+
+    //upper tail
+    double zLast = m_thresholds[nThresholds-1];
+    double pLast = ccdf[nThresholds-1];
+    if( p > pLast ){
+        //hyperbolic model: 1 - F(z) = lambda / z^omega, with lambda such that F(zLast) = pLast
+        if( m_upperTail == CDFInterpolationModel::HYPERBOLIC && zLast > 0.0 && m_upperTailParameter > 0.0 ){
+            if( p >= 1.0 )
+                return m_zMax;
+            double z = zLast * std::pow( ( 1.0 - pLast ) / ( 1.0 - p ), 1.0 / m_upperTailParameter );
+            return std::min( z, m_zMax );
+        }
+        return interpolate( m_upperTail, m_upperTailParameter, zLast, m_zMax, pLast, 1.0, p );
+    }
+
+    //middle classes
+    for( int k = 1; k < nThresholds; ++k )
+        if( p <= ccdf[k] )
+            return interpolate( m_middle, m_middleParameter, m_thresholds[k-1], m_thresholds[k], ccdf[k-1], ccdf[k], p );
+    return zLast;
+}
+
+double IndicatorPostProcessing::getCDF(const double *ccdf, double z) const
+{
+    int nThresholds = m_thresholds.size();
+
+    //lower tail
+    if( z <= m_thresholds[0] )
+        return interpolateCDF( m_lowerTail, m_lowerTailParameter, m_zMin, m_thresholds[0], 0.0, ccdf[0], z );
+
+    //upper tail
+    double zLast = m_thresholds[nThresholds-1];
+    double pLast = ccdf[nThresholds-1];
+    if( z > zLast ){
+        //hyperbolic model: 1 - F(z) = lambda / z^omega, with lambda such that F(zLast) = pLast
+        if( m_upperTail == CDFInterpolationModel::HYPERBOLIC && zLast > 0.0 && m_upperTailParameter > 0.0 ){
+            if( z >= m_zMax )
+                return 1.0;
+            return 1.0 - ( 1.0 - pLast ) * std::pow( zLast / z, m_upperTailParameter );
+        }
+        return interpolateCDF( m_upperTail, m_upperTailParameter, zLast, m_zMax, pLast, 1.0, z );
+    }
+
+    //middle classes
+    for( int k = 1; k < nThresholds; ++k )
+        if( z <= m_thresholds[k] )
+            return interpolateCDF( m_middle, m_middleParameter, m_thresholds[k-1], m_thresholds[k], ccdf[k-1], ccdf[k], z );
+    return pLast;
+}
+
+double IndicatorPostProcessing::integrateQuantiles(const double *ccdf, double pFrom, double pTo) const
+{
+    int nThresholds = m_thresholds.size();
+    double sum = 0.0;
+
+    //the classes are the lower tail (k = 0), the middle classes and the upper tail (k = nThresholds)
+    for( int k = 0; k <= nThresholds; ++k ){
+        double pLow = k == 0 ? 0.0 : ccdf[k-1];
+        double pHigh = k == nThresholds ? 1.0 : ccdf[k];
+        double a = std::max( pFrom, pLow );
+        double b = std::min( pTo, pHigh );
+        if( b <= a )
+            continue;
+        CDFInterpolationModel model = k == 0 ? m_lowerTail : ( k == nThresholds ? m_upperTail : m_middle );
+        double parameter = k == 0 ? m_lowerTailParameter : ( k == nThresholds ? m_upperTailParameter : m_middleParameter );
+        double zLow = k == 0 ? m_zMin : m_thresholds[k-1];
+        double zHigh = k == nThresholds ? m_zMax : m_thresholds[k];
+        bool hyperbolic = k == nThresholds && model == CDFInterpolationModel::HYPERBOLIC && zLow > 0.0 && parameter > 0.0;
+        if( model == CDFInterpolationModel::POWER && parameter > 0.0 ){
+            //z = zLow + (zHigh - zLow) * u^(1/omega) integrates in closed form
+            double e = 1.0 / parameter + 1.0;
+            double ua = ( a - pLow ) / ( pHigh - pLow );
+            double ub = ( b - pLow ) / ( pHigh - pLow );
+            sum += zLow * ( b - a ) + ( zHigh - zLow ) * ( pHigh - pLow ) * ( std::pow( ub, e ) - std::pow( ua, e ) ) / e;
+        } else if( model != CDFInterpolationModel::TABULATED && ! hyperbolic ){
+            //the quantiles are linear in the probability: the trapezoidal rule is exact
+            sum += 0.5 * ( b - a ) * ( interpolate( model, parameter, zLow, zHigh, pLow, pHigh, a ) +
+                                       interpolate( model, parameter, zLow, zHigh, pLow, pHigh, b ) );
+        } else {
+            //midpoint rule with the discretization of the local distributions
+            int n = std::max( 1, m_maxDiscretization );
+            double dp = ( b - a ) / n;
+            for( int l = 0; l < n; ++l )
+                sum += getQuantile( ccdf, a + ( l + 0.5 ) * dp ) * dp;
+        }
+    }
+    return sum;
+}
+
+double IndicatorPostProcessing::interpolateCDF(CDFInterpolationModel model, double parameter,
+                                               double zLow, double zHigh, double pLow, double pHigh, double z) const
+{
+    if( zHigh <= zLow )
+        return z < zLow ? pLow : pHigh;
+    double v = std::max( 0.0, std::min( 1.0, ( z - zLow ) / ( zHigh - zLow ) ) );
+    double u = v;
+    switch( model ){
+    case CDFInterpolationModel::POWER:
+        if( parameter > 0.0 )
+            u = std::pow( v, parameter );
+        break;
+    case CDFInterpolationModel::TABULATED:
+    {
+        double gLow = getGlobalCDF( zLow );
+        double gHigh = getGlobalCDF( zHigh );
+        if( gHigh > gLow )
+            u = std::max( 0.0, std::min( 1.0, ( getGlobalCDF( z ) - gLow ) / ( gHigh - gLow ) ) );
+        break;
+    }
+    default:
+        break;
+    }
+    return pLow + ( pHigh - pLow ) * u;
+}
+
+double IndicatorPostProcessing::interpolate(CDFInterpolationModel model, double parameter,
+                                            double zLow, double zHigh, double pLow, double pHigh, double p) const
+{
+    if( pHigh <= pLow )
+        return zLow;
+    double u = std::max( 0.0, std::min( 1.0, ( p - pLow ) / ( pHigh - pLow ) ) );
+    switch( model ){
+    case CDFInterpolationModel::POWER:
+        //like the powint() function of GSLib with the inverse of the exponent of the c.d.f.
+        if( parameter > 0.0 )
+            return zLow + ( zHigh - zLow ) * std::pow( u, 1.0 / parameter );
+        break;
+    case CDFInterpolationModel::TABULATED:
+    {
+        //the global distribution is rescaled to the probabilities of the class
+        double gLow = getGlobalCDF( zLow );
+        double gHigh = getGlobalCDF( zHigh );
+        if( gHigh > gLow ){
+            double z = getGlobalQuantile( gLow + u * ( gHigh - gLow ) );
+            return std::max( zLow, std::min( zHigh, z ) );
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return zLow + ( zHigh - zLow ) * u;
+}
+
+double IndicatorPostProcessing::getGlobalCDF(double z) const
+{
+    if( z <= m_globalValues.front() ){
+        if( z <= m_zMin || m_globalValues.front() <= m_zMin )
+            return 0.0;
+        return m_globalCDF.front() * ( z - m_zMin ) / ( m_globalValues.front() - m_zMin );
+    }
+    if( z >= m_globalValues.back() ){
+        if( z >= m_zMax || m_globalValues.back() >= m_zMax )
+            return 1.0;
+        return m_globalCDF.back() + ( 1.0 - m_globalCDF.back() ) * ( z - m_globalValues.back() ) / ( m_zMax - m_globalValues.back() );
+    }
+    long i = std::upper_bound( m_globalValues.begin(), m_globalValues.end(), z ) - m_globalValues.begin();
+    double zLow = m_globalValues[i-1], zHigh = m_globalValues[i];
+    if( zHigh <= zLow )
+        return m_globalCDF[i];
+    return m_globalCDF[i-1] + ( m_globalCDF[i] - m_globalCDF[i-1] ) * ( z - zLow ) / ( zHigh - zLow );
+}
+
+double IndicatorPostProcessing::getGlobalQuantile(double p) const
+{
+    if( p <= m_globalCDF.front() ){
+        double zLow = std::min( m_zMin, m_globalValues.front() );
+        return zLow + ( m_globalValues.front() - zLow ) * p / m_globalCDF.front();
+    }
+    if( p >= m_globalCDF.back() ){
+        double zHigh = std::max( m_zMax, m_globalValues.back() );
+        if( m_globalCDF.back() >= 1.0 )
+            return m_globalValues.back();
+        return m_globalValues.back() + ( zHigh - m_globalValues.back() ) * ( p - m_globalCDF.back() ) / ( 1.0 - m_globalCDF.back() );
+    }
+    long i = std::upper_bound( m_globalCDF.begin(), m_globalCDF.end(), p ) - m_globalCDF.begin();
+    double pLow = m_globalCDF[i-1], pHigh = m_globalCDF[i];
+    if( pHigh <= pLow )
+        return m_globalValues[i];
+    return m_globalValues[i-1] + ( m_globalValues[i] - m_globalValues[i-1] ) * ( p - pLow ) / ( pHigh - pLow );
+}
+
+void IndicatorPostProcessing::correctSupport(std::vector<double> &quantiles, double mean, double variance) const
+{
+    double f = std::max( 0.0, std::min( 1.0, m_varianceReduction ) );
+
+    //the indirect lognormal correction requires positive values
+    if( m_supportCorrection == SupportCorrection::INDIRECT_LOGNORMAL && mean > 0.0 && variance > 0.0 &&
+        quantiles.front() > 0.0 ){
+        double cv2 = variance / ( mean * mean );
+        double b = std::sqrt( std::log( f * cv2 + 1.0 ) / std::log( cv2 + 1.0 ) );
+        double a = mean / std::sqrt( f * cv2 + 1.0 ) * std::pow( std::sqrt( cv2 + 1.0 ) / mean, b );
+        double sum = 0.0;
+        for( double& quantile : quantiles ){
+            quantile = a * std::pow( quantile, b );
+            sum += quantile;
+        }
+        //the transform does not preserve the mean exactly, so the values are rescaled
+        double factor = mean / ( sum / quantiles.size() );
+        for( double& quantile : quantiles )
+            quantile *= factor;
+        return;
+    }
+
+    //affine correction: the deviations from the mean are shrunk by the square root of the variance reduction
+    double shrink = std::sqrt( f );
+    for( double& quantile : quantiles )
+        quantile = mean + shrink * ( quantile - mean );
+}
@@ -0,0 +1,152 @@
+#ifndef INDICATORPOSTPROCESSING_H
+#define INDICATORPOSTPROCESSING_H
+
+#include <vector>
+#include <QString>
+
+class CartesianGrid;
+class DataFile;
+
+/*! The products of IndicatorPostProcessing (same codes of the output option of postik). */
+enum class IKPostProcessingOutput : int {
+    ETYPE = 1,                  /*!< The mean of the local distributions (E-type estimate). */
+    PROBABILITY_AND_MEANS = 2,  /*!< The probability of exceeding a cutoff and the means above and below it. */
+    QUANTILE = 3,               /*!< A quantile of the local distributions. */
+    VARIANCE = 4                /*!< The variance of the local distributions (conditional variance). */
+};
+
+/*! The models to interpolate the local c.d.f.'s within the classes and in the tails (same codes of postik). */
+enum class CDFInterpolationModel : int {
+    LINEAR = 1,     /*!< Linear interpolation. */
+    POWER = 2,      /*!< Power model. */
+    TABULATED = 3,  /*!< Interpolation between the quantiles of a global distribution. */
+    HYPERBOLIC = 4  /*!< Hyperbolic model (upper tail only). */
+};
+
+/*! The change of support corrections of the local distributions (same codes of postik). */
+enum class SupportCorrection : int {
+    NONE = 0,
+    AFFINE = 1,
+    INDIRECT_LOGNORMAL = 2
+};
+
+/**
+ * The IndicatorPostProcessing class post-processes the local distributions estimated by indicator kriging (e.g.
+ * the output of IndicatorKriging or of ik3d) in-process, like the GSLib program postik: for each cell, the c.d.f.
+ * values at the thresholds are corrected for order relation deviations and interpolated with the same tail and
+ * middle class options of postik to compute the E-type estimate, the conditional variance, a quantile or the
+ * probability and the means above/below a cutoff.
+ *
+ * The cells are processed in parallel directly from the probabilities loaded in memory.  The results can be
+ * appended to the grid as new columns with appendToGrid().
+ */
+class IndicatorPostProcessing
+{
+public:
+    /** @param ikGrid The grid with the c.d.f. values, one column per threshold, starting at the first column. */
+    IndicatorPostProcessing( CartesianGrid* ikGrid );
+
+    /** Sets the thresholds of the c.d.f. values in the grid columns. */
+    void setThresholds( const std::vector<double>& thresholds ){ m_thresholds = thresholds; }
+
+    /** Sets the product to compute.  The parameter is the cutoff for PROBABILITY_AND_MEANS or the
+     *  cumulative probability for QUANTILE, otherwise it is ignored. */
+    void setOutput( IKPostProcessingOutput output, double parameter ){ m_output = output; m_outputParameter = parameter; }
+
+    /** Sets the minimum and maximum values of the variable, which bound the tails of the distributions. */
+    void setValueLimits( double min, double max ){ m_zMin = min; m_zMax = max; }
+
+    //@{
+    /** Sets the interpolation models and their parameters (e.g. the exponent of the power model). */
+    void setLowerTail( CDFInterpolationModel model, double parameter ){ m_lowerTail = model; m_lowerTailParameter = parameter; }
+    void setMiddle( CDFInterpolationModel model, double parameter ){ m_middle = model; m_middleParameter = parameter; }
+    void setUpperTail( CDFInterpolationModel model, double parameter ){ m_upperTail = model; m_upperTailParameter = parameter; }
+    //@}
+
+    /**
+     * Sets the global distribution used by the TABULATED interpolation model.
+     * @param weightGEOEASIndex The GEO-EAS index of the declustering weights, zero means equal weights.
+     */
+    void setGlobalDistribution( DataFile* dataFile, uint variableGEOEASIndex, uint weightGEOEASIndex,
+                                double trimMin, double trimMax );
+
+    /** Sets the change of support correction and the variance reduction factor (between 0 and 1). */
+    void setSupportCorrection( SupportCorrection correction, double varianceReduction ){
+        m_supportCorrection = correction; m_varianceReduction = varianceReduction; }
+
+    /** Sets the number of quantiles used to discretize the local distributions.  Default is 50. */
+    void setMaxDiscretization( int value ){ m_maxDiscretization = value; }
+
+    /** Performs the post-processing.  Returns false if the parameters are inconsistent with the grid. */
+    bool run();
+
+    /** The names of the output columns. */
+    std::vector<QString> getOutputNames() const;
+
+    /** The output values, one vector per output column.  The cells that were not estimated are std::nan(""). */
+    const std::vector< std::vector<double> >& getOutputs() const { return m_outputs; }
+
+    long getProcessedCellCount() const { return m_processedCount; }
+
+    /** Saves the results as a GEO-EAS grid file like that of postik. */
+    void saveInGEOEASFormat( const QString& path, double noDataValue ) const;
+
+    /** Appends the results as new columns to the grid.  If there are several columns (PROBABILITY_AND_MEANS),
+     *  the given name is used as a prefix of the column names. */
+    void appendToGrid( const QString& name );
+
+private:
+    CartesianGrid* m_grid;
+    std::vector<double> m_thresholds;
+    IKPostProcessingOutput m_output;
+    double m_outputParameter;
+    double m_zMin;
+    double m_zMax;
+    CDFInterpolationModel m_lowerTail;
+    double m_lowerTailParameter;
+    CDFInterpolationModel m_middle;
+    double m_middleParameter;
+    CDFInterpolationModel m_upperTail;
+    double m_upperTailParameter;
+    SupportCorrection m_supportCorrection;
+    double m_varianceReduction;
+    int m_maxDiscretization;
+
+    //the global distribution: sorted values and their cumulative probabilities
+    std::vector<double> m_globalValues;
+    std::vector<double> m_globalCDF;
+
+    std::vector< std::vector<double> > m_outputs;
+    long m_processedCount;
+
+    /** Returns the value of the local distribution given by the c.d.f. values at the thresholds for the given
+     *  cumulative probability, like the GSLib routine beyond. */
+    double getQuantile( const double* ccdf, double p ) const;
+
+    /** Returns the c.d.f. value of the local distribution given by the c.d.f. values at the thresholds for the
+     *  given value, that is, the inverse of getQuantile(). */
+    double getCDF( const double* ccdf, double z ) const;
+
+    /** Returns the integral of the quantiles of the local distribution given by the c.d.f. values at the thresholds
+     *  between the cumulative probabilities pFrom and pTo (the partial expectation of the local distribution). */
+    double integrateQuantiles( const double* ccdf, double pFrom, double pTo ) const;
+
+    /** Interpolates a value within the class [zLow, zHigh] whose c.d.f. values are [pLow, pHigh]. */
+    double interpolate( CDFInterpolationModel model, double parameter,
+                        double zLow, double zHigh, double pLow, double pHigh, double p ) const;
+
+    /** The inverse of interpolate(): returns the c.d.f. value of z within the class [zLow, zHigh]. */
+    double interpolateCDF( CDFInterpolationModel model, double parameter,
+                           double zLow, double zHigh, double pLow, double pHigh, double z ) const;
+
+    //@{
+    /** The global c.d.f. and its inverse, linearly interpolated between the tabulated values. */
+    double getGlobalCDF( double z ) const;
+    double getGlobalQuantile( double p ) const;
+    //@}
+
+    /** Applies the change of support correction to the quantiles of a local distribution. */
+    void correctSupport( std::vector<double>& quantiles, double mean, double variance ) const;
+};
+
+#endif // INDICATORPOSTPROCESSING_H
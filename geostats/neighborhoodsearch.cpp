@@ -0,0 +1,65 @@
+#include "neighborhoodsearch.h"
+
+#include "geostats/geostatsutils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+size_t NeighborhoodSearch::BucketKeyHash::operator()(const BucketKey &key) const
+{
+    return std::hash<long long>()( key.i * 73856093LL ^ key.j * 19349663LL ^ key.k * 83492791LL );
+}
+
+NeighborhoodSearch::NeighborhoodSearch(double hMax, double hMin, double vert, double azimuth, double dip, double roll) :
+    m_radius( hMax )
+{
+    //the transform makes the search ellipsoid a sphere with radius hMax
+    m_transform = GeostatsUtils::getAnisoTransform( hMax, hMin, vert, azimuth, dip, roll );
+}
+
+void NeighborhoodSearch::build(const std::vector<double> &x, const std::vector<double> &y, const std::vector<double> &z)
+{
+    long n = x.size();
+    m_sx.resize( n ); m_sy.resize( n ); m_sz.resize( n );
+    m_buckets.clear();
+    for( long i = 0; i < n; ++i ){
+        m_sx[i] = x[i]; m_sy[i] = y[i]; m_sz[i] = z[i];
+        GeostatsUtils::transform( m_transform, m_sx[i], m_sy[i], m_sz[i] );
+        m_buckets[ BucketKey{ (long long)std::floor( m_sx[i] / m_radius ),
+                              (long long)std::floor( m_sy[i] / m_radius ),
+                              (long long)std::floor( m_sz[i] / m_radius ) } ].push_back( i );
+    }
+}
+
+void NeighborhoodSearch::find(double x, double y, double z, int maxCount,
+                              std::vector<std::pair<double, long> > &result) const
+{
+    result.clear();
+    if( m_radius <= 0.0 )
+        return;
+    GeostatsUtils::transform( m_transform, x, y, z );
+    double r2 = m_radius * m_radius;
+    long long ci = (long long)std::floor( x / m_radius );
+    long long cj = (long long)std::floor( y / m_radius );
+    long long ck = (long long)std::floor( z / m_radius );
+    for( long long i = ci - 1; i <= ci + 1; ++i )
+        for( long long j = cj - 1; j <= cj + 1; ++j )
+            for( long long k = ck - 1; k <= ck + 1; ++k ){
+                auto it = m_buckets.find( BucketKey{ i, j, k } );
+                if( it == m_buckets.end() )
+                    continue;
+                for( long iPoint : it->second ){
+                    double dx = m_sx[iPoint] - x, dy = m_sy[iPoint] - y, dz = m_sz[iPoint] - z;
+                    double d2 = dx*dx + dy*dy + dz*dz;
+                    if( d2 <= r2 )
+                        result.push_back( std::make_pair( d2, iPoint ) );
+                }
+            }
+    //only the nearest maxCount points are sorted, so dense data do not cost a full sort per location
+    if( maxCount >= 0 && (long)result.size() > maxCount ){
+        std::partial_sort( result.begin(), result.begin() + maxCount, result.end() );
+        result.resize( maxCount );
+    } else
+        std::sort( result.begin(), result.end() );
+}
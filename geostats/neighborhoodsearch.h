@@ -0,0 +1,46 @@
+#ifndef NEIGHBORHOODSEARCH_H
+#define NEIGHBORHOODSEARCH_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+#include "matrix3x3.h"
+
+/**
+ * The NeighborhoodSearch class finds the points within a search ellipsoid centered at a given location, like the
+ * super block search of the GSLib kriging programs.  The points are transformed once to the space where the
+ * ellipsoid becomes a sphere and are bucketed by their integer cell coordinates in that space (cells as large as
+ * the search radius), so only the 27 cells around a location need to be visited.  Only the occupied cells take
+ * memory.  After build(), find() can be called concurrently from several threads.
+ */
+class NeighborhoodSearch
+{
+public:
+    /** Sets the search ellipsoid.  The parameters have the same meaning as in the GSLib parameter files. */
+    NeighborhoodSearch( double hMax, double hMin, double vert, double azimuth, double dip, double roll );
+
+    /** Indexes the given points.  The point indexes returned by find() refer to these vectors. */
+    void build( const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z );
+
+    /**
+     * Fills result with the (squared anisotropic distance, point index) pairs of the nearest maxCount points within
+     * the search ellipsoid centered at the given location, sorted by increasing distance.  The distances are measured
+     * in the space where the search ellipsoid is a sphere with radius hMax.  A negative maxCount returns all points.
+     */
+    void find( double x, double y, double z, int maxCount, std::vector< std::pair<double, long> >& result ) const;
+
+private:
+    struct BucketKey{
+        long long i, j, k;
+        bool operator==( const BucketKey& other ) const { return i == other.i && j == other.j && k == other.k; }
+    };
+    struct BucketKeyHash{
+        size_t operator()( const BucketKey& key ) const;
+    };
+    double m_radius;
+    Matrix3X3<double> m_transform;
+    std::vector<double> m_sx, m_sy, m_sz;
+    std::unordered_map< BucketKey, std::vector<long>, BucketKeyHash > m_buckets;
+};
+
+#endif // NEIGHBORHOODSEARCH_H
@@ -0,0 +1,231 @@
+#include "normalscoretransform.h"
+
+#include "geostatsutils.h"
+#include "univariatestatistics.h"
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/datafile.h"
+#include "util.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QRegExp>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    /** Interpolation between (xlow,ylow) and (xhigh,yhigh) with a power model (same as GSLib's powint()). */
+    double powint( double xlow, double xhigh, double ylow, double yhigh, double xval, double power ){
+        if( ( xhigh - xlow ) < 1.0E-20 )
+            return ( yhigh + ylow ) / 2.0;
+        return ylow + ( yhigh - ylow ) * std::pow( ( xval - xlow ) / ( xhigh - xlow ), power );
+    }
+
+    /** Linear interpolation in the sorted vector xs (with the values ys) clamped to the extreme ys. */
+    double interpolate( const std::vector<double>& xs, const std::vector<double>& ys, double x ){
+        if( x <= xs.front() )
+            return ys.front();
+        if( x >= xs.back() )
+            return ys.back();
+        size_t iRight = std::lower_bound( xs.begin(), xs.end(), x ) - xs.begin();
+        if( xs[iRight] == x )
+            return ys[iRight];
+        size_t iLeft = iRight - 1;
+        return ys[iLeft] + ( x - xs[iLeft] ) * ( ys[iRight] - ys[iLeft] ) / ( xs[iRight] - xs[iLeft] );
+    }
+}
+
+NormalScoreTransform::NormalScoreTransform() :
+    m_lowerTail( NormalScoreTail::CONSTANT ),
+    m_lowerTailLimit( 0.0 ),
+    m_lowerTailParameter( 1.0 ),
+    m_upperTail( NormalScoreTail::CONSTANT ),
+    m_upperTailLimit( 0.0 ),
+    m_upperTailParameter( 1.0 )
+{
+}
+
+bool NormalScoreTransform::build(Attribute *at, Attribute *weight)
+{
+    UnivariateStatistics stats( at, weight );
+    stats.compute();
+    return build( stats );
+}
+
+bool NormalScoreTransform::build(const UnivariateStatistics &stats)
+{
+    m_values.clear();
+    m_scores.clear();
+
+    const std::vector<double>& values = stats.getSortedValues();
+    const std::vector<double>& cumProbs = stats.getCumulativeProbabilities();
+    size_t n = values.size();
+    if( n == 0 )
+        return false;
+
+    //each group of equal values spans an interval of cumulative probability: its normal score is that of the middle
+    //of the interval
+    double previousCumProb = 0.0;
+    for( size_t i = 0; i < n; ){
+        size_t j = i;
+        while( j + 1 < n && values[j + 1] == values[i] )
+            ++j;
+        double p = ( previousCumProb + cumProbs[j] ) / 2.0;
+        m_values.push_back( values[i] );
+        m_scores.push_back( GeostatsUtils::getGaussianQuantile( p ) );
+        previousCumProb = cumProbs[j];
+        i = j + 1;
+    }
+    return true;
+}
+
+bool NormalScoreTransform::saveTable(const QString path) const
+{
+    QFile file( path );
+    if( ! file.open( QFile::WriteOnly | QFile::Text ) ){
+        Application::instance()->logError( "NormalScoreTransform::saveTable(): could not write to " + path + "." );
+        return false;
+    }
+    QTextStream out( &file );
+    for( size_t i = 0; i < m_values.size(); ++i )
+        out << QString::number( m_values[i], 'g', 12 ) << '\t' << QString::number( m_scores[i], 'g', 12 ) << '\n';
+    file.close();
+    return true;
+}
+
+bool NormalScoreTransform::loadTable(const QString path)
+{
+    m_values.clear();
+    m_scores.clear();
+    QFile file( path );
+    if( ! file.open( QFile::ReadOnly | QFile::Text ) ){
+        Application::instance()->logError( "NormalScoreTransform::loadTable(): could not read " + path + "." );
+        return false;
+    }
+    QTextStream in( &file );
+    //the .trn files generated by nscore have the values separated by spaces
+    while( ! in.atEnd() ){
+        QStringList fields = in.readLine().split( QRegExp("\\s+"), QString::SkipEmptyParts );
+        if( fields.size() < 2 )
+            continue;
+        double value = fields[0].toDouble();
+        double score = fields[1].toDouble();
+        //nscore writes tied values as separate entries: keep the first of them
+        if( ! m_values.empty() && value <= m_values.back() )
+            continue;
+        m_values.push_back( value );
+        m_scores.push_back( score );
+    }
+    file.close();
+    return ! m_values.empty();
+}
+
+double NormalScoreTransform::transform(double value) const
+{
+    return interpolate( m_values, m_scores, value );
+}
+
+std::vector<double> NormalScoreTransform::transform(Attribute *at) const
+{
+    return apply( at, [this]( double value ){ return transform( value ); } );
+}
+
+void NormalScoreTransform::setLowerTail(NormalScoreTail tail, double limit, double parameter)
+{
+    m_lowerTail = tail;
+    m_lowerTailLimit = limit;
+    m_lowerTailParameter = parameter;
+}
+
+void NormalScoreTransform::setUpperTail(NormalScoreTail tail, double limit, double parameter)
+{
+    m_upperTail = tail;
+    m_upperTailLimit = limit;
+    m_upperTailParameter = parameter;
+}
+
+double NormalScoreTransform::backTransform(double score) const
+{
+    //lower tail
+    if( score < m_scores.front() ){
+        double cdflo = GeostatsUtils::getGaussianCumulativeProbability( m_scores.front() );
+        double cdfbt = GeostatsUtils::getGaussianCumulativeProbability( score );
+        switch( m_lowerTail ){
+            case NormalScoreTail::LINEAR:
+                return powint( 0.0, cdflo, m_lowerTailLimit, m_values.front(), cdfbt, 1.0 );
+            case NormalScoreTail::POWER:
+                //like backtr, the exponent of the interpolation is the inverse of the tail parameter
+                if( m_lowerTailParameter > 0.0 )
+                    return powint( 0.0, cdflo, m_lowerTailLimit, m_values.front(), cdfbt, 1.0 / m_lowerTailParameter );
+                return m_values.front();
+            default:
+                return m_values.front();
+        }
+    }
+
+    //upper tail
+    if( score > m_scores.back() ){
+        double cdfhi = GeostatsUtils::getGaussianCumulativeProbability( m_scores.back() );
+        double cdfbt = GeostatsUtils::getGaussianCumulativeProbability( score );
+        switch( m_upperTail ){
+            case NormalScoreTail::LINEAR:
+                return powint( cdfhi, 1.0, m_values.back(), m_upperTailLimit, cdfbt, 1.0 );
+            case NormalScoreTail::POWER:
+                if( m_upperTailParameter > 0.0 )
+                    return powint( cdfhi, 1.0, m_values.back(), m_upperTailLimit, cdfbt, 1.0 / m_upperTailParameter );
+                return m_values.back();
+            case NormalScoreTail::HYPERBOLIC:
+                {
+                    double lambda = std::pow( m_values.back(), m_upperTailParameter ) * ( 1.0 - cdfhi );
+                    if( cdfbt >= 1.0 )
+                        return m_upperTailLimit;
+                    return std::min( m_upperTailLimit, std::pow( lambda / ( 1.0 - cdfbt ), 1.0 / m_upperTailParameter ) );
+                }
+            default:
+                return m_values.back();
+        }
+    }
+
+    //within the table
+    return interpolate( m_scores, m_values, score );
+}
+
+std::vector<double> NormalScoreTransform::backTransform(Attribute *at) const
+{
+    return apply( at, [this]( double score ){ return backTransform( score ); } );
+}
+
+template<typename F>
+std::vector<double> NormalScoreTransform::apply(Attribute *at, F function) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    DataFile* dataFile = (DataFile*)at->getContainingFile();
+    //the data must be loaded before going parallel
+    dataFile->loadData();
+    long nLines = dataFile->getDataLineCount();
+    uint column = dataFile->getFieldGEOEASIndex( at->getName() ) - 1;
+    bool hasNDV = dataFile->hasNoDataValue();
+    double NDV = dataFile->getNoDataValueAsDouble();
+
+    std::vector<double> result( nLines, std::nan("") );
+    if( m_values.empty() )
+        return result;
+
+    Util::parallelFor( nLines, [&]( long first, long last ){
+        for( long iLine = first; iLine < last; ++iLine ){
+            double value = dataFile->data( iLine, column );
+            if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+                continue;
+            result[iLine] = function( value );
+        }
+    });
+
+    Application::instance()->logInfo( "NormalScoreTransform: " + QString::number( nLines ) + " values of " + at->getName() +
+                                      " processed in " + QString::number( timer.elapsed() ) + "ms." );
+    return result;
+}
@@ -0,0 +1,98 @@
+#ifndef NORMALSCORETRANSFORM_H
+#define NORMALSCORETRANSFORM_H
+
+#include <vector>
+#include <QString>
+
+class Attribute;
+class UnivariateStatistics;
+
+/*! How values are extrapolated beyond the transform table in the back transform (same options as GSLib's backtr). */
+enum class NormalScoreTail : unsigned {
+    CONSTANT = 0, /*!< The extreme value of the table is returned. */
+    LINEAR,       /*!< Linear interpolation in probability to the tail limit. */
+    POWER,        /*!< Power model interpolation to the tail limit (parameter is ltpar/utpar of backtr, whose
+                       inverse is the exponent of the interpolation). */
+    HYPERBOLIC    /*!< Hyperbolic model (upper tail only, parameter is the exponent, which must be >= 1). */
+};
+
+/**
+ * The NormalScoreTransform class performs the normal score transform of a variable and its back transform in-process,
+ * replacing the GSLib programs nscore and backtr.
+ *
+ * The transform table is built from the (possibly declustered) distribution computed by UnivariateStatistics, which
+ * sorts the values in parallel.  Unlike nscore, ties are handled deterministically: equal values get the same
+ * normal score, corresponding to the middle of the cumulative probability interval they span.
+ *
+ * The table can be saved in the two-column format of the .trn files (value and normal score separated by a tab), which
+ * is also the format of ValuePairs files and can be read by backtr.
+ */
+class NormalScoreTransform
+{
+public:
+    NormalScoreTransform();
+
+    /** Builds the transform table from the distribution of the given variable.
+     * @param weight Optional declustering weight of the same file.
+     * @return False if there are no valid values.
+     */
+    bool build( Attribute* at, Attribute* weight = nullptr );
+
+    /** Builds the transform table from an already computed distribution. */
+    bool build( const UnivariateStatistics& stats );
+
+    /** Writes the transform table to a .trn file. */
+    bool saveTable( const QString path ) const;
+
+    /** Reads the transform table from a .trn file (e.g. one saved by saveTable() or generated by nscore). */
+    bool loadTable( const QString path );
+
+    //@{
+    /** The transform table: the distinct values in ascending order and their normal scores. */
+    const std::vector<double>& getTableValues() const { return m_values; }
+    const std::vector<double>& getTableScores() const { return m_scores; }
+    //@}
+
+    /** Returns the normal score of a value.  Values between those of the table are interpolated linearly and values
+     *  outside the table get the extreme normal scores. */
+    double transform( double value ) const;
+
+    /** Returns the normal scores of all values of the given variable (computed in parallel).  No-data values
+     *  result in std::nan("") (see NewGEOEASColumn). */
+    std::vector<double> transform( Attribute* at ) const;
+
+    /** Sets how values are extrapolated below the lowest normal score of the table.
+     * @param limit The minimum value (zmin of backtr) used by the LINEAR and POWER options.
+     * @param parameter The parameter of the POWER option (ltpar of backtr, the interpolation uses its inverse).
+     */
+    void setLowerTail( NormalScoreTail tail, double limit, double parameter = 1.0 );
+
+    /** Sets how values are extrapolated above the highest normal score of the table.
+     * @param limit The maximum value (zmax of backtr) used by the LINEAR and POWER options.
+     * @param parameter The parameter of the POWER and HYPERBOLIC options (utpar of backtr).
+     */
+    void setUpperTail( NormalScoreTail tail, double limit, double parameter = 1.0 );
+
+    /** Returns the value corresponding to a normal score. */
+    double backTransform( double score ) const;
+
+    /** Back transforms all values of the given variable (computed in parallel).  No-data values result in
+     *  std::nan("") (see NewGEOEASColumn). */
+    std::vector<double> backTransform( Attribute* at ) const;
+
+private:
+    std::vector<double> m_values;
+    std::vector<double> m_scores;
+    NormalScoreTail m_lowerTail;
+    double m_lowerTailLimit;
+    double m_lowerTailParameter;
+    NormalScoreTail m_upperTail;
+    double m_upperTailLimit;
+    double m_upperTailParameter;
+
+    /** Applies the given function to all the values of a variable in parallel. */
+    template<typename F>
+    std::vector<double> apply( Attribute* at, F function ) const;
+};
+
+#endif // NORMALSCORETRANSFORM_H
@@ -0,0 +1,292 @@
+#include "univariatestatistics.h"
+
+#include "domain/application.h"
+#include "domain/attribute.h"
+#include "domain/datafile.h"
+#include "util.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    /** The partial result of the parallel pass over a range of data lines. */
+    struct ValuesChunk{
+        std::vector< std::pair<double, double> > valueWeightPairs; //sorted by value
+        double sumOfWeights = 0.0;
+        double mean = 0.0;
+        double M2 = 0.0; //weighted sum of squared deviations from the mean
+    };
+
+    /** Combines the moments of chunk b into chunk a (Chan et al.'s pairwise update). */
+    void combineMoments( ValuesChunk& a, const ValuesChunk& b ){
+        double W = a.sumOfWeights + b.sumOfWeights;
+        if( W <= 0.0 )
+            return;
+        double delta = b.mean - a.mean;
+        a.mean += delta * b.sumOfWeights / W;
+        a.M2 += b.M2 + delta * delta * a.sumOfWeights * b.sumOfWeights / W;
+        a.sumOfWeights = W;
+    }
+}
+
+UnivariateStatistics::UnivariateStatistics(Attribute *at, Attribute *weight) :
+    m_at( at ),
+    m_weight( weight ),
+    m_name( at->getName() ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_mean( 0.0 ),
+    m_variance( 0.0 )
+{
+}
+
+UnivariateStatistics::UnivariateStatistics(std::vector<double> values, std::vector<double> weights, const QString &name) :
+    m_at( nullptr ),
+    m_weight( nullptr ),
+    m_inputValues( std::move( values ) ),
+    m_inputWeights( std::move( weights ) ),
+    m_name( name ),
+    m_trimMin( -std::numeric_limits<double>::max() ),
+    m_trimMax( std::numeric_limits<double>::max() ),
+    m_mean( 0.0 ),
+    m_variance( 0.0 )
+{
+}
+
+void UnivariateStatistics::compute()
+{
+    //the values are read either from the data file or from memory
+    long nLines = m_inputValues.size();
+    bool hasWeight = ! m_inputWeights.empty();
+    bool hasNDV = false;
+    double NDV = 0.0;
+    DataFile* dataFile = nullptr;
+    uint column = 0;
+    uint weightColumn = 0;
+    if( m_at ){
+        dataFile = (DataFile*)m_at->getContainingFile();
+        //the data must be loaded before going parallel
+        dataFile->loadData();
+        nLines = dataFile->getDataLineCount();
+        column = dataFile->getFieldGEOEASIndex( m_at->getName() ) - 1;
+        hasWeight = m_weight != nullptr;
+        weightColumn = hasWeight ? dataFile->getFieldGEOEASIndex( m_weight->getName() ) - 1 : 0;
+        hasNDV = dataFile->hasNoDataValue();
+        NDV = dataFile->getNoDataValueAsDouble();
+    }
+
+    //the parallel pass: each range of lines yields a sorted chunk of values and its moments
+    std::vector<ValuesChunk> chunks;
+    QMutex mutex;
+    Util::parallelFor( nLines, [&]( long first, long last ){
+        ValuesChunk chunk;
+        chunk.valueWeightPairs.reserve( last - first );
+        for( long iLine = first; iLine < last; ++iLine ){
+            double value = dataFile ? dataFile->data( iLine, column ) : m_inputValues[iLine];
+            if( std::isnan( value ) || ( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) ) )
+                continue;
+            if( value < m_trimMin || value > m_trimMax )
+                continue;
+            double w = 1.0;
+            if( hasWeight ){
+                w = dataFile ? dataFile->data( iLine, weightColumn ) : m_inputWeights[iLine];
+                if( ! ( w > 0.0 ) || ( hasNDV && Util::almostEqual2sComplement( NDV, w, 1 ) ) )
+                    continue;
+            }
+            chunk.valueWeightPairs.push_back( std::pair<double, double>( value, w ) );
+            //incremental weighted mean and sum of squared deviations (West, 1979)
+            chunk.sumOfWeights += w;
+            double delta = value - chunk.mean;
+            chunk.mean += delta * w / chunk.sumOfWeights;
+            chunk.M2 += w * delta * ( value - chunk.mean );
+        }
+        std::sort( chunk.valueWeightPairs.begin(), chunk.valueWeightPairs.end() );
+        QMutexLocker locker( &mutex );
+        chunks.push_back( std::move( chunk ) );
+    });
+
+    //merge the sorted chunks pairwise (the merges in each round are independent)
+    while( chunks.size() > 1 ){
+        long nPairs = chunks.size() / 2;
+        Util::parallelFor( nPairs, [&]( long first, long last ){
+            for( long iPair = first; iPair < last; ++iPair ){
+                ValuesChunk& a = chunks[ iPair * 2 ];
+                ValuesChunk& b = chunks[ iPair * 2 + 1 ];
+                std::vector< std::pair<double, double> > merged( a.valueWeightPairs.size() +
+                                                                 b.valueWeightPairs.size() );
+                std::merge( a.valueWeightPairs.begin(), a.valueWeightPairs.end(),
+                            b.valueWeightPairs.begin(), b.valueWeightPairs.end(),
+                            merged.begin() );
+                a.valueWeightPairs.swap( merged );
+                combineMoments( a, b );
+                b = ValuesChunk();
+            }
+        });
+        //keep the merged chunks (and the odd one out, if any)
+        std::vector<ValuesChunk> remaining;
+        remaining.reserve( nPairs + 1 );
+        for( size_t i = 0; i < chunks.size(); i += 2 )
+            remaining.push_back( std::move( chunks[i] ) );
+        chunks.swap( remaining );
+    }
+
+    m_values.clear();
+    m_cumWeights.clear();
+    m_plottingPositions.clear();
+    m_mean = 0.0;
+    m_variance = 0.0;
+    if( chunks.empty() || chunks[0].valueWeightPairs.empty() ){
+        Application::instance()->logWarn("UnivariateStatistics::compute(): no valid values in " + m_name + ".");
+        return;
+    }
+
+    //store the sorted values and their normalized cumulative weights
+    const ValuesChunk& all = chunks[0];
+    long n = all.valueWeightPairs.size();
+    m_values.resize( n );
+    m_cumWeights.resize( n );
+    m_plottingPositions.resize( n );
+    double cumWeight = 0.0;
+    for( long i = 0; i < n; ++i ){
+        m_values[i] = all.valueWeightPairs[i].first;
+        //the plotting position is the cumulative weight minus half the weight of the value
+        m_plottingPositions[i] = ( cumWeight + all.valueWeightPairs[i].second / 2.0 ) / all.sumOfWeights;
+        cumWeight += all.valueWeightPairs[i].second;
+        m_cumWeights[i] = cumWeight / all.sumOfWeights;
+    }
+    m_mean = all.mean;
+    m_variance = all.M2 / all.sumOfWeights;
+}
+
+double UnivariateStatistics::getMin() const
+{
+    if( m_values.empty() )
+        return std::numeric_limits<double>::quiet_NaN();
+    return m_values.front();
+}
+
+double UnivariateStatistics::getMax() const
+{
+    if( m_values.empty() )
+        return std::numeric_limits<double>::quiet_NaN();
+    return m_values.back();
+}
+
+double UnivariateStatistics::getStdDev() const
+{
+    return std::sqrt( m_variance );
+}
+
+double UnivariateStatistics::getCV() const
+{
+    if( m_mean == 0.0 )
+        return std::numeric_limits<double>::quiet_NaN();
+    return getStdDev() / m_mean;
+}
+
+double UnivariateStatistics::getQuantile(double p) const
+{
+    if( m_values.empty() )
+        return std::numeric_limits<double>::quiet_NaN();
+    const std::vector<double>& pp = m_plottingPositions;
+    //p beyond the first or last plotting positions returns the extreme values
+    if( p <= pp.front() )
+        return m_values.front();
+    if( p >= pp.back() )
+        return m_values.back();
+    //interpolate between the values whose plotting positions bracket p
+    long i = std::upper_bound( pp.begin(), pp.end(), p ) - pp.begin();
+    double p0 = pp[i-1];
+    double p1 = pp[i];
+    if( p1 <= p0 )
+        return m_values[i];
+    return m_values[i-1] + ( m_values[i] - m_values[i-1] ) * ( p - p0 ) / ( p1 - p0 );
+}
+
+double UnivariateStatistics::getCumulativeProbability(double value) const
+{
+    long k = std::upper_bound( m_values.begin(), m_values.end(), value ) - m_values.begin();
+    if( k == 0 )
+        return 0.0;
+    return m_cumWeights[k-1];
+}
+
+std::vector<double> UnivariateStatistics::getHistogram(int nBins, double min, double max, bool cumulative) const
+{
+    std::vector<double> result( std::max( nBins, 0 ), 0.0 );
+    if( m_values.empty() || nBins <= 0 || max <= min )
+        return result;
+
+    //returns the weighted fraction of values less than x (or equal to x if inclusive == true)
+    auto weightBelow = [this]( double x, bool inclusive ) -> double {
+        long k;
+        if( inclusive )
+            k = std::upper_bound( m_values.begin(), m_values.end(), x ) - m_values.begin();
+        else
+            k = std::lower_bound( m_values.begin(), m_values.end(), x ) - m_values.begin();
+        return k == 0 ? 0.0 : m_cumWeights[k-1];
+    };
+
+    //the classes are [lower edge, upper edge), except for the last one, which includes max
+    double binWidth = ( max - min ) / nBins;
+    double lowerCum = weightBelow( min, false );
+    for( int iBin = 0; iBin < nBins; ++iBin ){
+        double upperCum;
+        if( iBin == nBins - 1 )
+            upperCum = weightBelow( max, true );
+        else
+            upperCum = weightBelow( min + ( iBin + 1 ) * binWidth, false );
+        result[iBin] = cumulative ? upperCum : upperCum - lowerCum;
+        lowerCum = upperCum;
+    }
+    return result;
+}
+
+QString UnivariateStatistics::getSummary() const
+{
+    QString result;
+    result += "Number of data: " + QString::number( getCount() ) + "\n";
+    result += "Mean: " + QString::number( getMean() ) + "\n";
+    result += "Std. dev.: " + QString::number( getStdDev() ) + "\n";
+    result += "Coef. of var.: " + QString::number( getCV() ) + "\n";
+    result += "Maximum: " + QString::number( getMax() ) + "\n";
+    result += "Upper quartile: " + QString::number( getQuantile( 0.75 ) ) + "\n";
+    result += "Median: " + QString::number( getQuantile( 0.5 ) ) + "\n";
+    result += "Lower quartile: " + QString::number( getQuantile( 0.25 ) ) + "\n";
+    result += "Minimum: " + QString::number( getMin() );
+    return result;
+}
+
+void UnivariateStatistics::makeQQ(const UnivariateStatistics &x, const UnivariateStatistics &y, int nQuantiles,
+                                  std::vector<double> &xQuantiles, std::vector<double> &yQuantiles)
+{
+    xQuantiles.resize( nQuantiles );
+    yQuantiles.resize( nQuantiles );
+    for( int i = 0; i < nQuantiles; ++i ){
+        double p = ( i + 0.5 ) / nQuantiles;
+        xQuantiles[i] = x.getQuantile( p );
+        yQuantiles[i] = y.getQuantile( p );
+    }
+}
+
+void UnivariateStatistics::makePP(const UnivariateStatistics &x, const UnivariateStatistics &y, int nValues,
+                                  std::vector<double> &xProbabilities, std::vector<double> &yProbabilities)
+{
+    xProbabilities.clear();
+    yProbabilities.clear();
+    if( x.getCount() == 0 || y.getCount() == 0 || nValues < 2 )
+        return;
+    double min = std::min( x.getMin(), y.getMin() );
+    double max = std::max( x.getMax(), y.getMax() );
+    xProbabilities.resize( nValues );
+    yProbabilities.resize( nValues );
+    for( int i = 0; i < nValues; ++i ){
+        double value = min + ( max - min ) * i / ( nValues - 1 );
+        xProbabilities[i] = x.getCumulativeProbability( value );
+        yProbabilities[i] = y.getCumulativeProbability( value );
+    }
+}
@@ -0,0 +1,127 @@
+#ifndef UNIVARIATESTATISTICS_H
+#define UNIVARIATESTATISTICS_H
+
+#include <vector>
+#include <QString>
+
+class Attribute;
+
+/**
+ * The UnivariateStatistics class computes the (possibly declustered) univariate distribution of an Attribute
+ * in-process: summary statistics, histograms, cumulative distribution, quantiles and the data needed for
+ * probability plots and Q-Q/P-P plots.  It replaces running the GSLib programs histplt, probplt and qpplt
+ * for display purposes.
+ *
+ * compute() makes a single parallel pass over the data column to collect the valid values (no-data values
+ * and values with non-positive or unvalued weights are skipped) along with the moments.  The values are kept
+ * sorted with their cumulative weights, so histograms of any number of bins and quantiles can be obtained
+ * afterwards without touching the data file again.
+ */
+class UnivariateStatistics
+{
+public:
+    /**
+     * @param at The variable.
+     * @param weight Optional declustering weight (an Attribute of the same file).  If null, all values
+     *        have the same weight.
+     */
+    UnivariateStatistics( Attribute* at, Attribute* weight = nullptr );
+
+    /**
+     * Constructor for values already in memory (e.g. the result of a transform before it is saved to a file).
+     * NaN values are skipped (see NewGEOEASColumn).
+     * @param weights Optional weights, one per value.  If empty, all values have the same weight.
+     * @param name The variable name used in messages.
+     */
+    UnivariateStatistics( std::vector<double> values, std::vector<double> weights, const QString& name );
+
+    /** Values outside these limits are ignored (as well as no-data values). Default is no trimming. */
+    void setTrimmingLimits( double min, double max ){ m_trimMin = min; m_trimMax = max; }
+
+    /** Loads the data (if not already loaded) and computes the statistics.  Call this before any getter.
+     * If the data file has a data page set (see DataFile::setDataPage()), only the values in the page
+     * are considered.
+     */
+    void compute();
+
+    /** Returns the number of valid values. */
+    long getCount() const { return m_values.size(); }
+
+    double getMin() const;
+    double getMax() const;
+    double getMean() const { return m_mean; }
+    double getVariance() const { return m_variance; }
+    double getStdDev() const;
+    /** Coefficient of variation (standard deviation / mean). */
+    double getCV() const;
+
+    /** Returns the value corresponding to the given cumulative probability (0.0 to 1.0).
+     * The quantile is linearly interpolated between the plotting positions of the sorted values.
+     */
+    double getQuantile( double p ) const;
+
+    /** Returns the cumulative probability (0.0 to 1.0) of the given value, that is, the
+     * weighted fraction of values less than or equal to it.
+     */
+    double getCumulativeProbability( double value ) const;
+
+    /** Returns the weighted frequencies (fractions of the total weight) of the values in nBins classes of
+     * equal width between min and max.  Values outside [min, max] are not counted.
+     * This takes O( nBins * log(n) ) time, so it can be called interactively to rebin the histogram.
+     * @param cumulative If true, returns the cumulative frequencies instead.
+     */
+    std::vector<double> getHistogram( int nBins, double min, double max, bool cumulative = false ) const;
+
+    /** Returns the valid values in ascending order. */
+    const std::vector<double>& getSortedValues() const { return m_values; }
+
+    /** Returns the cumulative probabilities of the sorted values (see getSortedValues()) computed
+     * as plotting positions (cumulative weight minus half the weight of the value), which are suitable
+     * for probability plots.
+     */
+    const std::vector<double>& getPlottingPositions() const { return m_plottingPositions; }
+
+    /** Returns the cumulative probabilities of the sorted values (see getSortedValues()), that is, the
+     * normalized cumulative weights (the last one is 1.0).
+     */
+    const std::vector<double>& getCumulativeProbabilities() const { return m_cumWeights; }
+
+    /** Returns a text with the summary statistics (count, mean, std. dev., quartiles, etc.). */
+    QString getSummary() const;
+
+    /**
+     * Computes the data for a Q-Q plot of two distributions: nQuantiles quantiles of each distribution
+     * for the same probabilities, regularly spaced in (0, 1).
+     */
+    static void makeQQ( const UnivariateStatistics& x, const UnivariateStatistics& y, int nQuantiles,
+                        std::vector<double>& xQuantiles, std::vector<double>& yQuantiles );
+
+    /**
+     * Computes the data for a P-P plot of two distributions: the cumulative probabilities of both
+     * distributions for nValues values regularly spaced between the smallest and the largest value of both.
+     */
+    static void makePP( const UnivariateStatistics& x, const UnivariateStatistics& y, int nValues,
+                        std::vector<double>& xProbabilities, std::vector<double>& yProbabilities );
+
+private:
+    Attribute* m_at;
+    Attribute* m_weight;
+    /** The values and weights given in the constructor for values in memory. */
+    std::vector<double> m_inputValues;
+    std::vector<double> m_inputWeights;
+    QString m_name;
+    double m_trimMin;
+    double m_trimMax;
+
+    /** The valid values in ascending order. */
+    std::vector<double> m_values;
+    /** The cumulative normalized weights (last == 1.0) of m_values. */
+    std::vector<double> m_cumWeights;
+    /** The plotting positions of m_values. */
+    std::vector<double> m_plottingPositions;
+
+    double m_mean;
+    double m_variance;
+};
+
+#endif // UNIVARIATESTATISTICS_H
@@ -0,0 +1,443 @@
+#include "variogramfitter.h"
+
+#include "domain/application.h"
+#include "domain/variogrammodel.h"
+#include "geostats/geostatsutils.h"
+#include "util.h"
+
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+namespace {
+
+/**
+ * Minimizes a function with the Nelder-Mead simplex method.
+ * @param x The starting point.  It is replaced by the minimum found.
+ * @param steps The initial size of the simplex along each parameter.
+ * @return The value of the function at the minimum found.
+ */
+double minimize( const std::function<double(const std::vector<double>&)>& f, std::vector<double>& x,
+                 const std::vector<double>& steps, int maxEvaluations )
+{
+    int n = x.size();
+    std::vector< std::vector<double> > simplex( n + 1, x );
+    std::vector<double> values( n + 1 );
+    for( int i = 0; i < n; ++i )
+        simplex[i+1][i] += steps[i];
+    for( int i = 0; i <= n; ++i )
+        values[i] = f( simplex[i] );
+    int nEvaluations = n + 1;
+
+    std::vector<double> centroid( n ), trial( n ), trial2( n );
+    while( nEvaluations < maxEvaluations ){
+        //order the vertexes: best first, worst last
+        std::vector<int> order( n + 1 );
+        for( int i = 0; i <= n; ++i )
+            order[i] = i;
+        std::sort( order.begin(), order.end(), [&values]( int a, int b ){ return values[a] < values[b]; } );
+        int best = order[0], worst = order[n], secondWorst = order[n-1];
+        if( values[worst] - values[best] <= 1E-12 * ( std::abs( values[best] ) + 1E-30 ) )
+            break;
+
+        //the centroid of all vertexes but the worst
+        std::fill( centroid.begin(), centroid.end(), 0.0 );
+        for( int i = 0; i <= n; ++i )
+            if( i != worst )
+                for( int j = 0; j < n; ++j )
+                    centroid[j] += simplex[i][j] / n;
+
+        //reflection
+        for( int j = 0; j < n; ++j )
+            trial[j] = centroid[j] + ( centroid[j] - simplex[worst][j] );
+        double trialValue = f( trial );
+        ++nEvaluations;
+        if( trialValue < values[best] ){
+            //expansion
+            for( int j = 0; j < n; ++j )
+                trial2[j] = centroid[j] + 2.0 * ( centroid[j] - simplex[worst][j] );
+            double trial2Value = f( trial2 );
+            ++nEvaluations;
+            if( trial2Value < trialValue ){
+                simplex[worst] = trial2;
+                values[worst] = trial2Value;
+            } else {
+                simplex[worst] = trial;
+                values[worst] = trialValue;
+            }
+        } else if( trialValue < values[secondWorst] ){
+            simplex[worst] = trial;
+            values[worst] = trialValue;
+        } else {
+            //contraction
+            for( int j = 0; j < n; ++j )
+                trial2[j] = centroid[j] + 0.5 * ( simplex[worst][j] - centroid[j] );
+            double trial2Value = f( trial2 );
+            ++nEvaluations;
+            if( trial2Value < values[worst] ){
+                simplex[worst] = trial2;
+                values[worst] = trial2Value;
+            } else {
+                //shrink towards the best vertex
+                for( int i = 0; i <= n; ++i ){
+                    if( i == best )
+                        continue;
+                    for( int j = 0; j < n; ++j )
+                        simplex[i][j] = simplex[best][j] + 0.5 * ( simplex[i][j] - simplex[best][j] );
+                    values[i] = f( simplex[i] );
+                    ++nEvaluations;
+                }
+            }
+        }
+    }
+    int best = std::min_element( values.begin(), values.end() ) - values.begin();
+    x = simplex[best];
+    return values[best];
+}
+
+}
+
+/**
+ * The least squares problem for a combination of structure types.  The parameters are, first, those of the
+ * nugget effect and then, for each structure, those of the contribution followed by the logarithms of the ranges
+ * along the axes sampled by the curves.  The variances (nugget effect and contributions) are parameterized by their
+ * square roots or, for an LMC, by the Cholesky factors (l11, l21, l22) of their 2x2 matrices.
+ */
+class VariogramFitter::Problem
+{
+public:
+    Problem( const std::vector<VariogramStructureType>& types, int nVariables, const bool* sampledAxes,
+             double semiMinorRatio, double verticalRatio, double minRange, double maxRange ) :
+        m_types( types ), m_nVariables( nVariables ),
+        m_semiMinorRatio( semiMinorRatio ), m_verticalRatio( verticalRatio ),
+        m_logMinRange( std::log( minRange ) ), m_logMaxRange( std::log( maxRange ) )
+    {
+        for( int k = 0; k < 3; ++k )
+            m_sampledAxes[k] = sampledAxes[k];
+    }
+
+    int getVarianceParameterCount() const { return m_nVariables == 1 ? 1 : 3; }
+
+    int getRangeParameterCount() const { return 1 + ( m_sampledAxes[1] ? 1 : 0 ) + ( m_sampledAxes[2] ? 1 : 0 ); }
+
+    int getParameterCount() const {
+        return getVarianceParameterCount() * ( 1 + m_types.size() ) + getRangeParameterCount() * m_types.size();
+    }
+
+    /** Returns the variances (auto1, auto2, cross) of the nugget effect and of each structure and the ranges of each
+     *  structure given the parameters. */
+    void decode( const double* x, double* nuggets, std::vector< std::vector<double> >& contributions,
+                 std::vector< std::vector<double> >& ranges ) const
+    {
+        int p = 0;
+        decodeVariances( x, p, nuggets );
+        contributions.resize( m_types.size(), std::vector<double>( 3, 0.0 ) );
+        ranges.resize( m_types.size(), std::vector<double>( 3, 0.0 ) );
+        for( uint s = 0; s < m_types.size(); ++s ){
+            decodeVariances( x, p, contributions[s].data() );
+            double aMax = decodeRange( x[p++] );
+            ranges[s][0] = aMax;
+            ranges[s][1] = m_sampledAxes[1] ? decodeRange( x[p++] ) : aMax * m_semiMinorRatio;
+            ranges[s][2] = m_sampledAxes[2] ? decodeRange( x[p++] ) : aMax * m_verticalRatio;
+        }
+    }
+
+    /** Returns the weighted sum of squared residuals.  The scratch vectors avoid allocations in the loop. */
+    double evaluate( const std::vector<double>& x, const Lags* lags,
+                     std::vector<double>& h, std::vector<double>& model ) const
+    {
+        double nuggets[3];
+        std::vector< std::vector<double> > contributions, ranges;
+        decode( x.data(), nuggets, contributions, ranges );
+        double sum = 0.0;
+        for( int v = 0; v < m_nVariables; ++v ){
+            const Lags& l = lags[v];
+            long n = l.gammas.size();
+            h.resize( n );
+            model.assign( n, nuggets[v] );
+            for( uint s = 0; s < m_types.size(); ++s ){
+                double a1 = ranges[s][0], a2 = ranges[s][1], a3 = ranges[s][2];
+                for( long i = 0; i < n; ++i ){
+                    double h1 = l.dx[i] / a1, h2 = l.dy[i] / a2, h3 = l.dz[i] / a3;
+                    h[i] = std::sqrt( h1*h1 + h2*h2 + h3*h3 );
+                }
+                GeostatsUtils::addGammas( m_types[s], h.data(), n, 1.0, contributions[s][v], model.data() );
+            }
+            for( long i = 0; i < n; ++i ){
+                double residual = l.gammas[i] - model[i];
+                sum += l.weights[i] * residual * residual;
+            }
+        }
+        return sum;
+    }
+
+    const std::vector<VariogramStructureType>& getTypes() const { return m_types; }
+
+private:
+    std::vector<VariogramStructureType> m_types;
+    int m_nVariables;
+    bool m_sampledAxes[3];
+    double m_semiMinorRatio;
+    double m_verticalRatio;
+    double m_logMinRange;
+    double m_logMaxRange;
+
+    /** The ranges are bounded so the structures cannot degenerate into nugget effects or constants beyond the
+     *  lags, which would leave the fitted model meaningless away from them. */
+    double decodeRange( double logRange ) const {
+        return std::exp( std::max( m_logMinRange, std::min( m_logMaxRange, logRange ) ) );
+    }
+
+    void decodeVariances( const double* x, int& p, double* variances ) const {
+        if( m_nVariables == 1 ){
+            variances[0] = x[p] * x[p];
+            variances[1] = variances[2] = 0.0;
+            ++p;
+        } else {
+            double l11 = x[p], l21 = x[p+1], l22 = x[p+2];
+            variances[0] = l11 * l11;
+            variances[1] = l21 * l21 + l22 * l22;
+            variances[2] = l11 * l21;
+            p += 3;
+        }
+    }
+};
+
+VariogramFitter::VariogramFitter() :
+    m_nst( 1 ),
+    m_candidateTypes( { VariogramStructureType::SPHERIC,
+                        VariogramStructureType::EXPONENTIAL,
+                        VariogramStructureType::GAUSSIAN } ),
+    m_azimuth( 0.0 ), m_dip( 0.0 ), m_roll( 0.0 ),
+    m_semiMinorRatio( 1.0 ), m_verticalRatio( 1.0 ),
+    m_nStarts( 16 ),
+    m_seed( 69069 ),
+    m_isLMC( false ),
+    m_residual( 0.0 )
+{
+    for( int v = 0; v < 3; ++v )
+        m_nuggets[v] = 0.0;
+}
+
+void VariogramFitter::addCurves(const std::vector<ExperimentalVariogramCurve> &curves,
+                                const std::vector<double> &azimuths, const std::vector<double> &dips, int variable)
+{
+    Lags& lags = m_lags[variable];
+    for( uint c = 0; c < curves.size() && c < azimuths.size() && c < dips.size(); ++c ){
+        //the direction of the lags (same convention of vmodel)
+        double azimuth = azimuths[c] * Util::PI_OVER_180;
+        double dip = dips[c] * Util::PI_OVER_180;
+        double ux = std::sin( azimuth ) * std::cos( dip );
+        double uy = std::cos( azimuth ) * std::cos( dip );
+        double uz = std::sin( dip );
+        const ExperimentalVariogramCurve& curve = curves[c];
+        for( uint i = 0; i < curve.distances.size(); ++i ){
+            //the lags at zero distance do not depend on the model
+            if( curve.distances[i] <= 0.0 )
+                continue;
+            lags.dx.push_back( curve.distances[i] * ux );
+            lags.dy.push_back( curve.distances[i] * uy );
+            lags.dz.push_back( curve.distances[i] * uz );
+            lags.gammas.push_back( curve.gammas[i] );
+            lags.weights.push_back( curve.pairCounts[i] );
+        }
+    }
+}
+
+void VariogramFitter::setAnisotropy(double azimuth, double dip, double roll, double semiMinorRatio, double verticalRatio)
+{
+    m_azimuth = azimuth;
+    m_dip = dip;
+    m_roll = roll;
+    m_semiMinorRatio = semiMinorRatio > 0.0 ? semiMinorRatio : 1.0;
+    m_verticalRatio = verticalRatio > 0.0 ? verticalRatio : 1.0;
+}
+
+bool VariogramFitter::fit()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    int nVariables = m_isLMC ? 3 : 1;
+    for( int v = 0; v < nVariables; ++v )
+        if( m_lags[v].gammas.empty() ){
+            Application::instance()->logError( "VariogramFitter::fit(): there are no experimental lags for variable " +
+                                               QString::number( v ) + "." );
+            return false;
+        }
+    if( m_nst < 0 || ( m_nst > 0 && m_candidateTypes.empty() ) ){
+        Application::instance()->logError( "VariogramFitter::fit(): invalid number of structures or no candidate types." );
+        return false;
+    }
+    for( VariogramStructureType type : m_candidateTypes )
+        if( type == VariogramStructureType::POWER_LAW ){
+            Application::instance()->logError( "VariogramFitter::fit(): the power model cannot be fitted." );
+            return false;
+        }
+
+    //the separations along the axes of the anisotropy ellipsoid and the normalized weights
+    Matrix3X3<double> rotation = GeostatsUtils::getAnisoTransform( 1.0, 1.0, 1.0, m_azimuth, m_dip, m_roll );
+    Lags lags[3];
+    bool sampledAxes[3] = { false, false, false };
+    double minDistance = std::numeric_limits<double>::max(), maxDistance = 0.0;
+    double plateaus[3] = { 0.0, 0.0, 0.0 };
+    double magnitudes[3] = { 0.0, 0.0, 0.0 };
+    for( int v = 0; v < nVariables; ++v ){
+        lags[v] = m_lags[v];
+        long n = lags[v].gammas.size();
+        double totalWeight = 0.0, magnitude = 0.0;
+        std::vector<double> distances( n );
+        for( long i = 0; i < n; ++i ){
+            double& dx = lags[v].dx[i];
+            double& dy = lags[v].dy[i];
+            double& dz = lags[v].dz[i];
+            distances[i] = std::sqrt( dx*dx + dy*dy + dz*dz );
+            GeostatsUtils::transform( rotation, dx, dy, dz );
+            if( std::abs( dx ) > 0.01 * distances[i] ) sampledAxes[0] = true;
+            if( std::abs( dy ) > 0.01 * distances[i] ) sampledAxes[1] = true;
+            if( std::abs( dz ) > 0.01 * distances[i] ) sampledAxes[2] = true;
+            minDistance = std::min( minDistance, distances[i] );
+            maxDistance = std::max( maxDistance, distances[i] );
+            totalWeight += lags[v].weights[i];
+            magnitude += std::abs( lags[v].gammas[i] );
+        }
+        magnitude /= n;
+        //the cross variogram is scaled by the autovariograms, since it may be close to zero for weakly
+        //correlated variables
+        if( v == 2 )
+            magnitude = std::sqrt( magnitudes[0] * magnitudes[1] );
+        //unit scaling for a variogram that is zero everywhere
+        if( ! ( magnitude > std::numeric_limits<double>::epsilon() ) )
+            magnitude = 1.0;
+        if( ! ( totalWeight > 0.0 ) )
+            totalWeight = 1.0;
+        magnitudes[v] = magnitude;
+        //the variables have the same influence regardless of their magnitudes and numbers of pairs
+        for( long i = 0; i < n; ++i )
+            lags[v].weights[i] /= totalWeight * magnitude * magnitude;
+        //the plateau is the average of the farther half of the lags, which is a guess of the sill
+        std::vector<double> sortedDistances = distances;
+        std::nth_element( sortedDistances.begin(), sortedDistances.begin() + n / 2, sortedDistances.end() );
+        double median = sortedDistances[ n / 2 ];
+        long count = 0;
+        for( long i = 0; i < n; ++i )
+            if( distances[i] >= median ){
+                plateaus[v] += lags[v].gammas[i];
+                ++count;
+            }
+        plateaus[v] /= count;
+    }
+    for( int v = 0; v < std::min( 2, nVariables ); ++v )
+        if( plateaus[v] <= 0.0 )
+            plateaus[v] = *std::max_element( lags[v].gammas.begin(), lags[v].gammas.end() );
+    double correlation = 0.0;
+    if( m_isLMC && plateaus[0] > 0.0 && plateaus[1] > 0.0 )
+        correlation = std::max( -0.9, std::min( 0.9, plateaus[2] / std::sqrt( plateaus[0] * plateaus[1] ) ) );
+
+    //a problem for each combination of structure types
+    std::vector<Problem> problems;
+    long nCombinations = 1;
+    for( int s = 0; s < m_nst; ++s )
+        nCombinations *= m_candidateTypes.size();
+    for( long c = 0; c < nCombinations; ++c ){
+        std::vector<VariogramStructureType> types;
+        for( long s = 0, code = c; s < m_nst; ++s, code /= m_candidateTypes.size() )
+            types.push_back( m_candidateTypes[ code % m_candidateTypes.size() ] );
+        problems.push_back( Problem( types, nVariables, sampledAxes, m_semiMinorRatio, m_verticalRatio,
+                                     0.1 * minDistance, 10.0 * maxDistance ) );
+    }
+
+    //all the starts run in parallel, each with its own random number generator
+    long nTasks = nCombinations * std::max( 1, m_nStarts );
+    std::vector<double> residuals( nTasks );
+    std::vector< std::vector<double> > solutions( nTasks );
+    Util::parallelFor( nTasks, [&]( long first, long last ){
+        std::vector<double> h, model;
+        for( long task = first; task < last; ++task ){
+            const Problem& problem = problems[ task / std::max( 1, m_nStarts ) ];
+            std::mt19937 generator( m_seed + 7919u * task );
+            std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+
+            //a random initial model: the plateau split among the nugget effect and the structures
+            int nst = problem.getTypes().size();
+            std::vector<double> fractions( nst + 1 );
+            fractions[0] = 0.3 * uniform( generator );
+            double sum = 0.0;
+            for( int s = 1; s <= nst; ++s ){
+                fractions[s] = 0.1 + uniform( generator );
+                sum += fractions[s];
+            }
+            for( int s = 1; s <= nst; ++s )
+                fractions[s] *= ( 1.0 - fractions[0] ) / sum;
+            if( nst == 0 )
+                fractions[0] = 1.0;
+            std::vector<double> majorRanges( nst );
+            for( int s = 0; s < nst; ++s )
+                majorRanges[s] = std::exp( std::log( minDistance ) + uniform( generator ) *
+                                           ( std::log( 1.5 * maxDistance ) - std::log( minDistance ) ) );
+            std::sort( majorRanges.begin(), majorRanges.end() );
+
+            //the start vector in the order of Problem::decode(): the nugget effect, then the variances and the
+            //ranges of each structure
+            std::vector<double> x, steps;
+            auto addVariances = [&]( double fraction ){
+                if( nVariables == 1 ){
+                    x.push_back( std::sqrt( fraction * plateaus[0] ) );
+                    steps.push_back( 0.3 * std::sqrt( plateaus[0] ) );
+                } else {
+                    double c11 = fraction * plateaus[0];
+                    double c22 = fraction * plateaus[1];
+                    double l11 = std::sqrt( c11 );
+                    double l21 = l11 > 0.0 ? correlation * std::sqrt( c11 * c22 ) / l11 : 0.0;
+                    x.push_back( l11 );
+                    x.push_back( l21 );
+                    x.push_back( std::sqrt( std::max( 0.0, c22 - l21 * l21 ) ) );
+                    steps.push_back( 0.3 * std::sqrt( plateaus[0] ) );
+                    steps.push_back( 0.3 * std::sqrt( plateaus[1] ) );
+                    steps.push_back( 0.3 * std::sqrt( plateaus[1] ) );
+                }
+            };
+            addVariances( fractions[0] );
+            for( int s = 0; s < nst; ++s ){
+                addVariances( fractions[s+1] );
+                x.push_back( std::log( majorRanges[s] ) );
+                steps.push_back( 0.5 );
+                for( int k = 1; k < 3; ++k )
+                    if( sampledAxes[k] ){
+                        x.push_back( std::log( majorRanges[s] * ( 0.3 + 0.7 * uniform( generator ) ) ) );
+                        steps.push_back( 0.5 );
+                    }
+            }
+
+            auto objective = [&]( const std::vector<double>& parameters ){
+                return problem.evaluate( parameters, lags, h, model );
+            };
+            int maxEvaluations = 500 * problem.getParameterCount();
+            residuals[task] = minimize( objective, x, steps, maxEvaluations );
+            //restarting at the minimum found gets the simplex out of premature collapses
+            for( double& step : steps )
+                step *= 0.2;
+            residuals[task] = minimize( objective, x, steps, maxEvaluations );
+            solutions[task] = x;
+        }
+    });
+
+    //keep the best model
+    long best = std::min_element( residuals.begin(), residuals.end() ) - residuals.begin();
+    const Problem& bestProblem = problems[ best / std::max( 1, m_nStarts ) ];
+    bestProblem.decode( solutions[best].data(), m_nuggets, m_contributions, m_ranges );
+    m_types = bestProblem.getTypes();
+    m_residual = residuals[best];
+
+    QString typeNames;
+    for( VariogramStructureType type : m_types )
+        typeNames += QString::number( (int)type ) + " ";
+    Application::instance()->logInfo( "VariogramFitter::fit(): best of " + QString::number( nTasks ) + " starts (" +
+                                      QString::number( nCombinations ) + " combination(s) of structure types) has types [ " +
+                                      typeNames + "] and residual " + QString::number( m_residual ) + ".  Finished in " +
+                                      QString::number( timer.elapsed() ) + "ms." );
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef VARIOGRAMFITTER_H
+#define VARIOGRAMFITTER_H
+
+#include <vector>
+#include <QtGlobal>
+#include "domain/experimentalvariogram.h"
+
+enum class VariogramStructureType : int;
+
+/**
+ * The VariogramFitter class fits a variogram model to the directional curves of one or more experimental variograms
+ * in-process by weighted least squares (the weights are the numbers of pairs of the lags).  The nugget effect, the
+ * contributions and the ranges along the axes of the anisotropy ellipsoid are fitted for each combination of the
+ * candidate structure types, starting the minimization (Nelder-Mead simplex) from several random initial models.
+ * All the starts are independent, so they run in parallel, and the model with the least residual is kept.
+ * The model values are evaluated for all lags of a candidate at once with GeostatsUtils::addGammas().
+ *
+ * Optionally, two autovariograms and their cross variogram are fitted together as a linear model of
+ * coregionalization (LMC): the structures (types, ranges and angles) are shared and the contribution matrices
+ * are parameterized by their Cholesky factors, so every candidate is positive definite and the fitted models
+ * satisfy the conditions checked by Util::isLMC().
+ */
+class VariogramFitter
+{
+public:
+    VariogramFitter();
+
+    /**
+     * Adds curves of an experimental variogram (e.g. read with ExperimentalVariogram::readCurves()).
+     * @param azimuths The azimuth of each curve (degrees, GSLib convention).
+     * @param dips The dip of each curve (degrees, GSLib convention).
+     * @param variable 0 for the variogram to fit.  For an LMC, 0 and 1 are the autovariograms and 2 is the cross
+     *        variogram.
+     */
+    void addCurves( const std::vector<ExperimentalVariogramCurve>& curves,
+                    const std::vector<double>& azimuths, const std::vector<double>& dips, int variable = 0 );
+
+    /** Sets the number of nested structures (not counting the nugget effect).  Default is 1. */
+    void setNumberOfStructures( int value ){ m_nst = value; }
+
+    /** Sets the structure types tried for each structure.  Default is spheric, exponential and gaussian.
+     *  The power model is not supported. */
+    void setCandidateTypes( const std::vector<VariogramStructureType>& types ){ m_candidateTypes = types; }
+
+    /**
+     * Sets the orientation of the anisotropy ellipsoid, which is not fitted.  The ranges along the axes not sampled
+     * by any curve (e.g. vertical with only horizontal curves) are kept proportional to the semi-major range by the
+     * given ratios.
+     */
+    void setAnisotropy( double azimuth, double dip, double roll, double semiMinorRatio, double verticalRatio );
+
+    /** Sets the number of random starts for each combination of structure types.  Default is 16. */
+    void setNumberOfStarts( int value ){ m_nStarts = value; }
+
+    void setSeed( uint value ){ m_seed = value; }
+
+    /** Sets whether the curves of the variables 0, 1 and 2 are fitted as a linear model of coregionalization. */
+    void setLinearModelOfCoregionalization( bool value ){ m_isLMC = value; }
+
+    /** Performs the fitting.  Returns false if the inputs are inconsistent. */
+    bool fit();
+
+    //@{
+    /** The fitted model.  @param variable See addCurves(). */
+    double getNugget( int variable = 0 ) const { return m_nuggets[variable]; }
+    VariogramStructureType getType( int structure ) const { return m_types[structure]; }
+    double getContribution( int structure, int variable = 0 ) const { return m_contributions[structure][variable]; }
+    double get_a_hMax( int structure ) const { return m_ranges[structure][0]; }
+    double get_a_hMin( int structure ) const { return m_ranges[structure][1]; }
+    double get_a_vert( int structure ) const { return m_ranges[structure][2]; }
+    //@}
+
+    /** The weighted sum of squared residuals of the fitted model (the variables are scaled to unit magnitude). */
+    double getResidual() const { return m_residual; }
+
+private:
+    /** The lags of a variable with their separation vectors. */
+    struct Lags {
+        std::vector<double> dx, dy, dz;
+        std::vector<double> gammas;
+        std::vector<double> weights;
+    };
+    class Problem;
+
+    Lags m_lags[3];
+    int m_nst;
+    std::vector<VariogramStructureType> m_candidateTypes;
+    double m_azimuth, m_dip, m_roll;
+    double m_semiMinorRatio, m_verticalRatio;
+    int m_nStarts;
+    uint m_seed;
+    bool m_isLMC;
+
+    double m_nuggets[3];
+    std::vector<VariogramStructureType> m_types;
+    std::vector< std::vector<double> > m_contributions;
+    std::vector< std::vector<double> > m_ranges;
+    double m_residual;
+};
+
+#endif // VARIOGRAMFITTER_H
@@ -0,0 +1,93 @@
+#include "variogrammodelcurves.h"
+
+#include "geostats/geostatsutils.h"
+#include "domain/variogrammodel.h"
+#include "util.h"
+
+#include <cmath>
+
+VariogramModelCurves::VariogramModelCurves() :
+    m_nugget( 0.0 ),
+    m_nLags( 10 ),
+    m_pointsPerLag( 1 )
+{
+}
+
+void VariogramModelCurves::addStructure(VariogramStructureType type, double contribution,
+                                        double a_hMax, double a_hMin, double a_vert,
+                                        double azimuth, double dip, double roll)
+{
+    Structure structure;
+    structure.type = type;
+    structure.contribution = contribution;
+    structure.a_hMax = a_hMax;
+    structure.anisoTransform = GeostatsUtils::getAnisoTransform( a_hMax, a_hMin, a_vert, azimuth, dip, roll );
+    m_structures.push_back( structure );
+}
+
+void VariogramModelCurves::addDirection(double azimuth, double dip, double lag)
+{
+    //the direction vector (same convention of vmodel)
+    double azimuthRad = azimuth * Util::PI_OVER_180;
+    double dipRad = dip * Util::PI_OVER_180;
+    Direction direction;
+    direction.ux = std::sin( azimuthRad ) * std::cos( dipRad );
+    direction.uy = std::cos( azimuthRad ) * std::cos( dipRad );
+    direction.uz = std::sin( dipRad );
+    direction.lag = lag;
+    m_directions.push_back( direction );
+}
+
+void VariogramModelCurves::compute()
+{
+    //the separation vectors of all points of all curves
+    long nPointsPerCurve = (long)m_nLags * m_pointsPerLag + 1;
+    long nPoints = nPointsPerCurve * m_directions.size();
+    std::vector<double> dx( nPoints ), dy( nPoints ), dz( nPoints ), distances( nPoints );
+    for( size_t iDir = 0; iDir < m_directions.size(); ++iDir ){
+        const Direction& direction = m_directions[iDir];
+        for( long iPoint = 0; iPoint < nPointsPerCurve; ++iPoint ){
+            long i = iDir * nPointsPerCurve + iPoint;
+            distances[i] = iPoint * direction.lag / m_pointsPerLag;
+            dx[i] = distances[i] * direction.ux;
+            dy[i] = distances[i] * direction.uy;
+            dz[i] = distances[i] * direction.uz;
+        }
+    }
+
+    //the nugget effect applies to all separations but zero
+    std::vector<double> gammas( nPoints );
+    for( long i = 0; i < nPoints; ++i )
+        gammas[i] = distances[i] > 0.0 ? m_nugget : 0.0;
+
+    //accumulate each structure for all points at once
+    std::vector<double> h( nPoints );
+    for( const Structure& structure : m_structures ){
+        const Matrix3X3<double>& t = structure.anisoTransform;
+        for( long i = 0; i < nPoints; ++i ){
+            double h1 = t._a11 * dx[i] + t._a12 * dy[i] + t._a13 * dz[i];
+            double h2 = t._a21 * dx[i] + t._a22 * dy[i] + t._a23 * dz[i];
+            double h3 = t._a31 * dx[i] + t._a32 * dy[i] + t._a33 * dz[i];
+            h[i] = std::sqrt( h1*h1 + h2*h2 + h3*h3 );
+        }
+        GeostatsUtils::addGammas( structure.type, h.data(), nPoints, structure.a_hMax,
+                                  structure.contribution, gammas.data() );
+    }
+
+    //split the points into the curves
+    m_distances.assign( m_directions.size(), std::vector<double>() );
+    m_gammas.assign( m_directions.size(), std::vector<double>() );
+    for( size_t iDir = 0; iDir < m_directions.size(); ++iDir ){
+        long first = iDir * nPointsPerCurve;
+        m_distances[iDir].assign( distances.begin() + first, distances.begin() + first + nPointsPerCurve );
+        m_gammas[iDir].assign( gammas.begin() + first, gammas.begin() + first + nPointsPerCurve );
+    }
+}
+
+double VariogramModelCurves::getSill() const
+{
+    double sill = m_nugget;
+    for( const Structure& structure : m_structures )
+        sill += structure.contribution;
+    return sill;
+}
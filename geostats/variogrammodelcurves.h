@@ -0,0 +1,74 @@
+#ifndef VARIOGRAMMODELCURVES_H
+#define VARIOGRAMMODELCURVES_H
+
+#include <vector>
+#include "matrix3x3.h"
+
+enum class VariogramStructureType : int;
+
+/**
+ * The VariogramModelCurves class computes the curves of a variogram model along given directions in-process, like
+ * the GSLib program vmodel, so a model can be displayed (e.g. with VariogramPlot) without writing parameter and
+ * output files nor launching a process.
+ *
+ * The separation vectors of all points of all directions are stored contiguously and each structure is evaluated
+ * for all of them at once: the vectors are transformed to the isotropic space of the structure and the variogram
+ * values are accumulated with GeostatsUtils::addGammas().  This is cheap enough to recompute the curves upon every
+ * change of the model parameters.
+ */
+class VariogramModelCurves
+{
+public:
+    VariogramModelCurves();
+
+    void setNugget( double value ){ m_nugget = value; }
+
+    /** Adds a nested structure with the same parameters of the vmodel program (angles in degrees). */
+    void addStructure( VariogramStructureType type, double contribution,
+                       double a_hMax, double a_hMin, double a_vert,
+                       double azimuth, double dip, double roll );
+
+    /** Adds a direction along which a curve is computed (angles in degrees, GSLib convention). */
+    void addDirection( double azimuth, double dip, double lag );
+
+    /** Sets the number of lags of the curves.  The curves span from zero to this times the lag of each direction. */
+    void setNumberOfLags( int value ){ m_nLags = value; }
+
+    /** Sets the number of points computed per lag.  Default is 1 (like vmodel).  More points make smoother curves. */
+    void setPointsPerLag( int value ){ m_pointsPerLag = value; }
+
+    /** Computes the curves of all directions. */
+    void compute();
+
+    int getCurveCount() const { return m_directions.size(); }
+
+    //@{
+    /** The separations and the variogram values of the curve of a direction (in order of addition). */
+    const std::vector<double>& getDistances( int curve ) const { return m_distances[curve]; }
+    const std::vector<double>& getGammas( int curve ) const { return m_gammas[curve]; }
+    //@}
+
+    /** The sill of the model (nugget effect plus all contributions). */
+    double getSill() const;
+
+private:
+    struct Structure{
+        VariogramStructureType type;
+        double contribution;
+        double a_hMax;
+        Matrix3X3<double> anisoTransform;
+    };
+    struct Direction{
+        double ux, uy, uz;
+        double lag;
+    };
+    double m_nugget;
+    std::vector<Structure> m_structures;
+    std::vector<Direction> m_directions;
+    int m_nLags;
+    int m_pointsPerLag;
+    std::vector< std::vector<double> > m_distances;
+    std::vector< std::vector<double> > m_gammas;
+};
+
+#endif // VARIOGRAMMODELCURVES_H
@@ -3,8 +3,7 @@
 #include <QDir>
 #include "../domain/application.h"
 #include <QMessageBox>
-#include <QThread>
-#include "workerthread.h"
+#include "gslibjobrunner.h"
 
 /*static*/ GSLib* GSLib::s_instance = nullptr;
 
@@ -24,15 +23,7 @@ GSLib *GSLib::instance()
 void GSLib::runProgram(const QString program_name, const QString par_file_path, bool parFromStdIn )
 {
     QProcess process;
-    QDir gslib_home = QDir(Application::instance()->getGSLibPathSetting());
-    QString gslib_program = gslib_home.filePath( program_name );
-
-    //TODO: test whether running a program with quotation marks works in Unix
-    gslib_program = QString("\"").append(gslib_program).append("\"");
-
-    QString command = gslib_program;
-    if( !parFromStdIn )
-        command.append(" \"").append( par_file_path ).append("\"");
+    QString command = makeCommand( program_name, par_file_path, parFromStdIn );
 
     process.setWorkingDirectory( Application::instance()->getGSLibPathSetting() );
 
@@ -42,27 +33,7 @@ void GSLib::runProgram(const QString program_name, const QString par_file_path,
     }
     if(! process.waitForFinished(-1) ){
         Application::instance()->logError(QString("ERROR: call to external program ").append(program_name).append(" abnormally ended."));
-        QString errorCause;
-        switch( process.error() ){
-            case QProcess::FailedToStart:
-                errorCause = "Program file is missing or you lack execution permission on it.";
-                break;
-            case QProcess::Crashed:
-                errorCause = "Program crashed.";
-                break;
-            case QProcess::Timedout:
-                errorCause = "Execution timeout.";
-                break;
-            case QProcess::WriteError:
-                errorCause = "Could not write to process' input stream.";
-                break;
-            case QProcess::ReadError:
-                errorCause = "Could not read from process' output stream.";
-                break;
-            default:
-                errorCause = "Unknown.";
-        }
-        Application::instance()->logError(QString("      Cause: ").append(errorCause));
+        Application::instance()->logError(QString("      Cause: ").append( getErrorCause( process.error() ) ));
     }
 
     m_last_output = process.readAllStandardOutput();
@@ -77,12 +48,7 @@ void GSLib::runProgramAsync(const QString program_name, const QString par_file_p
 {
     m_stderr_assync_count = 0;
     m_process = new QProcess();
-    QDir gslib_home = QDir(Application::instance()->getGSLibPathSetting());
-    QString gslib_program = gslib_home.filePath( program_name );
-
-    gslib_program = QString("\"").append(gslib_program).append("\"");
-
-    QString command = gslib_program.append(" \"").append( par_file_path ).append("\"");
+    QString command = makeCommand( program_name, par_file_path );
 
     m_last_output = "";
 
@@ -95,15 +61,42 @@ void GSLib::runProgramAsync(const QString program_name, const QString par_file_p
 
 void GSLib::runProgramThread(const QString program_name, const QString par_file_path)
 {
-    WorkerThread *workerThread = new WorkerThread( this, program_name, par_file_path );
-    connect(workerThread, SIGNAL(completed()), this, SLOT(onProgramThreadFinished()));
-    connect(workerThread, SIGNAL(finished()), workerThread, SLOT(deleteLater()));
-    m_thread_running = true;
-    workerThread->start();
-    //FIXME: this wait is actually blocking...
-    // QThread::wait() does not work too.
-    while( m_thread_running )
-        QThread::msleep( 100 );
+    GSLibJobRunner runner;
+    runner.addJob( program_name, par_file_path );
+    runner.runAndWait( "Running " + program_name + "..." );
+    m_last_output = runner.getJobOutput( 0 );
+}
+
+QString GSLib::makeCommand(const QString program_name, const QString par_file_path, bool parFromStdIn)
+{
+    QDir gslib_home = QDir(Application::instance()->getGSLibPathSetting());
+    QString gslib_program = gslib_home.filePath( program_name );
+
+    //TODO: test whether running a program with quotation marks works in Unix
+    QString command = QString("\"").append(gslib_program).append("\"");
+
+    if( !parFromStdIn )
+        command.append(" \"").append( par_file_path ).append("\"");
+
+    return command;
+}
+
+QString GSLib::getErrorCause(QProcess::ProcessError error)
+{
+    switch( error ){
+        case QProcess::FailedToStart:
+            return "Program file is missing or you lack execution permission on it.";
+        case QProcess::Crashed:
+            return "Program crashed.";
+        case QProcess::Timedout:
+            return "Execution timeout.";
+        case QProcess::WriteError:
+            return "Could not write to process' input stream.";
+        case QProcess::ReadError:
+            return "Could not read from process' output stream.";
+        default:
+            return "Unknown.";
+    }
 }
 
 QString GSLib::getLastOutput()
@@ -132,9 +125,3 @@ void GSLib::onProgramFinished(int exit_code, QProcess::ExitStatus /*exit_status*
         QMessageBox::critical( nullptr, "Errors to stderr", "GSLib program output error messages. Please, check the Output Message panel for recent messages in red.");
     emit programFinished();
 }
-
-void GSLib::onProgramThreadFinished()
-{
-    Application::instance()->logInfo( "GSLib::onProgramThreadFinished(): Program thread finished work." );
-    m_thread_running = false;
-}
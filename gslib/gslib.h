@@ -39,11 +39,20 @@ public:
      * the program to terminate or crash.  This is the preferable way to execute external programs since
      * the client thread does not block, meaning that the user can get feedback on program execution like
      * runProgramAsync() while the client code can have control on program termination like runProgram().
-     * THIS IS CURRENTLY NOT WORKING PROPERLY.
-     * Use runProgramAsync() with the programFinished() signal for asynchronous run with controlled termination.
+     * The program is run as a single-job batch of GSLibJobRunner, which processes the GUI events while waiting.
+     * To run several independent programs concurrently, use GSLibJobRunner directly.
      */
     void runProgramThread( const QString program_name, const QString par_file_path );
 
+    /**
+     * Returns the command line to start the given GSLib program with the given parameter file.
+     * @param parFromStdIn If true, the parameter file path is not added to the command line (see runProgram()).
+     */
+    static QString makeCommand( const QString program_name, const QString par_file_path, bool parFromStdIn = false );
+
+    /** Returns a user-friendly description of the cause of an abnormal termination of an external program. */
+    static QString getErrorCause( QProcess::ProcessError error );
+
     /**
      *  Returns the last output generated during the last run.
      */
@@ -53,7 +62,6 @@ private:
      GSLib();
      QProcess* m_process;
      static GSLib* s_instance;
-     bool m_thread_running;
      QString m_last_output;
      uint m_stderr_assync_count;
 
@@ -63,7 +71,6 @@ signals:
 private slots:
      void onProgramOutput();
      void onProgramFinished(int exit_code, QProcess::ExitStatus exit_status);
-     void onProgramThreadFinished( );
 };
 
 #endif // GSLIB_H
@@ -0,0 +1,257 @@
+#include "gslibjobrunner.h"
+#include "gslib.h"
+#include "domain/application.h"
+
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <algorithm>
+
+GSLibJobRunner::GSLibJobRunner(QObject *parent) : QObject(parent),
+    m_maxConcurrentJobs( Application::instance()->getMaxConcurrentGSLibJobsSetting() ),
+    m_nextJob( 0 ),
+    m_runningCount( 0 ),
+    m_finishedCount( 0 ),
+    m_started( false ),
+    m_canceled( false )
+{
+}
+
+GSLibJobRunner::~GSLibJobRunner()
+{
+    //do not leave orphan processes behind
+    for( Job& job : m_jobs ){
+        if( job.process ){
+            job.process->disconnect( this );
+            job.process->kill();
+            job.process->waitForFinished( 1000 );
+            delete job.process;
+            job.process = nullptr;
+        }
+    }
+}
+
+void GSLibJobRunner::setMaxConcurrentJobs(int value)
+{
+    m_maxConcurrentJobs = std::max( 1, value );
+}
+
+int GSLibJobRunner::addJob(const QString program_name,
+                           const QString par_file_path,
+                           const QStringList expectedOutputs,
+                           const QString description,
+                           bool parFromStdIn)
+{
+    Job job;
+    job.program = program_name;
+    job.parFilePath = par_file_path;
+    job.expectedOutputs = expectedOutputs;
+    job.description = description.isEmpty() ? program_name : description;
+    job.parFromStdIn = parFromStdIn;
+    job.status = GSLibJobStatus::QUEUED;
+    job.process = nullptr;
+    m_jobs.push_back( job );
+    return m_jobs.size() - 1;
+}
+
+void GSLibJobRunner::start()
+{
+    m_started = true;
+    m_canceled = false;
+    Application::instance()->logInfo( "GSLibJobRunner::start(): running " + QString::number( m_jobs.size() ) +
+                                      " job(s), up to " + QString::number( m_maxConcurrentJobs ) + " at a time." );
+    if( m_jobs.empty() ){
+        emit allJobsFinished();
+        return;
+    }
+    startQueuedJobs();
+}
+
+bool GSLibJobRunner::runAndWait(const QString progressText, QWidget *progressParent)
+{
+    int nJobs = m_jobs.size();
+
+    QProgressDialog progressDialog( progressParent );
+    progressDialog.setLabelText( progressText );
+    progressDialog.setMinimum( 0 );
+    progressDialog.setMaximum( nJobs );
+    progressDialog.setValue( 0 );
+    progressDialog.setMinimumDuration( 0 );
+    connect( this, SIGNAL(progress(int,int)), &progressDialog, SLOT(setValue(int)) );
+    connect( &progressDialog, SIGNAL(canceled()), this, SLOT(cancel()) );
+
+    //process GUI events until all jobs end
+    QEventLoop loop;
+    connect( this, SIGNAL(allJobsFinished()), &loop, SLOT(quit()) );
+    start();
+    if( isRunning() )
+        loop.exec();
+
+    int nFailed = getFailedJobCount();
+    if( nFailed > 0 && ! m_canceled )
+        QMessageBox::critical( progressParent, "GSLib program errors", QString::number( nFailed ) + " of " +
+                               QString::number( nJobs ) + " program run(s) failed. Please, check the Output Message "
+                               "panel for recent messages in red.");
+    return nFailed == 0 && ! m_canceled;
+}
+
+void GSLibJobRunner::cancel()
+{
+    if( ! isRunning() )
+        return;
+    m_canceled = true;
+    Application::instance()->logWarn( "GSLibJobRunner::cancel(): batch canceled by the user." );
+    //discard the queued jobs
+    while( m_nextJob < (int)m_jobs.size() ){
+        m_jobs[m_nextJob].status = GSLibJobStatus::CANCELED;
+        ++m_nextJob;
+        ++m_finishedCount;
+    }
+    emit progress( m_finishedCount, m_jobs.size() );
+    //kill the running ones (onJobFinished() will be called for them)
+    for( Job& job : m_jobs )
+        if( job.status == GSLibJobStatus::RUNNING )
+            job.process->kill();
+    if( ! isRunning() )
+        emit allJobsFinished();
+}
+
+int GSLibJobRunner::getFailedJobCount() const
+{
+    int result = 0;
+    for( const Job& job : m_jobs )
+        if( job.status == GSLibJobStatus::FAILED )
+            ++result;
+    return result;
+}
+
+void GSLibJobRunner::startQueuedJobs()
+{
+    while( m_runningCount < m_maxConcurrentJobs && m_nextJob < (int)m_jobs.size() ){
+        int jobIndex = m_nextJob++;
+        Job& job = m_jobs[jobIndex];
+
+        job.process = new QProcess();
+        job.process->setWorkingDirectory( Application::instance()->getGSLibPathSetting() );
+        connect( job.process, SIGNAL(readyReadStandardOutput()), this, SLOT(onJobOutput()) );
+        connect( job.process, SIGNAL(readyReadStandardError()), this, SLOT(onJobOutput()) );
+        connect( job.process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(onJobFinished(int,QProcess::ExitStatus)) );
+        connect( job.process, SIGNAL(error(QProcess::ProcessError)), this, SLOT(onJobError(QProcess::ProcessError)) );
+
+        job.status = GSLibJobStatus::RUNNING;
+        job.startTime = QDateTime::currentDateTime();
+        ++m_runningCount;
+        emit jobStarted( jobIndex );
+
+        job.process->start( GSLib::makeCommand( job.program, job.parFilePath, job.parFromStdIn ) );
+        if( job.parFromStdIn )
+            job.process->write( QString( job.parFilePath ).append('\n').toStdString().c_str() );
+    }
+}
+
+void GSLibJobRunner::finishJob(int jobIndex, GSLibJobStatus status)
+{
+    Job& job = m_jobs[jobIndex];
+    job.status = status;
+    job.process->deleteLater();
+    job.process = nullptr;
+    --m_runningCount;
+    ++m_finishedCount;
+
+    //the messages of each job are logged in a block
+    QString header = job.description + " (" + QString::number( jobIndex + 1 ) + "/" + QString::number( m_jobs.size() ) + "): ";
+    if( ! job.output.trimmed().isEmpty() )
+        Application::instance()->logInfo( header + "\n" + job.output );
+    if( ! job.errors.trimmed().isEmpty() )
+        Application::instance()->logError( header + "\n" + job.errors );
+    switch( status ){
+        case GSLibJobStatus::SUCCEEDED: Application::instance()->logInfo( header + "finished." ); break;
+        case GSLibJobStatus::CANCELED: Application::instance()->logWarn( header + "canceled." ); break;
+        default: Application::instance()->logError( header + "failed." );
+    }
+
+    emit jobFinished( jobIndex, status == GSLibJobStatus::SUCCEEDED );
+    emit progress( m_finishedCount, m_jobs.size() );
+
+    if( ! m_canceled )
+        startQueuedJobs();
+    if( ! isRunning() )
+        emit allJobsFinished();
+}
+
+int GSLibJobRunner::getJobIndex(QObject *process) const
+{
+    for( size_t i = 0; i < m_jobs.size(); ++i )
+        if( m_jobs[i].process == process )
+            return i;
+    return -1;
+}
+
+QStringList GSLibJobRunner::getMissingOutputs(const Job &job) const
+{
+    QStringList result;
+    //allow for coarse file system timestamps
+    QDateTime limit = job.startTime.addSecs( -2 );
+    for( const QString& path : job.expectedOutputs ){
+        QFileInfo info( path );
+        if( ! info.exists() || info.lastModified() < limit )
+            result << path;
+    }
+    return result;
+}
+
+void GSLibJobRunner::onJobOutput()
+{
+    int jobIndex = getJobIndex( sender() );
+    if( jobIndex < 0 )
+        return;
+    Job& job = m_jobs[jobIndex];
+    job.output += QString( job.process->readAllStandardOutput() );
+    job.errors += QString( job.process->readAllStandardError() );
+}
+
+void GSLibJobRunner::onJobFinished(int exit_code, QProcess::ExitStatus exit_status)
+{
+    int jobIndex = getJobIndex( sender() );
+    if( jobIndex < 0 )
+        return;
+    Job& job = m_jobs[jobIndex];
+    job.output += QString( job.process->readAllStandardOutput() );
+    job.errors += QString( job.process->readAllStandardError() );
+
+    if( m_canceled ){
+        finishJob( jobIndex, GSLibJobStatus::CANCELED );
+        return;
+    }
+
+    bool success = true;
+    if( exit_status == QProcess::CrashExit ){
+        job.errors += "\n" + GSLib::getErrorCause( QProcess::Crashed );
+        success = false;
+    } else if( exit_code != 0 ){
+        job.errors += "\nProgram terminated with exit code = " + QString::number( exit_code ) + ".";
+        success = false;
+    }
+    if( ! job.errors.trimmed().isEmpty() )
+        success = false;
+    QStringList missingOutputs = getMissingOutputs( job );
+    if( ! missingOutputs.isEmpty() ){
+        job.errors += "\nExpected output file(s) not generated: " + missingOutputs.join( ", " );
+        success = false;
+    }
+    finishJob( jobIndex, success ? GSLibJobStatus::SUCCEEDED : GSLibJobStatus::FAILED );
+}
+
+void GSLibJobRunner::onJobError(QProcess::ProcessError error)
+{
+    //the other errors are followed by the finished() signal
+    if( error != QProcess::FailedToStart )
+        return;
+    int jobIndex = getJobIndex( sender() );
+    if( jobIndex < 0 )
+        return;
+    Job& job = m_jobs[jobIndex];
+    job.errors += GSLib::getErrorCause( error );
+    finishJob( jobIndex, m_canceled ? GSLibJobStatus::CANCELED : GSLibJobStatus::FAILED );
+}
@@ -0,0 +1,138 @@
+#ifndef GSLIBJOBRUNNER_H
+#define GSLIBJOBRUNNER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QDateTime>
+#include <vector>
+
+class QWidget;
+
+/*! The states of a job in GSLibJobRunner. */
+enum class GSLibJobStatus : unsigned {
+    QUEUED = 0, /*!< Waiting for a free slot. */
+    RUNNING,    /*!< The program is running. */
+    SUCCEEDED,  /*!< The program exited normally and generated all the expected output files. */
+    FAILED,     /*!< The program failed to start, crashed, returned a non-zero exit code, wrote to stderr
+                     or did not generate some of the expected output files. */
+    CANCELED    /*!< The job was canceled before it started or was killed while running. */
+};
+
+/**
+ * The GSLibJobRunner class runs a batch of independent GSLib program calls (e.g. kt3d for several domains or
+ * gam for each realization) as concurrent processes.  At most getMaxConcurrentJobs() programs run at the same
+ * time (default is the setting in Application, which defaults to the number of processor cores), the others
+ * wait in a queue.  Unlike GSLib::runProgram(), the GUI thread is not blocked while the programs run.
+ *
+ * The output of each program is kept separately and is sent to the message panel when the program finishes,
+ * so the messages of concurrent runs are not intermingled.
+ *
+ * Typical usage:
+ * @code
+ *     GSLibJobRunner runner;
+ *     for( ... )
+ *         runner.addJob( "kt3d", parFilePath, QStringList() << outputFilePath );
+ *     if( ! runner.runAndWait( "Running kt3d..." ) )
+ *         ... //some job failed or the user canceled
+ * @endcode
+ * Client code that does not want to wait can call start() and connect to the signals.
+ */
+class GSLibJobRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit GSLibJobRunner( QObject* parent = nullptr );
+    ~GSLibJobRunner();
+
+    /** Sets the maximum number of programs running at the same time. */
+    void setMaxConcurrentJobs( int value );
+    int getMaxConcurrentJobs() const { return m_maxConcurrentJobs; }
+
+    /**
+     * Queues a program run.  Jobs must be added before calling start() or runAndWait().
+     * @param expectedOutputs Paths to files the program must generate for the job to be considered successful.
+     * @param description Text to identify the job in messages (e.g. "realization 3").  Defaults to the program name.
+     * @param parFromStdIn See GSLib::runProgram().
+     * @return The index of the job, to be used with the getters and the signals.
+     */
+    int addJob( const QString program_name,
+                const QString par_file_path,
+                const QStringList expectedOutputs = QStringList(),
+                const QString description = QString(),
+                bool parFromStdIn = false );
+
+    /** Starts running the queued jobs and returns immediately.  allJobsFinished() is emitted when all jobs end. */
+    void start();
+
+    /**
+     * Runs the queued jobs and returns when they have all finished, showing a progress dialog that also allows
+     * the user to cancel the batch.  GUI events are processed while waiting.
+     * @return True if all jobs succeeded.
+     */
+    bool runAndWait( const QString progressText = "Running GSLib programs...", QWidget* progressParent = nullptr );
+
+    /** Returns whether there are jobs queued or running after start() was called. */
+    bool isRunning() const { return m_started && m_finishedCount < (int)m_jobs.size(); }
+
+    //@{
+    /** Job information. */
+    int getJobCount() const { return m_jobs.size(); }
+    GSLibJobStatus getJobStatus( int jobIndex ) const { return m_jobs[jobIndex].status; }
+    QString getJobOutput( int jobIndex ) const { return m_jobs[jobIndex].output; }
+    int getFinishedJobCount() const { return m_finishedCount; }
+    int getFailedJobCount() const;
+    //@}
+
+public slots:
+    /** Removes the queued jobs and kills the running ones. */
+    void cancel();
+
+signals:
+    void jobStarted( int jobIndex );
+    void jobFinished( int jobIndex, bool success );
+    /** Emitted whenever a job ends. */
+    void progress( int finishedJobs, int totalJobs );
+    void allJobsFinished();
+
+private:
+    struct Job{
+        QString program;
+        QString parFilePath;
+        QStringList expectedOutputs;
+        QString description;
+        bool parFromStdIn;
+        GSLibJobStatus status;
+        QProcess* process;
+        QDateTime startTime;
+        QString output;
+        QString errors;
+    };
+    std::vector<Job> m_jobs;
+    int m_maxConcurrentJobs;
+    int m_nextJob;
+    int m_runningCount;
+    int m_finishedCount;
+    bool m_started;
+    bool m_canceled;
+
+    /** Starts queued jobs while there are free slots. */
+    void startQueuedJobs();
+
+    /** Sets the final status of a job, logs its output and starts the next ones. */
+    void finishJob( int jobIndex, GSLibJobStatus status );
+
+    /** Returns the index of the job running the given process or -1 if not found. */
+    int getJobIndex( QObject* process ) const;
+
+    /** Returns the paths of the expected outputs of the job that do not exist or were not updated by the job. */
+    QStringList getMissingOutputs( const Job& job ) const;
+
+private slots:
+    void onJobOutput();
+    void onJobFinished( int exit_code, QProcess::ExitStatus exit_status );
+    void onJobError( QProcess::ProcessError error );
+};
+
+#endif // GSLIBJOBRUNNER_H
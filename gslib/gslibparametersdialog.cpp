@@ -3,14 +3,19 @@
 #include "gslibparameterfiles/gslibparameterfile.h"
 #include "gslibparams/widgets/gslibparamwidgets.h"
 #include "../domain/application.h"
+#include "../domain/project.h"
 #include "gslibparams/gslibparrepeat.h"
 
 #include <QSettings>
+#include <QTimer>
+#include <QLineEdit>
+#include <QComboBox>
 
 GSLibParametersDialog::GSLibParametersDialog(GSLibParameterFile *gpf, QWidget *parent) :
     QDialog(parent),
     ui(new Ui::GSLibParametersDialog),
-    _gpf(gpf)
+    _gpf(gpf),
+    m_liveUpdateTimer(nullptr)
 {
     ui->setupUi(this);
 
@@ -34,6 +39,20 @@ GSLibParametersDialog::~GSLibParametersDialog()
     delete ui;
 }
 
+void GSLibParametersDialog::enableLiveUpdates()
+{
+    if( m_liveUpdateTimer )
+        return;
+    //save the current values so they can be restored if the user cancels the dialog
+    m_backupParFilePath = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
+    _gpf->save( m_backupParFilePath );
+    m_liveUpdateTimer = new QTimer( this );
+    m_liveUpdateTimer->setSingleShot( true );
+    m_liveUpdateTimer->setInterval( 300 );
+    connect( m_liveUpdateTimer, SIGNAL(timeout()), this, SLOT(onLiveUpdate()) );
+    connectEditingSignals();
+}
+
 void GSLibParametersDialog::addParamWidgets()
 {
     int cparams = this->_gpf->getParameterCount();
@@ -105,7 +124,7 @@ void GSLibParametersDialog::detachParameterWidgets()
     }
 }
 
-void GSLibParametersDialog::onDialogAccepted()
+void GSLibParametersDialog::updateParameters()
 {
     //update the GSLib parameter object with the user input values in the associated widgets.
     int cparams = this->_gpf->getParameterCount();
@@ -117,6 +136,22 @@ void GSLibParametersDialog::onDialogAccepted()
                                                append("\" are not editable or the parameter update failed.") );
         }
     }
+}
+
+void GSLibParametersDialog::connectEditingSignals()
+{
+    //the value widgets of all parameter types are made of line edits and combo boxes
+    for( QLineEdit* lineEdit : ui->frmWidgets->findChildren<QLineEdit*>() )
+        connect( lineEdit, SIGNAL(textEdited(QString)), this, SLOT(onWidgetEdited()), Qt::UniqueConnection );
+    for( QComboBox* comboBox : ui->frmWidgets->findChildren<QComboBox*>() )
+        connect( comboBox, SIGNAL(activated(int)), this, SLOT(onWidgetEdited()), Qt::UniqueConnection );
+}
+
+void GSLibParametersDialog::onDialogAccepted()
+{
+    if( m_liveUpdateTimer )
+        m_liveUpdateTimer->stop();
+    updateParameters();
     detachParameterWidgets();
     //save the dialog settings to registry/user home
     rememberSettings();
@@ -127,6 +162,24 @@ void GSLibParametersDialog::onDialogRejected()
     detachParameterWidgets();
     //save the dialog settings to registry/user home
     rememberSettings();
+    //undo the live updates
+    if( m_liveUpdateTimer ){
+        m_liveUpdateTimer->stop();
+        _gpf->setValuesFromParFile( m_backupParFilePath );
+        emit parametersUpdated();
+    }
+}
+
+void GSLibParametersDialog::onWidgetEdited()
+{
+    //restart the countdown, so the update happens when the user pauses typing
+    m_liveUpdateTimer->start();
+}
+
+void GSLibParametersDialog::onLiveUpdate()
+{
+    updateParameters();
+    emit parametersUpdated();
 }
 
 void GSLibParametersDialog::someUintWidgetValueChanged(uint value, QString parameter_name)
@@ -151,6 +204,9 @@ void GSLibParametersDialog::someUintWidgetValueChanged(uint value, QString param
                 //      values stored in the contained GSLibPar* objects, so any values entered by the
                 //      user will be lost if one changes the repeat count
                 rep_par->getWidget();
+                //the widgets of the new repeats must also trigger the live updates
+                if( m_liveUpdateTimer )
+                    connectEditingSignals();
             }
         }
     }
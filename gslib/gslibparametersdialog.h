@@ -8,6 +8,7 @@ class GSLibParametersDialog;
 }
 
 class GSLibParameterFile;
+class QTimer;
 
 class GSLibParametersDialog : public QDialog
 {
@@ -22,9 +23,24 @@ public:
     explicit GSLibParametersDialog(GSLibParameterFile *gpf, QWidget *parent = 0);
     ~GSLibParametersDialog();
 
+    /**
+     * Makes the dialog update the GSLib parameter object and emit parametersUpdated() shortly after the user edits
+     * any value, so client code can preview the results while the parameters are edited (e.g. redraw a variogram
+     * model).  If the dialog is cancelled, the values the parameter object had when this was called are restored.
+     */
+    void enableLiveUpdates();
+
+signals:
+    /** Emitted when the parameter object was updated with the values being edited (see enableLiveUpdates()). */
+    void parametersUpdated();
+
 private:
     Ui::GSLibParametersDialog *ui;
     GSLibParameterFile *_gpf;
+    /** Delays the live updates until the user pauses typing. Null if live updates are not enabled. */
+    QTimer *m_liveUpdateTimer;
+    /** Parameter file with the values to restore if the dialog is cancelled while in live update mode. */
+    QString m_backupParFilePath;
 
     /** Internal method called to build the GUI according to the GSLibParameterFile object
      * passed in the constructor.
@@ -53,6 +69,13 @@ private:
     */
     void detachParameterWidgets();
 
+    /** Updates the parameter object with the values in the widgets. */
+    void updateParameters();
+
+    /** Connects the editing signals of the value widgets to onWidgetEdited() for the live updates.
+     *  This must be called again when widgets are recreated (e.g. when a repeat count changes). */
+    void connectEditingSignals();
+
 private slots:
     void onDialogAccepted();
     void onDialogRejected();
@@ -65,6 +88,8 @@ private slots:
      *  parameter file template.
      */
     void someUintWidgetValueChanged( uint value, QString parameter_name );
+    void onWidgetEdited();
+    void onLiveUpdate();
 };
 
 #endif // GSLIBPARAMETERSDIALOG_H
@@ -26,6 +26,7 @@
 #include <QModelIndexList>
 #include <typeinfo>
 #include <cmath>
+#include <limits>
 #include "domain/projectcomponent.h"
 #include "domain/file.h"
 #include "dialogs/filecontentsdialog.h"
@@ -38,6 +39,8 @@
 #include "gslib/gslibparametersdialog.h"
 #include "dialogs/variogramanalysisdialog.h"
 #include "dialogs/declusteringdialog.h"
+#include "dialogs/distributionplotdialog.h"
+#include "dialogs/calculatordialog.h"
 #include <QDesktopServices>
 #include <QInputDialog>
 #include <QLineEdit>
@@ -50,6 +53,8 @@
 #include "domain/categorypdf.h"
 #include "util.h"
 #include "dialogs/nscoredialog.h"
+#include "geostats/normalscoretransform.h"
+#include "geostats/gridpointsampler.h"
 #include "dialogs/distributionmodelingdialog.h"
 #include "dialogs/bidistributionmodelingdialog.h"
 #include "dialogs/valuespairsdialog.h"
@@ -60,6 +65,7 @@
 #include "dialogs/cokrigingdialog.h"
 #include "dialogs/multivariogramdialog.h"
 #include "dialogs/sgsimdialog.h"
+#include "dialogs/variogramplotdialog.h"
 #include "viewer3d/view3dwidget.h"
 #include "imagejockey/imagejockeydialog.h"
 
@@ -427,10 +433,12 @@ void MainWindow::onProjectContextMenu(const QPoint &mouse_location)
             if( _right_clicked_file->getFileType() == "POINTSET" ){
                 _projectContextMenu->addAction("Create estimation/simulation grid...", this, SLOT(onCreateGrid()));
                 _projectContextMenu->addAction("Look for duplicate/close samples", this, SLOT(onLookForDuplicates()));
+                _projectContextMenu->addAction("Calculator...", this, SLOT(onCalculator()));
             }
             if( _right_clicked_file->getFileType() == "CARTESIANGRID" ){
                 _projectContextMenu->addAction("Convert to point set", this, SLOT(onAddCoord()));
                 _projectContextMenu->addAction("Resample", this, SLOT(onResampleGrid()));
+                _projectContextMenu->addAction("Calculator...", this, SLOT(onCalculator()));
             }
             if( _right_clicked_file->getFileType() == "CATEGORYDEFINITION" ){
                 _projectContextMenu->addAction("Create category p.d.f. ...", this, SLOT(onCreateCategoryPDF()));
@@ -458,6 +466,8 @@ void MainWindow::onProjectContextMenu(const QPoint &mouse_location)
                 _projectContextMenu->addAction("Probability plot", this, SLOT(onProbPlt()));
                 _projectContextMenu->addAction("Variogram analysis...", this, SLOT(onVariogramAnalysis()));
                 _projectContextMenu->addAction("Normal score...", this, SLOT(onNScore()));
+                if( ((DataFile*)parent_file)->isNormal( _right_clicked_attribute ) )
+                    _projectContextMenu->addAction("Back transform...", this, SLOT(onBackTransform()));
                 _projectContextMenu->addAction("Model a distribution...", this, SLOT(onDistrModel()));
             }
             if( parent_file->getFileType().compare("POINTSET") == 0 ){
@@ -700,162 +710,17 @@ void MainWindow::onPixelPlt()
 
 void MainWindow::onProbPlt()
 {
-    //get input data file
-    DataFile* input_data_file = (DataFile*)_right_clicked_attribute->getContainingFile();
-
-    //load file data.
-    input_data_file->loadData();
-
-    //get the variable index in parent data file
-    uint var_index = input_data_file->getFieldGEOEASIndex( _right_clicked_attribute->getName() );
-
-    //make plot/window title
-    QString title = _right_clicked_attribute->getContainingFile()->getName();
-    title.append("/");
-    title.append(_right_clicked_attribute->getName());
-    title.append(" probability plot");
-
-    //Construct an object composition based on the parameter file template for the probplt program.
-    GSLibParameterFile gpf( "probplt" );
-
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf.setDefaultValues();
-
-    //get the maximum and minimun of selected variable with some tolerance,
-    //excluding no-data values
-    double data_min = input_data_file->min( var_index - 1 );
-    double data_max = input_data_file->max( var_index - 1 );
-    data_min -= fabs( data_min / 100.0 );
-    data_max += fabs( data_max / 100.0 );
-
-    //---------------------set the parameters-----------------------------
-
-    //set the input data
-    GSLibParInputData* par0;
-    par0 = gpf.getParameter<GSLibParInputData*>(0);
-    par0->_file_with_data._path = input_data_file->getPath();
-    par0->_trimming_limits._max = data_max;
-    par0->_trimming_limits._min = data_min;
-    par0->_var_wgt_pairs.first()->_var_index = var_index;
-
-    //set the output PS file
-    gpf.getParameter<GSLibParFile*>(1)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //set the scale
-    GSLibParMultiValuedFixed *par4 = gpf.getParameter<GSLibParMultiValuedFixed*>(4);
-    par4->getParameter<GSLibParDouble*>(0)->_value = data_min;
-    par4->getParameter<GSLibParDouble*>(1)->_value = data_max;
-    par4->getParameter<GSLibParDouble*>(2)->_value = fabs( data_max - data_min ) / 10.0;
-
-    //set the plot title
-    gpf.getParameter<GSLibParString*>(5)->_value = title;
-    //----------------------------------------------------------------------------------
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run probplt program
-    Application::instance()->logInfo("Starting probplt program...");
-    GSLib::instance()->runProgram( "probplt", par_file_path );
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(1)->_path, title, gpf, this);
-    dpd->show(); //show() makes dialog modalless
+    DistributionPlotDialog* dpd = new DistributionPlotDialog( _right_clicked_attribute,
+                                                              DistributionPlotType::PROBABILITY, this );
+    dpd->show();
 }
 
 void MainWindow::onQpplt()
 {
-    //get input data files
-    DataFile* input_data_fileX = (DataFile*)_right_clicked_attribute->getContainingFile();
-    DataFile* input_data_fileY = (DataFile*)_right_clicked_attribute2->getContainingFile();
-
-    //load file2 data.
-    input_data_fileX->loadData();
-    input_data_fileY->loadData();
-
-    //get the variable indexes in parent data files
-    uint var_indexX = input_data_fileX->getFieldGEOEASIndex( _right_clicked_attribute->getName() );
-    uint var_indexY = input_data_fileY->getFieldGEOEASIndex( _right_clicked_attribute2->getName() );
-
-    //make plot/window title
-    QString title = "Q-Q/P-P plot ";
-    title.append( input_data_fileX->getName() );
-    title.append(" X ");
-    title.append( input_data_fileY->getName() );
-    title.append("(" + _right_clicked_attribute->getName() + ")"); //assumes the variable is the same in both files
-
-    //Construct an object composition based on the parameter file template for the qpplt program.
-    GSLibParameterFile gpf( "qpplt" );
-
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf.setDefaultValues();
-
-    //get the maximum and minimun of selected variables with some tolerance,
-    //excluding no-data values
-    double data_minX = input_data_fileX->min( var_indexX - 1 );
-    double data_maxX = input_data_fileX->max( var_indexX - 1 );
-    data_minX -= fabs( data_minX / 100.0 );
-    data_maxX += fabs( data_maxX / 100.0 );
-    double data_minY = input_data_fileY->min( var_indexY - 1 );
-    double data_maxY = input_data_fileY->max( var_indexY - 1 );
-    data_minY -= fabs( data_minY / 100.0 );
-    data_maxY += fabs( data_maxY / 100.0 );
-
-    //---------------------set the parameters-----------------------------
-
-    //set the first input file
-    gpf.getParameter<GSLibParFile*>(0)->_path = input_data_fileX->getPath();
-
-    //set the GEO-EAS index of first variable
-    GSLibParMultiValuedFixed *par1 = gpf.getParameter<GSLibParMultiValuedFixed*>(1);
-    par1->getParameter<GSLibParUInt*>(0)->_value = var_indexX;
-    par1->getParameter<GSLibParUInt*>(1)->_value = 0;
-
-    //set the second input file
-    gpf.getParameter<GSLibParFile*>(2)->_path = input_data_fileY->getPath();
-
-    //set the GEO-EAS index of second variable
-    GSLibParMultiValuedFixed *par3 = gpf.getParameter<GSLibParMultiValuedFixed*>(3);
-    par3->getParameter<GSLibParUInt*>(0)->_value = var_indexY;
-    par3->getParameter<GSLibParUInt*>(1)->_value = 0;
-
-    //set the trimming limits
-    GSLibParMultiValuedFixed *par4 = gpf.getParameter<GSLibParMultiValuedFixed*>(4);
-    par4->getParameter<GSLibParDouble*>(0)->_value = ( data_minX < data_minY ? data_minX : data_minY );
-    par4->getParameter<GSLibParDouble*>(1)->_value = ( data_maxX > data_maxY ? data_maxX : data_maxY );
-
-    //set the output PostScript file
-    gpf.getParameter<GSLibParFile*>(5)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //set the X axis range
-    GSLibParMultiValuedFixed *par8 = gpf.getParameter<GSLibParMultiValuedFixed*>(8);
-    par8->getParameter<GSLibParDouble*>(0)->_value = data_minX;
-    par8->getParameter<GSLibParDouble*>(1)->_value = data_maxX;
-
-    //set the Y axis range
-    GSLibParMultiValuedFixed *par9 = gpf.getParameter<GSLibParMultiValuedFixed*>(9);
-    par9->getParameter<GSLibParDouble*>(0)->_value = data_minY;
-    par9->getParameter<GSLibParDouble*>(1)->_value = data_maxY;
-
-    //set the plot title
-    gpf.getParameter<GSLibParString*>(11)->_value = title;
-
-    //----------------------------------------------------------------------------------
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run qpplt program
-    Application::instance()->logInfo("Starting qpplt program...");
-    GSLib::instance()->runProgram( "qpplt", par_file_path );
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(5)->_path, title, gpf, this);
-    dpd->show(); //show() makes dialog modalless
+    DistributionPlotDialog* dpd = new DistributionPlotDialog( _right_clicked_attribute,
+                                                              _right_clicked_attribute2,
+                                                              DistributionPlotType::QQ, this );
+    dpd->show();
 }
 
 
@@ -908,54 +773,23 @@ void MainWindow::onGetPoints()
     PointSet* point_set = _right_clicked_point_set;
     CartesianGrid* cg_grid = _right_clicked_cartesian_grid;
 
-    //load grid data
-    cg_grid->loadData();
-
-    //create the GSLib parameter object
-    GSLibParameterFile gpf( "getpoints" );
-
-    //the grid file
-    gpf.getParameter<GSLibParFile*>(0)->_path = cg_grid->getPath();
-
-    //the grid geometry
-    GSLibParMultiValuedFixed* par1;
-    par1 = gpf.getParameter<GSLibParMultiValuedFixed*>(1);
-    par1->getParameter<GSLibParUInt*>(0)->_value = cg_grid->getNX();
-    par1->getParameter<GSLibParDouble*>(1)->_value = cg_grid->getX0();
-    par1->getParameter<GSLibParDouble*>(2)->_value = cg_grid->getDX();
-    GSLibParMultiValuedFixed* par2;
-    par2 = gpf.getParameter<GSLibParMultiValuedFixed*>(2);
-    par2->getParameter<GSLibParUInt*>(0)->_value = cg_grid->getNY();
-    par2->getParameter<GSLibParDouble*>(1)->_value = cg_grid->getY0();
-    par2->getParameter<GSLibParDouble*>(2)->_value = cg_grid->getDY();
-
-    //the point set file
-    gpf.getParameter<GSLibParFile*>(3)->_path = point_set->getPath();
-
-    //columns for X and Y
-    GSLibParMultiValuedFixed* par4;
-    par4 = gpf.getParameter<GSLibParMultiValuedFixed*>(4);
-    par4->getParameter<GSLibParUInt*>(0)->_value = point_set->getXindex();
-    par4->getParameter<GSLibParUInt*>(1)->_value = point_set->getYindex();
-
-    //the output file
-    gpf.getParameter<GSLibParFile*>(5)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("out");
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run getpoints program
-    Application::instance()->logInfo("Starting getpoints program...");
-    GSLib::instance()->runProgram( "getpoints", par_file_path );
-    Application::instance()->logInfo("getpoints completed.");
-
-    //call rename to trim trailing spaces that getpoints leaves in varable names
-    Util::renameGEOEASvariable( gpf.getParameter<GSLibParFile*>(5)->_path, "aaaaaaaaaaa", "aaaaaaaaaaa");
+    //ask how the grid values are taken at the points
+    QStringList options;
+    options << "Nearest (value of the cell containing the point)"
+            << "Trilinear (interpolated from the surrounding cell centers)";
+    bool ok;
+    QString option = QInputDialog::getItem( this, "Transfer collocated values", "Grid values at the points:", options, 0, false, &ok );
+    if( ! ok )
+        return;
 
-    //update the point set file with the new file with the collocated variables transfered
-    //from the cartesian grid.
-    point_set->replacePhysicalFile( gpf.getParameter<GSLibParFile*>(5)->_path );
+    //take the values of all grid variables at the points in parallel and append them in one batch
+    GridPointSampler sampler( cg_grid, point_set );
+    sampler.setMode( option == options[1] ? GridSamplingMode::TRILINEAR : GridSamplingMode::NEAREST );
+    sampler.run();
+    sampler.appendToPointSet();
+    if( sampler.getOutsideCount() > 0 )
+        Application::instance()->logWarn( "MainWindow::onGetPoints(): " + QString::number( sampler.getOutsideCount() ) +
+                                          " point(s) outside the grid got no-data values." );
 }
 
 void MainWindow::onNScore()
@@ -966,6 +800,54 @@ void MainWindow::onNScore()
     nsd->show();
 }
 
+void MainWindow::onBackTransform()
+{
+    DataFile* data_file = (DataFile*)_right_clicked_attribute->getContainingFile();
+
+    //load the transform table saved along with the normal score variable
+    QString trn_path = Application::instance()->getProject()->getPath() + "/" +
+                       data_file->getTransformTableOfNScoreVar( _right_clicked_attribute );
+    NormalScoreTransform transform;
+    if( ! transform.loadTable( trn_path ) ){
+        QMessageBox::critical( this, "Error", "Could not read the transform table " + trn_path + "." );
+        return;
+    }
+
+    //ask for the tail extrapolation option
+    QStringList options;
+    options << "Constant (extreme values of the transform table)"
+            << "Linear to the data limits extended by 1%"
+            << "Linear lower tail, hyperbolic upper tail (omega = 1.5)";
+    bool ok;
+    QString option = QInputDialog::getItem( this, "Back transform", "Extrapolation of the tails:", options, 0, false, &ok );
+    if( ! ok )
+        return;
+    double zmin = transform.getTableValues().front();
+    double zmax = transform.getTableValues().back();
+    if( option == options[1] || option == options[2] )
+        transform.setLowerTail( NormalScoreTail::LINEAR, zmin - std::fabs( zmin / 100.0 ) );
+    if( option == options[1] )
+        transform.setUpperTail( NormalScoreTail::LINEAR, zmax + std::fabs( zmax / 100.0 ) );
+    if( option == options[2] )
+        transform.setUpperTail( NormalScoreTail::HYPERBOLIC, std::numeric_limits<double>::max(), 1.5 );
+
+    //propose a name for the back transformed variable
+    QString proposed_name = _right_clicked_attribute->getName() + "_bt";
+    Attribute* original_variable = data_file->getVariableOfNScoreVar( _right_clicked_attribute );
+    if( original_variable )
+        proposed_name = original_variable->getName() + "_bt";
+    proposed_name = QInputDialog::getText( this, "Name the back transformed variable", "New variable name:",
+                                           QLineEdit::Normal, proposed_name, &ok );
+    if( ! ok || proposed_name.isEmpty() )
+        return;
+
+    //back transform in parallel and append the result to the data file
+    NewGEOEASColumn column;
+    column.values = transform.backTransform( _right_clicked_attribute );
+    column.name = proposed_name;
+    data_file->addGEOEASColumns( { column } );
+}
+
 void MainWindow::onDisplayPlot()
 {
     //display the plot output
@@ -1071,41 +953,18 @@ void MainWindow::onAddCoord()
                                              proposed_name, &ok);
     if(!ok) return;
 
-    //construct a parameter file for the addcoord program
-    GSLibParameterFile gpf( "addcoord" );
-
-    //input file
-    GSLibParFile* par0 = gpf.getParameter<GSLibParFile*>( 0 );
-    par0->_path = cg->getPath();
-
-    //output file (temporary)
-    GSLibParFile* par1 = gpf.getParameter<GSLibParFile*>( 1 );
-    par1->_path = Application::instance()->getProject()->generateUniqueTmpFilePath( "xyz" );
-
-    //realization number
-    GSLibParUInt* par2 = gpf.getParameter<GSLibParUInt*>( 2 );
-    par2->_value = realNumber;
-
-    //grid parameters
-    GSLibParGrid* par3 = gpf.getParameter<GSLibParGrid*>( 3 );
-    par3->setFromCG( cg );
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run addcoord program
-    Application::instance()->logInfo("Starting addcoord program...");
-    GSLib::instance()->runProgram( "addcoord", par_file_path );
-    Application::instance()->logInfo("addcoord completed.");
+    //write the realization with the cell center coordinates to a temporary point set file (in-process addcoord)
+    QString tmpPSpath = Application::instance()->getProject()->generateUniqueTmpFilePath( "xyz" );
+    if( ! cg->writeRealizationAsPointSet( realNumber - 1, tmpPSpath ) )
+        return;
 
     //rename the output point set file
-    QString newPSpath = Util::renameFile( par1->_path, new_name );
+    QString newPSpath = Util::renameFile( tmpPSpath, new_name );
 
-    //make the point set object from the temporary point set file created by addcoord
+    //make the point set object from the temporary point set file
     PointSet *ps = new PointSet( newPSpath );
 
-    //addcoord always adds the X,Y,Z fields as 1st, 2nd and 3rd variables in the data file
+    //the X,Y,Z fields are always the 1st, 2nd and 3rd variables in the data file
     //the ndv value is the same as the original Cartesian grid.
     ps->setInfo( 1, 2, 3, cg->getNoDataValue() );
 
@@ -1206,7 +1065,7 @@ void MainWindow::onLookForDuplicates()
         PointSet* ps = (PointSet*)_right_clicked_file;
         SpatialIndexPoints::fill( ps, tolerance );
         uint totFileDataLines = ps->getDataLineCount();
-        uint headerLineCount = Util::getHeaderLineCount( ps->getPath() );
+        uint headerLineCount = ps->getHeaderLineCount();
         Application::instance()->logInfo( "=======BEGIN OF REPORT============" );
         QStringList messages;
         for( uint iFileDataLine = 0; iFileDataLine < totFileDataLines; ++iFileDataLine){
@@ -1356,6 +1215,12 @@ void MainWindow::onNDVEstimation()
     ndved->show();
 }
 
+void MainWindow::onCalculator()
+{
+    CalculatorDialog* cd = new CalculatorDialog( (DataFile*)_right_clicked_file, this );
+    cd->show();
+}
+
 void MainWindow::onResampleGrid()
 {
     //========================user input part===============================
@@ -1414,10 +1279,10 @@ void MainWindow::onResampleGrid()
     new_cg->setCellGeometry( newNI, newNJ, newNK, dx, dy, dz );
 
     //get the file's data GEO-EAS column names
-    QStringList colNames = Util::getFieldNames( cg->getPath() );
+    QStringList colNames = cg->getFieldNames();
 
     //get the file's GEO-EAS description (first text line)
-    QString fileDescription = Util::getGEOEAScomment( cg->getPath() );
+    QString fileDescription = cg->getFileDescription();
 
     //save the results in the project's tmp directory
     Util::createGEOEASGridFile(fileDescription, colNames.toVector().toStdVector(), resampledData, tmp_file_path);
@@ -1440,8 +1305,6 @@ void MainWindow::onHistpltsim()
     //get realizations attribute and attribute with reference distribution (if any)
     Attribute* realizationsAttribute = nullptr;
     Attribute* refDistAttribute = nullptr;
-    CartesianGrid* grid = nullptr;
-    PointSet* pointSet = nullptr;
     if( _right_clicked_attribute &&
         _right_clicked_attribute->getContainingFile()->getFileType() == "CARTESIANGRID" ){
         realizationsAttribute = _right_clicked_attribute;
@@ -1451,100 +1314,9 @@ void MainWindow::onHistpltsim()
         refDistAttribute = _right_clicked_attribute;
     }
 
-    //get the files
-    grid = (CartesianGrid*)realizationsAttribute->getContainingFile();
-    if( refDistAttribute )
-        pointSet = (PointSet*)refDistAttribute->getContainingFile();
-
-    //load the data in grid
-    grid->loadData();
-
-    //get the maximum and minimun of selected variable, excluding no-data value
-    double data_min = grid->min( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
-    double data_max = grid->max( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
-    data_min -= std::fabs( data_min / 100.0 );
-    data_max += std::fabs( data_max / 100.0 );
-
-    //------------------------------parameters setting--------------------------------------
-
-    GSLibParameterFile gpf( "histpltsim" );
-
-    //Set default values so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf.setDefaultValues();
-
-    GSLibParMultiValuedFixed* par3 = gpf.getParameter<GSLibParMultiValuedFixed*>(3);
-    if( refDistAttribute ){
-        //file with reference distribution
-        gpf.getParameter<GSLibParFile*>(2)->_path = pointSet->getPath();
-        //   columns for reference variable and weight
-        par3->getParameter<GSLibParUInt*>(0)->_value = refDistAttribute->getAttributeGEOEASgivenIndex();
-        par3->getParameter<GSLibParUInt*>(1)->_value = 0;
-    } else{
-        gpf.getParameter<GSLibParFile*>(2)->_path = "NOFILE";
-        par3->getParameter<GSLibParUInt*>(0)->_value = 0;
-        par3->getParameter<GSLibParUInt*>(1)->_value = 0;
-    }
-
-    //file with distributions to check
-    gpf.getParameter<GSLibParFile*>(4)->_path = grid->getPath();
-
-    //   columns for variable and weight
-    GSLibParMultiValuedFixed* par5 = gpf.getParameter<GSLibParMultiValuedFixed*>(5);
-    par5->getParameter<GSLibParUInt*>(0)->_value = realizationsAttribute->getAttributeGEOEASgivenIndex();
-    par5->getParameter<GSLibParUInt*>(1)->_value = 0;
-
-    //   start and finish histograms (usually 1 and nreal)
-    GSLibParMultiValuedFixed* par7 = gpf.getParameter<GSLibParMultiValuedFixed*>(7);
-    par7->getParameter<GSLibParUInt*>(0)->_value = 1;
-    par7->getParameter<GSLibParUInt*>(1)->_value = grid->getNReal();
-
-    //   nx, ny, nz
-    GSLibParMultiValuedFixed* par8 = gpf.getParameter<GSLibParMultiValuedFixed*>(8);
-    par8->getParameter<GSLibParUInt*>(0)->_value = grid->getNX();
-    par8->getParameter<GSLibParUInt*>(1)->_value = grid->getNY();
-    par8->getParameter<GSLibParUInt*>(2)->_value = grid->getNZ();
-
-    //   trimming limits
-    GSLibParMultiValuedFixed* par9 = gpf.getParameter<GSLibParMultiValuedFixed*>(9);
-    par9->getParameter<GSLibParDouble*>(0)->_value = data_min;
-    par9->getParameter<GSLibParDouble*>(1)->_value = data_max;
-
-    //file for PostScript output
-    gpf.getParameter<GSLibParFile*>(10)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //file for summary output (always used)
-    gpf.getParameter<GSLibParFile*>(11)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("txt");
-
-    //file for numeric output (used if flag set above)
-    gpf.getParameter<GSLibParFile*>(12)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("dat");;
-
-    //attribute minimum and maximum
-    GSLibParMultiValuedFixed* par13 = gpf.getParameter<GSLibParMultiValuedFixed*>(13);
-    par13->getParameter<GSLibParDouble*>(0)->_value = data_min;
-    par13->getParameter<GSLibParDouble*>(1)->_value = data_max;
-
-    //title
-    QString title = grid->getName() + "/" +
-            realizationsAttribute->getName() + ": realizations";
-    gpf.getParameter<GSLibParString*>(18)->_value = title;
-
-    //reference value for box plot
-    gpf.getParameter<GSLibParDouble*>(20)->_value = grid->mean( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
-
-    //----------------------------------------------------------------------------------
-
-    //Generate the parameter file
-    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-    gpf.save( par_file_path );
-
-    //run histpltsim program
-    Application::instance()->logInfo("Starting histpltsim program...");
-    GSLib::instance()->runProgram( "histpltsim", par_file_path );
-
-    //display the plot output
-    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(10)->_path, title, gpf, this);
-    dpd->show(); //show() makes dialog modalless
+    DistributionPlotDialog* dpd = new DistributionPlotDialog( realizationsAttribute, refDistAttribute,
+                                                              DistributionPlotType::REALIZATIONS, this );
+    dpd->show();
 }
 
 void MainWindow::onRFFT()
@@ -1683,99 +1455,20 @@ void MainWindow::createOrReviewVariogramModel(VariogramModel *vm)
         gpf_vmodel.setDefaultValues();
     }
 
-    //always generates a temp file path for the .var file for display with vargplt program
-    //independently of what might have been saved to the vmodel par file
-    gpf_vmodel.getParameter<GSLibParFile*>(0)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("out");
-
-    //creates a parameter object for the vargplt program
-    GSLibParameterFile gpf_vargplt( "vargplt" );
-
-    //Set default values for vargplt so we need to change less parameters and let
-    //the user change the others as one may see fit.
-    gpf_vargplt.setDefaultValues();
-
-    //----------------prepare the vargplt parameter file values for plotting-------------------
-    //get the number of curves to be displayed from the vmodel parameter file
-    GSLibParMultiValuedFixed *par1 = gpf_vmodel.getParameter<GSLibParMultiValuedFixed*>(1);
-    uint ncurves_models = par1->getParameter<GSLibParUInt*>(0)->_value;
-
-    //get the output file of the vmodel program
-    QString vmodel_output_file = gpf_vmodel.getParameter<GSLibParFile*>(0)->_path;
-
-    //make plot/window title
-    QString title("Variogram Model" + title_complement );
-
-    //postscript file
-    gpf_vargplt.getParameter<GSLibParFile*>(0)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
-
-    //suggest number of curves based on the variogram model parameters
-    gpf_vargplt.getParameter<GSLibParUInt*>(1)->_value = ncurves_models; // nvarios
-
-    //plot title
-    gpf_vargplt.getParameter<GSLibParString*>(5)->_value = title;
-
-    //suggest display settings for each variogram curve
-    GSLibParRepeat *par6 = gpf_vargplt.getParameter<GSLibParRepeat*>(6); //repeat ndir-times
-    par6->setCount( ncurves_models );
-    //set display seetings for each curve
-    for(uint i = 0; i < ncurves_models; ++i)
-    {
-        par6->getParameter<GSLibParFile*>(i, 0)->_path = vmodel_output_file;
-        GSLibParMultiValuedFixed *par6_0_1 = par6->getParameter<GSLibParMultiValuedFixed*>(i, 1);
-        par6_0_1->getParameter<GSLibParUInt*>(0)->_value = i + 1;
-        par6_0_1->getParameter<GSLibParUInt*>(1)->_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(2)->_selected_value = 0;
-        par6_0_1->getParameter<GSLibParOption*>(3)->_selected_value = 1;
-        par6_0_1->getParameter<GSLibParColor*>(4)->_color_code = (i % 15) + 1; //cycle through the available colors (except the gray tones)
-    }
-
-    //this loop allows parameter adjustment cycles
-    while( true ){
-
-        //show the parameter dialog so the user can review and adjust other settings before running vmodel
-        GSLibParametersDialog *gslibpardiag = new GSLibParametersDialog( &gpf_vmodel );
-        int result = gslibpardiag->exec();
+    //the model curves are computed in-process and redrawn while the parameters are edited
+    VariogramPlotDialog *vpd = new VariogramPlotDialog( "Variogram Model" + title_complement, this );
+    vpd->setVariogramModel( &gpf_vmodel );
+    vpd->show();
 
-        //aborts functionality if user clicks "Cancel" or presses "ESC" in the dialog
-        if( result != QDialog::Accepted )
-            return;
+    //show the parameter dialog so the user can review and adjust the model
+    GSLibParametersDialog gslibpardiag( &gpf_vmodel, this );
+    gslibpardiag.enableLiveUpdates();
+    connect( &gslibpardiag, SIGNAL(parametersUpdated()), vpd, SLOT(onVariogramModelChanged()) );
 
-        //the user may have changed the number of variogram curves in vmodel parameters
-        //so it is necessary to update the vargplt parameters accordingly
-        GSLibParMultiValuedFixed *par1 = gpf_vmodel.getParameter<GSLibParMultiValuedFixed*>(1);
-        ncurves_models = par1->getParameter<GSLibParUInt*>(0)->_value;
-        gpf_vargplt.getParameter<GSLibParUInt*>(1)->_value = ncurves_models; // nvarios
-        GSLibParRepeat *par6 = gpf_vargplt.getParameter<GSLibParRepeat*>(6); //repeat ndir-times
-        par6->setCount( ncurves_models );
-
-        //Generate the parameter file for vmodel program
-        QString vmodel_par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-        gpf_vmodel.save( vmodel_par_file_path );
-
-        //run vmodel program
-        Application::instance()->logInfo("Starting vmodel program...");
-        GSLib::instance()->runProgram( "vmodel", vmodel_par_file_path );
-
-        //----------------------display plot------------------------------------------------------------
-
-        //Generate the parameter file for vargplt program
-        QString vargplt_par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
-        gpf_vargplt.save( vargplt_par_file_path );
-
-        //run vargplt program
-        Application::instance()->logInfo("Starting vargplt program...");
-        GSLib::instance()->runProgram( "vargplt", vargplt_par_file_path );
-
-        //display the plot output
-        DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf_vargplt.getParameter<GSLibParFile*>(0)->_path,
-                                                       gpf_vargplt.getParameter<GSLibParString*>(5)->_value,
-                                                       gpf_vargplt,
-                                                       this);
-        result = dpd->exec();
-
-        //ends the modeling loop if user clicks "OK" in the dialog
-        if( result == QDialog::Accepted )
-            break;
+    //aborts functionality if user clicks "Cancel" or presses "ESC" in the dialog
+    if( gslibpardiag.exec() != QDialog::Accepted ){
+        vpd->close();
+        return;
     }
 
     if( vm ){ //user is reviewing a model
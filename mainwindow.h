@@ -122,6 +122,7 @@ private slots:
     void onSetNDV();
     void onGetPoints( );
     void onNScore();
+    void onBackTransform();
     void onDisplayPlot();
     void onDisplayExperimentalVariogram();
     void onFitVModelToExperimentalVariogram();
@@ -147,6 +148,7 @@ private slots:
     void onFreeLoadedData();
     void onFFT();
     void onNDVEstimation();
+    void onCalculator();
     void onResampleGrid();
     void onMultiVariogram();
     void onHistpltsim();
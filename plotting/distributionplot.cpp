@@ -0,0 +1,377 @@
+#include "distributionplot.h"
+
+#include <qwt_plot_grid.h>
+#include <qwt_plot_curve.h>
+#include <qwt_plot_histogram.h>
+#include <qwt_plot_layout.h>
+#include <qwt_plot_marker.h>
+#include <qwt_scale_draw.h>
+#include <qwt_scale_engine.h>
+#include <qwt_scale_widget.h>
+#include <qwt_symbol.h>
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include "geostats/univariatestatistics.h"
+#include "geostats/geostatsutils.h"
+
+namespace {
+
+    /** Maximum number of points drawn in probability plots.  Beyond this, the sorted values are
+     * sampled at regular intervals (the extreme values are always drawn), which is visually identical
+     * and keeps the plot responsive with millions of data values.
+     */
+    const long MAX_PLOTTED_POINTS = 20000;
+
+    /** The cumulative probabilities (in %) marked in the vertical axis of probability plots. */
+    const double PROBABILITY_TICKS[] = { 0.01, 0.1, 1.0, 2.0, 5.0, 10.0, 20.0, 30.0, 40.0, 50.0,
+                                         60.0, 70.0, 80.0, 90.0, 95.0, 98.0, 99.0, 99.9, 99.99 };
+}
+
+/** Axis labeling for probability plots: the axis coordinates are standard normal quantiles
+ * but the labels show the corresponding cumulative probabilities in percent.
+ */
+class ProbabilityScaleDraw : public QwtScaleDraw
+{
+public:
+    virtual QwtText label( double value ) const
+    {
+        double p = 0.5 * std::erfc( -value / std::sqrt( 2.0 ) );
+        return QString::number( p * 100.0, 'g', 4 );
+    }
+};
+
+DistributionPlot::DistributionPlot(QWidget *parent) :
+    QwtPlot( parent )
+{
+    setCanvasBackground( Qt::white );
+    plotLayout()->setAlignCanvasToScales( true );
+    clear();
+}
+
+void DistributionPlot::showHistogram(const UnivariateStatistics &stats, int nBins, double min, double max,
+                                     const QString &variableName)
+{
+    clear();
+
+    if( nBins < 1 || ! ( max > min ) )
+        return;
+
+    //the frequencies are computed from the sorted values, so rebinning is fast
+    std::vector<double> frequencies = stats.getHistogram( nBins, min, max );
+    std::vector<double> cumFrequencies = stats.getHistogram( nBins, min, max, true );
+
+    double binWidth = ( max - min ) / nBins;
+    QVector<QwtIntervalSample> samples( nBins );
+    QVector<QPointF> cumPoints( nBins + 1 );
+    cumPoints[0] = QPointF( min, cumFrequencies[0] - frequencies[0] );
+    double maxFrequency = 0.0;
+    for( int iBin = 0; iBin < nBins; ++iBin ){
+        double lower = min + iBin * binWidth;
+        samples[iBin] = QwtIntervalSample( frequencies[iBin], lower, lower + binWidth );
+        cumPoints[iBin + 1] = QPointF( lower + binWidth, cumFrequencies[iBin] );
+        maxFrequency = std::max( maxFrequency, frequencies[iBin] );
+    }
+
+    QwtPlotHistogram* histogram = new QwtPlotHistogram();
+    histogram->setStyle( QwtPlotHistogram::Columns );
+    histogram->setPen( QPen( Qt::black ) );
+    histogram->setBrush( QBrush( QColor( 100, 149, 237 ) ) );
+    histogram->setSamples( samples );
+    histogram->attach( this );
+
+    //the cumulative frequency curve is referenced by the right axis
+    QwtPlotCurve* cumulative = new QwtPlotCurve();
+    cumulative->setRenderHint( QwtPlotItem::RenderAntialiased );
+    cumulative->setPen( Qt::darkRed, 2 );
+    cumulative->setSamples( cumPoints );
+    cumulative->setYAxis( QwtPlot::yRight );
+    cumulative->attach( this );
+
+    enableAxis( QwtPlot::yRight, true );
+    setAxisScale( QwtPlot::yRight, 0.0, 1.0 );
+    setAxisTitle( QwtPlot::yRight, "Cumulative frequency" );
+    setAxisScale( QwtPlot::xBottom, min, max );
+    setAxisScale( QwtPlot::yLeft, 0.0, maxFrequency > 0.0 ? maxFrequency * 1.05 : 1.0 );
+    setAxisTitle( QwtPlot::yLeft, "Frequency" );
+    setAxisTitle( QwtPlot::xBottom, variableName );
+
+    replot();
+}
+
+void DistributionPlot::showDistributionModel(const UnivariateStatistics &stats, const std::vector<double> &values,
+                                             const std::vector<double> &probabilities, int nBins,
+                                             const QString &variableName)
+{
+    clear();
+
+    if( nBins < 1 || values.size() < 2 || values.size() != probabilities.size() )
+        return;
+    double min = values.front();
+    double max = values.back();
+    double binWidth = ( max - min ) / nBins;
+
+    //the data histogram
+    std::vector<double> frequencies = stats.getHistogram( nBins, min, max );
+    QVector<QwtIntervalSample> samples( nBins );
+    double maxFrequency = 0.0;
+    for( int iBin = 0; iBin < nBins; ++iBin ){
+        double lower = min + iBin * binWidth;
+        samples[iBin] = QwtIntervalSample( frequencies[iBin], lower, lower + binWidth );
+        maxFrequency = std::max( maxFrequency, frequencies[iBin] );
+    }
+    QwtPlotHistogram* histogram = new QwtPlotHistogram();
+    histogram->setStyle( QwtPlotHistogram::Columns );
+    histogram->setPen( QPen( Qt::black ) );
+    histogram->setBrush( QBrush( QColor( 100, 149, 237 ) ) );
+    histogram->setSamples( samples );
+    histogram->attach( this );
+
+    //the model probabilities summed in the same classes (drawn at the class centers) and the model c.d.f.
+    std::vector<double> modelFrequencies( nBins, 0.0 );
+    QVector<QPointF> cumPoints( values.size() );
+    double cumProbability = 0.0;
+    for( uint i = 0; i < values.size(); ++i ){
+        int iBin = std::min( nBins - 1, (int)( ( values[i] - min ) / binWidth ) );
+        modelFrequencies[iBin] += probabilities[i];
+        cumProbability += probabilities[i];
+        cumPoints[i] = QPointF( values[i], cumProbability );
+    }
+    QVector<QPointF> modelPoints( nBins );
+    for( int iBin = 0; iBin < nBins; ++iBin ){
+        modelPoints[iBin] = QPointF( min + ( iBin + 0.5 ) * binWidth, modelFrequencies[iBin] );
+        maxFrequency = std::max( maxFrequency, modelFrequencies[iBin] );
+    }
+    QwtPlotCurve* model = new QwtPlotCurve();
+    model->setRenderHint( QwtPlotItem::RenderAntialiased );
+    model->setPen( Qt::darkGreen, 2 );
+    model->setSamples( modelPoints );
+    model->attach( this );
+
+    QwtPlotCurve* cumulative = new QwtPlotCurve();
+    cumulative->setRenderHint( QwtPlotItem::RenderAntialiased );
+    cumulative->setPen( Qt::darkRed, 2 );
+    cumulative->setSamples( cumPoints );
+    cumulative->setYAxis( QwtPlot::yRight );
+    cumulative->attach( this );
+
+    enableAxis( QwtPlot::yRight, true );
+    setAxisScale( QwtPlot::yRight, 0.0, 1.0 );
+    setAxisTitle( QwtPlot::yRight, "Cumulative probability (model)" );
+    setAxisScale( QwtPlot::xBottom, min, max );
+    setAxisScale( QwtPlot::yLeft, 0.0, maxFrequency > 0.0 ? maxFrequency * 1.05 : 1.0 );
+    setAxisTitle( QwtPlot::yLeft, "Frequency" );
+    setAxisTitle( QwtPlot::xBottom, variableName );
+
+    replot();
+}
+
+void DistributionPlot::showProbabilityPlot(const UnivariateStatistics &stats, bool logScale,
+                                           const QString &variableName)
+{
+    clear();
+
+    const std::vector<double>& values = stats.getSortedValues();
+    const std::vector<double>& probabilities = stats.getPlottingPositions();
+    long n = values.size();
+    if( n == 0 )
+        return;
+
+    //a log scale cannot display non-positive values
+    if( logScale && values.front() <= 0.0 )
+        logScale = false;
+
+    //sample the points to display (see MAX_PLOTTED_POINTS)
+    long step = std::max( 1L, n / MAX_PLOTTED_POINTS );
+    QVector<QPointF> points;
+    points.reserve( n / step + 2 );
+    for( long i = 0; i < n; i += step )
+        points.push_back( QPointF( values[i], GeostatsUtils::getGaussianQuantile( probabilities[i] ) ) );
+    if( ( n - 1 ) % step )
+        points.push_back( QPointF( values[n-1], GeostatsUtils::getGaussianQuantile( probabilities[n-1] ) ) );
+
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    curve->setStyle( QwtPlotCurve::NoCurve );
+    curve->setSymbol( new QwtSymbol( QwtSymbol::Ellipse, QBrush( Qt::black ), QPen( Qt::black ), QSize( 3, 3 ) ) );
+    curve->setSamples( points );
+    curve->attach( this );
+
+    //the vertical axis is in normal score units labeled with probabilities
+    QList<double> majorTicks;
+    for( double tick : PROBABILITY_TICKS )
+        majorTicks.push_back( GeostatsUtils::getGaussianQuantile( tick / 100.0 ) );
+    QwtScaleDiv scaleDiv( majorTicks.front(), majorTicks.back(), QList<double>(), QList<double>(), majorTicks );
+    setAxisScaleDraw( QwtPlot::yLeft, new ProbabilityScaleDraw() );
+    setAxisScaleDiv( QwtPlot::yLeft, scaleDiv );
+    setAxisTitle( QwtPlot::yLeft, "Cumulative probability (%)" );
+
+    if( logScale )
+        setAxisScaleEngine( QwtPlot::xBottom, new QwtLogScaleEngine() );
+    setAxisScale( QwtPlot::xBottom, values.front(), values.back() );
+    setAxisTitle( QwtPlot::xBottom, variableName );
+
+    replot();
+}
+
+void DistributionPlot::showQQPlot(const std::vector<double> &x, const std::vector<double> &y,
+                                  const QString &xTitle, const QString &yTitle)
+{
+    clear();
+
+    if( x.empty() || x.size() != y.size() )
+        return;
+
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    curve->setStyle( QwtPlotCurve::NoCurve );
+    curve->setSymbol( new QwtSymbol( QwtSymbol::Ellipse, QBrush( Qt::black ), QPen( Qt::black ), QSize( 5, 5 ) ) );
+    curve->setSamples( x.data(), y.data(), x.size() );
+    curve->attach( this );
+
+    //both axes have the same range so the 45-degree line is the diagonal
+    double min = std::min( *std::min_element( x.begin(), x.end() ), *std::min_element( y.begin(), y.end() ) );
+    double max = std::max( *std::max_element( x.begin(), x.end() ), *std::max_element( y.begin(), y.end() ) );
+    double diagonalX[] = { min, max };
+    QwtPlotCurve* diagonal = new QwtPlotCurve();
+    diagonal->setPen( Qt::red, 1, Qt::DashLine );
+    diagonal->setSamples( diagonalX, diagonalX, 2 );
+    diagonal->attach( this );
+
+    setAxisScale( QwtPlot::xBottom, min, max );
+    setAxisScale( QwtPlot::yLeft, min, max );
+    setAxisTitle( QwtPlot::xBottom, xTitle );
+    setAxisTitle( QwtPlot::yLeft, yTitle );
+
+    replot();
+}
+
+void DistributionPlot::showCDFs(const std::vector<std::vector<double> > &realizationsQuantiles,
+                                const std::vector<double> &probabilities,
+                                const UnivariateStatistics *reference,
+                                const QString &variableName)
+{
+    clear();
+
+    double min = std::numeric_limits<double>::max();
+    double max = -std::numeric_limits<double>::max();
+
+    for( const std::vector<double>& quantiles : realizationsQuantiles ){
+        if( quantiles.size() != probabilities.size() || quantiles.empty() )
+            continue;
+        QwtPlotCurve* curve = new QwtPlotCurve();
+        curve->setPen( Qt::gray, 1 );
+        curve->setSamples( quantiles.data(), probabilities.data(), quantiles.size() );
+        curve->attach( this );
+        min = std::min( min, quantiles.front() );
+        max = std::max( max, quantiles.back() );
+    }
+
+    //the reference curve is drawn last so it stays on top
+    if( reference && reference->getCount() > 0 ){
+        const std::vector<double>& values = reference->getSortedValues();
+        const std::vector<double>& plottingPositions = reference->getPlottingPositions();
+        long n = values.size();
+        long step = std::max( 1L, n / MAX_PLOTTED_POINTS );
+        QVector<QPointF> points;
+        points.reserve( n / step + 2 );
+        for( long i = 0; i < n; i += step )
+            points.push_back( QPointF( values[i], plottingPositions[i] ) );
+        if( ( n - 1 ) % step )
+            points.push_back( QPointF( values[n-1], plottingPositions[n-1] ) );
+        QwtPlotCurve* curve = new QwtPlotCurve();
+        curve->setRenderHint( QwtPlotItem::RenderAntialiased );
+        curve->setPen( Qt::red, 2 );
+        curve->setSamples( points );
+        curve->attach( this );
+        min = std::min( min, values.front() );
+        max = std::max( max, values.back() );
+    }
+
+    if( max > min )
+        setAxisScale( QwtPlot::xBottom, min, max );
+    setAxisScale( QwtPlot::yLeft, 0.0, 1.0 );
+    setAxisTitle( QwtPlot::yLeft, "Cumulative frequency" );
+    setAxisTitle( QwtPlot::xBottom, variableName );
+
+    replot();
+}
+
+void DistributionPlot::showDeclusteringCurve(const std::vector<double> &cellSizes, const std::vector<double> &means,
+                                             double optimalCellSize, double naiveMean, const QString &variableName)
+{
+    clear();
+
+    if( cellSizes.empty() || cellSizes.size() != means.size() )
+        return;
+
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    curve->setPen( Qt::black, 1 );
+    curve->setSymbol( new QwtSymbol( QwtSymbol::Ellipse, QBrush( Qt::black ), QPen( Qt::black ), QSize( 5, 5 ) ) );
+    curve->setSamples( cellSizes.data(), means.data(), cellSizes.size() );
+    curve->attach( this );
+
+    //the mean without declustering
+    double naiveX[] = { cellSizes.front(), cellSizes.back() };
+    double naiveY[] = { naiveMean, naiveMean };
+    QwtPlotCurve* naive = new QwtPlotCurve();
+    naive->setPen( Qt::gray, 1, Qt::DashLine );
+    naive->setSamples( naiveX, naiveY, 2 );
+    naive->attach( this );
+
+    //the optimal cell size
+    QwtPlotMarker* marker = new QwtPlotMarker();
+    marker->setLineStyle( QwtPlotMarker::VLine );
+    marker->setLinePen( Qt::red, 1, Qt::DashLine );
+    marker->setXValue( optimalCellSize );
+    marker->attach( this );
+
+    setAxisTitle( QwtPlot::xBottom, "Cell size" );
+    setAxisTitle( QwtPlot::yLeft, "Declustered mean of " + variableName );
+
+    replot();
+}
+
+void DistributionPlot::showVarianceLossCurve(const std::vector<double> &cellSizes, const std::vector<double> &losses,
+                                             double currentCellSize)
+{
+    clear();
+
+    if( cellSizes.empty() || cellSizes.size() != losses.size() )
+        return;
+
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    curve->setPen( Qt::blue, 1 );
+    curve->setSymbol( new QwtSymbol( QwtSymbol::Ellipse, QBrush( Qt::blue ), QPen( Qt::blue ), QSize( 5, 5 ) ) );
+    curve->setSamples( cellSizes.data(), losses.data(), cellSizes.size() );
+    curve->attach( this );
+
+    //the cell size currently set in the grid
+    QwtPlotMarker* marker = new QwtPlotMarker();
+    marker->setLineStyle( QwtPlotMarker::VLine );
+    marker->setLinePen( Qt::red, 1, Qt::DashLine );
+    marker->setXValue( currentCellSize );
+    marker->attach( this );
+
+    setAxisTitle( QwtPlot::xBottom, "Cell size (X)" );
+    setAxisTitle( QwtPlot::yLeft, "Variance loss (%)" );
+
+    replot();
+}
+
+void DistributionPlot::clear()
+{
+    //delete all curves, histograms, grids, etc.
+    detachItems( QwtPlotItem::Rtti_PlotItem, true );
+
+    //restore default axes
+    enableAxis( QwtPlot::yRight, false );
+    setAxisScaleDraw( QwtPlot::yLeft, new QwtScaleDraw() );
+    setAxisScaleEngine( QwtPlot::xBottom, new QwtLinearScaleEngine() );
+    setAxisAutoScale( QwtPlot::xBottom );
+    setAxisAutoScale( QwtPlot::yLeft );
+
+    QwtPlotGrid *grid = new QwtPlotGrid();
+    grid->setMajorPen( Qt::gray, 0, Qt::DotLine );
+    grid->attach( this );
+}
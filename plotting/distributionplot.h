@@ -0,0 +1,74 @@
+#ifndef DISTRIBUTIONPLOT_H
+#define DISTRIBUTIONPLOT_H
+
+#include <qwt_plot.h>
+#include <vector>
+
+class UnivariateStatistics;
+
+/**
+ * The DistributionPlot is a Qwt plot widget to display univariate distributions computed by
+ * UnivariateStatistics: histograms, probability plots and Q-Q/P-P plots.  Each show*() call replaces
+ * the current contents of the plot.
+ */
+class DistributionPlot : public QwtPlot
+{
+    Q_OBJECT
+
+public:
+    DistributionPlot( QWidget* parent = nullptr );
+
+    /** Displays the histogram of the distribution with nBins classes between min and max along with
+     * the cumulative frequency curve (right axis).
+     */
+    void showHistogram( const UnivariateStatistics& stats, int nBins, double min, double max,
+                        const QString& variableName );
+
+    /** Displays the histogram of the data with nBins classes along with the frequencies of the same classes
+     * computed from a distribution model (e.g. computed with DistributionSmoother) and the cumulative
+     * probability curve of the model (right axis).  The classes span the values of the model.
+     */
+    void showDistributionModel( const UnivariateStatistics& stats, const std::vector<double>& values,
+                                const std::vector<double>& probabilities, int nBins, const QString& variableName );
+
+    /** Displays the probability plot (values against cumulative probability in a Gaussian scale)
+     * of the distribution.
+     * @param logScale If true, the values are displayed in a logarithmic scale (ignored if there are
+     *        non-positive values).
+     */
+    void showProbabilityPlot( const UnivariateStatistics& stats, bool logScale, const QString& variableName );
+
+    /** Displays a cross plot of the given pairs of values (e.g. computed with UnivariateStatistics::makeQQ())
+     * along with the 45-degree line.
+     */
+    void showQQPlot( const std::vector<double>& x, const std::vector<double>& y,
+                     const QString& xTitle, const QString& yTitle );
+
+    /** Displays the cumulative distribution curves of several realizations (in gray) and, optionally,
+     * that of a reference distribution (in red), like the GSLib program histpltsim.
+     * @param realizationsQuantiles The quantiles of each realization for the given cumulative probabilities.
+     * @param reference The reference distribution (e.g. the declustered data) or nullptr.
+     */
+    void showCDFs( const std::vector< std::vector<double> >& realizationsQuantiles,
+                   const std::vector<double>& probabilities,
+                   const UnivariateStatistics* reference,
+                   const QString& variableName );
+
+    /** Displays the declustered mean as a function of the cell size (e.g. computed with CellDeclustering)
+     * marking the optimal cell size and the mean without declustering (dashed line).
+     */
+    void showDeclusteringCurve( const std::vector<double>& cellSizes, const std::vector<double>& means,
+                                double optimalCellSize, double naiveMean, const QString& variableName );
+
+    /** Displays the variance loss (in %) due to averaging values into blocks as a function of the block size
+     * (e.g. computed with AverageVariogram) marking the current cell size.
+     */
+    void showVarianceLossCurve( const std::vector<double>& cellSizes, const std::vector<double>& losses,
+                                double currentCellSize );
+
+private:
+    /** Removes all plot items and restores the default axes. */
+    void clear();
+};
+
+#endif // DISTRIBUTIONPLOT_H
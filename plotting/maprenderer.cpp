@@ -0,0 +1,231 @@
+#include "maprenderer.h"
+
+#include "domain/categorydefinition.h"
+#include "util.h"
+
+#include <QPainter>
+#include <QColor>
+#include <cstring>
+#include <map>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+    /** Makes a category code to color map from a category definition. */
+    std::map<int, QRgb> makeCategoryColorMap( CategoryDefinition* cd )
+    {
+        std::map<int, QRgb> result;
+        //make sure the category definition info is loaded from the file
+        cd->loadTriplets();
+        for( int iCat = 0; iCat < cd->getCategoryCount(); ++iCat )
+            result[ cd->getCategoryCode( iCat ) ] = Util::getGSLibColor( cd->getColorCode( iCat ) ).rgb();
+        return result;
+    }
+
+    /** Returns the color of a value, either continuous or categorical. */
+    inline QRgb getColor( double value, bool hasNDV, double NDV, double min, double max,
+                          const std::map<int, QRgb>* categoryColors )
+    {
+        if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+            return MapRenderer::NDV_COLOR;
+        if( categoryColors ){
+            std::map<int, QRgb>::const_iterator it = categoryColors->find( (int)value );
+            if( it == categoryColors->end() ) //value not defined as a category
+                return MapRenderer::NDV_COLOR;
+            return it->second;
+        }
+        return MapRenderer::getContinuousColor( value, min, max );
+    }
+}
+
+MapRenderer::MapRenderer()
+{
+}
+
+QImage MapRenderer::renderGrid(const std::vector<double> &values, uint nI, uint nJ, uint k, uint pixelSize,
+                               bool hasNDV, double NDV, double min, double max, CategoryDefinition *cd)
+{
+    pixelSize = std::max( 1u, pixelSize );
+
+    //the color table is built once here, not in the threads
+    getColorTable();
+
+    //make the category color map, if applicable
+    std::map<int, QRgb> categoryColors;
+    if( cd )
+        categoryColors = makeCategoryColorMap( cd );
+    const std::map<int, QRgb>* pCategoryColors = cd ? &categoryColors : nullptr;
+
+    //the values of the slice
+    const double* slice = values.data() + (long)k * nI * nJ;
+
+    //create the image
+    QImage image( nI * pixelSize, nJ * pixelSize, QImage::Format_RGB32 );
+    //get the raw pixel buffer here, because QImage::scanLine() may detach the image (not thread-safe).
+    uchar* bits = image.bits();
+    int bytesPerLine = image.bytesPerLine();
+
+    //render the grid rows in parallel (each thread writes distinct scan lines)
+    Util::parallelFor( nJ, [=]( long first, long last ){
+        for( long j = first; j < last; ++j ){
+            //the grid's first row is at the bottom of the map
+            long firstScanLine = ( nJ - 1 - j ) * pixelSize;
+            QRgb* scanLine = reinterpret_cast<QRgb*>( bits + firstScanLine * bytesPerLine );
+            for( uint i = 0; i < nI; ++i ){
+                double value = slice[ j * nI + i ];
+                QRgb color = getColor( value, hasNDV, NDV, min, max, pCategoryColors );
+                for( uint p = 0; p < pixelSize; ++p )
+                    scanLine[ i * pixelSize + p ] = color;
+            }
+            //replicate the first scan line of the cell row to complete the pixel block
+            for( uint p = 1; p < pixelSize; ++p )
+                memcpy( bits + ( firstScanLine + p ) * bytesPerLine, scanLine, nI * pixelSize * sizeof(QRgb) );
+        }
+    });
+
+    return image;
+}
+
+QImage MapRenderer::renderPointSet(const std::vector<double> &x, const std::vector<double> &y,
+                                   const std::vector<double> &values, int width, int height, int pointSize,
+                                   bool hasNDV, double NDV, double min, double max, CategoryDefinition *cd)
+{
+    long nPoints = values.size();
+    pointSize = std::max( 1, pointSize );
+
+    //the color table is built once here, not in the threads
+    getColorTable();
+
+    //make the category color map, if applicable
+    std::map<int, QRgb> categoryColors;
+    if( cd )
+        categoryColors = makeCategoryColorMap( cd );
+    const std::map<int, QRgb>* pCategoryColors = cd ? &categoryColors : nullptr;
+
+    //get the data set's bounding box (X and Y columns are coordinates, there is no NDV)
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxX = -std::numeric_limits<double>::max();
+    double maxY = -std::numeric_limits<double>::max();
+    for( long line = 0; line < nPoints; ++line ){
+        minX = std::min( minX, x[line] ); maxX = std::max( maxX, x[line] );
+        minY = std::min( minY, y[line] ); maxY = std::max( maxY, y[line] );
+    }
+    Util::assureNonZeroWindow( minX, maxX, minX, maxX );
+    Util::assureNonZeroWindow( minY, maxY, minY, maxY );
+
+    //compute the world to pixel scale preserving the aspect ratio (with a margin for the point size)
+    int drawableWidth = std::max( 1, width - pointSize );
+    int drawableHeight = std::max( 1, height - pointSize );
+    double scale = std::min( drawableWidth / ( maxX - minX ), drawableHeight / ( maxY - minY ) );
+
+    //compute the pixel position and color of each sample in parallel
+    std::vector<QPoint> positions( nPoints );
+    std::vector<QRgb> colors( nPoints );
+    QPoint* pPositions = positions.data();
+    QRgb* pColors = colors.data();
+    Util::parallelFor( nPoints, [&]( long first, long last ){
+        for( long line = first; line < last; ++line ){
+            //north is up
+            pPositions[line] = QPoint( (int)( ( x[line] - minX ) * scale ),
+                                       (int)( ( maxY - y[line] ) * scale ) );
+            pColors[line] = getColor( values[line], hasNDV, NDV, min, max, pCategoryColors );
+        }
+    });
+
+    //draw the samples in file order
+    QImage image( width, height, QImage::Format_RGB32 );
+    image.fill( Qt::white );
+    QPainter painter( &image );
+    painter.setPen( Qt::NoPen );
+    for( long line = 0; line < nPoints; ++line )
+        painter.fillRect( positions[line].x(), positions[line].y(), pointSize, pointSize, QColor( colors[line] ) );
+    painter.end();
+
+    return image;
+}
+
+QImage MapRenderer::renderColorScale(int width, int height, double min, double max, CategoryDefinition *cd)
+{
+    QImage image( width, height, QImage::Format_RGB32 );
+    image.fill( Qt::white );
+    QPainter painter( &image );
+    int barWidth = std::min( 20, width / 3 );
+
+    if( cd ){
+        //one colored box per category, with the category names beside them.
+        cd->loadTriplets();
+        int nCats = cd->getCategoryCount();
+        if( nCats == 0 )
+            return image;
+        int boxHeight = std::min( 20, height / nCats );
+        for( int iCat = 0; iCat < nCats; ++iCat ){
+            int top = iCat * boxHeight;
+            painter.fillRect( 0, top, barWidth, boxHeight - 2, Util::getGSLibColor( cd->getColorCode( iCat ) ) );
+            painter.drawRect( 0, top, barWidth, boxHeight - 2 );
+            painter.drawText( barWidth + 4, top, width - barWidth - 4, boxHeight,
+                              Qt::AlignLeft | Qt::AlignVCenter, cd->getCategoryName( iCat ) );
+        }
+    } else {
+        //a vertical color bar with max value on top
+        int fontHeight = painter.fontMetrics().height();
+        int barTop = fontHeight / 2;
+        int barHeight = std::max( 1, height - fontHeight );
+        for( int y = 0; y < barHeight; ++y ){
+            double value = max - ( max - min ) * y / barHeight;
+            painter.setPen( QColor( getContinuousColor( value, min, max ) ) );
+            painter.drawLine( 0, barTop + y, barWidth, barTop + y );
+        }
+        painter.setPen( Qt::black );
+        //label the bar with five values
+        for( int iTick = 0; iTick <= 4; ++iTick ){
+            int y = barTop + barHeight * iTick / 4;
+            double value = max - ( max - min ) * iTick / 4.0;
+            painter.drawLine( barWidth, y, barWidth + 3, y );
+            painter.drawText( barWidth + 5, y - fontHeight/2, width - barWidth - 5, fontHeight,
+                              Qt::AlignLeft | Qt::AlignVCenter, QString::number( value, 'g', 4 ) );
+        }
+    }
+
+    painter.end();
+    return image;
+}
+
+QRgb MapRenderer::getContinuousColor(double value, double min, double max)
+{
+    const std::vector<QRgb>& colorTable = getColorTable();
+    if( ! ( max > min ) )
+        return colorTable[ COLOR_SCALE_SIZE / 2 ];
+    //values outside the min-max interval get the color of the nearest end of the scale
+    int index = (int)( ( value - min ) / ( max - min ) * ( COLOR_SCALE_SIZE - 1 ) );
+    index = std::max( 0, std::min( COLOR_SCALE_SIZE - 1, index ) );
+    return colorTable[ index ];
+}
+
+const std::vector<QRgb> &MapRenderer::getColorTable()
+{
+    //the classic rainbow: blue, cyan, green, yellow and red (same as View3dColorTables' rainbow)
+    static std::vector<QRgb> colorTable;
+    if( colorTable.empty() ){
+        const double controlPoints[5][3] = { { 0.0, 0.0, 1.0 },
+                                             { 0.0, 1.0, 1.0 },
+                                             { 0.0, 1.0, 0.0 },
+                                             { 1.0, 1.0, 0.0 },
+                                             { 1.0, 0.0, 0.0 } };
+        std::vector<QRgb> table;
+        table.reserve( COLOR_SCALE_SIZE );
+        for( int i = 0; i < COLOR_SCALE_SIZE; ++i ){
+            //interpolate linearly between the two nearest control points
+            double t = i / (double)( COLOR_SCALE_SIZE - 1 ) * 4.0;
+            int iCP = std::min( 3, (int)t );
+            double w = t - iCP;
+            double rgb[3];
+            for( int c = 0; c < 3; ++c )
+                rgb[c] = controlPoints[iCP][c] * ( 1.0 - w ) + controlPoints[iCP+1][c] * w;
+            table.push_back( qRgb( (int)( rgb[0] * 255 ), (int)( rgb[1] * 255 ), (int)( rgb[2] * 255 ) ) );
+        }
+        colorTable = table;
+    }
+    return colorTable;
+}
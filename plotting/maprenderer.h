@@ -0,0 +1,72 @@
+#ifndef MAPRENDERER_H
+#define MAPRENDERER_H
+
+#include <QImage>
+#include <QRgb>
+#include <vector>
+
+class CategoryDefinition;
+
+/**
+ * The MapRenderer class groups static functions to render maps of data files straight to QImage objects.
+ * It is the in-process alternative to running the GSLib programs pixelplt and locmap, which requires writing
+ * parameter files, two external program runs (the GSLib program and Ghostscript) and PostScript parsing.
+ * The color conventions follow those of GSLib: continuous values are colored with a rainbow color scale
+ * (lower values bluer, higher values redder) and categorical values are colored with the GSLib colors
+ * assigned to each category (see Util::getGSLibColor()).
+ * The rendering is parallelized with Util::parallelFor().
+ * The functions take copies of the values instead of data files, so the caller may render again after the
+ * data file it read the values from is gone.
+ */
+class MapRenderer
+{
+public:
+    MapRenderer();
+
+    /** The number of colors in the continuous color scale. */
+    static const int COLOR_SCALE_SIZE = 256;
+
+    /** The color used to paint unvalued (no-data value) locations. */
+    static const QRgb NDV_COLOR = 0xFFFFFFFF; //white
+
+    /**
+     * Renders a horizontal slice of a Cartesian grid.  The slice is rendered in grid topological space
+     * (like pixelplt does), that is, rotation is ignored and north (higher J) is up.
+     * @param values The values of the grid cells in GEO-EAS grid order (I runs fastest, then J, then K).
+     * @param k The zero-based slice index (use 0 for 2D grids).
+     * @param pixelSize Size in pixels of each cell's side.
+     * @param min Value mapped to the first color of the continuous color scale (ignored if cd is set).
+     * @param max Value mapped to the last color of the continuous color scale (ignored if cd is set).
+     * @param cd If set, the values are treated as category codes and colored according to the definition.
+     */
+    static QImage renderGrid( const std::vector<double>& values, uint nI, uint nJ, uint k, uint pixelSize,
+                              bool hasNDV, double NDV, double min, double max, CategoryDefinition* cd = nullptr );
+
+    /**
+     * Renders the samples of a point set in the XY plane.  The image is scaled to fit the given dimensions
+     * preserving the aspect ratio of the data set's bounding box.  The samples are drawn in file order, so
+     * later samples are drawn over earlier ones.
+     * @param x The X coordinates of the samples.
+     * @param y The Y coordinates of the samples.
+     * @param values The values of the samples.
+     * @param pointSize Size in pixels of the side of the square drawn for each sample.
+     * @param cd If set, the values are treated as category codes and colored according to the definition.
+     */
+    static QImage renderPointSet( const std::vector<double>& x, const std::vector<double>& y,
+                                  const std::vector<double>& values, int width, int height, int pointSize,
+                                  bool hasNDV, double NDV, double min, double max, CategoryDefinition* cd = nullptr );
+
+    /**
+     * Renders a color scale legend with the min and max labels (continuous) or with the category names.
+     */
+    static QImage renderColorScale( int width, int height, double min, double max, CategoryDefinition* cd = nullptr );
+
+    /** Returns the color of the given value in the continuous color scale. */
+    static QRgb getContinuousColor( double value, double min, double max );
+
+private:
+    /** Returns the continuous color table (computed once). */
+    static const std::vector<QRgb>& getColorTable();
+};
+
+#endif // MAPRENDERER_H
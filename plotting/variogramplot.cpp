@@ -0,0 +1,87 @@
+#include "variogramplot.h"
+
+#include <qwt_plot_grid.h>
+#include <qwt_plot_curve.h>
+#include <qwt_plot_layout.h>
+#include <qwt_plot_marker.h>
+#include <qwt_symbol.h>
+
+namespace {
+
+    /** The colors of the curves, similar to those of vargplt (no gray tones). */
+    const Qt::GlobalColor CURVE_COLORS[] = { Qt::red, Qt::blue, Qt::darkGreen, Qt::magenta, Qt::darkCyan,
+                                             Qt::darkYellow, Qt::darkRed, Qt::darkBlue, Qt::green, Qt::darkMagenta,
+                                             Qt::cyan, Qt::black };
+}
+
+VariogramPlot::VariogramPlot(QWidget *parent) :
+    QwtPlot( parent )
+{
+    setCanvasBackground( Qt::white );
+    plotLayout()->setAlignCanvasToScales( true );
+    clear();
+}
+
+void VariogramPlot::clear()
+{
+    //delete all curves, markers, grids, etc.
+    detachItems( QwtPlotItem::Rtti_PlotItem, true );
+
+    setAxisAutoScale( QwtPlot::xBottom );
+    setAxisAutoScale( QwtPlot::yLeft );
+    setAxisTitle( QwtPlot::xBottom, "Distance" );
+    setAxisTitle( QwtPlot::yLeft, "Variogram" );
+
+    QwtPlotGrid *grid = new QwtPlotGrid();
+    grid->setMajorPen( Qt::gray, 0, Qt::DotLine );
+    grid->attach( this );
+
+    //an invisible point at the origin keeps it in the automatic scales
+    double zero[] = { 0.0 };
+    QwtPlotCurve* origin = new QwtPlotCurve();
+    origin->setStyle( QwtPlotCurve::NoCurve );
+    origin->setSamples( zero, zero, 1 );
+    origin->attach( this );
+}
+
+void VariogramPlot::addExperimentalCurve(const std::vector<double> &distances, const std::vector<double> &gammas,
+                                         const QColor &color, bool joinPoints, Qt::PenStyle style)
+{
+    if( distances.empty() || distances.size() != gammas.size() )
+        return;
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    if( joinPoints )
+        curve->setPen( color, 1, style );
+    else
+        curve->setStyle( QwtPlotCurve::NoCurve );
+    curve->setSymbol( new QwtSymbol( QwtSymbol::Ellipse, QBrush( color ), QPen( color ), QSize( 5, 5 ) ) );
+    curve->setSamples( distances.data(), gammas.data(), distances.size() );
+    curve->attach( this );
+}
+
+void VariogramPlot::addModelCurve(const std::vector<double> &distances, const std::vector<double> &gammas,
+                                  const QColor &color, Qt::PenStyle style)
+{
+    if( distances.empty() || distances.size() != gammas.size() )
+        return;
+    QwtPlotCurve* curve = new QwtPlotCurve();
+    curve->setPen( color, 2, style );
+    curve->setRenderHint( QwtPlotItem::RenderAntialiased, true );
+    curve->setSamples( distances.data(), gammas.data(), distances.size() );
+    curve->attach( this );
+}
+
+void VariogramPlot::setSill(double sill)
+{
+    QwtPlotMarker* marker = new QwtPlotMarker();
+    marker->setLineStyle( QwtPlotMarker::HLine );
+    marker->setLinePen( Qt::gray, 1, Qt::DashLine );
+    marker->setYValue( sill );
+    marker->attach( this );
+}
+
+QColor VariogramPlot::getCurveColor(int i)
+{
+    int nColors = sizeof( CURVE_COLORS ) / sizeof( CURVE_COLORS[0] );
+    return QColor( CURVE_COLORS[ i % nColors ] );
+}
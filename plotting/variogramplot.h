@@ -0,0 +1,39 @@
+#ifndef VARIOGRAMPLOT_H
+#define VARIOGRAMPLOT_H
+
+#include <qwt_plot.h>
+#include <vector>
+
+/**
+ * The VariogramPlot is a Qwt plot widget to display experimental variograms (points) and variogram model curves
+ * (lines), like the GSLib program vargplt.  The curves are added one by one after clear() and the plot is redrawn
+ * with replot(), so it is cheap to refresh the model curves while the model parameters are edited.
+ */
+class VariogramPlot : public QwtPlot
+{
+    Q_OBJECT
+
+public:
+    VariogramPlot( QWidget* parent = nullptr );
+
+    /** Removes all curves and restores the default axes. */
+    void clear();
+
+    /** Adds the lags of an experimental variogram drawn as points.
+     * @param joinPoints If true, the points are also joined by lines of the given style.
+     */
+    void addExperimentalCurve( const std::vector<double>& distances, const std::vector<double>& gammas,
+                               const QColor& color, bool joinPoints = false, Qt::PenStyle style = Qt::SolidLine );
+
+    /** Adds a variogram model curve (e.g. computed with VariogramModelCurves) drawn as a line. */
+    void addModelCurve( const std::vector<double>& distances, const std::vector<double>& gammas,
+                        const QColor& color, Qt::PenStyle style = Qt::SolidLine );
+
+    /** Marks the sill (e.g. the variance) with a dashed horizontal line. */
+    void setSill( double sill );
+
+    /** Returns a color for the i-th curve (or direction), cycling through a palette of distinct colors. */
+    static QColor getCurveColor( int i );
+};
+
+#endif // VARIOGRAMPLOT_H
@@ -1,33 +1,172 @@
 #include "scripting.h"
-//#include "exprtk.hpp"
+#include "exprtk.hpp"
+#include "domain/application.h"
+#include "domain/datafile.h"
+#include "util.h"
 
-Scripting::Scripting()
+#include <QMap>
+#include <QRegularExpression>
+#include <QThread>
+#include <QElapsedTimer>
+#include <cmath>
+
+typedef exprtk::symbol_table<double> symbol_table_t;
+typedef exprtk::expression<double>     expression_t;
+typedef exprtk::parser<double>             parser_t;
+
+/** The compiled expression of a worker thread bound to its own variables. */
+struct Scripting::Evaluator{
+    symbol_table_t symbolTable;
+    expression_t expression;
+    std::vector<double> variables;
+};
+
+Scripting::Scripting( DataFile *dataFile ) :
+    m_dataFile( dataFile )
 {
 }
 
-void Scripting::trig_function()
+Scripting::~Scripting()
 {
-/*   typedef exprtk::symbol_table<double> symbol_table_t;
-   typedef exprtk::expression<double>     expression_t;
-   typedef exprtk::parser<double>             parser_t;
+    clearEvaluators();
+}
 
-   std::string expression_string = "clamp(-1.0,sin(2 * pi * x) + cos(x / 2 * pi),+1.0)";
+QString Scripting::getVariableName(const QString attributeName)
+{
+    QString result = attributeName.trimmed();
+    result.replace( QRegularExpression("[^A-Za-z0-9_]"), "_" );
+    if( result.isEmpty() || ! result.at(0).isLetter() )
+        result.prepend( "v_" );
+    return result;
+}
+
+bool Scripting::compile(const QString expression)
+{
+    clearEvaluators();
+    m_expression = expression;
+    m_usedVariables.clear();
+    m_usedColumns.clear();
+    m_lastError.clear();
 
-   double x;
+    //map the variable names (ExprTk symbols are case-insensitive) to the data columns
+    QStringList fieldNames = m_dataFile->getFieldNames();
+    QMap<QString, uint> columnOfVariable;
+    std::vector<double> dummyValues( fieldNames.size(), 0.0 );
+    symbol_table_t symbolTable;
+    for( int i = 0; i < fieldNames.size(); ++i ){
+        QString variableName = getVariableName( fieldNames[i] );
+        if( columnOfVariable.contains( variableName.toLower() ) ||
+            ! symbolTable.add_variable( variableName.toStdString(), dummyValues[i] ) ){
+            Application::instance()->logWarn( "Scripting::compile(): variable " + fieldNames[i].trimmed() +
+                                              " cannot be used in expressions: its name (" + variableName +
+                                              ") is repeated or is a reserved word." );
+            continue;
+        }
+        columnOfVariable.insert( variableName.toLower(), i );
+    }
+    symbolTable.add_constants();
 
-   symbol_table_t symbol_table;
-   symbol_table.add_variable("x",x);
-   symbol_table.add_constants();
+    //compile the expression once to check it and to find out the variables it uses
+    expression_t checkExpression;
+    checkExpression.register_symbol_table( symbolTable );
+    parser_t parser( parser_t::settings_t::compile_all_opts + parser_t::settings_t::e_collect_vars );
+    if( ! parser.compile( expression.toStdString(), checkExpression ) ){
+        m_lastError = QString::fromStdString( parser.error() );
+        for( std::size_t i = 0; i < parser.error_count(); ++i ){
+            exprtk::parser_error::type error = parser.get_error( i );
+            m_lastError += "\n" + QString::fromStdString( exprtk::parser_error::to_str( error.mode ) ) +
+                           " at position " + QString::number( error.token.position ) + ": " +
+                           QString::fromStdString( error.diagnostic );
+        }
+        return false;
+    }
+    std::vector< std::pair<std::string, parser_t::symbol_type> > symbols;
+    parser.dec().symbols( symbols );
+    for( const std::pair<std::string, parser_t::symbol_type>& symbol : symbols ){
+        if( symbol.second != parser_t::e_st_variable )
+            continue;
+        QString name = QString::fromStdString( symbol.first ).toLower();
+        if( columnOfVariable.contains( name ) ){
+            m_usedVariables << fieldNames[ columnOfVariable[name] ].trimmed();
+            m_usedColumns.push_back( columnOfVariable[name] );
+        }
+    }
 
-   expression_t expression;
-   expression.register_symbol_table(symbol_table);
+    //make one evaluator per worker thread, each with its own symbol table bound to its own variables
+    int nThreads = std::max( 1, QThread::idealThreadCount() );
+    for( int iThread = 0; iThread < nThreads; ++iThread ){
+        Evaluator* evaluator = new Evaluator();
+        evaluator->variables.resize( m_usedColumns.size() ); //must not be resized after binding
+        for( size_t iVar = 0; iVar < m_usedColumns.size(); ++iVar )
+            evaluator->symbolTable.add_variable( getVariableName( fieldNames[ m_usedColumns[iVar] ] ).toStdString(),
+                                                 evaluator->variables[iVar] );
+        evaluator->symbolTable.add_constants();
+        evaluator->expression.register_symbol_table( evaluator->symbolTable );
+        parser_t threadParser;
+        if( ! threadParser.compile( expression.toStdString(), evaluator->expression ) ){
+            m_lastError = QString::fromStdString( threadParser.error() );
+            delete evaluator;
+            clearEvaluators();
+            return false;
+        }
+        m_evaluators.push_back( evaluator );
+    }
 
-   parser_t parser;
-   parser.compile(expression_string,expression);
+    return true;
+}
 
-   for (x = double(-5); x <= double(+5); x += double(0.1))
-   {
-      double y = expression.value();
-      printf("%19.15f\t%19.15f\n",x,y);
-   }*/
+std::vector<double> Scripting::run()
+{
+    std::vector<double> result;
+    if( m_evaluators.empty() ){
+        Application::instance()->logError( "Scripting::run(): expression not compiled.  Nothing done." );
+        return result;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    //data must be loaded before the parallel section
+    m_dataFile->loadData();
+    long nLines = m_dataFile->getDataLineCount();
+    bool hasNDV = m_dataFile->hasNoDataValue();
+    double ndv = m_dataFile->getNoDataValueAsDouble();
+    result.resize( nLines, std::nan("") );
+
+    //each evaluator processes a contiguous chunk of data lines
+    long nEvaluators = m_evaluators.size();
+    long chunkSize = nLines / nEvaluators + ( nLines % nEvaluators ? 1 : 0 );
+    Util::parallelFor( nEvaluators, [&]( long first, long last ){
+        for( long iEvaluator = first; iEvaluator < last; ++iEvaluator ){
+            Evaluator* evaluator = m_evaluators[iEvaluator];
+            long lastLine = std::min( nLines, ( iEvaluator + 1 ) * chunkSize );
+            for( long iLine = iEvaluator * chunkSize; iLine < lastLine; ++iLine ){
+                bool isNDV = false;
+                for( size_t iVar = 0; iVar < m_usedColumns.size(); ++iVar ){
+                    double value = m_dataFile->data( iLine, m_usedColumns[iVar] );
+                    if( hasNDV && Util::almostEqual2sComplement( ndv, value, 1 ) ){
+                        isNDV = true;
+                        break;
+                    }
+                    evaluator->variables[iVar] = value;
+                }
+                if( isNDV )
+                    continue;
+                double value = evaluator->expression.value();
+                if( std::isfinite( value ) )
+                    result[iLine] = value;
+            }
+        }
+    });
+
+    Application::instance()->logInfo( "Scripting::run(): " + m_expression + " evaluated for " + QString::number( nLines ) +
+                                      " data lines in " + QString::number( timer.elapsed() ) + "ms." );
+    return result;
+}
+
+void Scripting::clearEvaluators()
+{
+    for( Evaluator* evaluator : m_evaluators )
+        delete evaluator;
+    m_evaluators.clear();
 }
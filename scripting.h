@@ -1,18 +1,64 @@
 #ifndef SCRIPTING_H
 #define SCRIPTING_H
 
-//FIXME: migrate to a 64-bit tool set since exprtk.hpp is too large resulting in
-//       "too many section" excpetion with MinGW 32-bit.  Also it is necessary
-//       to enable the -Wa,-mbig-obj for MinGW or /bigobj for MSVC.
-//       Another option is to use another scripting engine such as Python, Lua or muParser.
+#include <QString>
+#include <QStringList>
+#include <vector>
+
+class DataFile;
+
+//NOTE: exprtk.hpp is very large and is only included in scripting.cpp.  It requires a 64-bit tool set and
+//      the -Wa,-mbig-obj (MinGW) or /bigobj (MSVC) compiler options (see GammaRay.pro).
 /**
- * @brief The Scripting class encapsulates the scripting engine (currently trying the ExprTK header library).
+ * @brief The Scripting class encapsulates the scripting engine (the ExprTk header library).
+ * It evaluates user expressions over the variables of a data file, such as "log10(Cu)*density", to derive
+ * new variables.  The expression is compiled once per worker thread (each with its own symbol table, since
+ * ExprTk expressions are not thread-safe) and the data lines are evaluated in parallel.
  */
 class Scripting
 {
 public:
-    Scripting();
-    void trig_function();
+    /** @param dataFile The data file whose variables can be referred to in expressions. */
+    Scripting( DataFile* dataFile );
+    ~Scripting();
+
+    /** Returns the name used to refer to the given variable in expressions: characters that are not allowed in
+     * ExprTk identifiers are replaced by underscores and names not starting with a letter are prefixed with "v_".
+     */
+    static QString getVariableName( const QString attributeName );
+
+    /**
+     * Compiles the expression.  Returns false if the expression has errors (see getLastError()).
+     * Variable names are case-insensitive.
+     */
+    bool compile( const QString expression );
+
+    /**
+     * Evaluates the compiled expression for each data line of the data file (loads the data if needed).
+     * The result has one value per data line.  It is std::nan("") where any of the variables used in the
+     * expression has the no-data value or where the result is not finite (e.g. log of a negative number).
+     */
+    std::vector<double> run();
+
+    /** Returns the names of the variables used in the compiled expression. */
+    QStringList getUsedVariables() const { return m_usedVariables; }
+
+    QString getLastError() const { return m_lastError; }
+
+private:
+    struct Evaluator;
+
+    DataFile* m_dataFile;
+    QString m_expression;
+    /** The names of the variables used in the expression. */
+    QStringList m_usedVariables;
+    /** The column indexes (first == 0) of the variables used in the expression. */
+    std::vector<uint> m_usedColumns;
+    /** One evaluator per worker thread. */
+    std::vector<Evaluator*> m_evaluators;
+    QString m_lastError;
+
+    void clearEvaluators();
 };
 
 #endif // SCRIPTING_H
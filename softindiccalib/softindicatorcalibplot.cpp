@@ -9,6 +9,9 @@
 #include <qwt_legend.h>
 
 #include "softindicatorcalibcanvaspicker.h"
+#include "util.h"
+
+#include <algorithm>
 
 SoftIndicatorCalibPlot::SoftIndicatorCalibPlot(QWidget *parent) :
     QwtPlot(parent),
@@ -109,83 +112,70 @@ void SoftIndicatorCalibPlot::setNumberOfCurves(size_t number)
 
 std::vector< std::vector<double> > SoftIndicatorCalibPlot::getSoftIndicators(SoftIndicatorCalculationMode mode)
 {
-    std::vector< std::vector<double> > m;
+    //snapshot the calibration curves into sorted arrays, so the data can be calibrated in parallel without
+    //touching the Qwt objects
+    std::vector< CalibrationFunction > functions;
 
     if( mode == SoftIndicatorCalculationMode::CONTINUOUS ){
         //for each curve
-        uint nCurves = m_curves.size();
-        for( uint iCurve = 0; iCurve < nCurves; ++iCurve){
-            QwtPlotCurve* curve = m_curves[iCurve];
-            std::vector<double> softIndicators;
-            softIndicators.reserve( m_data.size() );
-            //for each datum
-            uint nData = m_data.size();
-            for( uint iDatum = 0; iDatum < nData; ++iDatum ){
-                //find the index of the curve point whose X is less or equal than the data value, but the next
-                // X is greater than.
-                int iLeft = 0;
-                for ( int i = 0; i < static_cast<int>( curve->dataSize() ); i++ )
-                    if( m_data[iDatum] <= curve->sample(i).x() ){
-                        iLeft = i-1;
-                        //adjust for begining-of-scale case
-                        if(iLeft < 0)
-                            iLeft = 0;
-                        break; //interrupt search
-                    }
-                //perform the linear interpolation
-                double x = m_data[iDatum];
-                double x0 = curve->sample(iLeft).x();
-                double y0 = curve->sample(iLeft).y();
-                double x1 = curve->sample(iLeft+1).x();
-                double y1 = curve->sample(iLeft+1).y();
-                double y = y0 + (x-x0) * (y1-y0) / (x1-x0);
-                softIndicators.push_back( y );
-            }
-            m.push_back( softIndicators );
+        for( QwtPlotCurve* curve : m_curves ){
+            CalibrationFunction function;
+            for ( int i = 0; i < static_cast<int>( curve->dataSize() ); i++ )
+                function.points.push_back( { curve->sample(i).x(), 0.0, curve->sample(i).y() } );
+            functions.push_back( function );
         }
     }
 
     if( mode == SoftIndicatorCalculationMode::CATEGORICAL ){
         //for each filled area
-        uint nFills = m_fillAreas.size();
-        for( uint iFill = 0; iFill < nFills; ++iFill){
-            QwtPlotIntervalCurve* fill = m_fillAreas[iFill];
-            std::vector<double> softIndicators;
-            softIndicators.reserve( m_data.size() );
-            //for each datum
-            uint nData = m_data.size();
-            for( uint iDatum = 0; iDatum < nData; ++iDatum ){
-                //find the index of the fill area sample whose X is less or equal than the data value, but the next
-                // X is greater than.
-                int iLeft = 0;
-                for ( int i = 0; i < static_cast<int>( fill->dataSize() ); i++ )
-                    if( m_data[iDatum] <= fill->sample(i).value ){
-                        iLeft = i-1;
-                        //adjust for begining-of-scale case
-                        if(iLeft < 0)
-                            iLeft = 0;
-                        break; //interrupt search
-                    }
-                //perform the linear interpolation of upper bound
-                double x = m_data[iDatum];
-                double x0 = fill->sample(iLeft).value;
-                double y0 = fill->sample(iLeft).interval.maxValue();
-                double x1 = fill->sample(iLeft+1).value;
-                double y1 = fill->sample(iLeft+1).interval.maxValue();
-                double yUpper = y0 + (x-x0) * (y1-y0) / (x1-x0);
-                //perform the linear interpolation of lower bound
-                y0 = fill->sample(iLeft).interval.minValue();
-                y1 = fill->sample(iLeft+1).interval.minValue();
-                double yLower = y0 + (x-x0) * (y1-y0) / (x1-x0);
-                //stores the difference (probability of a category)
-                softIndicators.push_back( yUpper - yLower );
-            }
-            m.push_back( softIndicators );
+        for( QwtPlotIntervalCurve* fill : m_fillAreas ){
+            CalibrationFunction function;
+            for ( int i = 0; i < static_cast<int>( fill->dataSize() ); i++ )
+                function.points.push_back( { fill->sample(i).value,
+                                             fill->sample(i).interval.minValue(),
+                                             fill->sample(i).interval.maxValue() } );
+            functions.push_back( function );
         }
     }
 
-    //return by move semantics
-    return std::move(m);
+    for( CalibrationFunction& function : functions )
+        std::sort( function.points.begin(), function.points.end(),
+                   []( const CalibrationPoint& a, const CalibrationPoint& b ){ return a.x < b.x; } );
+
+    //the outer vector corresponds to each curve/filled area
+    uint nFunctions = functions.size();
+    std::vector< std::vector<double> > m( nFunctions, std::vector<double>( m_data.size() ) );
+
+    //for each datum (in parallel)
+    Util::parallelFor( m_data.size(), [&]( long first, long last ){
+        for( long iDatum = first; iDatum < last; ++iDatum ){
+            double x = m_data[iDatum];
+            for( uint iFunction = 0; iFunction < nFunctions; ++iFunction ){
+                const std::vector<CalibrationPoint>& points = functions[iFunction].points;
+                if( points.size() < 2 ){
+                    m[iFunction][iDatum] = points.empty() ? 0.0 : points[0].upper - points[0].lower;
+                    continue;
+                }
+                //find the index of the point whose X is less than the data value, but the next
+                // X is greater than or equal to it (binary search).
+                long iRight = std::lower_bound( points.begin(), points.end(), x,
+                                                []( const CalibrationPoint& p, double value ){ return p.x < value; } )
+                              - points.begin();
+                //adjust for beginning- and end-of-scale cases
+                long iLeft = std::min<long>( std::max<long>( iRight - 1, 0 ), points.size() - 2 );
+                const CalibrationPoint& p0 = points[iLeft];
+                const CalibrationPoint& p1 = points[iLeft+1];
+                //perform the linear interpolation of the bounds
+                double t = ( p1.x != p0.x ) ? ( x - p0.x ) / ( p1.x - p0.x ) : 0.0;
+                double yUpper = p0.upper + t * ( p1.upper - p0.upper );
+                double yLower = p0.lower + t * ( p1.lower - p0.lower );
+                //stores the difference (probability of a category or cumulative probability for a curve)
+                m[iFunction][iDatum] = yUpper - yLower;
+            }
+        }
+    });
+
+    return m;
 }
 
 void SoftIndicatorCalibPlot::setXAxisLabel(QString text)
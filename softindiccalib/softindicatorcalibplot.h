@@ -2,6 +2,7 @@
 #define SOFTINDICATORCALIBPLOT_H
 
 #include <qwt_plot.h>
+#include <vector>
 
 class QwtPlotCurve;
 class QwtPlotIntervalCurve;
@@ -87,6 +88,19 @@ public slots:
     void insertCurve( int axis, double base );
 
 private:
+    /** A point of a calibration function: the soft indicator at x is upper - lower (lower is zero for
+     * the curves of continuous variables and is the curve below for the fill areas of categorical variables).
+     */
+    struct CalibrationPoint{
+        double x;
+        double lower;
+        double upper;
+    };
+    /** A snapshot of a calibration curve or fill area with its points sorted by x. */
+    struct CalibrationFunction{
+        std::vector<CalibrationPoint> points;
+    };
+
     void insertCurve(Qt::Orientation o, const QColor &c, double base , QString label);
 
     /** Removes all curves currently in the plot. */
@@ -363,21 +363,19 @@ QString SoftIndicatorCalibrationDialog::saveTmpFileWithSoftIndicators()
             uint nData = dataFile->getDataLineCount();
             //get the Attribute's GEO-EAS index
             uint atGEOEASIndex = m_at->getAttributeGEOEASgivenIndex();
-            //fills the arrays of soft indicator vectors with any NDVs, to make sure the
-            //sizes match the data count
-            for( uint i = 0; i < nData; ++i){
-                //get sample value
-                double value = dataFile->data( i, atGEOEASIndex-1 );
-                //if the value is a No-Data-Value
-                if( dataFile->isNDV( value ) ){
-                    //for each soft indicator variable
-                    for( uint iSoftIndicator = 0; iSoftIndicator < nSoftIndicators; ++iSoftIndicator){
-                        //insert a no-data-value in the soft indicator vector
-                        softIndicators[iSoftIndicator].insert( softIndicators[iSoftIndicator].begin() + i,
-                                                               dataFile->getNoDataValueAsDouble() );
-                    }
+            //merges the soft indicators with NDVs in a single pass, to make sure the
+            //sizes match the data count (the calibrated values skip the NDV samples)
+            double ndv = dataFile->getNoDataValueAsDouble();
+            std::vector< std::vector< double > > mergedSoftIndicators( nSoftIndicators, std::vector<double>( nData, ndv ) );
+            for( uint i = 0, iCalibrated = 0; i < nData; ++i){
+                //if the sample value is not a No-Data-Value
+                if( ! dataFile->isNDV( dataFile->data( i, atGEOEASIndex-1 ) ) ){
+                    for( uint iSoftIndicator = 0; iSoftIndicator < nSoftIndicators; ++iSoftIndicator)
+                        mergedSoftIndicators[iSoftIndicator][i] = softIndicators[iSoftIndicator][iCalibrated];
+                    ++iCalibrated;
                 }
             }
+            softIndicators.swap( mergedSoftIndicators );
             ////////////////////////////////////////////////////////////////
 
             //suggest names for the soft indicator fields
@@ -417,46 +415,58 @@ QString SoftIndicatorCalibrationDialog::saveTmpFileWithSoftIndicators()
 
             //The data file is surely a PointSet file
             PointSet* ps = (PointSet*)dataFile;
-
-            //output the original data and their computed soft indicators
-            for( uint i = 0; i < nData; ++i){
-                //output the X, Y, Z fields of the pointset
-                out << dataFile->data( i, ps->getXindex()-1 ) << '\t';
-                out << dataFile->data( i, ps->getYindex()-1 ) << '\t';
-                if( ps->is3D() )
-                    out << dataFile->data( i, ps->getZindex()-1 ) << '\t';
-                else
-                    out << "0.0" << '\t';
-                // the residue is used to ensure a 1.0 sum for the soft indicators
-                double residue = 1.0;
-                //for each soft indicator variable
-                for( uint iSoftIndicator = 0; iSoftIndicator < nSoftIndicators; ++iSoftIndicator){
-                    QString softIndicatorString;
-                    //get the soft indicator value
-                    double softIndicatorValue = softIndicators[iSoftIndicator][i];
-                    //if the soft indicator value is not NDV
-                    if( ! dataFile->isNDV( softIndicatorValue ) ) {
-                        double softIndicatorTruncated = std::floor( (softIndicatorValue/100.0) * 10000+0.5)/10000;
-                        //get the string presentation of the soft indicator value with 6-digit precision
-                        softIndicatorString = QString::number( softIndicatorTruncated, 'g', 4 );
-                        //for categorical case, the delivered soft indicators must sum up 1.0 exactly
-                        if( calcMode == SoftIndicatorCalculationMode::CATEGORICAL ){
-                            //subtract the actual output value from the residue
-                            residue -= softIndicatorTruncated;
-                            //ensure a 1.0 total probability
-                            if( iSoftIndicator == nSoftIndicators - 1){
-                                softIndicatorTruncated += residue;
-                                softIndicatorString = QString::number( softIndicatorTruncated, 'g', 4 );
+            bool hasNDV = dataFile->hasNoDataValue();
+            QByteArray ndvText = dataFile->getNoDataValue().toLatin1();
+
+            //format the original data and their computed soft indicators in parallel chunks of text
+            const long linesPerChunk = 10000;
+            long nChunks = ( (long)nData + linesPerChunk - 1 ) / linesPerChunk;
+            std::vector< QByteArray > chunks( nChunks );
+            Util::parallelFor( nChunks, [&]( long firstChunk, long lastChunk ){
+                for( long iChunk = firstChunk; iChunk < lastChunk; ++iChunk ){
+                    QByteArray& chunk = chunks[iChunk];
+                    long lastLine = std::min( (long)nData, ( iChunk + 1 ) * linesPerChunk );
+                    for( long i = iChunk * linesPerChunk; i < lastLine; ++i){
+                        //output the X, Y, Z fields of the pointset
+                        chunk.append( QByteArray::number( dataFile->data( i, ps->getXindex()-1 ), 'g', 12 ) ).append( '\t' );
+                        chunk.append( QByteArray::number( dataFile->data( i, ps->getYindex()-1 ), 'g', 12 ) ).append( '\t' );
+                        if( ps->is3D() )
+                            chunk.append( QByteArray::number( dataFile->data( i, ps->getZindex()-1 ), 'g', 12 ) ).append( '\t' );
+                        else
+                            chunk.append( "0.0\t" );
+                        // the residue is used to ensure a 1.0 sum for the soft indicators
+                        double residue = 1.0;
+                        //for each soft indicator variable
+                        for( uint iSoftIndicator = 0; iSoftIndicator < nSoftIndicators; ++iSoftIndicator){
+                            //get the soft indicator value
+                            double softIndicatorValue = softIndicators[iSoftIndicator][i];
+                            //if the soft indicator value is not NDV
+                            if( ! hasNDV || ! Util::almostEqual2sComplement( ndv, softIndicatorValue, 1 ) ) {
+                                double softIndicatorTruncated = std::floor( (softIndicatorValue/100.0) * 10000+0.5)/10000;
+                                //for categorical case, the delivered soft indicators must sum up 1.0 exactly
+                                if( calcMode == SoftIndicatorCalculationMode::CATEGORICAL ){
+                                    //subtract the actual output value from the residue
+                                    residue -= softIndicatorTruncated;
+                                    //ensure a 1.0 total probability
+                                    if( iSoftIndicator == nSoftIndicators - 1)
+                                        softIndicatorTruncated += residue;
+                                }
+                                //output the soft indicator value with 4-digit precision
+                                chunk.append( QByteArray::number( softIndicatorTruncated, 'g', 4 ) );
+                            } else {
+                                chunk.append( ndvText );
                             }
+                            chunk.append( '\t' );
                         }
-                    } else {
-                        softIndicatorString = dataFile->getNoDataValue();
+                        chunk.append( '\n' );
                     }
-                    //output the soft indicator or NDV value
-                    out << softIndicatorString << '\t';
                 }
-                out << '\n';
-            }
+            });
+
+            //write the text with a single buffered writer
+            out.flush();
+            for( const QByteArray& chunk : chunks )
+                outputFile.write( chunk );
             //closes the output file
             outputFile.close();
             //////////////////////////////////////////////////////////////////////////////////////
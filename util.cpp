@@ -10,6 +10,8 @@
 #include <QScreen>
 #include <QApplication>
 #include <QFrame>
+#include <QThread>
+#include <QtConcurrent/QtConcurrent>
 #include <cassert>
 #include <stdint.h>
 #include "exceptions/invalidgslibdatafileexception.h"
@@ -20,11 +22,14 @@
 #include "domain/categorydefinition.h"
 #include "domain/pointset.h"
 #include "domain/variogrammodel.h"
+#include "domain/auxiliary/geoeasheadercache.h"
 #include "gslib/gslibparameterfiles/gslibparameterfile.h"
 #include "gslib/gslibparameterfiles/gslibparamtypes.h"
 #include "gslib/gslibparams/gslibparinputdata.h"
 #include "gslib/gslib.h"
 #include "dialogs/displayplotdialog.h"
+#include "dialogs/mapviewdialog.h"
+#include "dialogs/distributionplotdialog.h"
 #include "dialogs/distributioncolumnrolesdialog.h"
 #include <QDir>
 #include <QFileInfo>
@@ -66,29 +71,7 @@ Util::Util()
 
 QStringList Util::getFieldNames(const QString gslib_data_file_path)
 {
-    QStringList list;
-    QFile file( gslib_data_file_path );
-    file.open( QFile::ReadOnly | QFile::Text );
-    QTextStream in(&file);
-    int n_vars = 0;
-    int var_count = 0;
-    for (int i = 0; !in.atEnd(); ++i)
-    {
-       //read file line by line
-       QString line = in.readLine();
-       //second line is the number of variables
-       //TODO: second line may contain other information in grid files, so it will fail for such cases
-       if( i == 1 ){
-           n_vars = Util::getFirstNumber( line );
-       } else if ( i > 1 && var_count < n_vars ){
-           list << line;
-           ++var_count;
-           if( var_count == n_vars )
-               break;
-       }
-    }
-    file.close();
-    return list;
+    return GEOEASHeaderCache::getHeader( gslib_data_file_path ).fieldNames;
 }
 
 std::pair<QStringList, QString> Util::parseTagsAndDescription( const QString gslib_param_file_template_line )
@@ -321,6 +304,7 @@ void Util::fixVarmapBug(const QString varmap_grid_file_path)
        inputFile.remove();
        //renames the new file
        outputFile.rename( QFile( varmap_grid_file_path ).fileName() );
+       GEOEASHeaderCache::invalidate( varmap_grid_file_path );
     }
 }
 
@@ -364,6 +348,7 @@ void Util::renameGEOEASvariable(const QString file_path, const QString old_name,
 
        //renames the new file
        outputFile.rename( QFile( file_path ).fileName() );
+       GEOEASHeaderCache::invalidate( file_path );
     }
 }
 
@@ -533,7 +518,31 @@ void Util::createGEOEASGridFile(const QString gridDescription,
     file.close();
 }
 
-bool Util::viewGrid(Attribute *variable, QWidget* parent = 0, bool modal, CategoryDefinition *cd)
+bool Util::viewGrid(Attribute *variable, QWidget *parent, bool modal, CategoryDefinition *cd)
+{
+    //the map is rendered in-process
+    MapViewDialog *mvd = new MapViewDialog( variable, cd, parent );
+    if( modal ){
+        int response = mvd->exec();
+        return response == QDialog::Accepted;
+    }
+    mvd->show();
+    return false;
+}
+
+bool Util::viewPointSet(Attribute *variable, QWidget *parent, bool modal)
+{
+    //the map is rendered in-process
+    MapViewDialog *mvd = new MapViewDialog( variable, nullptr, parent );
+    if( modal ){
+        int response = mvd->exec();
+        return response == QDialog::Accepted;
+    }
+    mvd->show();
+    return false;
+}
+
+bool Util::viewGridWithPixelplt(Attribute *variable, QWidget* parent, bool modal, CategoryDefinition *cd)
 {
     //get input data file
     //the parent component of an attribute is a file
@@ -652,7 +661,7 @@ bool Util::viewGrid(Attribute *variable, QWidget* parent = 0, bool modal, Catego
     return false;
 }
 
-bool Util::viewPointSet(Attribute *variable, QWidget *parent, bool modal)
+bool Util::viewPointSetWithLocmap(Attribute *variable, QWidget *parent, bool modal)
 {
     //get input data file
     //the parent component of an attribute is a file
@@ -867,7 +876,7 @@ QString Util::renameFile(const QString path, const QString newName)
     return newPath;
 }
 
-void Util::importUnivariateDistribution(Attribute *at, const QString path_from, QWidget *dialogs_owner)
+void Util::importUnivariateDistribution(Attribute *at, const QString path_from, QWidget *dialogs_owner, bool askForRoles)
 {
     //propose a name for the file
     QString proposed_name( at->getName() );
@@ -882,6 +891,17 @@ void Util::importUnivariateDistribution(Attribute *at, const QString path_from,
 
         QString tmpPathOfDistr = path_from;
 
+        //the roles of the columns of files generated in-process are known
+        if( ! askForRoles ){
+            QMap<uint, Roles::DistributionColumnRole> roles;
+            roles.insert( 1, Roles::DistributionColumnRole::VALUE );
+            roles.insert( 2, Roles::DistributionColumnRole::PVALUE );
+            Application::instance()->getProject()->importUnivariateDistribution( tmpPathOfDistr,
+                                                                                new_dist_model_name.append(".dst"),
+                                                                                roles );
+            return;
+        }
+
         //asks the user to set the roles for each of the distribution file columns.
         DistributionColumnRolesDialog dcrd( tmpPathOfDistr, dialogs_owner );
         dcrd.adjustSize();
@@ -1028,42 +1048,19 @@ QString Util::getProgramInstallDir()
 
 uint Util::getHeaderLineCount( QString file_path )
 {
-    QFile file( file_path );
-    file.open( QFile::ReadOnly | QFile::Text );
-    QTextStream in(&file);
-    int n_vars = 0;
-    int var_count = 0;
-
-    for (int i = 0; !in.atEnd(); ++i)
-    {
-       //read file line by line
-       QString line = in.readLine();
-
-       if( i == 0 ){} //first line is ignored
-       else if( i == 1 ){ //second line is the number of variables
-           n_vars = Util::getFirstNumber( line );
-       } else if ( i > 1 && var_count < n_vars ){ //the variables names
-           ++var_count;
-       } else { //begin lines containing data
-           file.close();
-           return i;
-       }
+    GEOEASHeader header = GEOEASHeaderCache::getHeader( file_path );
+    //it is not supposed to have no data lines.
+    if( header.firstDataByteOffset < 0 ){
+        Application::instance()->logWarn("WARNING: Util::getHeaderLineCount(): unexpected reach EOF.");
+        return 0;
     }
-    //it is not supposed to reach the end of file.
-    Application::instance()->logWarn("WARNING: Util::getHeaderLineCount(): unexpected reach EOF.");
-    file.close();
-    return 0;
+    return header.headerLineCount;
 }
 
 QString Util::getGEOEAScomment(QString file_path)
 {
-    QFile file( file_path );
-    file.open( QFile::ReadOnly | QFile::Text );
-    QTextStream in(&file);
-    //the comment is the first file line (no need for loops, etc.)
-    QString result = in.readLine();
-    file.close();
-    return result;
+    //the comment is the first file line
+    return GEOEASHeaderCache::getHeader( file_path ).description;
 }
 
 QFrame *Util::createHorizontalLine()
@@ -1657,6 +1654,17 @@ void Util::assureNonZeroWindow(double &outMin,
 }
 
 bool Util::viewHistogram(Attribute *at, QWidget *parent, bool modal)
+{
+    DistributionPlotDialog *dpd = new DistributionPlotDialog( at, DistributionPlotType::HISTOGRAM, parent );
+    if( modal ){
+        int response = dpd->exec();
+        return response == QDialog::Accepted;
+    }
+    dpd->show();
+    return false;
+}
+
+bool Util::viewHistogramWithHistplt(Attribute *at, QWidget *parent, bool modal)
 {
     //get input data file
     //the parent component of an attribute is a file
@@ -1733,6 +1741,267 @@ bool Util::viewHistogram(Attribute *at, QWidget *parent, bool modal)
     return false;
 }
 
+void Util::viewProbabilityPlotWithProbplt(Attribute *at, QWidget *parent)
+{
+    //get input data file
+    DataFile* input_data_file = (DataFile*)at->getContainingFile();
+
+    //load file data.
+    input_data_file->loadData();
+
+    //get the variable index in parent data file
+    uint var_index = input_data_file->getFieldGEOEASIndex( at->getName() );
+
+    //make plot/window title
+    QString title = at->getContainingFile()->getName();
+    title.append("/");
+    title.append(at->getName());
+    title.append(" probability plot");
+
+    //Construct an object composition based on the parameter file template for the probplt program.
+    GSLibParameterFile gpf( "probplt" );
+
+    //Set default values so we need to change less parameters and let
+    //the user change the others as one may see fit.
+    gpf.setDefaultValues();
+
+    //get the maximum and minimun of selected variable with some tolerance,
+    //excluding no-data values
+    double data_min = input_data_file->min( var_index - 1 );
+    double data_max = input_data_file->max( var_index - 1 );
+    data_min -= fabs( data_min / 100.0 );
+    data_max += fabs( data_max / 100.0 );
+
+    //---------------------set the parameters-----------------------------
+
+    //set the input data
+    GSLibParInputData* par0;
+    par0 = gpf.getParameter<GSLibParInputData*>(0);
+    par0->_file_with_data._path = input_data_file->getPath();
+    par0->_trimming_limits._max = data_max;
+    par0->_trimming_limits._min = data_min;
+    par0->_var_wgt_pairs.first()->_var_index = var_index;
+
+    //set the output PS file
+    gpf.getParameter<GSLibParFile*>(1)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
+
+    //set the scale
+    GSLibParMultiValuedFixed *par4 = gpf.getParameter<GSLibParMultiValuedFixed*>(4);
+    par4->getParameter<GSLibParDouble*>(0)->_value = data_min;
+    par4->getParameter<GSLibParDouble*>(1)->_value = data_max;
+    par4->getParameter<GSLibParDouble*>(2)->_value = fabs( data_max - data_min ) / 10.0;
+
+    //set the plot title
+    gpf.getParameter<GSLibParString*>(5)->_value = title;
+    //----------------------------------------------------------------------------------
+
+    //Generate the parameter file
+    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
+    gpf.save( par_file_path );
+
+    //run probplt program
+    Application::instance()->logInfo("Starting probplt program...");
+    GSLib::instance()->runProgram( "probplt", par_file_path );
+
+    //display the plot output
+    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(1)->_path, title, gpf, parent);
+    dpd->show(); //show() makes dialog modalless
+}
+
+void Util::viewQQPlotWithQpplt(Attribute *atX, Attribute *atY, QWidget *parent)
+{
+    //get input data files
+    DataFile* input_data_fileX = (DataFile*)atX->getContainingFile();
+    DataFile* input_data_fileY = (DataFile*)atY->getContainingFile();
+
+    //load file2 data.
+    input_data_fileX->loadData();
+    input_data_fileY->loadData();
+
+    //get the variable indexes in parent data files
+    uint var_indexX = input_data_fileX->getFieldGEOEASIndex( atX->getName() );
+    uint var_indexY = input_data_fileY->getFieldGEOEASIndex( atY->getName() );
+
+    //make plot/window title
+    QString title = "Q-Q/P-P plot ";
+    title.append( input_data_fileX->getName() );
+    title.append(" X ");
+    title.append( input_data_fileY->getName() );
+    title.append("(" + atX->getName() + ")"); //assumes the variable is the same in both files
+
+    //Construct an object composition based on the parameter file template for the qpplt program.
+    GSLibParameterFile gpf( "qpplt" );
+
+    //Set default values so we need to change less parameters and let
+    //the user change the others as one may see fit.
+    gpf.setDefaultValues();
+
+    //get the maximum and minimun of selected variables with some tolerance,
+    //excluding no-data values
+    double data_minX = input_data_fileX->min( var_indexX - 1 );
+    double data_maxX = input_data_fileX->max( var_indexX - 1 );
+    data_minX -= fabs( data_minX / 100.0 );
+    data_maxX += fabs( data_maxX / 100.0 );
+    double data_minY = input_data_fileY->min( var_indexY - 1 );
+    double data_maxY = input_data_fileY->max( var_indexY - 1 );
+    data_minY -= fabs( data_minY / 100.0 );
+    data_maxY += fabs( data_maxY / 100.0 );
+
+    //---------------------set the parameters-----------------------------
+
+    //set the first input file
+    gpf.getParameter<GSLibParFile*>(0)->_path = input_data_fileX->getPath();
+
+    //set the GEO-EAS index of first variable
+    GSLibParMultiValuedFixed *par1 = gpf.getParameter<GSLibParMultiValuedFixed*>(1);
+    par1->getParameter<GSLibParUInt*>(0)->_value = var_indexX;
+    par1->getParameter<GSLibParUInt*>(1)->_value = 0;
+
+    //set the second input file
+    gpf.getParameter<GSLibParFile*>(2)->_path = input_data_fileY->getPath();
+
+    //set the GEO-EAS index of second variable
+    GSLibParMultiValuedFixed *par3 = gpf.getParameter<GSLibParMultiValuedFixed*>(3);
+    par3->getParameter<GSLibParUInt*>(0)->_value = var_indexY;
+    par3->getParameter<GSLibParUInt*>(1)->_value = 0;
+
+    //set the trimming limits
+    GSLibParMultiValuedFixed *par4 = gpf.getParameter<GSLibParMultiValuedFixed*>(4);
+    par4->getParameter<GSLibParDouble*>(0)->_value = ( data_minX < data_minY ? data_minX : data_minY );
+    par4->getParameter<GSLibParDouble*>(1)->_value = ( data_maxX > data_maxY ? data_maxX : data_maxY );
+
+    //set the output PostScript file
+    gpf.getParameter<GSLibParFile*>(5)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
+
+    //set the X axis range
+    GSLibParMultiValuedFixed *par8 = gpf.getParameter<GSLibParMultiValuedFixed*>(8);
+    par8->getParameter<GSLibParDouble*>(0)->_value = data_minX;
+    par8->getParameter<GSLibParDouble*>(1)->_value = data_maxX;
+
+    //set the Y axis range
+    GSLibParMultiValuedFixed *par9 = gpf.getParameter<GSLibParMultiValuedFixed*>(9);
+    par9->getParameter<GSLibParDouble*>(0)->_value = data_minY;
+    par9->getParameter<GSLibParDouble*>(1)->_value = data_maxY;
+
+    //set the plot title
+    gpf.getParameter<GSLibParString*>(11)->_value = title;
+
+    //----------------------------------------------------------------------------------
+
+    //Generate the parameter file
+    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
+    gpf.save( par_file_path );
+
+    //run qpplt program
+    Application::instance()->logInfo("Starting qpplt program...");
+    GSLib::instance()->runProgram( "qpplt", par_file_path );
+
+    //display the plot output
+    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(5)->_path, title, gpf, parent);
+    dpd->show(); //show() makes dialog modalless
+}
+
+void Util::viewRealizationsHistogramsWithHistpltsim(Attribute *realizationsAttribute, Attribute *refDistAttribute, QWidget *parent)
+{
+    CartesianGrid* grid = nullptr;
+    PointSet* pointSet = nullptr;
+
+    //get the files
+    grid = (CartesianGrid*)realizationsAttribute->getContainingFile();
+    if( refDistAttribute )
+        pointSet = (PointSet*)refDistAttribute->getContainingFile();
+
+    //load the data in grid
+    grid->loadData();
+
+    //get the maximum and minimun of selected variable, excluding no-data value
+    double data_min = grid->min( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
+    double data_max = grid->max( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
+    data_min -= std::fabs( data_min / 100.0 );
+    data_max += std::fabs( data_max / 100.0 );
+
+    //------------------------------parameters setting--------------------------------------
+
+    GSLibParameterFile gpf( "histpltsim" );
+
+    //Set default values so we need to change less parameters and let
+    //the user change the others as one may see fit.
+    gpf.setDefaultValues();
+
+    GSLibParMultiValuedFixed* par3 = gpf.getParameter<GSLibParMultiValuedFixed*>(3);
+    if( refDistAttribute ){
+        //file with reference distribution
+        gpf.getParameter<GSLibParFile*>(2)->_path = pointSet->getPath();
+        //   columns for reference variable and weight
+        par3->getParameter<GSLibParUInt*>(0)->_value = refDistAttribute->getAttributeGEOEASgivenIndex();
+        par3->getParameter<GSLibParUInt*>(1)->_value = 0;
+    } else{
+        gpf.getParameter<GSLibParFile*>(2)->_path = "NOFILE";
+        par3->getParameter<GSLibParUInt*>(0)->_value = 0;
+        par3->getParameter<GSLibParUInt*>(1)->_value = 0;
+    }
+
+    //file with distributions to check
+    gpf.getParameter<GSLibParFile*>(4)->_path = grid->getPath();
+
+    //   columns for variable and weight
+    GSLibParMultiValuedFixed* par5 = gpf.getParameter<GSLibParMultiValuedFixed*>(5);
+    par5->getParameter<GSLibParUInt*>(0)->_value = realizationsAttribute->getAttributeGEOEASgivenIndex();
+    par5->getParameter<GSLibParUInt*>(1)->_value = 0;
+
+    //   start and finish histograms (usually 1 and nreal)
+    GSLibParMultiValuedFixed* par7 = gpf.getParameter<GSLibParMultiValuedFixed*>(7);
+    par7->getParameter<GSLibParUInt*>(0)->_value = 1;
+    par7->getParameter<GSLibParUInt*>(1)->_value = grid->getNReal();
+
+    //   nx, ny, nz
+    GSLibParMultiValuedFixed* par8 = gpf.getParameter<GSLibParMultiValuedFixed*>(8);
+    par8->getParameter<GSLibParUInt*>(0)->_value = grid->getNX();
+    par8->getParameter<GSLibParUInt*>(1)->_value = grid->getNY();
+    par8->getParameter<GSLibParUInt*>(2)->_value = grid->getNZ();
+
+    //   trimming limits
+    GSLibParMultiValuedFixed* par9 = gpf.getParameter<GSLibParMultiValuedFixed*>(9);
+    par9->getParameter<GSLibParDouble*>(0)->_value = data_min;
+    par9->getParameter<GSLibParDouble*>(1)->_value = data_max;
+
+    //file for PostScript output
+    gpf.getParameter<GSLibParFile*>(10)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("ps");
+
+    //file for summary output (always used)
+    gpf.getParameter<GSLibParFile*>(11)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("txt");
+
+    //file for numeric output (used if flag set above)
+    gpf.getParameter<GSLibParFile*>(12)->_path = Application::instance()->getProject()->generateUniqueTmpFilePath("dat");;
+
+    //attribute minimum and maximum
+    GSLibParMultiValuedFixed* par13 = gpf.getParameter<GSLibParMultiValuedFixed*>(13);
+    par13->getParameter<GSLibParDouble*>(0)->_value = data_min;
+    par13->getParameter<GSLibParDouble*>(1)->_value = data_max;
+
+    //title
+    QString title = grid->getName() + "/" +
+            realizationsAttribute->getName() + ": realizations";
+    gpf.getParameter<GSLibParString*>(18)->_value = title;
+
+    //reference value for box plot
+    gpf.getParameter<GSLibParDouble*>(20)->_value = grid->mean( realizationsAttribute->getAttributeGEOEASgivenIndex()-1 );
+
+    //----------------------------------------------------------------------------------
+
+    //Generate the parameter file
+    QString par_file_path = Application::instance()->getProject()->generateUniqueTmpFilePath("par");
+    gpf.save( par_file_path );
+
+    //run histpltsim program
+    Application::instance()->logInfo("Starting histpltsim program...");
+    GSLib::instance()->runProgram( "histpltsim", par_file_path );
+
+    //display the plot output
+    DisplayPlotDialog *dpd = new DisplayPlotDialog(gpf.getParameter<GSLibParFile*>(10)->_path, title, gpf, parent);
+    dpd->show(); //show() makes dialog modalless
+}
+
 bool Util::programWasCalledWithCommandLineArgument(QString argument)
 {
     QStringList arguments = QCoreApplication::arguments();
@@ -1788,3 +2057,24 @@ std::int64_t Util::getPhysicalRAMusage()
     return (std::int64_t)-1;
 #endif
 }
+
+void Util::parallelFor(long n, std::function<void (long, long)> body)
+{
+    if( n <= 0 )
+        return;
+
+    //make a few ranges per core so the threads that finish early can pick up remaining work
+    long nRanges = std::min<long>( n, std::max( 1, QThread::idealThreadCount() ) * 4 );
+    long rangeSize = n / nRanges + ( n % nRanges ? 1 : 0 );
+
+    //build the list of [first, last) ranges
+    std::vector< std::pair<long, long> > ranges;
+    ranges.reserve( nRanges );
+    for( long first = 0; first < n; first += rangeSize )
+        ranges.push_back( std::pair<long, long>( first, std::min( first + rangeSize, n ) ) );
+
+    //process the ranges in parallel and wait for all of them to finish
+    QtConcurrent::blockingMap( ranges, [&body]( std::pair<long, long>& range ){
+        body( range.first, range.second );
+    });
+}
@@ -5,6 +5,7 @@
 #include <QList>
 #include <complex>
 #include <cassert>
+#include <functional>
 #include "array3d.h"
 
 //macro used to do printf on QString for debugging purposes
@@ -78,7 +79,7 @@ public:
      * GSLib format data file.  GSLib files are in GEO-EAS format.
      * The list is in the same order as found in the file, so you
      * can use QStringList's index to find the variable column in
-     * the file.
+     * the file.  The file header is cached (see GEOEASHeaderCache).
      */
     static QStringList getFieldNames( const QString gslib_data_file_path );
 
@@ -252,6 +253,29 @@ public:
                                       QString path );
 
 
+    /**
+     * Opens the map dialog to view a variable in a regular grid.  The map is rendered in-process
+     * (see MapRenderer), so neither GSLib nor Ghostscript are required.
+     * @param parent Parent QWidget for the map dialog.
+     * @param modal If true, the method returns only when the user closes the map dialog.
+     * @param cd If informed, the grid is renderd as a categorical variable.
+     * @return True if modal == true and if the user did not cancel the map dialog; false otherwise.
+     */
+    static bool viewGrid(Attribute* variable ,
+                         QWidget *parent,
+                         bool modal = false,
+                         CategoryDefinition *cd = nullptr);
+
+    /**
+     * Opens the map dialog to view a variable in a point set file.  The map is rendered in-process
+     * (see MapRenderer), so neither GSLib nor Ghostscript are required.
+     * @param parent Parent QWidget for the map dialog.
+     * @param modal If true, the method returns only when the user closes the map dialog.
+     */
+    static bool viewPointSet(Attribute* variable ,
+                             QWidget *parent,
+                             bool modal = false);
+
     /**
      * Runs the GSLib program pixelplt and opens the plot dialog to view a
      * variable in a regular grid.
@@ -260,10 +284,10 @@ public:
      * @param cd If informed, the grid is renderd as a categorical variable.
      * @return True if modal == true and if the user did not cancel the Plot Dialog; false otherwise.
      */
-    static bool viewGrid(Attribute* variable ,
-                         QWidget *parent,
-                         bool modal = false,
-                         CategoryDefinition *cd = nullptr);
+    static bool viewGridWithPixelplt(Attribute* variable ,
+                                     QWidget *parent,
+                                     bool modal = false,
+                                     CategoryDefinition *cd = nullptr);
 
     /**
      * Runs the GSLib program locmap and opens the plot dialog to view a
@@ -271,9 +295,9 @@ public:
      * @param parent Parent QWidget for the plot dialog.
      * @param modal If true, the method returns only when the user closes the Plot Dialog.
      */
-    static bool viewPointSet(Attribute* variable ,
-                             QWidget *parent,
-                             bool modal = false);
+    static bool viewPointSetWithLocmap(Attribute* variable ,
+                                       QWidget *parent,
+                                       bool modal = false);
 
     /**
      * Runs the GSLib program scatplt and opens the plot dialog to view a
@@ -308,8 +332,11 @@ public:
     *  @param at The attribute that originated the distribution.
     *  @param path_from The complete path to the file.
     *  @param dialogs_owner Widget used to anchor the modal dialogs to.
+    *  @param askForRoles If false, the first and second columns are set as value and probability without asking
+    *         the user (e.g. for files generated in-process).
     */
-    static void importUnivariateDistribution(Attribute *at, const QString path_from , QWidget *dialogs_owner);
+    static void importUnivariateDistribution(Attribute *at, const QString path_from , QWidget *dialogs_owner,
+                                             bool askForRoles = true );
 
     /**
      * Populates the passed list with QColor objects containing colors according to GSLib convention.
@@ -501,6 +528,15 @@ public:
                                      double inMax,
                                      double minWindowPercent = 0.01); //0.01 == 1%
 
+    /**
+     * Opens the distribution plot dialog to view the histogram of a variable.  The histogram is computed
+     * in-process (see UnivariateStatistics), so neither GSLib nor Ghostscript are required.
+     * @param parent Parent QWidget for the plot dialog.
+     * @param modal If true, the method returns only when the user closes the plot dialog.
+     * @return True if modal == true and if the user did not cancel the plot dialog; false otherwise.
+     */
+    static bool viewHistogram( Attribute *at, QWidget *parent = nullptr, bool modal = false );
+
     /**
      * Runs the GSLib program histplt and opens the plot dialog to view the histogram of
      * variable.
@@ -508,7 +544,31 @@ public:
      * @param modal If true, the method returns only when the user closes the Plot Dialog.
      * @return True if modal == true and if the user did not cancel the Plot Dialog; false otherwise.
      */
-    static bool viewHistogram( Attribute *at, QWidget *parent = nullptr, bool modal = false );
+    static bool viewHistogramWithHistplt( Attribute *at, QWidget *parent = nullptr, bool modal = false );
+
+    /**
+     * Runs the GSLib program probplt and opens the plot dialog to view the probability plot of
+     * a variable.
+     * @param parent Parent QWidget for the plot dialog.
+     */
+    static void viewProbabilityPlotWithProbplt( Attribute *at, QWidget *parent = nullptr );
+
+    /**
+     * Runs the GSLib program qpplt and opens the plot dialog to view the Q-Q/P-P plot of
+     * two variables.
+     * @param parent Parent QWidget for the plot dialog.
+     */
+    static void viewQQPlotWithQpplt( Attribute *atX, Attribute *atY, QWidget *parent = nullptr );
+
+    /**
+     * Runs the GSLib program histpltsim and opens the plot dialog to view the distributions of the
+     * realizations of a simulated variable in a Cartesian grid.
+     * @param refDistAttribute Variable with the reference distribution (e.g. in a point set).  Can be null.
+     * @param parent Parent QWidget for the plot dialog.
+     */
+    static void viewRealizationsHistogramsWithHistpltsim( Attribute *realizationsAttribute,
+                                                          Attribute *refDistAttribute,
+                                                          QWidget *parent = nullptr );
 
     /** Returns whether the program was launched with the given argument. */
     static bool programWasCalledWithCommandLineArgument( QString argument );
@@ -519,6 +579,14 @@ public:
      */
     static std::int64_t getPhysicalRAMusage();
 
+    /** Splits the index interval [0, n) into contiguous ranges and calls body( first, last ) for each
+     * range in parallel using the global QThreadPool (QtConcurrent).  The last index is exclusive.
+     * This function returns only when all ranges have been processed.
+     * @note The body must be thread-safe: concurrent calls only receive disjoint ranges, but any shared
+     *       state (e.g. DataFile::loadData()) must be prepared before calling this function.
+     */
+    static void parallelFor( long n, std::function<void(long first, long last)> body );
+
 };
 
 #endif // UTIL_H
@@ -6,6 +6,7 @@
 #include "domain/cartesiangrid.h"
 #include "view3dcolortables.h"
 #include "view3dwidget.h"
+#include "util.h"
 
 #include <vtkPoints.h>
 #include <vtkCellArray.h>
@@ -39,6 +40,11 @@
 #include <vtkRenderWindow.h>
 #include <vtkThreshold.h>
 #include <QMessageBox>
+#include <unordered_map>
+#include <cstdint>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 void RefreshCallback( vtkObject* vtkNotUsed(caller),
                       long unsigned int vtkNotUsed(eventId),
@@ -64,54 +70,8 @@ View3DViewData View3DBuilders::build(ProjectComponent *object, View3DWidget */*w
 
 View3DViewData View3DBuilders::build(PointSet *object, View3DWidget */*widget3D*/)
 {
-    //use a more meaningful name.
-    PointSet *pointSet = object;
-
-    // Create the geometry of a point (the coordinate)
-    vtkSmartPointer<vtkPoints> points =
-      vtkSmartPointer<vtkPoints>::New();
-    ///////const float p[3] = {1.0, 2.0, 3.0};
-
-    // Create the topology of the point (a vertex)
-    vtkSmartPointer<vtkCellArray> vertices = vtkSmartPointer<vtkCellArray>::New();
-    ///////vtkIdType pid[1];
-    ///////pid[0] = points->InsertNextPoint(p);
-    ///////vertices->InsertNextCell(1,pid);
-
-    //read point geometry
-    vtkSmartPointer<vtkIdList> pids = vtkSmartPointer<vtkIdList>::New();
-    pointSet->loadData();
-    pids->Allocate( pointSet->getDataLineCount() );
-    for( uint line = 0; line < pointSet->getDataLineCount(); ++line){
-        double x = pointSet->data( line, pointSet->getXindex()-1 );
-        double y = pointSet->data( line, pointSet->getYindex()-1 );
-        double z = 0.0;
-        if( pointSet->is3D() )
-            z = pointSet->data( line, pointSet->getZindex()-1 );
-        pids->InsertNextId(  points->InsertNextPoint( x, y, z ) );
-    }
-    vertices->InsertNextCell( pids );
-
-    // Create a polydata object
-    vtkSmartPointer<vtkPolyData> pointCloud =
-      vtkSmartPointer<vtkPolyData>::New();
-
-    // Set the points and vertices we created as the geometry and topology of the polydata
-    pointCloud->SetPoints(points);
-    pointCloud->SetVerts(vertices);
-
-    // Visualize
-    vtkSmartPointer<vtkPolyDataMapper> mapper =
-      vtkSmartPointer<vtkPolyDataMapper>::New();
-    mapper->SetInputData(pointCloud);
-
-    // Create and configure the actor
-    vtkSmartPointer<vtkActor> actor =
-      vtkSmartPointer<vtkActor>::New();
-    actor->SetMapper(mapper);
-    actor->GetProperty()->SetPointSize(3);
-
-    return View3DViewData( actor );
+    //geometry only (no attribute to color the points with)
+    return buildPointCloud( object, nullptr );
 }
 
 View3DViewData View3DBuilders::build(Attribute *object, View3DWidget *widget3D)
@@ -156,75 +116,318 @@ View3DViewData View3DBuilders::buildForAttributeFromPointSet(PointSet* pointSet,
                                                              Attribute *attribute,
                                                              View3DWidget */*widget3D*/)
 {
-    // Create the geometry of a point (the coordinate)
-    vtkSmartPointer<vtkPoints> points =
-      vtkSmartPointer<vtkPoints>::New();
-
-    // Create the topology of the point (a vertex)
-    vtkSmartPointer<vtkCellArray> vertices = vtkSmartPointer<vtkCellArray>::New();
+    return buildPointCloud( pointSet, attribute );
+}
 
+View3DViewData View3DBuilders::buildPointCloud(PointSet *pointSet, Attribute *attribute)
+{
     //loads data in file, because it's necessary.
     pointSet->loadData();
 
-    //get the variable index in parent data file
-    uint var_index = pointSet->getFieldGEOEASIndex( attribute->getName() );
+    vtkIdType nPoints = pointSet->getDataLineCount();
+
+    //get the coordinate columns (zero-based)
+    int xColumn = pointSet->getXindex() - 1;
+    int yColumn = pointSet->getYindex() - 1;
+    int zColumn = pointSet->is3D() ? pointSet->getZindex() - 1 : -1;
+
+    //get the variable column, if an attribute was passed
+    int valueColumn = -1;
+    double min = 0.0;
+    double max = 0.0;
+    if( attribute ){
+        valueColumn = pointSet->getFieldGEOEASIndex( attribute->getName() ) - 1;
+        //get the max and min of the selected variable
+        min = pointSet->min( valueColumn );
+        max = pointSet->max( valueColumn );
+    }
 
-    //get the max and min of the selected variable
-    double min = pointSet->min( var_index-1 );
-    double max = pointSet->max( var_index-1 );
+    //allocate the coordinates (x,y,z triplets) and values arrays in bulk, so we can fill them
+    //directly through their raw buffers instead of inserting one point at a time.
+    vtkSmartPointer<vtkDoubleArray> coordinates = vtkSmartPointer<vtkDoubleArray>::New();
+    coordinates->SetNumberOfComponents( 3 );
+    coordinates->SetNumberOfTuples( nPoints );
+    double* xyz = coordinates->GetPointer( 0 );
+    vtkSmartPointer<vtkFloatArray> values; //remains null if no attribute was passed
+    float* v = nullptr;
+    if( valueColumn >= 0 ){
+        values = vtkSmartPointer<vtkFloatArray>::New();
+        values->SetName("values");
+        values->SetNumberOfValues( nPoints );
+        v = values->GetPointer( 0 );
+    }
 
-    //create a VTK array to store the sample values
-    vtkSmartPointer<vtkFloatArray> values = vtkSmartPointer<vtkFloatArray>::New();
-    values->SetName("values");
+    //copy the point set data columns into the VTK arrays in parallel
+    //(the data table is read-only from now on, so this is thread-safe)
+    Util::parallelFor( nPoints, [=]( long first, long last ){
+        for( long line = first; line < last; ++line ){
+            xyz[ line*3     ] = pointSet->data( line, xColumn );
+            xyz[ line*3 + 1 ] = pointSet->data( line, yColumn );
+            xyz[ line*3 + 2 ] = zColumn >= 0 ? pointSet->data( line, zColumn ) : 0.0;
+            if( v )
+                v[ line ] = pointSet->data( line, valueColumn );
+        }
+    });
 
-    //read point geometry and sample values
-    vtkSmartPointer<vtkIdList> pids = vtkSmartPointer<vtkIdList>::New();
-    pids->Allocate( pointSet->getDataLineCount() );
-    values->Allocate( pointSet->getDataLineCount() );
-    for( uint line = 0; line < pointSet->getDataLineCount(); ++line){
-        // sample location
-        double x = pointSet->data( line, pointSet->getXindex()-1 );
-        double y = pointSet->data( line, pointSet->getYindex()-1 );
-        double z = 0.0;
-        if( pointSet->is3D() )
-            z = pointSet->data( line, pointSet->getZindex()-1 );
-        pids->InsertNextId(  points->InsertNextPoint( x, y, z ) );
-        // sample value
-        double value = pointSet->data( line, var_index - 1 );
-        values->InsertNextValue( value );
+    //get the point budget for interactive rendering
+    vtkIdType pointBudget = Application::instance()->getMaxPointCountFor3DVisualizationSetting();
+
+    //get the no-data value configuration (used to compute representative values in decimation)
+    bool hasNDV = pointSet->hasNoDataValue();
+    double NDV = pointSet->getNoDataValueAsDouble();
+
+    //make the VTK mapper for the full-resolution point cloud
+    vtkSmartPointer<vtkPolyDataMapper> fullMapper =
+            makePointCloudMapper( coordinates, values, min, max );
+
+    //small point sets are rendered in full detail all the time
+    if( nPoints <= pointBudget ){
+        vtkSmartPointer<vtkActor> actor = vtkSmartPointer<vtkActor>::New();
+        actor->SetMapper( fullMapper );
+        actor->GetProperty()->SetPointSize(3);
+        return View3DViewData(actor);
     }
+
+    Application::instance()->logInfo("View3DBuilders::buildPointCloud(): " + QString::number( nPoints ) +
+                                      " points exceed the budget of " + QString::number( pointBudget ) +
+                                      " points.  A decimated point cloud will be rendered during camera interaction.");
+
+    //make the decimated levels-of-detail: the point budget itself and a coarser one (1/8 of budget, at least one
+    //point) for very slow rendering machines
+    vtkSmartPointer<vtkPolyDataMapper> budgetMapper =
+            makeDecimatedPointCloudMapper( coordinates, values, hasNDV, NDV, pointBudget, min, max );
+    vtkSmartPointer<vtkPolyDataMapper> coarseMapper =
+            makeDecimatedPointCloudMapper( coordinates, values, hasNDV, NDV,
+                                           std::max<vtkIdType>( 1, pointBudget / 8 ), min, max );
+
+    //create a LOD VTK actor.  The renderer allocates less render time during camera interaction
+    //(the interactor's desired update rate), so the decimated levels are drawn while the user drags the scene.
+    //Once the interaction stops, the still update rate allows the full-resolution level to be rendered,
+    //thus the point cloud progressively refines.
+    vtkSmartPointer<vtkLODProp3D> propLOD = vtkSmartPointer<vtkLODProp3D>::New();
+    propLOD->AutomaticLODSelectionOn();
+    vtkSmartPointer<vtkProperty> pointProperty = vtkSmartPointer<vtkProperty>::New();
+    pointProperty->SetPointSize(3);
+    propLOD->SetLODLevel( propLOD->AddLOD( fullMapper, pointProperty, 0.0 ), 0.0 );
+    propLOD->SetLODLevel( propLOD->AddLOD( budgetMapper, pointProperty, 0.0 ), 1.0 );
+    propLOD->SetLODLevel( propLOD->AddLOD( coarseMapper, pointProperty, 0.0 ), 2.0 );
+
+    return View3DViewData(propLOD);
+}
+
+vtkSmartPointer<vtkPolyDataMapper> View3DBuilders::makePointCloudMapper(vtkSmartPointer<vtkDoubleArray> coordinates,
+                                                                        vtkSmartPointer<vtkFloatArray> values,
+                                                                        double min, double max)
+{
+    vtkIdType nPoints = coordinates->GetNumberOfTuples();
+
+    // Create the geometry of the points (the coordinates) sharing the coordinates array
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( coordinates );
+
+    // Create the topology of the points (a single polyvertex) with the ids filled in bulk
+    vtkSmartPointer<vtkIdList> pids = vtkSmartPointer<vtkIdList>::New();
+    pids->SetNumberOfIds( nPoints );
+    vtkIdType* ids = pids->GetPointer( 0 );
+    for( vtkIdType i = 0; i < nPoints; ++i )
+        ids[i] = i;
+    vtkSmartPointer<vtkCellArray> vertices = vtkSmartPointer<vtkCellArray>::New();
     vertices->InsertNextCell( pids );
 
     // Create a polydata object (topological object)
-    vtkSmartPointer<vtkPolyData> pointCloud =
-      vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkPolyData> pointCloud = vtkSmartPointer<vtkPolyData>::New();
 
-    // Set the points, values and vertices we created as the geometry and topology of the polydata
+    // Set the points and vertices we created as the geometry and topology of the polydata
     pointCloud->SetPoints(points);
     pointCloud->SetVerts(vertices);
-    pointCloud->GetPointData()->SetScalars( values );
-    pointCloud->GetPointData()->SetActiveScalars("values");
-
-    //assign a color table
-    vtkSmartPointer<vtkLookupTable> lut = View3dColorTables::getColorTable( ColorTable::RAINBOW, min, max);
 
     // Create a visualization parameters object
-    vtkSmartPointer<vtkPolyDataMapper> mapper =
-      vtkSmartPointer<vtkPolyDataMapper>::New();
+    vtkSmartPointer<vtkPolyDataMapper> mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
     mapper->SetInputData(pointCloud);
-    mapper->SetLookupTable(lut);
-    mapper->SetScalarModeToUsePointFieldData();
-    mapper->SetColorModeToMapScalars();
-    mapper->SelectColorArray("values");
-    mapper->SetScalarRange(min, max);
 
-    // Create and configure the final actor object
-    vtkSmartPointer<vtkActor> actor =
-      vtkSmartPointer<vtkActor>::New();
-    actor->SetMapper(mapper);
-    actor->GetProperty()->SetPointSize(3);
+    //set the values and color table, if values were informed
+    if( values ){
+        pointCloud->GetPointData()->SetScalars( values );
+        pointCloud->GetPointData()->SetActiveScalars("values");
+        //assign a color table
+        vtkSmartPointer<vtkLookupTable> lut = View3dColorTables::getColorTable( ColorTable::RAINBOW, min, max);
+        mapper->SetLookupTable(lut);
+        mapper->SetScalarModeToUsePointFieldData();
+        mapper->SetColorModeToMapScalars();
+        mapper->SelectColorArray("values");
+        mapper->SetScalarRange(min, max);
+    }
 
-    return View3DViewData(actor);
+    return mapper;
+}
+
+vtkSmartPointer<vtkPolyDataMapper> View3DBuilders::makeDecimatedPointCloudMapper(vtkSmartPointer<vtkDoubleArray> coordinates,
+                                                                                 vtkSmartPointer<vtkFloatArray> values,
+                                                                                 bool hasNDV, double NDV,
+                                                                                 vtkIdType pointBudget,
+                                                                                 double min, double max)
+{
+    //select the representative points
+    std::vector<vtkIdType> selection = decimateByVoxelGrid( coordinates->GetPointer( 0 ),
+                                                            ( values ? values->GetPointer( 0 ) : nullptr ),
+                                                            coordinates->GetNumberOfTuples(),
+                                                            hasNDV, NDV, pointBudget );
+    vtkIdType nSelected = selection.size();
+
+    //copy the selected points to new arrays (in parallel)
+    vtkSmartPointer<vtkDoubleArray> selectedCoordinates = vtkSmartPointer<vtkDoubleArray>::New();
+    selectedCoordinates->SetNumberOfComponents( 3 );
+    selectedCoordinates->SetNumberOfTuples( nSelected );
+    double* xyzIn = coordinates->GetPointer( 0 );
+    double* xyzOut = selectedCoordinates->GetPointer( 0 );
+    vtkSmartPointer<vtkFloatArray> selectedValues;
+    float* vIn = nullptr;
+    float* vOut = nullptr;
+    if( values ){
+        selectedValues = vtkSmartPointer<vtkFloatArray>::New();
+        selectedValues->SetName("values");
+        selectedValues->SetNumberOfValues( nSelected );
+        vIn = values->GetPointer( 0 );
+        vOut = selectedValues->GetPointer( 0 );
+    }
+    const vtkIdType* sel = selection.data();
+    Util::parallelFor( nSelected, [=]( long first, long last ){
+        for( long i = first; i < last; ++i ){
+            vtkIdType src = sel[i];
+            xyzOut[ i*3     ] = xyzIn[ src*3     ];
+            xyzOut[ i*3 + 1 ] = xyzIn[ src*3 + 1 ];
+            xyzOut[ i*3 + 2 ] = xyzIn[ src*3 + 2 ];
+            if( vOut )
+                vOut[ i ] = vIn[ src ];
+        }
+    });
+
+    return makePointCloudMapper( selectedCoordinates, selectedValues, min, max );
+}
+
+std::vector<vtkIdType> View3DBuilders::decimateByVoxelGrid(const double *xyz,
+                                                           const float *values,
+                                                           vtkIdType nPoints,
+                                                           bool hasNDV, double NDV,
+                                                           vtkIdType pointBudget)
+{
+    std::vector<vtkIdType> result;
+    if( nPoints == 0 || pointBudget < 1 )
+        return result;
+
+    //get the bounding box of the point cloud
+    double bbox[6] = { std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max(),
+                       std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+    for( vtkIdType i = 0; i < nPoints; ++i ){
+        for( int c = 0; c < 3; ++c ){
+            double coord = xyz[ i*3 + c ];
+            bbox[ c*2 ] = std::min( bbox[ c*2 ], coord );
+            bbox[ c*2 + 1 ] = std::max( bbox[ c*2 + 1 ], coord );
+        }
+    }
+    double lx = bbox[1] - bbox[0];
+    double ly = bbox[3] - bbox[2];
+    double lz = bbox[5] - bbox[4];
+
+    //compute an initial voxel size such that the bounding box holds about pointBudget voxels
+    //zero-length extents (e.g. 2D point sets) do not count as a dimension
+    int nDims = ( lx > 0.0 ? 1 : 0 ) + ( ly > 0.0 ? 1 : 0 ) + ( lz > 0.0 ? 1 : 0 );
+    if( nDims == 0 ){
+        //all points are coincident, one point is enough
+        result.push_back( 0 );
+        return result;
+    }
+    double measure = ( lx > 0.0 ? lx : 1.0 ) * ( ly > 0.0 ? ly : 1.0 ) * ( lz > 0.0 ? lz : 1.0 );
+    double voxelSize = std::pow( measure / pointBudget, 1.0 / nDims );
+
+    //the voxel keys for each point
+    std::vector<uint64_t> keys( nPoints );
+
+    //representative point selection per voxel
+    struct Voxel{
+        double sum;             //sum of valued samples in the voxel
+        vtkIdType count;        //number of valued samples in the voxel
+        vtkIdType first;        //first point found in the voxel (representative if values are not used)
+    };
+    std::unordered_map<uint64_t, Voxel> voxels;
+
+    //sparse point sets occupy few voxels, so refine the voxels until the budget is about met
+    for( int iRefinement = 0; iRefinement < 4; ++iRefinement ){
+        //voxel count along each direction (+1 so the points on the max bounding box faces fit in)
+        uint64_t nvx = (uint64_t)( lx / voxelSize ) + 1;
+        uint64_t nvy = (uint64_t)( ly / voxelSize ) + 1;
+
+        //compute the voxel key of each point (integer cell hashing) in parallel
+        uint64_t* pKeys = keys.data();
+        Util::parallelFor( nPoints, [=]( long first, long last ){
+            for( long i = first; i < last; ++i ){
+                uint64_t ix = (uint64_t)( ( xyz[ i*3     ] - bbox[0] ) / voxelSize );
+                uint64_t iy = (uint64_t)( ( xyz[ i*3 + 1 ] - bbox[2] ) / voxelSize );
+                uint64_t iz = (uint64_t)( ( xyz[ i*3 + 2 ] - bbox[4] ) / voxelSize );
+                pKeys[i] = ix + iy * nvx + iz * nvx * nvy;
+            }
+        });
+
+        //accumulate the voxel statistics
+        voxels.clear();
+        voxels.reserve( pointBudget * 2 );
+        for( vtkIdType i = 0; i < nPoints; ++i ){
+            std::unordered_map<uint64_t, Voxel>::iterator it = voxels.find( keys[i] );
+            if( it == voxels.end() )
+                it = voxels.emplace( keys[i], Voxel{ 0.0, 0, i } ).first;
+            if( values ){
+                double value = values[i];
+                if( !hasNDV || !Util::almostEqual2sComplement( NDV, value, 1 ) ){
+                    it->second.sum += value;
+                    ++it->second.count;
+                }
+            }
+        }
+
+        //stop refining if the number of occupied voxels is near the point budget
+        if( (vtkIdType)voxels.size() * 2 >= pointBudget )
+            break;
+        voxelSize /= 2.0;
+    }
+
+    //select one representative point per voxel: the point whose value is the closest to the mean
+    //of the voxel (if there are values), so the decimated cloud keeps the local value distribution;
+    //otherwise, the first point found in the voxel.
+    if( values ){
+        std::unordered_map<uint64_t, std::pair<vtkIdType, double> > best; //pair: point index, |value-mean|
+        best.reserve( voxels.size() );
+        for( vtkIdType i = 0; i < nPoints; ++i ){
+            const Voxel& voxel = voxels[ keys[i] ];
+            if( voxel.count == 0 ) //voxel with only unvalued points
+                continue;
+            double value = values[i];
+            if( hasNDV && Util::almostEqual2sComplement( NDV, value, 1 ) )
+                continue;
+            double diff = std::abs( value - voxel.sum / voxel.count );
+            std::unordered_map<uint64_t, std::pair<vtkIdType, double> >::iterator it = best.find( keys[i] );
+            if( it == best.end() )
+                best.emplace( keys[i], std::pair<vtkIdType, double>( i, diff ) );
+            else if( diff < it->second.second )
+                it->second = std::pair<vtkIdType, double>( i, diff );
+        }
+        result.reserve( voxels.size() );
+        for( std::unordered_map<uint64_t, Voxel>::iterator it = voxels.begin(); it != voxels.end(); ++it ){
+            if( it->second.count == 0 )
+                result.push_back( it->second.first );
+            else
+                result.push_back( best[ it->first ].first );
+        }
+    } else {
+        result.reserve( voxels.size() );
+        for( std::unordered_map<uint64_t, Voxel>::iterator it = voxels.begin(); it != voxels.end(); ++it )
+            result.push_back( it->second.first );
+    }
+
+    //keep the original point order (better memory locality when copying)
+    std::sort( result.begin(), result.end() );
+
+    return result;
 }
 
 View3DViewData View3DBuilders::buildForMapCartesianGrid(CartesianGrid *cartesianGrid, View3DWidget */*widget3D*/)
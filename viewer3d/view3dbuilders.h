@@ -4,6 +4,10 @@
 #include <vtkSmartPointer.h>
 #include <vtkActor.h>
 #include <vtkImageActor.h>
+#include <vtkPolyDataMapper.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vector>
 #include "view3dviewdata.h"
 
 class ProjectComponent;
@@ -35,6 +39,41 @@ public:
 private:
     static View3DViewData buildForAttributeFromPointSet( PointSet* pointSet, Attribute* attribute, View3DWidget * widget3D );
 
+    /** Builds the point cloud of a point set, optionally colored by one of its attributes (pass nullptr to
+     *  render geometry only).  If the number of points exceeds the budget set by
+     *  Application::getMaxPointCountFor3DVisualizationSetting(), voxel-grid decimated versions of the cloud
+     *  are rendered during camera interaction and the full cloud is rendered when the interaction stops.
+     */
+    static View3DViewData buildPointCloud( PointSet* pointSet, Attribute* attribute );
+
+    /** Makes a mapper for a point cloud given its coordinates (x,y,z triplets) and values.
+     *  The arrays are shared, not copied.  Pass a null values array to render geometry only.
+     */
+    static vtkSmartPointer<vtkPolyDataMapper> makePointCloudMapper( vtkSmartPointer<vtkDoubleArray> coordinates,
+                                                                    vtkSmartPointer<vtkFloatArray> values,
+                                                                    double min, double max );
+
+    /** Same as makePointCloudMapper(), but renders only the points selected by decimateByVoxelGrid(). */
+    static vtkSmartPointer<vtkPolyDataMapper> makeDecimatedPointCloudMapper( vtkSmartPointer<vtkDoubleArray> coordinates,
+                                                                             vtkSmartPointer<vtkFloatArray> values,
+                                                                             bool hasNDV, double NDV,
+                                                                             vtkIdType pointBudget,
+                                                                             double min, double max );
+
+    /** Spatially stratified decimation: the bounding box of the points is divided into voxels sized
+     *  so that about pointBudget voxels are occupied and one representative point is selected per voxel.
+     *  If values are given, the representative is the point whose value is closest to the voxel mean
+     *  (no-data values do not count), otherwise it is the first point found in the voxel.
+     *  @param xyz Point coordinates as x,y,z triplets (nPoints*3 elements).
+     *  @param values Point values (nPoints elements) or nullptr.
+     *  @return The indexes of the selected points in ascending order.
+     */
+    static std::vector<vtkIdType> decimateByVoxelGrid( const double* xyz,
+                                                       const float* values,
+                                                       vtkIdType nPoints,
+                                                       bool hasNDV, double NDV,
+                                                       vtkIdType pointBudget );
+
     /** Specific builder for a Cartesian grid that represents a 2D map (nZ < 2).
      *  The grid is displayed in the XY plane (Z=0).
     */